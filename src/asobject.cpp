@@ -21,6 +21,7 @@
 #include "asobject.h"
 #include "scripting/class.h"
 #include <algorithm>
+#include <cstring>
 #include "compat.h"
 #include "parsing/amf3_generator.h"
 #include "scripting/argconv.h"
@@ -49,6 +50,38 @@ asfreelist::~asfreelist()
 	for (int i = 0; i < freelistsize; i++)
 		delete freelist[i];
 	freelistsize = 0;
+	free(freelist);
+}
+
+bool asfreelist::growFreeList()
+{
+	if (freelistcapacity)
+		overflows++;
+	if (freelistcapacity >= FREELIST_MAX_SIZE)
+		return false;
+	int newcapacity = freelistcapacity ? freelistcapacity*2 : FREELIST_SIZE;
+	ASObject** newlist = (ASObject**)realloc(freelist,newcapacity*sizeof(ASObject*));
+	if (!newlist)
+		return false;
+	freelist = newlist;
+	freelistcapacity = newcapacity;
+	return true;
+}
+
+void asfreelist::trim()
+{
+	// the objects at the bottom of the list were not needed since the last trim, release half of them
+	int unused = (lowwatermark-FREELIST_SIZE)/2;
+	if (unused > 0)
+	{
+		for (int i = 0; i < unused; i++)
+			delete freelist[i];
+		freelistsize -= unused;
+		memmove(freelist,freelist+unused,freelistsize*sizeof(ASObject*));
+	}
+	if (freelistcapacity > FREELIST_SIZE && freelistsize <= freelistcapacity/4)
+		freelistcapacity /= 2;
+	lowwatermark = freelistsize;
 }
 
 string ASObject::toDebugString() const
@@ -528,10 +561,8 @@ void ASObject::call_toString(asAtom &ret)
 	ASATOM_DECREF(o);
 }
 
-tiny_string ASObject::call_toJSON(bool& ok,std::vector<ASObject *> &path, asAtom replacer, const tiny_string &spaces,const tiny_string& filter)
+bool ASObject::call_toJSON(std::string& res, std::vector<ASObject *> &path, asAtom replacer, const tiny_string &spaces,const tiny_string& filter)
 {
-	tiny_string res;
-	ok = false;
 	multiname toJSONName(nullptr);
 	toJSONName.name_type=multiname::NAME_STRING;
 	toJSONName.name_s_id=getSystemState()->getUniqueStringId("toJSON");
@@ -539,32 +570,32 @@ tiny_string ASObject::call_toJSON(bool& ok,std::vector<ASObject *> &path, asAtom
 	toJSONName.ns.emplace_back(getSystemState(),BUILTIN_STRINGS::STRING_AS3NS,NAMESPACE);
 	toJSONName.isAttribute = false;
 	if (!ASObject::hasPropertyByMultiname(toJSONName, true, true,getInstanceWorker()))
-		return res;
+		return false;
 
 	asAtom o=asAtomHandler::invalidAtom;
 	getVariableByMultiname(o,toJSONName,SKIP_IMPL,getInstanceWorker());
 	if (!asAtomHandler::isFunction(o))
 	{
 		ASATOM_DECREF(o);
-		return res;
+		return false;
 	}
 	asAtom v=asAtomHandler::fromObject(this);
 	asAtom ret=asAtomHandler::invalidAtom;
 	asAtomHandler::callFunction(o,getInstanceWorker(), ret,v,nullptr,0,false);
 	ASATOM_DECREF(o);
 	if (getInstanceWorker()->currentCallContext && getInstanceWorker()->currentCallContext->exceptionthrown)
-		return res;
+		return false;
 	if (asAtomHandler::isString(ret))
 	{
+		tiny_string s = asAtomHandler::toString(ret,getInstanceWorker());
 		res += "\"";
-		res += asAtomHandler::toString(ret,getInstanceWorker());
+		res.append(s.raw_buf(),s.numBytes());
 		res += "\"";
 	}
 	else 
-		res = asAtomHandler::toObject(ret,getInstanceWorker())->toJSON(path,replacer,spaces,filter);
+		asAtomHandler::toObject(ret,getInstanceWorker())->toJSON(res,path,replacer,spaces,filter);
 	ASATOM_DECREF(ret);
-	ok = true;
-	return res;
+	return true;
 }
 
 bool ASObject::isPrimitive() const
@@ -671,6 +702,7 @@ void ASObject::setDeclaredMethodByQName(uint32_t nameId, const nsNameAndKind& ns
 	{
 		assert(this->is<Class_base>());
 		obj=this->as<Class_base>()->borrowedVariables.findObjVar(nameId,ns,DECLARED_TRAIT, DECLARED_TRAIT);
+		this->as<Class_base>()->traitsRevision++;
 	}
 	else
 	{
@@ -752,6 +784,7 @@ void ASObject::setDeclaredMethodAtomByQName(uint32_t nameId, const nsNameAndKind
 	{
 		assert(this->is<Class_base>());
 		obj=this->as<Class_base>()->borrowedVariables.findObjVar(nameId,ns,DECLARED_TRAIT, DECLARED_TRAIT);
+		this->as<Class_base>()->traitsRevision++;
 		if (!this->is<Class_inherit>())
 			o->setRefConstant();
 	}
@@ -1090,6 +1123,7 @@ void variables_map::killObjVar(SystemState* sys,const multiname& mname)
 		if(ns==*nsIt)
 		{
 			Variables.erase(ret);
+			compactVariables();
 			return;
 		}
 		else
@@ -1518,6 +1552,42 @@ variable* ASObject::findVariableByMultiname(const multiname& name, Class_base* c
 	return obj;
 }
 
+bool ASObject::getCacheableVariable(const multiname& name, bool forsetting, uint32_t& slotid, variable*& var)
+{
+	// dynamic variables can't be added to instances of sealed classes, so the result only depends on the class
+	if (!classdef || !classdef->isSealed || !traitsInitialized
+			|| type != T_OBJECT || is<Proxy>() || is<Global>()
+			|| name.name_type != multiname::NAME_STRING || name.isAttribute)
+		return false;
+	slotid = 0;
+	var = nullptr;
+	variable* v = Variables.findObjVar(getSystemState(),name,DECLARED_TRAIT);
+	if (v)
+	{
+		if (!v->slotid || asAtomHandler::isInvalid(v->var) || asAtomHandler::isValid(v->getter) || asAtomHandler::isValid(v->setter))
+			return false;
+		// constants are not cached for setting, as they need special error handling
+		if (forsetting && v->kind != DECLARED_TRAIT)
+			return false;
+		slotid = v->slotid;
+		return true;
+	}
+	if (forsetting)
+	{
+		v = classdef->findBorrowedSettable(name);
+		if (!v || asAtomHandler::isInvalid(v->setter))
+			return false;
+	}
+	else
+	{
+		v = ASObject::findGettableImpl(getSystemState(),classdef->borrowedVariables,name);
+		if (!v || (asAtomHandler::isInvalid(v->getter) && !asAtomHandler::isFunction(v->var)))
+			return false;
+	}
+	var = v;
+	return true;
+}
+
 GET_VARIABLE_RESULT ASObject::getVariableByMultinameIntern(asAtom &ret, const multiname& name, Class_base* cls, GET_VARIABLE_OPTION opt,ASWorker* wrk)
 {
 	check();
@@ -1802,8 +1872,12 @@ void variables_map::destroyContents()
 		else
 			Variables.erase(it);
 	}
+	Variables.clear();
 	slots_vars.clear();
 	slotcount=0;
+	if (instanceshape)
+		instanceshape->decRef();
+	instanceshape=nullptr;
 }
 void variables_map::prepareShutdown()
 {
@@ -1826,7 +1900,19 @@ bool variables_map::cloneInstance(variables_map &map)
 {
 	if (!cloneable)
 		return false;
-	map.Variables = Variables;
+	if (!instanceshape || instanceshape->sourcerevision != Variables.getRevision() || instanceshape->slotcount != slotcount)
+	{
+		// (re)build the layout shared by all instances created from this map
+		// the variables of this map keep their storage, so pointers to them stay valid
+		if (instanceshape)
+			instanceshape->decRef();
+		instanceshape = Variables.buildShape();
+		instanceshape->slotcount = slotcount;
+	}
+	variables_shape* shape = instanceshape;
+	map.Variables.initFromShape(shape);
+	if (shape->slotcount > map.slots_vars.capacity())
+		map.slots_vars.reserve(shape->slotcount);
 	auto it = map.Variables.begin();
 	while (it !=map.Variables.end())
 	{
@@ -1837,6 +1923,128 @@ bool variables_map::cloneInstance(variables_map &map)
 	return true;
 }
 
+variables_storage::iterator variables_storage::erase(iterator it)
+{
+	if (it.pos)
+	{
+		// variables in the flat layout are only marked as removed, so pointers to the other variables stay valid
+		value_type* p = it.pos;
+		++it;
+		p->second.kind=NO_CREATE_TRAIT;
+		p->second.var=asAtomHandler::invalidAtom;
+		p->second.getter=asAtomHandler::invalidAtom;
+		p->second.setter=asAtomHandler::invalidAtom;
+		p->second.slotid=0;
+		flatcount--;
+		++revision;
+		if (flatcount == 0 && it.pos == nullptr)
+		{
+			// all variables of the flat layout are removed, release it
+			std::vector<value_type>().swap(flat);
+			shape->decRef();
+			shape=nullptr;
+		}
+		return it;
+	}
+	++revision;
+	return iterator(nullptr,nullptr,dynamic.erase(it.it));
+}
+
+bool variables_storage::getFlatIndex(const variable* v, uint32_t& shapeid, uint32_t& index) const
+{
+	if (!shape || flat.empty())
+		return false;
+	const char* p = (const char*)v;
+	const char* start = (const char*)&flat.front().second;
+	if (p < start || p > (const char*)&flat.back().second)
+		return false;
+	index = (p-start)/sizeof(value_type);
+	shapeid = shape->id;
+	return &flat[index].second == v;
+}
+
+bool variables_storage::compact()
+{
+	// only worth it if most of the flat layout is unused
+	if (!shape || flatcount*2 >= flat.size())
+		return false;
+	for (auto it = flat.begin(); it != flat.end(); it++)
+	{
+		if (it->second.kind != NO_CREATE_TRAIT)
+			dynamic.insert(*it);
+	}
+	std::vector<value_type>().swap(flat);
+	flatcount=0;
+	shape->decRef();
+	shape=nullptr;
+	++revision;
+	return true;
+}
+
+variables_shape* variables_storage::buildShape() const
+{
+	variables_shape* s = new variables_shape();
+	std::vector<const value_type*> vars;
+	vars.reserve(size());
+	for (auto it = begin(); it != end(); it++)
+		vars.push_back(&(*it));
+	// keep the variables with the same name adjacent, in the order they were found
+	std::stable_sort(vars.begin(),vars.end(),[](const value_type* a, const value_type* b) { return a->first < b->first; });
+	s->prototype.reserve(vars.size());
+	for (auto it = vars.begin(); it != vars.end(); it++)
+	{
+		uint32_t nameId = (*it)->first;
+		auto idx = s->nameindex.find(nameId);
+		if (idx == s->nameindex.end())
+			s->nameindex.insert(make_pair(nameId,make_pair(uint32_t(s->prototype.size()),uint32_t(1))));
+		else
+			idx->second.second++;
+		s->prototype.push_back(**it);
+	}
+	s->sourcerevision = revision;
+	return s;
+}
+
+void variables_storage::initFromShape(variables_shape* s)
+{
+	assert(s);
+	s->incRef();
+	std::vector<value_type> vars(s->prototype);
+	// replace the current contents, the values are primitives, so no reference counting is needed
+	clear();
+	flat.swap(vars);
+	flatcount = flat.size();
+	shape = s;
+	++revision;
+}
+
+void variables_storage::clear()
+{
+	dynamic.clear();
+	std::vector<value_type>().swap(flat);
+	flatcount=0;
+	if (shape)
+		shape->decRef();
+	shape=nullptr;
+	++revision;
+}
+
+std::atomic<uint32_t> variables_shape::nextid(0);
+
+void variables_map::compactVariables()
+{
+	if (!Variables.compact())
+		return;
+	// the variables were moved, so the slots have to be updated
+	auto it = Variables.begin();
+	while (it != Variables.end())
+	{
+		if (it->second.slotid)
+			initSlot(it->second.slotid,&(it->second));
+		it++;
+	}
+}
+
 void variables_map::removeAllDeclaredProperties()
 {
 	var_iterator it=Variables.begin();
@@ -1850,6 +2058,7 @@ void variables_map::removeAllDeclaredProperties()
 		else
 			it++;
 	}
+	compactVariables();
 }
 
 bool variables_map::countCylicMemberReferences(garbagecollectorstate& gcstate, ASObject* parent)
@@ -1862,7 +2071,7 @@ bool variables_map::countCylicMemberReferences(garbagecollectorstate& gcstate, A
 		ASObject* o = asAtomHandler::getObject(it->second.var);
 		if (it->second.isrefcounted && o && !o->getCached() && !o->getConstant() && !o->getInDestruction() && o->canHaveCyclicMemberReference() && !o->getInstanceWorker()->isDeletedInGarbageCollection(o))
 		{
-			if (o==gcstate.startobj)
+			if (gcstate.isStartObject(o))
 			{
 				gcstate.incCount(o);
 				ret = true;
@@ -1876,7 +2085,7 @@ bool variables_map::countCylicMemberReferences(garbagecollectorstate& gcstate, A
 					ret = true;
 				}
 			}
-			if (parent == gcstate.startobj)
+			if (gcstate.isStartObject(parent))
 			{
 				gcstate.ancestors.clear();
 				gcstate.ancestors.insert(parent);
@@ -1915,6 +2124,8 @@ ASObject::ASObject(ASWorker* wrk, Class_base* c, SWFOBJECT_TYPE t, CLASS_SUBTYPE
 	classdef(c),proxyMultiName(nullptr),sys(c?c->sys:nullptr),worker(wrk),
 	stringId(UINT32_MAX),storedmembercount(0),type(t),subtype(st),traitsInitialized(false),constructIndicator(false),constructorCallComplete(false),preparedforshutdown(false),markedforgarbagecollection(false),implEnable(true)
 {
+	if (wrk && wrk != this)
+		wrk->countAllocation();
 #ifndef NDEBUG
 	//Stuff only used in debugging
 	initialized=false;
@@ -2005,7 +2216,11 @@ void ASObject::handleGarbageCollection()
 		return;
 	if (storedmembercount && this->canHaveCyclicMemberReference() && ((uint32_t)this->getRefCount() == storedmembercount+1))
 	{
-		garbagecollectorstate gcstate(this);
+		// use the traversal state of the worker, unless we are called while it is in use
+		ASWorker* wrk = getInstanceWorker();
+		garbagecollectorstate localgcstate(this);
+		garbagecollectorstate* pgcstate = wrk->acquireGarbageCollectorState(this);
+		garbagecollectorstate& gcstate = pgcstate ? *pgcstate : localgcstate;
 		this->countCylicMemberReferences(gcstate);
 		markedforgarbagecollection=false;
 		uint32_t c =0;
@@ -2026,6 +2241,7 @@ void ASObject::handleGarbageCollection()
 				break;
 			}
 		}
+		wrk->releaseGarbageCollectorState(pgcstate);
 		assert(c == UINT32_MAX || c <= storedmembercount || this->preparedforshutdown);
 		if (c == storedmembercount)
 		{
@@ -2038,6 +2254,77 @@ void ASObject::handleGarbageCollection()
 	decRef();
 }
 
+/*
+ * checks a batch of candidates with one traversal shared by all of them.
+ * The candidates are treated like a single start object, so objects reachable from several candidates are only traversed once.
+ * If all references to the candidates and to the objects leading back to them are found in the traversal, the whole batch is garbage.
+ * Candidates with references from outside of the traversal are alive and are released without checking them again.
+ * Candidates that are handled are removed from the garbage collection set,
+ * the remaining ones have to be checked one by one
+ */
+void ASObject::handleGarbageCollectionBatch(ASWorker* wrk, std::vector<ASObject*>& candidates)
+{
+	std::vector<ASObject*> roots;
+	for (auto it = candidates.begin(); it != candidates.end(); it++)
+	{
+		ASObject* o = *it;
+		if (!o->getConstant() && !o->getCached() && !o->getInDestruction()
+				&& o->storedmembercount && o->canHaveCyclicMemberReference() && ((uint32_t)o->getRefCount() == o->storedmembercount+1))
+			roots.push_back(o);
+	}
+	if (roots.size() < 2)
+		return;
+	garbagecollectorstate* gcstate = wrk->acquireGarbageCollectorState(nullptr);
+	if (!gcstate)
+		return;
+	for (auto it = roots.begin(); it != roots.end(); it++)
+		gcstate->startobjs.insert(*it);
+	for (auto it = roots.begin(); it != roots.end(); it++)
+	{
+		gcstate->ancestors.clear();
+		(*it)->countCylicMemberReferences(*gcstate);
+	}
+	bool collectable = true;
+	for (auto it = gcstate->checkedobjects.begin(); it != gcstate->checkedobjects.end() && collectable; it++)
+	{
+		if (!gcstate->isStartObject((*it).first) && (*it).second.hasmember && (*it).second.count!=(uint32_t)(*it).first->getRefCount())
+			collectable = false;
+	}
+	std::vector<ASObject*> alive;
+	for (auto it = roots.begin(); it != roots.end(); it++)
+	{
+		auto itc = gcstate->checkedobjects.find(*it);
+		uint32_t c = itc == gcstate->checkedobjects.end() ? 0 : (*itc).second.count;
+		assert(c <= (*it)->storedmembercount || (*it)->preparedforshutdown);
+		if (c != (*it)->storedmembercount)
+			collectable = false;
+		// the traversal of a single candidate is contained in the shared traversal, so it can't find more references
+		if (c < (*it)->storedmembercount)
+			alive.push_back(*it);
+	}
+	wrk->releaseGarbageCollectorState(gcstate);
+	if (collectable)
+	{
+		for (auto it = roots.begin(); it != roots.end(); it++)
+		{
+			(*it)->removefromGarbageCollection();
+			wrk->setDeletedInGarbageCollection(*it);
+		}
+		for (auto it = roots.begin(); it != roots.end(); it++)
+		{
+			(*it)->destruct();
+			(*it)->finalize();
+		}
+		return;
+	}
+	for (auto it = alive.begin(); it != alive.end(); it++)
+	{
+		(*it)->removefromGarbageCollection();
+		*std::find(candidates.begin(),candidates.end(),*it) = nullptr;
+		(*it)->decRef();
+	}
+}
+
 bool ASObject::countCylicMemberReferences(garbagecollectorstate& gcstate)
 {
 	return Variables.countCylicMemberReferences(gcstate,this);
@@ -2046,7 +2333,7 @@ bool ASObject::countCylicMemberReferences(garbagecollectorstate& gcstate)
 bool ASObject::countAllCylicMemberReferences(garbagecollectorstate& gcstate)
 {
 	bool ret = false;
-	if (this == gcstate.startobj)
+	if (gcstate.isStartObject(this))
 	{
 		gcstate.incCount(this);
 		ret = true;
@@ -2338,9 +2625,9 @@ unsigned int ASObject::numVariables() const
 	return Variables.size();
 }
 
-void ASObject::serializeDynamicProperties(ByteArray* out, std::map<tiny_string, uint32_t>& stringMap,
-				std::map<const ASObject*, uint32_t>& objMap,
-				std::map<const Class_base*, uint32_t> traitsMap, ASWorker* wrk, bool usedynamicPropertyWriter, bool forSharedObject)
+void ASObject::serializeDynamicProperties(ByteArray* out, amf3stringtable& stringMap,
+				amf3objecttable& objMap,
+				amf3traitstable& traitsMap, ASWorker* wrk, bool usedynamicPropertyWriter, bool forSharedObject)
 {
 	if (usedynamicPropertyWriter && 
 			!out->getSystemState()->static_ObjectEncoding_dynamicPropertyWriter.isNull() &&
@@ -2376,9 +2663,9 @@ void ASObject::serializeDynamicProperties(ByteArray* out, std::map<tiny_string,
 		Variables.serialize(out, stringMap, objMap, traitsMap,forSharedObject,wrk);
 }
 
-void variables_map::serialize(ByteArray* out, std::map<tiny_string, uint32_t>& stringMap,
-				std::map<const ASObject*, uint32_t>& objMap,
-				std::map<const Class_base*, uint32_t>& traitsMap, bool forsharedobject, ASWorker* wrk)
+void variables_map::serialize(ByteArray* out, amf3stringtable& stringMap,
+				amf3objecttable& objMap,
+				amf3traitstable& traitsMap, bool forsharedobject, ASWorker* wrk)
 {
 	bool amf0 = out->getObjectEncoding() == OBJECT_ENCODING::AMF0;
 	//Pairs of name, value
@@ -2405,9 +2692,9 @@ void variables_map::serialize(ByteArray* out, std::map<tiny_string, uint32_t>& s
 		out->writeStringVR(stringMap, "");
 }
 
-void ASObject::serialize(ByteArray* out, std::map<tiny_string, uint32_t>& stringMap,
-				std::map<const ASObject*, uint32_t>& objMap,
-				std::map<const Class_base*, uint32_t>& traitsMap, ASWorker* wrk)
+void ASObject::serialize(ByteArray* out, amf3stringtable& stringMap,
+				amf3objecttable& objMap,
+				amf3traitstable& traitsMap, ASWorker* wrk)
 {
 	bool amf0 = out->getObjectEncoding() == OBJECT_ENCODING::AMF0;
 	if (amf0)
@@ -2415,18 +2702,18 @@ void ASObject::serialize(ByteArray* out, std::map<tiny_string, uint32_t>& string
 	else
 		out->writeByte(object_marker);
 	//Check if the object has been already serialized to send it by reference
-	auto it=objMap.find(this);
-	if(it!=objMap.end())
+	uint32_t ref=objMap.find(this);
+	if(ref!=amf3objecttable::npos)
 	{
 		if (amf0)
 		{
 			out->writeByte(amf0_reference_marker);
-			out->writeShort(it->second);
+			out->writeShort(ref);
 		}
 		else
 		{
 			//The least significant bit is 0 to signal a reference
-			out->writeU29(it->second << 1);
+			out->writeU29(ref << 1);
 		}
 		return;
 	}
@@ -2487,21 +2774,21 @@ void ASObject::serialize(ByteArray* out, std::map<tiny_string, uint32_t>& string
 	}
 
 	//Add the object to the map
-	objMap.insert(make_pair(this, objMap.size()));
+	objMap.add(this);
 
 	uint32_t traitsCount=0;
 	const variables_map::var_iterator beginIt = Variables.Variables.begin();
 	const variables_map::var_iterator endIt = Variables.Variables.end();
 	//Check if the class traits has been already serialized to send it by reference
-	auto it2=traitsMap.find(type);
+	uint32_t traitsref=traitsMap.find(type);
 
 	if (amf0)
 	{
 		LOG(LOG_NOT_IMPLEMENTED,"serializing ASObject in AMF0 not completely implemented");
-		if(it2!=traitsMap.end())
+		if(traitsref!=amf3traitstable::npos)
 		{
 			out->writeByte(amf0_reference_marker);
-			out->writeShort(it2->second);
+			out->writeShort(traitsref);
 			for(variables_map::var_iterator varIt=beginIt; varIt != endIt; ++varIt)
 			{
 				if(varIt->second.kind==DECLARED_TRAIT)
@@ -2523,11 +2810,11 @@ void ASObject::serialize(ByteArray* out, std::map<tiny_string, uint32_t>& string
 		return;
 	}
 
-	if(it2!=traitsMap.end())
-		out->writeU29((it2->second << 2) | 1);
+	if(traitsref!=amf3traitstable::npos)
+		out->writeU29((traitsref << 2) | 1);
 	else
 	{
-		traitsMap.insert(make_pair(type, traitsMap.size()));
+		traitsMap.add(type);
 		for(variables_map::const_var_iterator varIt=beginIt; varIt != endIt; ++varIt)
 		{
 			if(varIt->second.kind==DECLARED_TRAIT)
@@ -2611,21 +2898,19 @@ ASObject *ASObject::describeType(ASWorker* wrk) const
 	return XML::createFromNode(wrk,root);
 }
 
-tiny_string ASObject::toJSON(std::vector<ASObject *> &path, asAtom replacer, const tiny_string &spaces,const tiny_string& filter)
+void ASObject::toJSON(std::string& res, std::vector<ASObject *> &path, asAtom replacer, const tiny_string &spaces,const tiny_string& filter)
 {
-	bool ok;
-	tiny_string res = call_toJSON(ok,path,replacer,spaces,filter);
-	if (ok)
-		return res;
+	if (call_toJSON(res,path,replacer,spaces,filter))
+		return;
 
-	tiny_string newline = (spaces.empty() ? "" : "\n");
+	const char* newline = (spaces.empty() ? "" : "\n");
 	if (this->isPrimitive())
 	{
 		switch(this->type)
 		{
 			case T_STRING:
 			{
-				res = this->toString().toQuotedString();
+				this->toString().toQuotedString(res);
 				break;
 			}
 			case T_UNDEFINED:
@@ -2639,12 +2924,15 @@ tiny_string ASObject::toJSON(std::vector<ASObject *> &path, asAtom replacer, con
 				if (s == "Infinity" || s == "-Infinity" || s == "NaN")
 					res += "null";
 				else
-					res += s;
+					res.append(s.raw_buf(),s.numBytes());
 				break;
 			}
 			default:
-				res += this->toString();
+			{
+				tiny_string s = this->toString();
+				res.append(s.raw_buf(),s.numBytes());
 				break;
+			}
 		}
 	}
 	else
@@ -2715,15 +3003,17 @@ tiny_string ASObject::toJSON(std::vector<ASObject *> &path, asAtom replacer, con
 						std::find(path.begin(),path.end(), v) != path.end())
 					{
 						createError<TypeError>(getInstanceWorker(), kJSONCyclicStructure);
-						return res;
+						return;
 					}
 					if (asAtomHandler::isValid(replacer))
 					{
 						if (!bfirst)
 							res += ",";
-						res += newline+spaces;
+						res += newline;
+						res.append(spaces.raw_buf(),spaces.numBytes());
+						const tiny_string& name = getSystemState()->getStringFromUniqueId(varIt->first);
 						res += "\"";
-						res += getSystemState()->getStringFromUniqueId(varIt->first);
+						res.append(name.raw_buf(),name.numBytes());
 						res += "\"";
 						res += ":";
 						if (!spaces.empty())
@@ -2737,25 +3027,28 @@ tiny_string ASObject::toJSON(std::vector<ASObject *> &path, asAtom replacer, con
 						asAtomHandler::callFunction(replacer,getInstanceWorker(),funcret,asAtomHandler::nullAtom, params, 2,true);
 						if (asAtomHandler::isValid(funcret))
 						{
-							res += asAtomHandler::toString(funcret,getInstanceWorker());
+							tiny_string s = asAtomHandler::toString(funcret,getInstanceWorker());
+							res.append(s.raw_buf(),s.numBytes());
 							ASATOM_DECREF(funcret);
 						}
 						else
-							res += v->toJSON(path,replacer,spaces+spaces,filter);
+							v->toJSON(res,path,replacer,spaces+spaces,filter);
 						bfirst = false;
 					}
 					else if (filter.empty() || filter.find(tiny_string(" ")+getSystemState()->getStringFromUniqueId(varIt->first)+" ") != tiny_string::npos)
 					{
 						if (!bfirst)
 							res += ",";
-						res += newline+spaces;
+						res += newline;
+						res.append(spaces.raw_buf(),spaces.numBytes());
+						const tiny_string& name = getSystemState()->getStringFromUniqueId(varIt->first);
 						res += "\"";
-						res += getSystemState()->getStringFromUniqueId(varIt->first);
+						res.append(name.raw_buf(),name.numBytes());
 						res += "\"";
 						res += ":";
 						if (!spaces.empty())
 							res += " ";
-						res += v->toJSON(path,replacer,spaces+spaces,filter);
+						v->toJSON(res,path,replacer,spaces+spaces,filter);
 						bfirst = false;
 					}
 				}
@@ -2763,13 +3056,15 @@ tiny_string ASObject::toJSON(std::vector<ASObject *> &path, asAtom replacer, con
 				if (newobj)
 					v->decRef();
 				if (!bfirst)
-					res += newline+spaces.substr_bytes(0,spaces.numBytes()/2);
+				{
+					res += newline;
+					res.append(spaces.raw_buf(),spaces.numBytes()/2);
+				}
 			}
 		}
 		res += "}";
 		path.pop_back();
 	}
-	return res;
 }
 
 bool ASObject::hasprop_prototype()
@@ -2920,7 +3215,7 @@ void asAtomHandler::getVariableByMultiname(asAtom& a, asAtom& ret,SystemState* s
 {
 	// classes for primitives are final and sealed, so we only have to check the class for the variable
 	// no need to create ASObjects for the primitives
-	switch(a.uintval&0x7)
+	switch(getAtomType(a))
 	{
 		case ATOM_INTEGER:
 			Class<Integer>::getClass(wrk->getSystemState())->getClassVariableByMultiname(ret,name,wrk);
@@ -2965,7 +3260,7 @@ Class_base *asAtomHandler::getClass(asAtom& a,SystemState* sys,bool followclass)
 {
 	// classes for primitives are final and sealed, so we only have to check the class for the variable
 	// no need to create ASObjects for the primitives
-	switch(a.uintval&0x7)
+	switch(getAtomType(a))
 	{
 		case ATOM_INTEGER:
 			return Class<Integer>::getRef(sys).getPtr()->as<Class_base>();
@@ -2995,7 +3290,7 @@ Class_base *asAtomHandler::getClass(asAtom& a,SystemState* sys,bool followclass)
 bool asAtomHandler::canCacheMethod(asAtom& a,const multiname* name)
 {
 	assert(name->isStatic);
-	switch(a.uintval&0x7)
+	switch(getAtomType(a))
 	{
 		case ATOM_INTEGER:
 		case ATOM_UINTEGER:
@@ -3028,7 +3323,7 @@ bool asAtomHandler::canCacheMethod(asAtom& a,const multiname* name)
 
 void asAtomHandler::fillMultiname(asAtom& a, ASWorker* wrk, multiname &name)
 {
-	switch(a.uintval&0x7)
+	switch(getAtomType(a))
 	{
 		case ATOM_INTEGER:
 			name.name_type = multiname::NAME_INT;
@@ -3057,6 +3352,11 @@ void asAtomHandler::fillMultiname(asAtom& a, ASWorker* wrk, multiname &name)
 	}
 }
 
+int32_t asAtomHandler::numberToInt(number_t val)
+{
+	return Number::toInt(val);
+}
+
 void asAtomHandler::replaceBool(asAtom& a, ASObject *obj)
 {
 	a.uintval = obj->as<Boolean>()->val ? 0x100 : 0;
@@ -3064,7 +3364,7 @@ void asAtomHandler::replaceBool(asAtom& a, ASObject *obj)
 
 std::string asAtomHandler::toDebugString(const asAtom a)
 {
-	switch(a.uintval&0x7)
+	switch(getAtomType(a))
 	{
 		case ATOM_INTEGER:
 			return Integer::toString(a.intval>>3)+"i";
@@ -3074,6 +3374,8 @@ std::string asAtomHandler::toDebugString(const asAtom a)
 		{
 			std::string ret = Number::toString(toNumber(a))+"d";
 #ifndef NDEBUG
+			if (isInlineNumber(a))
+				return ret;
 			assert(getObject(a));
 			char buf[300];
 			sprintf(buf,"(%p/%d/%d/%d)",getObject(a),getObject(a)->getRefCount(),getObject(a)->storedmembercount,getObject(a)->getConstant());
@@ -3283,7 +3585,7 @@ bool asAtomHandler::isTypelate(asAtom& a,asAtom& t)
 
 void asAtomHandler::getStringView(tiny_string& res, const asAtom& a, ASWorker* wrk)
 {
-	switch(a.uintval&0x7)
+	switch(getAtomType(a))
 	{
 		case ATOM_INVALID_UNDEFINED_NULL_BOOL:
 		{
@@ -3336,7 +3638,7 @@ void asAtomHandler::getStringView(tiny_string& res, const asAtom& a, ASWorker* w
 
 tiny_string asAtomHandler::toString(const asAtom& a, ASWorker* wrk)
 {
-	switch(a.uintval&0x7)
+	switch(getAtomType(a))
 	{
 		case ATOM_INVALID_UNDEFINED_NULL_BOOL:
 		{
@@ -3371,7 +3673,7 @@ tiny_string asAtomHandler::toString(const asAtom& a, ASWorker* wrk)
 }
 tiny_string asAtomHandler::toLocaleString(const asAtom& a, ASWorker* wrk)
 {
-	switch(a.uintval&0x7)
+	switch(getAtomType(a))
 	{
 		case ATOM_INVALID_UNDEFINED_NULL_BOOL:
 		{
@@ -3431,7 +3733,7 @@ bool asAtomHandler::Boolean_concrete_string(asAtom &a)
 void asAtomHandler::convert_b(asAtom& a, bool refcounted)
 {
 	bool v = false;
-	switch(a.uintval&0x7)
+	switch(getAtomType(a))
 	{
 		case ATOM_INVALID_UNDEFINED_NULL_BOOL:
 		{
@@ -3457,6 +3759,15 @@ void asAtomHandler::convert_b(asAtom& a, bool refcounted)
 		case ATOM_STRINGID:
 			v = a.uintval>>3 != BUILTIN_STRINGS::EMPTY;
 			break;
+		case ATOM_NUMBERPTR:
+			if (isInlineNumber(a))
+			{
+				number_t n = getInlineNumber(a);
+				v = n != 0.0 && !std::isnan(n);
+				break;
+			}
+			v= lightspark::Boolean_concrete(getObject(a));
+			break;
 		default:
 			v= lightspark::Boolean_concrete(getObject(a));
 			break;
@@ -3498,6 +3809,18 @@ bool asAtomHandler::add(asAtom& a, asAtom &v2, ASWorker* wrk, bool forceint)
 	}
 	else if(isString(a) || isString(v2))
 	{
+		if (!forceint && getAtomType(a) == ATOM_STRINGPTR)
+		{
+			// long concatenations are appended to a shared builder to avoid copying the whole string every time
+			// the debug string is logged, as converting the left operand to a string would flatten the builder
+			LOG_CALL("add concatenated " << toDebugString(a) << '+' << toString(v2,wrk));
+			ASString* res = getObjectNoCheck(a)->as<ASString>()->concatenate(wrk,toString(v2,wrk));
+			if (res)
+			{
+				a.uintval = (LIGHTSPARK_ATOM_VALTYPE)(res)|ATOM_STRINGPTR;
+				return true;
+			}
+		}
 		tiny_string sa = toString(a,wrk);
 		sa += toString(v2,wrk);
 		LOG_CALL("add " << toString(a,wrk) << '+' << toString(v2,wrk));
@@ -3620,6 +3943,19 @@ void asAtomHandler::addreplace(asAtom& ret, ASWorker* wrk, asAtom& v1, asAtom &v
 	}
 	else if(isString(v1) || isString(v2))
 	{
+		if (!forceint && getAtomType(v1) == ATOM_STRINGPTR)
+		{
+			// long concatenations are appended to a shared builder to avoid copying the whole string every time
+			// the debug string is logged, as converting the left operand to a string would flatten the builder
+			LOG_CALL("add replace concatenated " << toDebugString(v1) << '+' << toString(v2,wrk));
+			ASString* res = getObjectNoCheck(v1)->as<ASString>()->concatenate(wrk,toString(v2,wrk));
+			if (res)
+			{
+				ASATOM_DECREF(ret);
+				ret.uintval = (LIGHTSPARK_ATOM_VALTYPE)(res)|ATOM_STRINGPTR;
+				return;
+			}
+		}
 		tiny_string sa = toString(v1,wrk);
 		sa += toString(v2,wrk);
 		LOG_CALL("add replace " << toString(v1,wrk) << '+' << toString(v2,wrk));
@@ -3710,9 +4046,9 @@ void asAtomHandler::addreplace(asAtom& ret, ASWorker* wrk, asAtom& v1, asAtom &v
 	}
 }
 
-void asAtomHandler::serialize(ByteArray* out, std::map<tiny_string, uint32_t>& stringMap, std::map<const ASObject*, uint32_t>& objMap, std::map<const Class_base*, uint32_t>& traitsMap, ASWorker* wrk, asAtom& a)
+void asAtomHandler::serialize(ByteArray* out, amf3stringtable& stringMap, amf3objecttable& objMap, amf3traitstable& traitsMap, ASWorker* wrk, asAtom& a)
 {
-	switch (a.uintval&0x7)
+	switch(getAtomType(a))
 	{
 		case ATOM_INTEGER:
 			Integer::serializeValue(out,asAtomHandler::getInt(a));
@@ -3720,6 +4056,9 @@ void asAtomHandler::serialize(ByteArray* out, std::map<tiny_string, uint32_t>& s
 		case ATOM_UINTEGER:
 			UInteger::serializeValue(out,asAtomHandler::getUInt(a));
 			break;
+		case ATOM_NUMBERPTR:
+			Number::serializeValue(out,asAtomHandler::getNumber(a));
+			break;
 		case ATOM_INVALID_UNDEFINED_NULL_BOOL:
 			switch (a.uintval&0xf0)
 			{
@@ -3783,6 +4122,10 @@ bool asAtomHandler::Boolean_concrete_object(asAtom& a)
 
 void asAtomHandler::setNumber(asAtom& a, ASWorker* w, number_t val)
 {
+#ifdef LIGHTSPARK_ATOM_NANBOXING
+	setInlineNumber(a,val);
+	return;
+#endif
 	if (std::isnan(val))
 		a.uintval = w->getSystemState()->nanAtom.uintval;
 	else
@@ -3790,6 +4133,11 @@ void asAtomHandler::setNumber(asAtom& a, ASWorker* w, number_t val)
 }
 bool asAtomHandler::replaceNumber(asAtom& a, ASWorker* w, number_t val)
 {
+#ifdef LIGHTSPARK_ATOM_NANBOXING
+	// no Number object is needed, so the caller can always release the previous value
+	setInlineNumber(a,val);
+	return true;
+#endif
 	if (isNumber(a) && getObject(a)->isLastRef())
 	{
 		as<Number>(a)->setNumber(val);
@@ -3835,13 +4183,42 @@ void asAtomHandler::replace(asAtom& a, ASObject *obj)
 	}
 }
 
+// converts the operand compared against an inline Number the way Number::isLess does, without boxing the Number
+static number_t comparisonOperandToNumber(asAtom& o)
+{
+	if (asAtomHandler::isInlineNumber(o) || !asAtomHandler::isObject(o))
+		return asAtomHandler::toNumber(o);
+	ASObject* obj = asAtomHandler::getObjectNoCheck(o);
+	switch (obj->getObjectType())
+	{
+		case T_NUMBER:
+		case T_INTEGER:
+		case T_UINTEGER:
+		case T_BOOLEAN:
+		case T_STRING:
+		case T_NULL:
+		case T_UNDEFINED:
+			return obj->toNumber();
+		default:
+		{
+			asAtom primitive=asAtomHandler::invalidAtom;
+			bool isrefcounted;
+			obj->toPrimitive(primitive,isrefcounted,NUMBER_HINT);
+			number_t res = asAtomHandler::toNumber(primitive);
+			if (isrefcounted)
+				ASATOM_DECREF(primitive);
+			return res;
+		}
+	}
+}
+
 TRISTATE asAtomHandler::isLessIntern(asAtom& a, ASWorker* w, asAtom &v2)
 {
-	switch(a.uintval&0x7)
+	switch(getAtomType(a))
 	{
 		case ATOM_INTEGER:
 		{
-			switch (v2.uintval&0x7)
+			switch(getAtomType(v2))
 			{
 				case ATOM_INTEGER:
 					return (a.intval < v2.intval)?TTRUE:TFALSE;
@@ -3872,7 +4249,7 @@ TRISTATE asAtomHandler::isLessIntern(asAtom& a, ASWorker* w, asAtom &v2)
 		}
 		case ATOM_UINTEGER:
 		{
-			switch (v2.uintval&0x7)
+			switch(getAtomType(v2))
 			{
 				case ATOM_INTEGER:
 					return ((v2.intval>>3) > 0 && ((a.uintval>>3) < (uint32_t)(v2.intval>>3)))?TTRUE:TFALSE;
@@ -3905,7 +4282,7 @@ TRISTATE asAtomHandler::isLessIntern(asAtom& a, ASWorker* w, asAtom &v2)
 		{
 			if(std::isnan(toNumber(a)))
 				return TUNDEFINED;
-			switch (v2.uintval&0x7)
+			switch(getAtomType(v2))
 			{
 				case ATOM_INTEGER:
 					return (toNumber(a) < (v2.intval>>3))?TTRUE:TFALSE;
@@ -3942,7 +4319,7 @@ TRISTATE asAtomHandler::isLessIntern(asAtom& a, ASWorker* w, asAtom &v2)
 			{
 				case ATOMTYPE_NULL_BIT:
 				{
-					switch (v2.uintval&0x7)
+					switch(getAtomType(v2))
 					{
 						case ATOM_INTEGER:
 							return (0 < (v2.intval>>3))?TTRUE:TFALSE;
@@ -3976,7 +4353,7 @@ TRISTATE asAtomHandler::isLessIntern(asAtom& a, ASWorker* w, asAtom &v2)
 					return TUNDEFINED;
 				case ATOMTYPE_BOOL_BIT:
 				{
-					switch (v2.uintval&0x7)
+					switch(getAtomType(v2))
 					{
 						case ATOM_INTEGER:
 							return ((int32_t)(a.uintval&0x80)>>7 < (v2.intval>>3))?TTRUE:TFALSE;
@@ -4012,7 +4389,7 @@ TRISTATE asAtomHandler::isLessIntern(asAtom& a, ASWorker* w, asAtom &v2)
 		}
 		case ATOM_STRINGID:
 		{
-			switch (v2.uintval&0x7)
+			switch(getAtomType(v2))
 			{
 				case ATOM_STRINGID:
 					if (((a.uintval>>3) < BUILTIN_STRINGS_CHAR_MAX) && ((v2.uintval>>3) < BUILTIN_STRINGS_CHAR_MAX))
@@ -4022,6 +4399,14 @@ TRISTATE asAtomHandler::isLessIntern(asAtom& a, ASWorker* w, asAtom &v2)
 				case ATOM_UINTEGER:
 				case ATOM_STRINGPTR:
 					return toString(a,w) < toString(v2,w) ? TTRUE : TFALSE;
+				case ATOM_NUMBERPTR:
+				{
+					number_t num1 = toNumber(a);
+					number_t num2 = toNumber(v2);
+					if(std::isnan(num1) || std::isnan(num2))
+						return TUNDEFINED;
+					return (num1 < num2)?TTRUE:TFALSE;
+				}
 				case ATOM_INVALID_UNDEFINED_NULL_BOOL:
 				{
 					switch (v2.uintval&0x70)
@@ -4054,7 +4439,7 @@ TRISTATE asAtomHandler::isLessIntern(asAtom& a, ASWorker* w, asAtom &v2)
 		}
 		case ATOM_STRINGPTR:
 		{
-			switch (v2.uintval&0x7)
+			switch(getAtomType(v2))
 			{
 				case ATOM_INTEGER:
 				case ATOM_UINTEGER:
@@ -4069,7 +4454,7 @@ TRISTATE asAtomHandler::isLessIntern(asAtom& a, ASWorker* w, asAtom &v2)
 		}
 		case ATOM_U_INTEGERPTR:
 		{
-			switch (v2.uintval&0x7)
+			switch(getAtomType(v2))
 			{
 				case ATOM_INTEGER:
 					return (toInt(a) < (v2.intval>>3))?TTRUE:TFALSE;
@@ -4100,7 +4485,7 @@ TRISTATE asAtomHandler::isLessIntern(asAtom& a, ASWorker* w, asAtom &v2)
 		}
 		case ATOM_OBJECTPTR:
 		{
-			switch (v2.uintval&0x7)
+			switch(getAtomType(v2))
 			{
 				case ATOM_INVALID_UNDEFINED_NULL_BOOL:
 				case ATOM_STRINGID:
@@ -4126,6 +4511,22 @@ TRISTATE asAtomHandler::isLessIntern(asAtom& a, ASWorker* w, asAtom &v2)
 		default:
 			break;
 	}
+	if (isInlineNumber(a))
+	{
+		// compare the unboxed values directly, following Number::isLess
+		number_t d1 = getInlineNumber(a);
+		if (std::isnan(d1))
+			return TUNDEFINED;
+		number_t d2 = comparisonOperandToNumber(v2);
+		if (std::isnan(d2))
+			return TUNDEFINED;
+		return (d1<d2)?TTRUE:TFALSE;
+	}
+	if (isInlineNumber(v2))
+	{
+		assert(getObject(a));
+		return getObject(a)->isLessAtom(v2);
+	}
 	assert(getObject(a));
 	assert(getObject(v2));
 	return getObject(a)->isLess(getObject(v2));
@@ -4133,11 +4534,11 @@ TRISTATE asAtomHandler::isLessIntern(asAtom& a, ASWorker* w, asAtom &v2)
 
 bool asAtomHandler::isEqualIntern(asAtom& a, ASWorker* w, asAtom &v2)
 {
-	switch (a.uintval&0x7)
+	switch(getAtomType(a))
 	{
 		case ATOM_INTEGER:
 		{
-			switch (v2.uintval&0x7)
+			switch(getAtomType(v2))
 			{
 				case ATOM_INTEGER:
 					return false;
@@ -4170,7 +4571,7 @@ bool asAtomHandler::isEqualIntern(asAtom& a, ASWorker* w, asAtom &v2)
 		}
 		case ATOM_UINTEGER:
 		{
-			switch (v2.uintval&0x7)
+			switch(getAtomType(v2))
 			{
 				case ATOM_INTEGER:
 					return (v2.intval>>3) >= 0 && (a.uintval>>3)==toUInt(v2);
@@ -4203,7 +4604,7 @@ bool asAtomHandler::isEqualIntern(asAtom& a, ASWorker* w, asAtom &v2)
 		}
 		case ATOM_NUMBERPTR:
 		{
-			switch (v2.uintval&0x7)
+			switch(getAtomType(v2))
 			{
 				case ATOM_INTEGER:
 				case ATOM_UINTEGER:
@@ -4228,13 +4629,15 @@ bool asAtomHandler::isEqualIntern(asAtom& a, ASWorker* w, asAtom &v2)
 					}
 				}
 				default:
+					if (isInlineNumber(a))
+						break;
 					return toObject(v2,w)->isEqual(toObject(a,w));
 			}
 			break;
 		}
 		case ATOM_U_INTEGERPTR:
 		{
-			switch (v2.uintval&0x7)
+			switch(getAtomType(v2))
 			{
 				case ATOM_INTEGER:
 				case ATOM_UINTEGER:
@@ -4271,7 +4674,7 @@ bool asAtomHandler::isEqualIntern(asAtom& a, ASWorker* w, asAtom &v2)
 				case ATOMTYPE_NULL_BIT:
 				case ATOMTYPE_UNDEFINED_BIT:
 				{
-					switch (v2.uintval&0x7)
+					switch(getAtomType(v2))
 					{
 						case ATOM_INVALID_UNDEFINED_NULL_BOOL:
 						{
@@ -4295,7 +4698,7 @@ bool asAtomHandler::isEqualIntern(asAtom& a, ASWorker* w, asAtom &v2)
 					}
 				}
 				case ATOMTYPE_BOOL_BIT:
-					switch (v2.uintval&0x7)
+					switch(getAtomType(v2))
 					{
 						case ATOM_STRINGID:
 							return (bool)((a.uintval&0x80)>>7)==toNumber(v2);
@@ -4325,7 +4728,7 @@ bool asAtomHandler::isEqualIntern(asAtom& a, ASWorker* w, asAtom &v2)
 		}
 		case ATOM_STRINGID:
 		{
-			switch (v2.uintval&0x7)
+			switch(getAtomType(v2))
 			{
 				case ATOM_INVALID_UNDEFINED_NULL_BOOL:
 				{
@@ -4353,7 +4756,7 @@ bool asAtomHandler::isEqualIntern(asAtom& a, ASWorker* w, asAtom &v2)
 		}
 		case ATOM_STRINGPTR:
 		{
-			switch (v2.uintval&0x7)
+			switch(getAtomType(v2))
 			{
 				case ATOM_INVALID_UNDEFINED_NULL_BOOL:
 				{
@@ -4388,7 +4791,7 @@ bool asAtomHandler::isEqualIntern(asAtom& a, ASWorker* w, asAtom &v2)
 				else
 					return false;
 			}
-			switch (v2.uintval&0x7)
+			switch(getAtomType(v2))
 			{
 				case ATOM_INVALID_UNDEFINED_NULL_BOOL:
 					return getObject(a)->isEqual(toObject(v2,w));
@@ -4414,6 +4817,52 @@ bool asAtomHandler::isEqualIntern(asAtom& a, ASWorker* w, asAtom &v2)
 		default:
 			break;
 	}
+	if (isInlineNumber(a) || isInlineNumber(v2))
+	{
+		// compare the unboxed value directly, following Number::isEqual
+		asAtom& num = isInlineNumber(a) ? a : v2;
+		asAtom& other = isInlineNumber(a) ? v2 : a;
+		number_t d = getInlineNumber(num);
+		if (isInlineNumber(other))
+			return d == getInlineNumber(other);
+		if (!isObject(other))
+		{
+			if (isNull(other) || isUndefined(other))
+				return false;
+			return d == toNumber(other);
+		}
+		ASObject* o = getObjectNoCheck(other);
+		switch (o->getObjectType())
+		{
+			case T_NUMBER:
+			case T_INTEGER:
+			case T_UINTEGER:
+			case T_BOOLEAN:
+			case T_STRING:
+				return d == o->toNumber();
+			case T_NULL:
+			case T_UNDEFINED:
+				return false;
+			default:
+				break;
+		}
+		if (o->is<XML>() || o->is<XMLList>())
+		{
+			// XML compares its content against the Number's string representation
+			ASObject* n = abstract_d(w,d);
+			bool ret = o->isEqual(n);
+			n->decRef();
+			return ret;
+		}
+		asAtom primitive=asAtomHandler::invalidAtom;
+		bool res=false;
+		bool isrefcounted;
+		if (o->toPrimitive(primitive,isrefcounted))
+			res = isEqual(primitive,w,num);
+		if (isrefcounted)
+			ASATOM_DECREF(primitive);
+		return res;
+	}
 	assert(getObject(a));
 	assert(getObject(v2));
 	return getObject(a)->isEqual(getObject(v2));
@@ -4426,7 +4875,7 @@ ASObject *asAtomHandler::toObject(asAtom& a, ASWorker* wrk, bool isconstant)
 		assert(getObjectNoCheck(a) && getObjectNoCheck(a)->getRefCount() >= 1);
 		return getObjectNoCheck(a);
 	}
-	switch(a.uintval&0x7)
+	switch(getAtomType(a))
 	{
 		case ATOM_INTEGER:
 			// ints are internally treated as numbers, so create a Number instance
@@ -4454,6 +4903,10 @@ ASObject *asAtomHandler::toObject(asAtom& a, ASWorker* wrk, bool isconstant)
 		case ATOM_STRINGID:
 			a.uintval = ((LIGHTSPARK_ATOM_VALTYPE)abstract_s(wrk,(a.uintval>>3))) | ATOM_STRINGPTR ;
 			break;
+		case ATOM_NUMBERPTR:
+			// Number is stored inline, so create a Number instance
+			a.uintval = ((LIGHTSPARK_ATOM_VALTYPE)(isconstant ? abstract_d_constant(wrk,getInlineNumber(a)) : abstract_d(wrk,getInlineNumber(a))))|ATOM_NUMBERPTR;
+			break;
 		default:
 			throw RunTimeException("calling toObject on invalid asAtom, should not happen");
 			break;
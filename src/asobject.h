@@ -21,6 +21,7 @@
 #define ASOBJECT_H 1
 
 #include "swftypes.h"
+#include "parsing/amf3_reftable.h"
 #include <unordered_map>
 #include <unordered_set>
 #include <limits>
@@ -285,16 +286,36 @@ class EventDispatcher;
 class MouseEvent;
 class Event;
 
+// initial and maximum number of objects kept in a freelist
 #define FREELIST_SIZE 16
+#define FREELIST_MAX_SIZE 1024
+/*
+ * recycled objects of one class, there is one list per class in every ASWorker.
+ * The depth of the list adapts to the allocation pattern of the class:
+ * it is doubled every time an object has to be deleted because the list is full,
+ * and trim() releases the objects that were not needed since the last call.
+ * The objects themselves are still allocated one by one through memory_reporter,
+ * there is no size class slab behind the list
+ */
 struct asfreelist
 {
-	ASObject* freelist[FREELIST_SIZE];
+	ASObject** freelist;
 	int freelistsize;
-	asfreelist():freelistsize(0) {}
+	// current depth of the list
+	int freelistcapacity;
+	// smallest size of the list since the last trim()
+	int lowwatermark;
+	// statistics
+	uint64_t allocations; // objects requested from the list
+	uint64_t reused; // objects taken from the list
+	uint64_t overflows; // objects deleted because the list was full
+	asfreelist():freelist(nullptr),freelistsize(0),freelistcapacity(0),lowwatermark(0),allocations(0),reused(0),overflows(0) {}
 	~asfreelist();
 
 	inline ASObject* getObjectFromFreeList();
 	inline bool pushObjectToFreeList(ASObject *obj);
+	bool growFreeList();
+	void trim();
 };
 
 extern SystemState* getSys();
@@ -337,6 +358,23 @@ union asAtom
 // dddd d011: int
 // dddd d111: (U)Integer
 // dddd d100: ASObject
+//
+// on 64bit architectures Numbers are not stored as pointers to Number objects, but inline in the atom (NaN-boxing):
+// all atoms described above have the upper 16 bits either all cleared (pointers, non-negative values)
+// or all set (negative ints), so every other bit pattern can be used to store the raw bits of a double.
+// doubles are stored with an offset of ATOM_NUMBER_OFFSET added to their raw bits, which moves them out of the ranges used by the other atoms.
+// NaNs are always stored as ATOM_NUMBER_CANONICAL_NAN, so no double is mapped to the "all upper bits set" range
+// Number objects may still be found in atoms with ATOM_NUMBERPTR type (e.g. after calling toObject()),
+// so always use getNumber() instead of accessing the Number object directly
+#ifdef LIGHTSPARK_64
+#define LIGHTSPARK_ATOM_NANBOXING
+#define ATOM_NUMBER_OFFSET 0x0001000000000000ULL
+#define ATOM_NUMBER_CANONICAL_NAN 0x7ff8000000000000ULL
+// mask to check that an atom is not an inline Number
+#define ATOM_NONNUMBER_MASK 0xffff000000000000ULL
+#else
+#define ATOM_NONNUMBER_MASK 0x0
+#endif
 enum ATOM_TYPE 
 { 
 	ATOM_INVALID_UNDEFINED_NULL_BOOL=0x0, 
@@ -424,7 +462,11 @@ public:
 	static FORCE_INLINE asAtom fromNumber(ASWorker* wrk, number_t val,bool constant)
 	{
 		asAtom a=asAtomHandler::invalidAtom;
+#ifdef LIGHTSPARK_ATOM_NANBOXING
+		setInlineNumber(a,val);
+#else
 		a.uintval =((LIGHTSPARK_ATOM_VALTYPE)(constant ? abstract_d_constant(wrk,val) : abstract_d(wrk,val))|ATOM_NUMBERPTR);
+#endif
 		return a;
 	}
 	
@@ -496,15 +538,27 @@ public:
 	static FORCE_INLINE bool isNumber(const asAtom& a); 
 	static FORCE_INLINE bool isValid(const asAtom& a) { return a.uintval; }
 	static FORCE_INLINE bool isInvalid(const asAtom& a) { return !a.uintval; }
-	static FORCE_INLINE bool isNull(const asAtom& a) { return (a.uintval&0x7f) == ATOMTYPE_NULL_BIT; }
-	static FORCE_INLINE bool isUndefined(const asAtom& a) { return (a.uintval&0x7f) == ATOMTYPE_UNDEFINED_BIT; }
-	static FORCE_INLINE bool isBool(const asAtom& a) { return (a.uintval&0x7f) == ATOMTYPE_BOOL_BIT; }
+	static FORCE_INLINE bool isNull(const asAtom& a) { return (a.uintval&(ATOM_NONNUMBER_MASK|0x7f)) == ATOMTYPE_NULL_BIT; }
+	static FORCE_INLINE bool isUndefined(const asAtom& a) { return (a.uintval&(ATOM_NONNUMBER_MASK|0x7f)) == ATOMTYPE_UNDEFINED_BIT; }
+	static FORCE_INLINE bool isBool(const asAtom& a) { return (a.uintval&(ATOM_NONNUMBER_MASK|0x7f)) == ATOMTYPE_BOOL_BIT; }
 	static FORCE_INLINE bool isInteger(const asAtom& a);
 	static FORCE_INLINE bool isUInteger(const asAtom& a);
-	static FORCE_INLINE bool isObject(const asAtom& a) { return a.uintval & ATOMTYPE_OBJECT_BIT; }
+	static FORCE_INLINE bool isObject(const asAtom& a) { return (a.uintval&(ATOM_NONNUMBER_MASK|ATOMTYPE_OBJECT_BIT)) == ATOMTYPE_OBJECT_BIT; }
+	// true if this atom contains a Number stored directly in the atom
+	static FORCE_INLINE bool isInlineNumber(const asAtom& a)
+	{
+#ifdef LIGHTSPARK_ATOM_NANBOXING
+		// upper 16 bits are neither 0x0000 nor 0xffff
+		return ((a.uintval+ATOM_NUMBER_OFFSET)>>49) != 0;
+#else
+		return false;
+#endif
+	}
+	// returns the ATOM_TYPE of this atom, inline Numbers are reported as ATOM_NUMBERPTR
+	static FORCE_INLINE uint32_t getAtomType(const asAtom& a) { return isInlineNumber(a) ? (uint32_t)ATOM_NUMBERPTR : (uint32_t)(a.uintval&0x7); }
 	static FORCE_INLINE bool isFunction(const asAtom& a);
 	static FORCE_INLINE bool isString(const asAtom& a);
-	static FORCE_INLINE bool isStringID(const asAtom& a) { return (a.uintval&0x7) == ATOM_STRINGID; }
+	static FORCE_INLINE bool isStringID(const asAtom& a) { return (a.uintval&(ATOM_NONNUMBER_MASK|0x7)) == ATOM_STRINGID; }
 	static FORCE_INLINE bool isQName(const asAtom& a);
 	static FORCE_INLINE bool isNamespace(const asAtom& a);
 	static FORCE_INLINE bool isArray(const asAtom& a);
@@ -530,9 +584,34 @@ public:
 	static bool Boolean_concrete(asAtom& a);
 	static bool Boolean_concrete_object(asAtom& a);
 	static void convert_b(asAtom& a, bool refcounted);
-	static FORCE_INLINE int32_t getInt(const asAtom& a) { assert((a.uintval&0x7) == ATOM_INTEGER || (a.uintval&0x7) == ATOM_UINTEGER); return a.intval>>3; }
-	static FORCE_INLINE uint32_t getUInt(const asAtom& a) { assert((a.uintval&0x7) == ATOM_UINTEGER || (a.uintval&0x7) == ATOM_INTEGER); return a.uintval>>3; }
-	static FORCE_INLINE uint32_t getStringId(const asAtom& a) { assert((a.uintval&0x7) == ATOM_STRINGID); return a.uintval>>3; }
+	static FORCE_INLINE int32_t getInt(const asAtom& a) { assert(getAtomType(a) == ATOM_INTEGER || getAtomType(a) == ATOM_UINTEGER); return a.intval>>3; }
+	static FORCE_INLINE uint32_t getUInt(const asAtom& a) { assert(getAtomType(a) == ATOM_UINTEGER || getAtomType(a) == ATOM_INTEGER); return a.uintval>>3; }
+	static FORCE_INLINE uint32_t getStringId(const asAtom& a) { assert(getAtomType(a) == ATOM_STRINGID); return a.uintval>>3; }
+	static FORCE_INLINE number_t getInlineNumber(const asAtom& a)
+	{
+		assert(isInlineNumber(a));
+#ifdef LIGHTSPARK_ATOM_NANBOXING
+		union { uint64_t u; number_t d; } v;
+		v.u = a.uintval-ATOM_NUMBER_OFFSET;
+		return v.d;
+#else
+		return 0;
+#endif
+	}
+	// returns the value of an atom of type ATOM_NUMBERPTR
+	static FORCE_INLINE number_t getNumber(const asAtom& a);
+	static FORCE_INLINE void setInlineNumber(asAtom& a, number_t val)
+	{
+#ifdef LIGHTSPARK_ATOM_NANBOXING
+		union { uint64_t u; number_t d; } v;
+		v.d = val;
+		a.uintval = (std::isnan(val) ? ATOM_NUMBER_CANONICAL_NAN : v.u)+ATOM_NUMBER_OFFSET;
+#else
+		assert(false);
+#endif
+	}
+	// implements ECMA-262 9.5 ToInt32 for Numbers not stored in a Number object
+	static int32_t numberToInt(number_t val);
 	static FORCE_INLINE void setInt(asAtom& a,ASWorker* wrk, int64_t val);
 	static FORCE_INLINE void setUInt(asAtom& a, ASWorker* wrk, uint32_t val);
 	static void setNumber(asAtom& a,ASWorker* w,number_t val);
@@ -567,9 +646,9 @@ public:
 	static FORCE_INLINE void add_i(asAtom& a,ASWorker* wrk,asAtom& v2);
 	static FORCE_INLINE void subtract_i(asAtom& a,ASWorker* wrk,asAtom& v2);
 	static FORCE_INLINE void multiply_i(asAtom& a,ASWorker* wrk,asAtom& v2);
-	static void serialize(ByteArray* out, std::map<tiny_string, uint32_t>& stringMap,
-						  std::map<const ASObject*, uint32_t>& objMap,
-						  std::map<const Class_base*, uint32_t>& traitsMap, ASWorker* wrk,
+	static void serialize(ByteArray* out, amf3stringtable& stringMap,
+						  amf3objecttable& objMap,
+						  amf3traitstable& traitsMap, ASWorker* wrk,
 						  asAtom& a);
 	template<class T> static bool is(asAtom& a);
 	template<class T> static T* as(asAtom& a) 
@@ -631,9 +710,15 @@ struct garbagecollectorstate
 	std::unordered_map<ASObject*,cyclicmembercount> checkedobjects;
 	std::unordered_set<ASObject*> ancestors;
 	std::unordered_set<ASObject*> countedobjects;
+	// all candidates of a batch that is checked with one traversal, empty if a single candidate is checked
+	std::unordered_set<ASObject*> startobjs;
 	ASObject* startobj;
 	int level;
 	int incCount(ASObject* o);
+	FORCE_INLINE bool isStartObject(ASObject* o) const
+	{
+		return o==startobj || (!startobjs.empty() && startobjs.find(o)!=startobjs.end());
+	}
 	FORCE_INLINE bool checkAncestors(ASObject* o)
 	{
 		return ancestors.find(o)!=ancestors.end();
@@ -641,6 +726,16 @@ struct garbagecollectorstate
 	garbagecollectorstate(ASObject* _startobj):startobj(_startobj),level(0)
 	{
 	}
+	// prepares the state for the next candidate, the containers keep their allocated buckets
+	void reset(ASObject* _startobj)
+	{
+		checkedobjects.clear();
+		ancestors.clear();
+		countedobjects.clear();
+		startobjs.clear();
+		startobj=_startobj;
+		level=0;
+	}
 };
 
 struct varName
@@ -666,19 +761,196 @@ struct varName
 	}
 };
 
+/*
+ * Layout of the declared variables of a class, shared by all instances created from the instancefactory of the class.
+ * The variables are ordered by name, so all variables with the same name are adjacent and can be found with a single lookup
+ */
+class variables_shape
+{
+	ATOMIC_INT32(refcount);
+	static std::atomic<uint32_t> nextid;
+public:
+	typedef std::pair<const uint32_t,variable> entry;
+	// initial values of the variables, in layout order
+	std::vector<entry> prototype;
+	// nameId -> position and number of the variables with this name
+	std::unordered_map<uint32_t,std::pair<uint32_t,uint32_t>> nameindex;
+	uint32_t slotcount;
+	// unique id of this shape, never reused, so it can be cached without keeping the shape alive
+	const uint32_t id;
+	// revision of the variables_storage this shape was built from
+	uint32_t sourcerevision;
+	variables_shape():refcount(1),slotcount(0),id(++nextid),sourcerevision(0) {}
+	void incRef() { ++refcount; }
+	void decRef()
+	{
+		if (--refcount == 0)
+			delete this;
+	}
+};
+
+/*
+ * Storage of the variables of an object.
+ * Objects created from a shape keep their declared variables in a flat array laid out by the shape,
+ * all other variables are stored in a hash map.
+ * The interface mimics the unordered_multimap that was used before, so iterating over all variables
+ * or over all variables with the same name works as before.
+ */
+class variables_storage
+{
+public:
+	typedef std::unordered_multimap<uint32_t,variable> dynamicType;
+	typedef variables_shape::entry value_type;
+	template<bool isconst>
+	class iterator_base
+	{
+	friend class variables_storage;
+	public:
+		typedef typename std::conditional<isconst,const value_type,value_type>::type V;
+		typedef typename std::conditional<isconst,dynamicType::const_iterator,dynamicType::iterator>::type mapIterator;
+	private:
+		// current position in the flat array, nullptr if iterating over the hash map
+		V* pos;
+		V* posend;
+		// position in the hash map to continue with when the flat array is done
+		mapIterator it;
+		iterator_base(V* _pos, V* _posend, mapIterator _it):pos(_pos),posend(_posend),it(_it)
+		{
+			skipRemoved();
+		}
+		void skipRemoved()
+		{
+			while (pos != posend && pos->second.kind==NO_CREATE_TRAIT)
+				++pos;
+			if (pos == posend)
+				pos = posend = nullptr;
+		}
+	public:
+		iterator_base():pos(nullptr),posend(nullptr) {}
+		template<bool c=isconst, typename std::enable_if<c,int>::type = 0>
+		iterator_base(const iterator_base<false>& o):pos(o.pos),posend(o.posend),it(o.it) {}
+		V& operator*() const { return pos ? *pos : *it; }
+		V* operator->() const { return pos ? pos : &(*it); }
+		iterator_base& operator++()
+		{
+			if (pos)
+			{
+				++pos;
+				skipRemoved();
+			}
+			else
+				++it;
+			return *this;
+		}
+		iterator_base operator++(int)
+		{
+			iterator_base ret=*this;
+			++(*this);
+			return ret;
+		}
+		friend bool operator==(const iterator_base& a, const iterator_base& b)
+		{
+			return a.pos ? a.pos==b.pos : (b.pos==nullptr && a.it==b.it);
+		}
+		friend bool operator!=(const iterator_base& a, const iterator_base& b)
+		{
+			return !(a==b);
+		}
+		template<bool c> friend class iterator_base;
+	};
+	typedef iterator_base<false> iterator;
+	typedef iterator_base<true> const_iterator;
+private:
+	variables_shape* shape;
+	std::vector<value_type> flat;
+	uint32_t flatcount;
+	// incremented whenever variables are added or removed
+	uint32_t revision;
+	dynamicType dynamic;
+	value_type* flatBegin() { return flat.empty() ? nullptr : flat.data(); }
+	const value_type* flatBegin() const { return flat.empty() ? nullptr : flat.data(); }
+public:
+	variables_storage():shape(nullptr),flatcount(0),revision(0) {}
+	~variables_storage()
+	{
+		if (shape)
+			shape->decRef();
+	}
+	iterator begin() { return iterator(flatBegin(),flatBegin()+flat.size(),dynamic.begin()); }
+	iterator end() { return iterator(nullptr,nullptr,dynamic.end()); }
+	const_iterator begin() const { return const_iterator(flatBegin(),flatBegin()+flat.size(),dynamic.cbegin()); }
+	const_iterator end() const { return const_iterator(nullptr,nullptr,dynamic.cend()); }
+	const_iterator cbegin() const { return begin(); }
+	const_iterator cend() const { return end(); }
+	FORCE_INLINE iterator find(uint32_t nameId)
+	{
+		if (shape)
+		{
+			auto it = shape->nameindex.find(nameId);
+			if (it != shape->nameindex.end())
+			{
+				value_type* p = flat.data()+it->second.first;
+				return iterator(p,p+it->second.second,dynamic.find(nameId));
+			}
+		}
+		return iterator(nullptr,nullptr,dynamic.find(nameId));
+	}
+	FORCE_INLINE const_iterator find(uint32_t nameId) const
+	{
+		if (shape)
+		{
+			auto it = shape->nameindex.find(nameId);
+			if (it != shape->nameindex.end())
+			{
+				const value_type* p = flat.data()+it->second.first;
+				return const_iterator(p,p+it->second.second,dynamic.find(nameId));
+			}
+		}
+		return const_iterator(nullptr,nullptr,dynamic.find(nameId));
+	}
+	// new variables are always added to the hash map
+	iterator insert(const_iterator /*hint*/, const value_type& v) { ++revision; return iterator(nullptr,nullptr,dynamic.insert(v)); }
+	iterator insert(const value_type& v) { ++revision; return iterator(nullptr,nullptr,dynamic.insert(v)); }
+	iterator erase(iterator it);
+	// returns the variable at position index of the flat layout, nullptr if this storage doesn't use the shape with the given id or the variable was removed
+	FORCE_INLINE variable* getFlatVar(uint32_t shapeid, uint32_t index)
+	{
+		if (!shape || shape->id != shapeid)
+			return nullptr;
+		variable* v = &flat[index].second;
+		return v->kind==NO_CREATE_TRAIT ? nullptr : v;
+	}
+	// gets the shape id and the position of v in the flat layout, returns false if v is not stored in the flat layout
+	bool getFlatIndex(const variable* v, uint32_t& shapeid, uint32_t& index) const;
+	// moves the variables of the flat layout to the hash map if most of them were removed, returns true if the variables were moved
+	bool compact();
+	uint32_t getRevision() const { return revision; }
+	FORCE_INLINE size_t size() const { return flatcount+dynamic.size(); }
+	FORCE_INLINE bool empty() const { return size()==0; }
+	void reserve(size_t n) { dynamic.reserve(n); }
+	variables_shape* getShape() const { return shape; }
+	// creates a new shape from the variables of this storage
+	variables_shape* buildShape() const;
+	// initializes the variables of an empty storage with the layout and values of the shape
+	void initFromShape(variables_shape* s);
+	void clear();
+};
+
 class variables_map
 {
 public:
 	//Names are represented by strings in the string and namespace pools
-	typedef std::unordered_multimap<uint32_t,variable> mapType;
+	typedef variables_storage mapType;
 	mapType Variables;
-	typedef std::unordered_multimap<uint32_t,variable>::iterator var_iterator;
-	typedef std::unordered_multimap<uint32_t,variable>::const_iterator const_var_iterator;
+	typedef variables_storage::iterator var_iterator;
+	typedef variables_storage::const_iterator const_var_iterator;
 	std::vector<variable*> slots_vars;
 	uint32_t slotcount;
 	// indicates if this map was initialized with no variables with non-primitive values
 	bool cloneable;
-	variables_map():slotcount(0),cloneable(true)
+	// layout of the instances cloned from this map, the variables of this map are not stored in it
+	variables_shape* instanceshape;
+	variables_map():slotcount(0),cloneable(true),instanceshape(nullptr)
 	{
 	}
 	/**
@@ -825,14 +1097,16 @@ public:
 	int getNextEnumerable(unsigned int i) const;
 	~variables_map();
 	void check() const;
-	void serialize(ByteArray* out, std::map<tiny_string, uint32_t>& stringMap,
-				std::map<const ASObject*, uint32_t>& objMap,
-				std::map<const Class_base*, uint32_t>& traitsMap, bool forsharedobject, ASWorker* wrk);
+	void serialize(ByteArray* out, amf3stringtable& stringMap,
+				amf3objecttable& objMap,
+				amf3traitstable& traitsMap, bool forsharedobject, ASWorker* wrk);
 	void dumpVariables();
 	void destroyContents();
 	void prepareShutdown();
 	bool cloneInstance(variables_map& map);
 	void removeAllDeclaredProperties();
+	// releases the unused part of the flat layout after variables were removed
+	void compactVariables();
 	bool countCylicMemberReferences(garbagecollectorstate& gcstate, ASObject* parent);
 };
 
@@ -987,9 +1261,9 @@ protected:
 	}
 public:
 	ASObject(ASWorker* wrk, Class_base* c,SWFOBJECT_TYPE t = T_OBJECT,CLASS_SUBTYPE subtype = SUBTYPE_NOT_SET);
-	void serializeDynamicProperties(ByteArray* out, std::map<tiny_string, uint32_t>& stringMap,
-				std::map<const ASObject*, uint32_t>& objMap,
-				std::map<const Class_base*, uint32_t> traitsMap, ASWorker* wrk, bool usedynamicPropertyWriter=true, bool forSharedObject = false);
+	void serializeDynamicProperties(ByteArray* out, amf3stringtable& stringMap,
+				amf3objecttable& objMap,
+				amf3traitstable& traitsMap, ASWorker* wrk, bool usedynamicPropertyWriter=true, bool forSharedObject = false);
 #ifndef NDEBUG
 	//Stuff only used in debugging
 	bool initialized:1;
@@ -1014,6 +1288,7 @@ public:
 	void removefromGarbageCollection();
 	void removeStoredMember();
 	void handleGarbageCollection();
+	static void handleGarbageCollectionBatch(ASWorker* wrk, std::vector<ASObject*>& candidates);
 	virtual bool countCylicMemberReferences(garbagecollectorstate& gcstate);
 	FORCE_INLINE bool canHaveCyclicMemberReference()
 	{
@@ -1080,6 +1355,13 @@ public:
 	 * It is used by getVariableByMultiname and by early binding code
 	 */
 	virtual variable *findVariableByMultiname(const multiname& name, Class_base* cls, uint32_t* nsRealID, bool* isborrowed, bool considerdynamic, ASWorker* wrk);
+	/*
+	 * Looks up a variable that can be stored in the property cache of the preloaded code.
+	 * This is only possible for instances of sealed classes using the default property lookup.
+	 * On success either slotid is set to the slot of an instance variable or var is set to the
+	 * getter/method (or setter, if forsetting is true) found in the borrowed traits of the class
+	 */
+	bool getCacheableVariable(const multiname& name, bool forsetting, uint32_t& slotid, variable*& var);
 	/*
 	 * Gets a variable of this object. It looks through all classes (beginning at cls),
 	 * then the prototype chain, and then instance variables.
@@ -1171,10 +1453,23 @@ public:
 	{
 		return Variables.getSlotVar(n);
 	}
+	// direct access to a declared variable of an object cloned from a class shape, see variables_storage::getFlatVar
+	FORCE_INLINE variable* getFlatVar(uint32_t shapeid, uint32_t index)
+	{
+		return Variables.Variables.getFlatVar(shapeid,index);
+	}
+	bool getFlatIndex(const variable* v, uint32_t& shapeid, uint32_t& index) const
+	{
+		return Variables.Variables.getFlatIndex(v,shapeid,index);
+	}
 	FORCE_INLINE asAtom getSlotNoCheck(unsigned int n)
 	{
 		return Variables.getSlotNoCheck(n);
 	}
+	FORCE_INLINE uint32_t getSlotCount() const
+	{
+		return Variables.slotcount;
+	}
 	FORCE_INLINE TRAIT_KIND getSlotKind(unsigned int n)
 	{
 		return Variables.getSlotKind(n);
@@ -1257,7 +1552,8 @@ public:
 	void call_valueOf(asAtom &ret);
 	bool has_toString();
 	void call_toString(asAtom &ret);
-	tiny_string call_toJSON(bool &ok, std::vector<ASObject *> &path, asAtom replacer, const tiny_string &spaces, const tiny_string &filter);
+	// appends the result of the toJSON method of this object to res, returns false if there is no such method
+	bool call_toJSON(std::string& res, std::vector<ASObject *> &path, asAtom replacer, const tiny_string &spaces, const tiny_string &filter);
 
 	/* Helper function for calling getClass()->getQualifiedClassName() */
 	virtual tiny_string getClassName() const;
@@ -1302,13 +1598,14 @@ public:
 
 	  The various maps are used to implement reference type of the AMF3 spec
 	*/
-	virtual void serialize(ByteArray* out, std::map<tiny_string, uint32_t>& stringMap,
-				std::map<const ASObject*, uint32_t>& objMap,
-				std::map<const Class_base*, uint32_t>& traitsMap, ASWorker*wrk);
+	virtual void serialize(ByteArray* out, amf3stringtable& stringMap,
+				amf3objecttable& objMap,
+				amf3traitstable& traitsMap, ASWorker*wrk);
 
 	virtual ASObject *describeType(ASWorker* wrk) const;
 
-	virtual tiny_string toJSON(std::vector<ASObject *> &path, asAtom replacer, const tiny_string &spaces,const tiny_string& filter);
+	// appends the JSON representation of this object to res
+	virtual void toJSON(std::string& res, std::vector<ASObject *> &path, asAtom replacer, const tiny_string &spaces,const tiny_string& filter);
 	/* returns true if the current object is of type T */
 	template<class T> bool is() const { 
 		LOG(LOG_INFO,"dynamic cast:"<<this->getClassName());
@@ -1705,25 +2002,27 @@ template<> inline bool asAtomHandler::is<Undefined>(asAtom& a) { return isUndefi
 
 FORCE_INLINE int32_t asAtomHandler::toInt(const asAtom& a)
 {
-	if ((a.uintval&0x7)==ATOM_INTEGER)
+	if (getAtomType(a)==ATOM_INTEGER)
         return a.intval>>3;
-    else if ((a.uintval&0x7)==ATOM_UINTEGER)
+    else if (getAtomType(a)==ATOM_UINTEGER)
         return a.uintval>>3;
-    else if ((a.uintval&0x7)==ATOM_INVALID_UNDEFINED_NULL_BOOL)
+    else if (getAtomType(a)==ATOM_INVALID_UNDEFINED_NULL_BOOL)
         return (a.uintval&ATOMTYPE_BOOL_BIT) ? (a.uintval&0x80)>>7 : 0;
-    else if ((a.uintval&0x7)==ATOM_STRINGID)
+    else if (getAtomType(a)==ATOM_STRINGID)
     {
         ASObject* s = abstract_s(getWorker(),a.uintval>>3);
         int32_t ret = s->toInt();
         s->decRef();
         return ret;
     }
+    else if (isInlineNumber(a))
+        return numberToInt(getInlineNumber(a));
     assert(getObject(a));
     return getObjectNoCheck(a)->toInt();
 }
 FORCE_INLINE int32_t asAtomHandler::toIntStrict(const asAtom& a)
 {
-	switch(a.uintval&0x7)
+	switch(getAtomType(a))
 	{
 		case ATOM_INTEGER:
 			return a.intval>>3;
@@ -1738,6 +2037,10 @@ FORCE_INLINE int32_t asAtomHandler::toIntStrict(const asAtom& a)
 			s->decRef();
 			return ret;
 		}
+		case ATOM_NUMBERPTR:
+			if (isInlineNumber(a))
+				return numberToInt(getInlineNumber(a));
+			return getObjectNoCheck(a)->toIntStrict();
 		default:
 			assert(getObject(a));
 			return getObjectNoCheck(a)->toIntStrict();
@@ -1745,7 +2048,7 @@ FORCE_INLINE int32_t asAtomHandler::toIntStrict(const asAtom& a)
 }
 FORCE_INLINE number_t asAtomHandler::toNumber(const asAtom& a)
 {
-	switch(a.uintval&0x7)
+	switch(getAtomType(a))
 	{
 		case ATOM_INTEGER:
 			return a.intval>>3;
@@ -1760,6 +2063,8 @@ FORCE_INLINE number_t asAtomHandler::toNumber(const asAtom& a)
 			s->decRef();
 			return ret;
 		}
+		case ATOM_NUMBERPTR:
+			return getNumber(a);
 		default:
 			assert(getObject(a));
 			return getObjectNoCheck(a)->toNumber();
@@ -1767,7 +2072,7 @@ FORCE_INLINE number_t asAtomHandler::toNumber(const asAtom& a)
 }
 FORCE_INLINE number_t asAtomHandler::AVM1toNumber(asAtom& a, uint32_t swfversion)
 {
-	switch(a.uintval&0x7)
+	switch(getAtomType(a))
 	{
 		case ATOM_INTEGER:
 			return a.intval>>3;
@@ -1782,6 +2087,8 @@ FORCE_INLINE number_t asAtomHandler::AVM1toNumber(asAtom& a, uint32_t swfversion
 			s->decRef();
 			return ret;
 		}
+		case ATOM_NUMBERPTR:
+			return getNumber(a);
 		default:
 			assert(getObject(a));
 			return getObjectNoCheck(a)->toNumber();
@@ -1789,7 +2096,7 @@ FORCE_INLINE number_t asAtomHandler::AVM1toNumber(asAtom& a, uint32_t swfversion
 }
 FORCE_INLINE bool asAtomHandler::AVM1toBool(asAtom& a)
 {
-	switch(a.uintval&0x7)
+	switch(getAtomType(a))
 	{
 		case ATOM_INTEGER:
 			return a.intval>>3;
@@ -1806,7 +2113,7 @@ FORCE_INLINE bool asAtomHandler::AVM1toBool(asAtom& a)
 
 FORCE_INLINE int64_t asAtomHandler::toInt64(const asAtom& a)
 {
-	switch(a.uintval&0x7)
+	switch(getAtomType(a))
 	{
 		case ATOM_INTEGER:
 			return a.intval>>3;
@@ -1821,6 +2128,15 @@ FORCE_INLINE int64_t asAtomHandler::toInt64(const asAtom& a)
 			s->decRef();
 			return ret;
 		}
+		case ATOM_NUMBERPTR:
+			if (isInlineNumber(a))
+			{
+				number_t n = getInlineNumber(a);
+				if(std::isnan(n) || std::isinf(n))
+					return INT64_MAX;
+				return (int64_t)n;
+			}
+			return getObjectNoCheck(a)->toInt64();
 		default:
 			assert(getObject(a));
 			return getObjectNoCheck(a)->toInt64();
@@ -1828,7 +2144,7 @@ FORCE_INLINE int64_t asAtomHandler::toInt64(const asAtom& a)
 }
 FORCE_INLINE uint32_t asAtomHandler::toUInt(asAtom& a)
 {
-	switch(a.uintval&0x7)
+	switch(getAtomType(a))
 	{
 		case ATOM_INTEGER:
 			return a.intval>>3;
@@ -1843,6 +2159,10 @@ FORCE_INLINE uint32_t asAtomHandler::toUInt(asAtom& a)
 			s->decRef();
 			return ret;
 		}
+		case ATOM_NUMBERPTR:
+			if (isInlineNumber(a))
+				return (uint32_t)numberToInt(getInlineNumber(a));
+			return getObjectNoCheck(a)->toUInt();
 		default:
 			assert(getObject(a));
 			return getObjectNoCheck(a)->toUInt();
@@ -1851,7 +2171,7 @@ FORCE_INLINE uint32_t asAtomHandler::toUInt(asAtom& a)
 
 FORCE_INLINE void asAtomHandler::applyProxyProperty(asAtom& a,SystemState* sys,multiname &name)
 {
-	switch(a.uintval&0x7)
+	switch(getAtomType(a))
 	{
 		case ATOM_INTEGER:
 		case ATOM_UINTEGER:
@@ -1873,7 +2193,7 @@ FORCE_INLINE bool asAtomHandler::isEqualStrict(asAtom& a, ASWorker* wrk, asAtom
 	if(getObjectType(a)!=getObjectType(v2))
 	{
 		//Type conversions are ok only for numeric types
-		switch(a.uintval&0x7)
+		switch(getAtomType(a))
 		{
 			case ATOM_NUMBERPTR:
 			case ATOM_INTEGER:
@@ -1900,7 +2220,7 @@ FORCE_INLINE bool asAtomHandler::isEqualStrict(asAtom& a, ASWorker* wrk, asAtom
 			default:
 				return false;
 		}
-		switch(v2.uintval&0x7)
+		switch(getAtomType(v2))
 		{
 			case ATOM_NUMBERPTR:
 			case ATOM_INTEGER:
@@ -1933,7 +2253,7 @@ FORCE_INLINE bool asAtomHandler::isEqualStrict(asAtom& a, ASWorker* wrk, asAtom
 
 FORCE_INLINE bool asAtomHandler::isConstructed(const asAtom& a)
 {
-	switch(a.uintval&0x7)
+	switch(getAtomType(a))
 	{
 		case ATOM_INTEGER:
 		case ATOM_UINTEGER:
@@ -1955,9 +2275,9 @@ FORCE_INLINE bool asAtomHandler::isPrimitive(const asAtom& a)
 }
 FORCE_INLINE bool asAtomHandler::checkArgumentConversion(const asAtom& a,const asAtom& obj)
 {
-	if ((a.uintval&0x7) == (obj.uintval&0x7))
+	if (getAtomType(a) == getAtomType(obj))
 	{
-		if ((a.uintval&0x7) == ATOM_OBJECTPTR)
+		if (getAtomType(a) == ATOM_OBJECTPTR)
 			return getObjectNoCheck(a)->getObjectType() == getObjectNoCheck(obj)->getObjectType();
 		return true;
 	}
@@ -2008,7 +2328,7 @@ FORCE_INLINE void asAtomHandler::setUndefined(asAtom& a)
 }
 FORCE_INLINE bool asAtomHandler::increment(asAtom& a, ASWorker* wrk, bool replace)
 {
-	switch(a.uintval&0x7)
+	switch(getAtomType(a))
 	{
 		case ATOM_INVALID_UNDEFINED_NULL_BOOL:
 		{
@@ -2036,7 +2356,7 @@ FORCE_INLINE bool asAtomHandler::increment(asAtom& a, ASWorker* wrk, bool replac
 			break;
 		case ATOM_NUMBERPTR:
 		{
-			number_t n = getObjectNoCheck(a)->toNumber();
+			number_t n = getNumber(a);
 			if (std::isnan(n) || std::isinf(n))
 				setNumber(a,wrk,n);
 			else if(trunc(n) == n && n < INT32_MAX)
@@ -2078,7 +2398,7 @@ FORCE_INLINE bool asAtomHandler::increment(asAtom& a, ASWorker* wrk, bool replac
 
 FORCE_INLINE bool asAtomHandler::decrement(asAtom& a, ASWorker* wrk, bool replace)
 {
-	switch(a.uintval&0x7)
+	switch(getAtomType(a))
 	{
 		case ATOM_INVALID_UNDEFINED_NULL_BOOL:
 		{
@@ -2114,7 +2434,7 @@ FORCE_INLINE bool asAtomHandler::decrement(asAtom& a, ASWorker* wrk, bool replac
 		}
 		case ATOM_NUMBERPTR:
 		{
-			number_t n = getObjectNoCheck(a)->toNumber();
+			number_t n = getNumber(a);
 			if (std::isnan(n) || std::isinf(n))
 				setNumber(a,wrk,n);
 			else if(trunc(n) == n && n > INT32_MIN)
@@ -2156,14 +2476,14 @@ FORCE_INLINE bool asAtomHandler::decrement(asAtom& a, ASWorker* wrk, bool replac
 
 FORCE_INLINE void asAtomHandler::increment_i(asAtom& a, ASWorker* wrk, int32_t amount)
 {
-	if ((a.uintval&0x7) == ATOM_INTEGER)
+	if (getAtomType(a) == ATOM_INTEGER)
 		setInt(a,wrk,int32_t(a.intval>>3)+amount);
 	else
 		setInt(a,wrk,toInt(a)+amount);
 }
 FORCE_INLINE void asAtomHandler::decrement_i(asAtom& a, ASWorker* wrk, int32_t amount)
 {
-	if ((a.uintval&0x7) == ATOM_INTEGER)
+	if (getAtomType(a) == ATOM_INTEGER)
 		setInt(a,wrk,int32_t(a.intval>>3)-amount);
 	else
 		setInt(a,wrk,toInt(a)-amount);
@@ -2186,8 +2506,8 @@ FORCE_INLINE void asAtomHandler::bitnot(asAtom& a, ASWorker* wrk)
 
 FORCE_INLINE void asAtomHandler::subtract(asAtom& a, ASWorker* wrk, asAtom &v2, bool forceint)
 {
-	if( ((a.uintval&0x7) == ATOM_INTEGER || (a.uintval&0x7) == ATOM_UINTEGER) &&
-		(isInteger(v2) || (v2.uintval&0x7) ==ATOM_UINTEGER))
+	if( (getAtomType(a) == ATOM_INTEGER || getAtomType(a) == ATOM_UINTEGER) &&
+		(isInteger(v2) || getAtomType(v2) ==ATOM_UINTEGER))
 	{
 		int64_t num1=toInt64(a);
 		int64_t num2=toInt64(v2);
@@ -2215,8 +2535,8 @@ FORCE_INLINE void asAtomHandler::subtract(asAtom& a, ASWorker* wrk, asAtom &v2,
 }
 FORCE_INLINE void asAtomHandler::subtractreplace(asAtom& ret, ASWorker* wrk, const asAtom &v1, const asAtom &v2, bool forceint)
 {
-	if( ((v1.uintval&0x7) == ATOM_INTEGER || (v1.uintval&0x7) == ATOM_UINTEGER) &&
-		(isInteger(v2) || (v2.uintval&0x7) ==ATOM_UINTEGER))
+	if( (getAtomType(v1) == ATOM_INTEGER || getAtomType(v1) == ATOM_UINTEGER) &&
+		(isInteger(v2) || getAtomType(v2) ==ATOM_UINTEGER))
 	{
 		int64_t num1=toInt64(v1);
 		int64_t num2=toInt64(v2);
@@ -2251,8 +2571,8 @@ FORCE_INLINE void asAtomHandler::subtractreplace(asAtom& ret, ASWorker* wrk, con
 
 FORCE_INLINE void asAtomHandler::multiply(asAtom& a, ASWorker* wrk, asAtom &v2, bool forceint)
 {
-	if( ((a.uintval&0x7) == ATOM_INTEGER || (a.uintval&0x7) == ATOM_UINTEGER) &&
-		(isInteger(v2) || (v2.uintval&0x7) ==ATOM_UINTEGER))
+	if( (getAtomType(a) == ATOM_INTEGER || getAtomType(a) == ATOM_UINTEGER) &&
+		(isInteger(v2) || getAtomType(v2) ==ATOM_UINTEGER))
 	{
 		int64_t num1=toInt64(a);
 		int64_t num2=toInt64(v2);
@@ -2280,8 +2600,8 @@ FORCE_INLINE void asAtomHandler::multiply(asAtom& a, ASWorker* wrk, asAtom &v2,
 
 FORCE_INLINE void asAtomHandler::multiplyreplace(asAtom& ret, ASWorker* wrk, const asAtom& v1, const asAtom &v2, bool forceint)
 {
-	if( ((v1.uintval&0x7) == ATOM_INTEGER || (v1.uintval&0x7) == ATOM_UINTEGER) &&
-		(isInteger(v2) || (v2.uintval&0x7) ==ATOM_UINTEGER))
+	if( (getAtomType(v1) == ATOM_INTEGER || getAtomType(v1) == ATOM_UINTEGER) &&
+		(isInteger(v2) || getAtomType(v2) ==ATOM_UINTEGER))
 	{
 		int64_t num1=toInt64(v1);
 		int64_t num2=toInt64(v2);
@@ -2382,8 +2702,8 @@ FORCE_INLINE void asAtomHandler::dividereplace(asAtom& ret, ASWorker* wrk, const
 FORCE_INLINE void asAtomHandler::modulo(asAtom& a, ASWorker* wrk, asAtom &v2, bool forceint)
 {
 	// if both values are Integers the result is also an int
-	if( ((a.uintval&0x7) == ATOM_INTEGER || (a.uintval&0x7) == ATOM_UINTEGER) &&
-		(isInteger(v2) || (v2.uintval&0x7) ==ATOM_UINTEGER))
+	if( (getAtomType(a) == ATOM_INTEGER || getAtomType(a) == ATOM_UINTEGER) &&
+		(isInteger(v2) || getAtomType(v2) ==ATOM_UINTEGER))
 	{
 		int32_t num1=toInt(a);
 		int32_t num2=toInt(v2);
@@ -2408,8 +2728,8 @@ FORCE_INLINE void asAtomHandler::modulo(asAtom& a, ASWorker* wrk, asAtom &v2, bo
 FORCE_INLINE void asAtomHandler::moduloreplace(asAtom& ret, ASWorker* wrk, const asAtom& v1, const asAtom &v2, bool forceint)
 {
 	// if both values are Integers the result is also an int
-	if( ((v1.uintval&0x7) == ATOM_INTEGER || (v1.uintval&0x7) == ATOM_UINTEGER) &&
-		(isInteger(v2) || (v2.uintval&0x7) ==ATOM_UINTEGER))
+	if( (getAtomType(v1) == ATOM_INTEGER || getAtomType(v1) == ATOM_UINTEGER) &&
+		(isInteger(v2) || getAtomType(v2) ==ATOM_UINTEGER))
 	{
 		int32_t num1=toInt(v1);
 		int32_t num2=toInt(v2);
@@ -2529,15 +2849,20 @@ FORCE_INLINE bool asAtomHandler::isNumeric(const asAtom& a)
 }
 FORCE_INLINE bool asAtomHandler::isNumber(const asAtom& a)
 {
-	return (a.uintval&0x7)==ATOM_NUMBERPTR;
+	return getAtomType(a)==ATOM_NUMBERPTR;
+}
+FORCE_INLINE number_t asAtomHandler::getNumber(const asAtom& a)
+{
+	assert(isNumber(a));
+	return isInlineNumber(a) ? getInlineNumber(a) : getObjectNoCheck(a)->toNumber();
 }
 FORCE_INLINE bool asAtomHandler::isInteger(const asAtom& a)
 { 
-	return (a.uintval&0x3) == ATOM_INTEGER || ((a.uintval&0x7) == ATOM_U_INTEGERPTR && isObject(a) && getObjectNoCheck(a)->getObjectType() == T_INTEGER);
+	return (!isInlineNumber(a) && (a.uintval&0x3) == ATOM_INTEGER) || (getAtomType(a) == ATOM_U_INTEGERPTR && isObject(a) && getObjectNoCheck(a)->getObjectType() == T_INTEGER);
 }
 FORCE_INLINE bool asAtomHandler::isUInteger(const asAtom& a)
 { 
-	return (a.uintval&0x7) == ATOM_UINTEGER || ((a.uintval&0x7) == ATOM_U_INTEGERPTR  && isObject(a) && getObjectNoCheck(a)->getObjectType() == T_UINTEGER);
+	return getAtomType(a) == ATOM_UINTEGER || (getAtomType(a) == ATOM_U_INTEGERPTR  && isObject(a) && getObjectNoCheck(a)->getObjectType() == T_UINTEGER);
 }
 FORCE_INLINE asAtom asAtomHandler::fromObjectNoPrimitive(ASObject* obj)
 {
@@ -2549,7 +2874,7 @@ FORCE_INLINE asAtom asAtomHandler::fromObjectNoPrimitive(ASObject* obj)
 
 FORCE_INLINE SWFOBJECT_TYPE asAtomHandler::getObjectType(const asAtom& a)
 {
-	switch (a.uintval&0x7)
+	switch(getAtomType(a))
 	{
 		case ATOM_INTEGER:
 			return T_INTEGER;
@@ -2580,7 +2905,7 @@ FORCE_INLINE SWFOBJECT_TYPE asAtomHandler::getObjectType(const asAtom& a)
 FORCE_INLINE asAtom asAtomHandler::typeOf(asAtom& a)
 {
 	BUILTIN_STRINGS ret=BUILTIN_STRINGS::STRING_OBJECT;
-	switch(a.uintval&0x7)
+	switch(getAtomType(a))
 	{
 		case ATOM_INVALID_UNDEFINED_NULL_BOOL:
 		{
@@ -2631,19 +2956,35 @@ FORCE_INLINE asAtom asAtomHandler::typeOf(asAtom& a)
 }
 bool asAtomHandler::isEqual(asAtom& a, ASWorker* wrk, asAtom &v2)
 {
-	if ((((a.intval ^ ATOM_INTEGER) | (v2.intval ^ ATOM_INTEGER)) & 7) == 0)
+	if (isInlineNumber(a))
+	{
+		if (isInlineNumber(v2))
+			return getInlineNumber(a) == getInlineNumber(v2);
+	}
+	else if (!isInlineNumber(v2) && (((a.intval ^ ATOM_INTEGER) | (v2.intval ^ ATOM_INTEGER)) & 7) == 0)
 		return (a.intval == v2.intval);
 	if (a.uintval == v2.uintval && 
-			((a.uintval&0x7) != ATOM_NUMBERPTR)) // number needs special handling for NaN
+			(getAtomType(a) != ATOM_NUMBERPTR)) // number needs special handling for NaN
 		return true;
 	return isEqualIntern(a,wrk,v2);
 }
 TRISTATE asAtomHandler::isLess(asAtom& a, ASWorker* wrk, asAtom &v2)
 {
-	if ((((a.intval ^ ATOM_INTEGER) | (v2.intval ^ ATOM_INTEGER)) & 7) == 0)
+	if (isInlineNumber(a))
+	{
+		if (isInlineNumber(v2))
+		{
+			number_t n1 = getInlineNumber(a);
+			number_t n2 = getInlineNumber(v2);
+			if (std::isnan(n1) || std::isnan(n2))
+				return TUNDEFINED;
+			return (n1 < n2)?TTRUE:TFALSE;
+		}
+	}
+	else if (!isInlineNumber(v2) && (((a.intval ^ ATOM_INTEGER) | (v2.intval ^ ATOM_INTEGER)) & 7) == 0)
 		return (a.intval < v2.intval)?TTRUE:TFALSE;
 	if (a.uintval == v2.uintval && 
-			((a.uintval&0x7) != ATOM_NUMBERPTR)) // number needs special handling for NaN
+			(getAtomType(a) != ATOM_NUMBERPTR)) // number needs special handling for NaN
 	{
 		return a.uintval == ATOMTYPE_UNDEFINED_BIT ? TUNDEFINED : TFALSE;
 	}
@@ -2652,7 +2993,7 @@ TRISTATE asAtomHandler::isLess(asAtom& a, ASWorker* wrk, asAtom &v2)
 /* implements ecma3's ToBoolean() operation, see section 9.2, but returns the value instead of an Boolean object */
 FORCE_INLINE bool asAtomHandler::Boolean_concrete(asAtom& a)
 {
-	switch(a.uintval&0x7)
+	switch(getAtomType(a))
 	{
 		case ATOM_INVALID_UNDEFINED_NULL_BOOL:
 		{
@@ -2691,17 +3032,17 @@ FORCE_INLINE bool asAtomHandler::isTemplate(const asAtom& a) { return isObject(a
 
 FORCE_INLINE ASObject* asAtomHandler::getObject(const asAtom& a)
 {
-	assert(!(a.uintval & ATOMTYPE_OBJECT_BIT) || !((ASObject*)(a.uintval& ~((LIGHTSPARK_ATOM_VALTYPE)0x7)))->getCached() || ((ASObject*)(a.uintval& ~((LIGHTSPARK_ATOM_VALTYPE)0x7)))->getInDestruction());
-	return a.uintval & ATOMTYPE_OBJECT_BIT ? (ASObject*)(a.uintval& ~((LIGHTSPARK_ATOM_VALTYPE)0x7)) : nullptr;
+	assert(!isObject(a) || !((ASObject*)(a.uintval& ~((LIGHTSPARK_ATOM_VALTYPE)0x7)))->getCached() || ((ASObject*)(a.uintval& ~((LIGHTSPARK_ATOM_VALTYPE)0x7)))->getInDestruction());
+	return isObject(a) ? (ASObject*)(a.uintval& ~((LIGHTSPARK_ATOM_VALTYPE)0x7)) : nullptr;
 }
 FORCE_INLINE ASObject* asAtomHandler::getObjectNoCheck(const asAtom& a)
 {
-	assert(!(a.uintval & ATOMTYPE_OBJECT_BIT) || !((ASObject*)(a.uintval& ~((LIGHTSPARK_ATOM_VALTYPE)0x7)))->getCached() || ((ASObject*)(a.uintval& ~((LIGHTSPARK_ATOM_VALTYPE)0x7)))->getInDestruction());
+	assert(!isObject(a) || !((ASObject*)(a.uintval& ~((LIGHTSPARK_ATOM_VALTYPE)0x7)))->getCached() || ((ASObject*)(a.uintval& ~((LIGHTSPARK_ATOM_VALTYPE)0x7)))->getInDestruction());
 	return (ASObject*)(a.uintval& ~((LIGHTSPARK_ATOM_VALTYPE)0x7));
 }
 FORCE_INLINE void asAtomHandler::resetCached(const asAtom& a)
 {
-	ASObject* o = a.uintval & ATOMTYPE_OBJECT_BIT ? (ASObject*)(a.uintval& ~((LIGHTSPARK_ATOM_VALTYPE)0x7)) : nullptr;
+	ASObject* o = isObject(a) ? (ASObject*)(a.uintval& ~((LIGHTSPARK_ATOM_VALTYPE)0x7)) : nullptr;
 	if (o)
 		o->resetCached();
 }
@@ -2709,13 +3050,21 @@ FORCE_INLINE void asAtomHandler::resetCached(const asAtom& a)
 inline ASObject* asfreelist::getObjectFromFreeList()
 {
 	assert(freelistsize>=0);
-	ASObject* o = freelistsize ? freelist[--freelistsize] :nullptr;
+	allocations++;
+	ASObject* o = nullptr;
+	if (freelistsize)
+	{
+		o = freelist[--freelistsize];
+		reused++;
+		if (freelistsize < lowwatermark)
+			lowwatermark = freelistsize;
+	}
 	LOG_CALL("getfromfreelist:"<<freelistsize<<" "<<o<<" "<<this);
 	return o;
 }
 inline bool asfreelist::pushObjectToFreeList(ASObject *obj)
 {
-	if (freelistsize < FREELIST_SIZE)
+	if (freelistsize < freelistcapacity || growFreeList())
 	{
 		assert(freelistsize>=0);
 		LOG_CALL("pushtofreelist:"<<freelistsize<<" "<<obj<<" "<<this);
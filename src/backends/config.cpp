@@ -85,7 +85,8 @@ Config::Config():
 	//DEFAULT SETTINGS
 	defaultCacheDirectory((string) g_get_user_cache_dir() + G_DIR_SEPARATOR_S + "lightspark"),
 	cacheDirectory(defaultCacheDirectory),cachePrefix("cache"),
-	renderingEnabled(true)
+	renderingEnabled(true),preloadCacheEnabled(false),backgroundPreloadEnabled(false),
+	gcAllocationThreshold(4096),gcSliceTime(2),threadPoolSize(0)
 {
 #ifdef _WIN32
 	const char* exePath = getExectuablePath();
@@ -211,6 +212,20 @@ void Config::handleEntry()
 	//Cache prefix
 	else if(group == "cache" && key == "prefix")
 		cachePrefix = value;
+	//Cache of preloaded ActionScript code
+	else if(group == "cache" && key == "preload")
+		preloadCacheEnabled = atoi(value.c_str());
+	//Preloading of ActionScript methods in the background
+	else if(group == "scripting" && key == "backgroundpreload")
+		backgroundPreloadEnabled = atoi(value.c_str());
+	//Pacing of the cycle collector
+	else if(group == "gc" && key == "allocationthreshold")
+		gcAllocationThreshold = atoi(value.c_str());
+	else if(group == "gc" && key == "slicetime")
+		gcSliceTime = atoi(value.c_str());
+	//Size of the thread pools
+	else if(group == "threadpool" && key == "threads")
+		threadPoolSize = atoi(value.c_str());
 	else
 		LOG(LOG_ERROR,"Invalid entry encountered in configuration file" << ": '" << group << "/" << key << "'='" << value << "'");
 }
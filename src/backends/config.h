@@ -51,6 +51,16 @@ namespace lightspark
 
 		//Specifies if rendering should be done
 		bool renderingEnabled;
+		//Specifies if the preloaded code of methods is cached on disk
+		bool preloadCacheEnabled;
+		//Specifies if methods are prepared for preloading by the thread pool after the code is parsed
+		bool backgroundPreloadEnabled;
+		//Number of objects allocated by a worker before the cycle collector runs a slice
+		uint32_t gcAllocationThreshold;
+		//Maximum duration of a slice of the cycle collector in milliseconds
+		uint32_t gcSliceTime;
+		//Number of threads of the thread pools, 0 for the number of cpus
+		uint32_t threadPoolSize;
 		Config();
 		~Config();
 	public:
@@ -64,6 +74,11 @@ namespace lightspark
 		const std::string& getGnashPath() const { return gnashPath; }
 
 		bool isRenderingEnabled() const { return renderingEnabled; }
+		bool isPreloadCacheEnabled() const { return preloadCacheEnabled; }
+		bool isBackgroundPreloadEnabled() const { return backgroundPreloadEnabled; }
+		uint32_t getGCAllocationThreshold() const { return gcAllocationThreshold; }
+		uint32_t getGCSliceTime() const { return gcSliceTime; }
+		uint32_t getThreadPoolSize() const { return threadPoolSize; }
 	};
 }
 
@@ -299,6 +299,8 @@ public:
 	void execute() override;
 	void threadAbort() override;
 	void jobFence() override;
+	THREADJOB_PRIORITY getPriority() const override { return THREADJOB_PRIORITY_HIGH; }
+	bool isShortRunning() const override { return true; }
 	//ITextureUploadable interface
 	uint8_t* upload(bool refresh) override;
 	void sizeNeeded(uint32_t& w, uint32_t& h) const override;
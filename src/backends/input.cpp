@@ -79,6 +79,7 @@ int InputThread::worker(void* d)
 	setTLSWorker(th->m_sys->worker);
 	// Set TLS variable for `getInputThread()`.
 	tls_set(inputThread, th);
+	setEventSource(EVENTSOURCE_INPUT);
 
 	while (true)
 	{
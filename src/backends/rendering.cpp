@@ -158,6 +158,7 @@ int RenderThread::worker(void* d)
 	setTLSWorker(th->m_sys->worker);
 	/* set TLS variable for getRenderThread() */
 	tls_set(renderThread, th);
+	setEventSource(EVENTSOURCE_RENDER);
 
 	ThreadProfile* profile=th->m_sys->allocateProfiler(RGB(200,0,0));
 	profile->setTag("Render");
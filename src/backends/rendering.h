@@ -26,6 +26,7 @@
 #include <SDL.h>
 #include <sys/time.h>
 #include <unordered_map>
+#include <list>
 #ifdef _WIN32
 #	include <windef.h>
 #endif
@@ -27,7 +27,6 @@ namespace lightspark
 
 /* forward declarations */
 struct sorton_field;
-struct sorton_value;
 class Array;
 
 };
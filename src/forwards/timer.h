@@ -26,6 +26,7 @@ namespace lightspark
 {
 
 /* forward declarations */
+class TickBatch;
 class TimerThread;
 class Chronometer;
 class ITickJob;
@@ -25,11 +25,14 @@
 namespace lightspark
 {
 
+enum THREADJOB_PRIORITY { THREADJOB_PRIORITY_HIGH=0, THREADJOB_PRIORITY_NORMAL, THREADJOB_PRIORITY_LOW, THREADJOB_PRIORITY_COUNT };
+
 class IThreadJob
 {
 friend class ThreadPool;
 private:
 	ASWorker* fromWorker;
+	int affinity;
 public:
 	/*
 	 * Set to true by the ThreadPool just before threadAbort()
@@ -60,9 +63,26 @@ public:
 	 * 'delete this'.
 	 */
 	virtual void jobFence()=0;
-	IThreadJob() : fromWorker(nullptr),threadAborting(false) {}
+	/*
+	 * Queued jobs of a higher priority are started before jobs of a lower priority.
+	 * Work needed for the next frame (e.g. rasterization) should use THREADJOB_PRIORITY_HIGH,
+	 * background work nobody is waiting for THREADJOB_PRIORITY_LOW.
+	 */
+	virtual THREADJOB_PRIORITY getPriority() const { return THREADJOB_PRIORITY_NORMAL; }
+	/*
+	 * Returns true if execute() only computes and never waits for
+	 * other threads, the network or the user.
+	 * Jobs that may block are never allowed to occupy all threads of the pool.
+	 */
+	virtual bool isShortRunning() const { return false; }
+	IThreadJob() : fromWorker(nullptr),affinity(-1),threadAborting(false) {}
 	virtual ~IThreadJob() {}
 	void setWorker(ASWorker* w) { fromWorker = w;}
+	/*
+	 * Hint for the ThreadPool to queue the job on the thread with the given index
+	 * (modulo the number of threads), -1 for no preference
+	 */
+	void setAffinity(int a) { affinity = a; }
 };
 
 };
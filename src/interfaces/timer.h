@@ -23,6 +23,8 @@
 namespace lightspark
 {
 
+class TickBatch;
+
 //Jobs that run on tick are supposed to be very short
 //For longer jobs use ThreadPool
 class ITickJob
@@ -37,6 +39,12 @@ protected:
 	bool stopMe;
 public:
 	virtual void tick()=0;
+	/*
+	   Like tick(), but the events for the vm are added to batch instead of being sent directly.
+	   All jobs due in the same millisecond share one batch.
+	   Returns false if the job doesn't support batching, tick() is called instead
+	*/
+	virtual bool tickBatched(TickBatch& batch) { return false; }
 	ITickJob():stopMe(false){}
 	virtual ~ITickJob(){}
 	// This is called after tick() for single-shot jobs (i.e. enqueued with isTick==false)
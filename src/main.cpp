@@ -656,7 +656,7 @@ int main(int argc, char* argv[])
 		{
 			LOG(LOG_ERROR, "Usage: " << argv[0] << " [--url|-u http://loader.url/file.swf]" <<
 							   " [--disable-interpreter|-ni] [--enable-fast-interpreter|-fi]" <<
-#ifdef LLVM_ENABLED
+#if defined(LLVM_ENABLED) || defined(JIT_ENABLED)
 							   " [--enable-jit|-j]" <<
 #endif
 							   " [--log-level|-l 0-4] [--parameters-file|-p params-file] [--security-sandbox|-s sandbox]" <<
@@ -332,9 +332,8 @@ asAtom Amf3Deserializer::parseDictionary(std::vector<tiny_string>& stringMap,
 	uint8_t weakkeys;
 	if (!input->readByte(weakkeys))
 		throw ParseException("Not enough data to parse AMF3 vector");
-	if (weakkeys)
-		LOG(LOG_NOT_IMPLEMENTED,"handling of weak keys in Dictionary");
 	Dictionary* ret=Class<Dictionary>::getInstanceS(input->getInstanceWorker());
+	ret->setWeakKeys(weakkeys);
 	//Add object to the map
 	objMap.push_back(asAtomHandler::fromObject(ret));
 
@@ -0,0 +1,109 @@
+/**************************************************************************
+    Lightspark, a free flash player implementation
+
+    Copyright (C) 2010-2013  Alessandro Pignotti (a.pignotti@sssup.it)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+#ifndef PARSING_AMF3_REFTABLE_H
+#define PARSING_AMF3_REFTABLE_H 1
+
+#include <vector>
+#include <functional>
+#include <cstdint>
+#include "tiny_string.h"
+
+namespace lightspark
+{
+
+class ASObject;
+class Class_base;
+
+/*
+ * Reference table used when writing AMF3 data.
+ * Strings, objects and traits are sent by reference if they were already written,
+ * the reference is the position of the first occurence in the table.
+ * As entries are only added and the reference index is the insertion order,
+ * the keys are kept in a vector and the hash table only stores positions in that vector
+ * (open addressing, linear probing).
+ */
+template<class K, class H = std::hash<K>>
+class amf3referencetable
+{
+private:
+	std::vector<K> keys;
+	// index+1 of the key in keys, 0 for empty slots
+	std::vector<uint32_t> slots;
+	uint32_t mask;
+	static uint32_t slotForHash(size_t h, uint32_t mask)
+	{
+		// fibonacci hashing, so that aligned pointers are spread over the table
+		return uint32_t((uint64_t(h)*0x9e3779b97f4a7c15ULL)>>32)&mask;
+	}
+	void grow()
+	{
+		uint32_t newsize = slots.empty() ? 16 : slots.size()*2;
+		slots.assign(newsize,0);
+		mask = newsize-1;
+		for (uint32_t i = 0; i < keys.size(); i++)
+		{
+			uint32_t s = slotForHash(H()(keys[i]),mask);
+			while (slots[s])
+				s = (s+1)&mask;
+			slots[s] = i+1;
+		}
+	}
+public:
+	static const uint32_t npos = UINT32_MAX;
+	amf3referencetable():mask(0) {}
+	uint32_t size() const { return keys.size(); }
+	// returns the reference index of key, npos if it wasn't added yet
+	uint32_t find(const K& key) const
+	{
+		if (slots.empty())
+			return npos;
+		uint32_t s = slotForHash(H()(key),mask);
+		while (slots[s])
+		{
+			if (keys[slots[s]-1] == key)
+				return slots[s]-1;
+			s = (s+1)&mask;
+		}
+		return npos;
+	}
+	// adds key with the next reference index, the key must not be in the table
+	void add(const K& key)
+	{
+		// keep the load factor below 1/2
+		if ((keys.size()+1)*2 > slots.size())
+		{
+			keys.push_back(key);
+			grow();
+			return;
+		}
+		uint32_t s = slotForHash(H()(key),mask);
+		while (slots[s])
+			s = (s+1)&mask;
+		keys.push_back(key);
+		slots[s] = keys.size();
+	}
+};
+
+typedef amf3referencetable<tiny_string> amf3stringtable;
+typedef amf3referencetable<const ASObject*> amf3objecttable;
+typedef amf3referencetable<const Class_base*> amf3traitstable;
+
+}
+#endif /* PARSING_AMF3_REFTABLE_H */
@@ -31,6 +31,8 @@
 #include "backends/geometry.h"
 #include "backends/security.h"
 #include "backends/streamcache.h"
+#include "backends/config.h"
+#include "scripting/preloadcache.h"
 #include "swftypes.h"
 #include "logger.h"
 #include "compat.h"
@@ -3157,6 +3159,31 @@ VideoFrameTag::~VideoFrameTag()
 		delete[] framedata;
 }
 
+/*
+ * Parses the abc data up to dest.
+ * If the preload cache is enabled the data is read into a buffer first, as it is used as key for the cache
+ */
+static ABCContext* parseABCContext(RootMovieClip* root, std::istream& in, int dest)
+{
+	if (!Config::getConfig()->isPreloadCacheEnabled())
+		return new ABCContext(root, in, getVm(root->getSystemState()));
+	int len=dest-in.tellg();
+	if (len <= 0)
+		throw ParseException("Not complete ABC data");
+	std::string data(len,'\0');
+	in.read(&data[0],len);
+	std::istringstream abcin(data);
+	ABCContext* context=new ABCContext(root, abcin, getVm(root->getSystemState()));
+	context->preloadcache=PreloadCache::create(data.data(),len);
+	int pos=abcin.tellg();
+	if(len!=pos)
+	{
+		LOG(LOG_ERROR,"Corrupted ABC data: missing " << len-pos);
+		throw ParseException("Not complete ABC data");
+	}
+	return context;
+}
+
 DoABCTag::DoABCTag(RECORDHEADER h, std::istream& in):ControlTag(h)
 {
 	int dest=in.tellg();
@@ -3164,7 +3191,7 @@ DoABCTag::DoABCTag(RECORDHEADER h, std::istream& in):ControlTag(h)
 	LOG(LOG_CALLS,"DoABCTag");
 
 	RootMovieClip* root=getParseThread()->getRootMovie();
-	context=new ABCContext(root, in, getVm(root->getSystemState()));
+	context=parseABCContext(root, in, dest);
 
 	int pos=in.tellg();
 	if(dest!=pos)
@@ -3200,7 +3227,7 @@ DoABCDefineTag::DoABCDefineTag(RECORDHEADER h, std::istream& in):ControlTag(h)
 	LOG(LOG_CALLS,"DoABCDefineTag Name: " << Name);
 
 	RootMovieClip* root=getParseThread()->getRootMovie();
-	context=new ABCContext(root, in, getVm(root->getSystemState()));
+	context=parseABCContext(root, in, dest);
 
 	int pos=in.tellg();
 	if(dest!=pos)
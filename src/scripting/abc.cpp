@@ -78,6 +78,9 @@
 #include "scripting/class.h"
 #include "exceptions.h"
 #include "scripting/abc.h"
+#include "scripting/preloadcache.h"
+#include "interfaces/threading.h"
+#include "backends/config.h"
 #include "backends/rendering.h"
 #include "parsing/tags.h"
 #include "scripting/toplevel/Array.h"
@@ -558,13 +561,44 @@ multiname* ABCContext::getMultinameImpl(asAtom& n, ASObject* n2, unsigned int mi
 	}
 	return ret;
 }
+namespace lightspark
+{
+/*
+ * runs the first preloading pass of the likely hot methods of an ABCContext in the background,
+ * so the methods are ready to be preloaded when they are called for the first time
+ */
+class BackgroundPreloadJob : public IThreadJob
+{
+private:
+	ABCContext* context;
+	std::vector<uint32_t> bodies;
+public:
+	Semaphore finished;
+	BackgroundPreloadJob(ABCContext* _context, std::vector<uint32_t>& _bodies):context(_context),finished(0)
+	{
+		bodies.swap(_bodies);
+	}
+	void execute() override
+	{
+		for (auto it = bodies.begin(); it != bodies.end() && !threadAborting; it++)
+			context->backgroundPreload(*it);
+	}
+	void jobFence() override
+	{
+		finished.signal();
+	}
+	THREADJOB_PRIORITY getPriority() const override { return THREADJOB_PRIORITY_LOW; }
+	bool isShortRunning() const override { return true; }
+};
+}
+
 ABCContext::ABCContext(RootMovieClip* r, istream& in, ABCVm* vm):scriptsdeclared(false),root(r),constant_pool(vm->vmDataMemory),
 	methods(reporter_allocator<method_info>(vm->vmDataMemory)),
 	metadata(reporter_allocator<metadata_info>(vm->vmDataMemory)),
 	instances(reporter_allocator<instance_info>(vm->vmDataMemory)),
 	classes(reporter_allocator<class_info>(vm->vmDataMemory)),
 	scripts(reporter_allocator<script_info>(vm->vmDataMemory)),
-	method_body(reporter_allocator<method_body_info>(vm->vmDataMemory))
+	method_body(reporter_allocator<method_body_info>(vm->vmDataMemory)),preloadcache(nullptr),backgroundpreloadjob(nullptr)
 {
 	in >> minor >> major;
 	LOG(LOG_CALLS,"ABCVm version " << major << '.' << minor);
@@ -587,8 +621,7 @@ ABCContext::ABCContext(RootMovieClip* r, istream& in, ABCVm* vm):scriptsdeclared
 	constantAtoms_doubles.resize(constant_pool.doubles.size());
 	for (uint32_t i = 0; i < constant_pool.doubles.size(); i++)
 	{
-		ASObject* res = abstract_d_constant(root->getInstanceWorker(),constant_pool.doubles[i]);
-		constantAtoms_doubles[i] = asAtomHandler::fromObject(res);
+		constantAtoms_doubles[i] = asAtomHandler::fromNumber(root->getInstanceWorker(),constant_pool.doubles[i],true);
 	}
 	constantAtoms_strings.resize(constant_pool.strings.size());
 	for (uint32_t i = 0; i < constant_pool.strings.size(); i++)
@@ -714,10 +747,109 @@ ABCContext::ABCContext(RootMovieClip* r, istream& in, ABCVm* vm):scriptsdeclared
 #ifdef PROFILING_SUPPORT
 	root->getSystemState()->contextes.push_back(this);
 #endif
+	if (Config::getConfig()->isBackgroundPreloadEnabled())
+		startBackgroundPreload();
 }
 
 ABCContext::~ABCContext()
 {
+	if (backgroundpreloadjob)
+	{
+		// the job may still be running, wait until it is finished
+		backgroundpreloadjob->threadAborting=true;
+		static_cast<BackgroundPreloadJob*>(backgroundpreloadjob)->finished.wait();
+		delete backgroundpreloadjob;
+	}
+	for (auto it = backgroundpreloadinfo.begin(); it != backgroundpreloadinfo.end(); it++)
+		delete *it;
+	delete preloadcache;
+}
+
+void ABCContext::startBackgroundPreload()
+{
+	// candidates are the script and class initializers, the constructors and the methods of all classes
+	std::vector<uint32_t> bodies;
+	std::vector<bool> added(method_body.size(),false);
+	auto addmethod = [&](uint32_t m)
+	{
+		if (m >= methods.size() || methods[m].body == nullptr)
+			return;
+		uint32_t b = methods[m].body-method_body.data();
+		if (!added[b])
+		{
+			added[b]=true;
+			bodies.push_back(b);
+		}
+	};
+	auto addtraits = [&](const std::vector<traits_info>& traits)
+	{
+		for (auto it = traits.begin(); it != traits.end(); it++)
+		{
+			uint32_t kind = it->kind&0xf;
+			if (kind == traits_info::Method || kind == traits_info::Getter || kind == traits_info::Setter)
+				addmethod(it->method);
+		}
+	};
+	for (uint32_t i = scripts.size(); i > 0; i--)
+		addmethod(scripts[i-1].init);
+	for (uint32_t i = 0; i < class_count; i++)
+	{
+		addmethod(classes[i].cinit);
+		addmethod(instances[i].init);
+	}
+	for (uint32_t i = 0; i < class_count; i++)
+	{
+		addtraits(instances[i].traits);
+		addtraits(classes[i].traits);
+	}
+	if (bodies.empty())
+		return;
+	backgroundpreloadinfo.resize(method_body.size(),nullptr);
+	backgroundpreloadtaken.resize(method_body.size(),false);
+	backgroundpreloadjob = new BackgroundPreloadJob(this,bodies);
+	root->getSystemState()->addJob(backgroundpreloadjob);
+}
+
+void ABCContext::backgroundPreload(uint32_t bodyindex)
+{
+	// the preload cache and preloadFunction change the exception handlers of the body in place
+	// after it was taken, so the scan uses a copy of them
+	std::vector<exception_info_abc> exceptions;
+	{
+		Locker l(backgroundpreloadmutex);
+		if (backgroundpreloadtaken[bodyindex])
+			return;
+		exceptions = method_body[bodyindex].exceptions;
+	}
+	preloadjumpinfo* info = new preloadjumpinfo();
+	try
+	{
+		ABCVm::scanJumpTargets(this,&method_body[bodyindex],exceptions,*info);
+	}
+	catch(LightsparkException& e)
+	{
+		// invalid code is reported when the method is called
+		delete info;
+		return;
+	}
+	Locker l(backgroundpreloadmutex);
+	// the body was taken while it was scanned, the script thread has done the scan itself
+	if (backgroundpreloadtaken[bodyindex])
+		delete info;
+	else
+		backgroundpreloadinfo[bodyindex] = info;
+}
+
+preloadjumpinfo* ABCContext::takeBackgroundPreloadInfo(method_body_info* body)
+{
+	if (!backgroundpreloadjob || body->isspeculative)
+		return nullptr;
+	uint32_t bodyindex = body-method_body.data();
+	Locker l(backgroundpreloadmutex);
+	backgroundpreloadtaken[bodyindex] = true;
+	preloadjumpinfo* info = backgroundpreloadinfo[bodyindex];
+	backgroundpreloadinfo[bodyindex] = nullptr;
+	return info;
 }
 
 #ifdef PROFILING_SUPPORT
@@ -755,8 +887,8 @@ void ABCContext::dumpProfilingData(ostream& f) const
 /*
  * nextNamespaceBase is set to 2 since 0 is the empty namespace and 1 is the AS3 namespace
  */
-ABCVm::ABCVm(SystemState* s, MemoryAccount* m):m_sys(s),status(CREATED),isIdle(true),canFlushInvalidationQueue(true),shuttingdown(false),
-	events_queue(reporter_allocator<eventType>(m)),idleevents_queue(reporter_allocator<eventType>(m)),event_buffer(reporter_allocator<eventType>(m)),nextNamespaceBase(2),
+ABCVm::ABCVm(SystemState* s, MemoryAccount* m):m_sys(s),status(CREATED),isIdle(true),canFlushInvalidationQueue(true),shuttingdown(false),eventsclosed(false),
+	events_queue(reporter_allocator<eventType>(m)),events_intake(4096),idleevents_queue(reporter_allocator<eventType>(m)),event_buffer(reporter_allocator<eventType>(m)),nextNamespaceBase(2),
 	vmDataMemory(m)
 {
 	m_sys=s;
@@ -792,6 +924,7 @@ void ABCVm::addDeletableObject(ASObject *obj)
 void ABCVm::finalize()
 {
 	//The event queue may be not empty if the VM has been been started
+	drainEventIntake();
 	if(status==CREATED && !events_queue.empty())
 		LOG(LOG_ERROR, "Events queue is not empty as expected");
 	events_queue.clear();
@@ -820,7 +953,7 @@ ABCVm::~ABCVm()
 
 int ABCVm::getEventQueueSize()
 {
-	return events_queue.size();
+	return events_queue.size()+events_intake.size();
 }
 
 void ABCVm::publicHandleEvent(EventDispatcher* dispatcher, _R<Event> event)
@@ -929,7 +1062,15 @@ void ABCVm::publicHandleEvent(EventDispatcher* dispatcher, _R<Event> event)
 		else
 		{
 			DisplayObject* cur = dispatcher->as<DisplayObject>();
-			while(true)
+			// the parents are only needed if one of them listens to the event, keyboard events are always bubbled up to the stage
+			bool needsparents = event->is<KeyboardEvent>();
+			if (!needsparents && cur->getParent())
+			{
+				uint32_t nameId = dispatcher->getSystemState()->getUniqueStringId(event->type);
+				for (DisplayObject* p = cur->getParent(); p && !needsparents; p = p->getParent())
+					needsparents = p->mayHaveEventListener(nameId);
+			}
+			while(needsparents)
 			{
 				if(!cur->getParent())
 					break;
@@ -1187,6 +1328,9 @@ void ABCVm::handleEvent(std::pair<_NR<EventDispatcher>, _R<Event> > e)
 				m_sys->handleLocalConnectionEvent(ev);
 				break;
 			}
+			case SYNC:
+				//Only signalled below
+				break;
 			case IDLE_EVENT:
 			{
 				m_sys->setFramePhase(FramePhase::IDLE);
@@ -1196,6 +1340,7 @@ void ABCVm::handleEvent(std::pair<_NR<EventDispatcher>, _R<Event> > e)
 				m_sys->resetParentList();
 				{
 					Locker l(event_queue_mutex);
+					drainEventIntake();
 					while (!idleevents_queue.empty())
 					{
 						events_queue.push_back(idleevents_queue.front());
@@ -1213,6 +1358,7 @@ void ABCVm::handleEvent(std::pair<_NR<EventDispatcher>, _R<Event> > e)
 			{
 				FlushEventBufferEvent* ev=static_cast<FlushEventBufferEvent*>(e.second.getPtr());
 				Locker l(event_queue_mutex);
+				drainEventIntake();
 				events_queue.insert(
 					ev->append ? events_queue.end() : events_queue.begin(),
 					ev->reverse ? event_buffer.rend().base() : event_buffer.begin(),
@@ -1289,7 +1435,10 @@ bool ABCVm::prependEvent(_NR<EventDispatcher> obj ,_R<Event> ev, bool force)
 	if (isIdle || force)
 		events_queue.push_front(pair<_NR<EventDispatcher>,_R<Event>>(obj, ev));
 	else
+	{
+		drainEventIntake();
 		events_queue.push_back(pair<_NR<EventDispatcher>,_R<Event>>(obj, ev));
+	}
 	sem_event_cond.signal();
 	return true;
 }
@@ -1317,8 +1466,6 @@ bool ABCVm::addEvent(_NR<EventDispatcher> obj ,_R<Event> ev, bool isGlobalMessag
 	}
 
 
-	Locker l(event_queue_mutex);
-
 	//If the system should terminate new events are not accepted
 	if(shuttingdown)
 	{
@@ -1330,15 +1477,70 @@ bool ABCVm::addEvent(_NR<EventDispatcher> obj ,_R<Event> ev, bool isGlobalMessag
 	}
 	if (!obj.isNull())
 		obj->onNewEvent(ev.getPtr());
-	events_queue.push_back(pair<_NR<EventDispatcher>,_R<Event>>(obj, ev));
 	RELEASE_WRITE(ev->queued,true);
-	sem_event_cond.signal();
+	// the vm thread is only woken up if it is waiting for events
+	if (events_intake.push(pair<_NR<EventDispatcher>,_R<Event>>(obj, ev)))
+	{
+		Locker l(event_queue_mutex);
+		sem_event_cond.signal();
+	}
+	// the shutdown may have started after the check above
+	if(shuttingdown && rejectLateEvents())
+		return false;
 	if (isGlobalMessage)
 	{
 		m_sys->addEventToBackgroundWorkers(obj,ev);
 	}
 	return true;
 }
+/*! \brief enqueue several events at once, the vm thread is woken up only once
+* * \param events the events, a SyncEvent is appended if sync is true
+* * \param sync wait until the vm has handled all events */
+void ABCVm::addEventBatch(std::vector<std::pair<_NR<EventDispatcher>,_R<Event>>>& events, bool sync)
+{
+	assert(!sync || !isVmThread());
+	_NR<SyncEvent> syncevent;
+	if (sync)
+	{
+		syncevent = _MR(new (m_sys->unaccountedMemory) SyncEvent());
+		events.push_back(pair<_NR<EventDispatcher>,_R<Event>>(NullRef,syncevent));
+	}
+	bool wakeup = false;
+	for (auto it = events.begin(); it != events.end(); it++)
+	{
+		_NR<EventDispatcher> obj = it->first;
+		_R<Event> ev = it->second;
+		if (!obj.isNull() && ev->getInstanceWorker() && !ev->getInstanceWorker()->isPrimordial)
+		{
+			ev->getInstanceWorker()->addEvent(obj,ev);
+			continue;
+		}
+		//If the system should terminate new events are not accepted
+		if(shuttingdown)
+		{
+			if (ev->is<WaitableEvent>())
+				ev->as<WaitableEvent>()->signal();
+			if (obj)
+				obj->afterHandleEvent(ev.getPtr());
+			continue;
+		}
+		if (!obj.isNull())
+			obj->onNewEvent(ev.getPtr());
+		RELEASE_WRITE(ev->queued,true);
+		if (events_intake.push(*it))
+			wakeup = true;
+	}
+	if (wakeup)
+	{
+		Locker l(event_queue_mutex);
+		sem_event_cond.signal();
+	}
+	// the shutdown may have started while the events were added
+	if(shuttingdown)
+		rejectLateEvents();
+	if (sync)
+		syncevent->wait();
+}
 bool ABCVm::addIdleEvent(_NR<EventDispatcher> obj ,_R<Event> ev, bool removeprevious)
 {
 	Locker l(event_queue_mutex);
@@ -1460,6 +1662,7 @@ void ABCVm::checkExternalCallEvent()
 	if (shuttingdown)
 		return;
 	event_queue_mutex.lock();
+	drainEventIntake();
 	if (events_queue.size() == 0)
 	{
 		event_queue_mutex.unlock();
@@ -1471,6 +1674,10 @@ void ABCVm::checkExternalCallEvent()
 	else
 		event_queue_mutex.unlock();
 }
+uint32_t ABCVm::drainEventIntake()
+{
+	return events_intake.drainTo(events_queue);
+}
 void ABCVm::handleFrontEvent()
 {
 	pair<_NR<EventDispatcher>,_R<Event>> e=events_queue.front();
@@ -1510,13 +1717,7 @@ void ABCVm::handleFrontEvent()
 	}
 	catch(ASObject*& e)
 	{
-		ASWorker* wrk = e->getInstanceWorker();
-		if (!wrk->callStack.empty())
-		{
-			call_context* saved_cc = wrk->callStack.back();
-			wrk->callStack.pop_back();
-			wrk->decStack(saved_cc);
-		}
+		// the call frames were already removed from the call stack of the worker while unwinding
 		if(e->getClass())
 			LOG(LOG_ERROR,"Unhandled ActionScript exception in VM " << e->toString());
 		else
@@ -1697,6 +1898,7 @@ int ABCVm::Run(void* d)
 
 	/* set TLS variable for isVmThread() */
 	tls_set(is_vm_thread, GINT_TO_POINTER(1));
+	setEventSource(EVENTSOURCE_VM);
 #ifndef NDEBUG
 	inStartupOrClose= false;
 #endif
@@ -1796,13 +1998,22 @@ int ABCVm::Run(void* d)
 		th->deletableObjects.clear();
 		th->deletable_objects_mutex.unlock();
 		th->event_queue_mutex.lock();
+		th->drainEventIntake();
 		while(th->events_queue.empty() && !th->shuttingdown)
-			th->sem_event_cond.wait(th->event_queue_mutex);
+		{
+			th->events_intake.setConsumerWaiting(true);
+			// events added before the flag was set don't signal the condition
+			if (th->drainEventIntake() == 0)
+				th->sem_event_cond.wait(th->event_queue_mutex);
+			th->events_intake.setConsumerWaiting(false);
+			th->drainEventIntake();
+		}
 		if(th->shuttingdown)
 		{
 			//If the queue is empty stop immediately
 			if(th->events_queue.empty())
 			{
+				th->eventsclosed=true;
 				th->event_queue_mutex.unlock();
 				break;
 			}
@@ -1829,6 +2040,7 @@ int ABCVm::Run(void* d)
 		delete th->module;
 	}
 #endif
+	th->events_intake.stats.log("VM");
 #ifndef NDEBUG
 	inStartupOrClose= true;
 #endif
@@ -1839,7 +2051,15 @@ int ABCVm::Run(void* d)
 void ABCVm::signalEventWaiters()
 {
 	assert(shuttingdown);
-	//we do not need a lock because th->shuttingdown keeps other events from being enqueued
+	// producers check shuttingdown without the lock, so events may still be added concurrently, see rejectLateEvents()
+	Locker l(event_queue_mutex);
+	eventsclosed=true;
+	signalQueuedEvents();
+}
+
+void ABCVm::signalQueuedEvents()
+{
+	drainEventIntake();
 	while(!events_queue.empty())
 	{
 		pair<_NR<EventDispatcher>,_R<Event>> e=events_queue.front();
@@ -1849,6 +2069,15 @@ void ABCVm::signalEventWaiters()
 	}
 }
 
+bool ABCVm::rejectLateEvents()
+{
+	Locker l(event_queue_mutex);
+	// until the vm thread stopped handling events it also handles the late ones
+	if (eventsclosed)
+		signalQueuedEvents();
+	return eventsclosed;
+}
+
 void ABCVm::parseRPCMessage(_R<ByteArray> message, _NR<ASObject> client, _NR<Responder> responder)
 {
 	uint16_t version;
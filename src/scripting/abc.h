@@ -32,6 +32,7 @@
 #include "threading.h"
 #include "scripting/abcutils.h"
 #include "scripting/abctypes.h"
+#include "scripting/eventqueue.h"
 
 #ifdef LLVM_ENABLED
 namespace llvm {
@@ -133,7 +134,6 @@ public:
 	// indicates if the function code starts with getlocal_0/pushscope
 	bool needsscope;
 	bool needscoerceresult;
-	call_context cc;
 	method_info():
 #ifdef LLVM_ENABLED
 		llvmf(nullptr),
@@ -142,37 +142,9 @@ public:
 		profTime(0),
 		validProfName(false),
 #endif
-		f(nullptr),context(nullptr),body(nullptr),returnType(nullptr),hasExplicitTypes(false),needsscope(false),needscoerceresult(true),cc(this)
+		f(nullptr),context(nullptr),body(nullptr),returnType(nullptr),hasExplicitTypes(false),needsscope(false),needscoerceresult(true)
 	{
 	}
-	~method_info()
-	{
-		if (cc.locals)
-		{
-			delete[] cc.locals;
-			cc.locals=nullptr;
-		}
-		if (cc.stack)
-		{
-			delete[] cc.stack;
-			cc.stack=nullptr;
-		}
-		if (cc.scope_stack)
-		{
-			delete[] cc.scope_stack;
-			cc.scope_stack=nullptr;
-		}
-		if (cc.scope_stack_dynamic)
-		{
-			delete[] cc.scope_stack_dynamic;
-			cc.scope_stack_dynamic=nullptr;
-		}
-		if (cc.localslots)
-		{
-			delete[] cc.localslots;
-			cc.localslots=nullptr;
-		}
-	}
 };
 
 struct opcode_handler
@@ -205,6 +177,7 @@ struct typed_opcode_handler
 	ARGS_TYPE type;
 };
 
+class PreloadCache;
 class ABCContext
 {
 friend class ABCVm;
@@ -251,6 +224,22 @@ public:
 	std::unordered_map<uint32_t,asAtom> constantAtoms_cached;
 	ATOMIC_INT32(atomsCachedMaxID);
 	uint32_t addCachedConstantAtom(asAtom a);
+	// on-disk cache of the preloaded code of the methods, nullptr if disabled
+	PreloadCache* preloadcache;
+private:
+	// first preloading pass of likely hot method bodies, done by a job in the ThreadPool
+	Mutex backgroundpreloadmutex;
+	// result of the background preloading of every method body, owned by the context until taken
+	std::vector<preloadjumpinfo*> backgroundpreloadinfo;
+	// method bodies that were taken by ABCVm::preloadFunction
+	std::vector<bool> backgroundpreloadtaken;
+	IThreadJob* backgroundpreloadjob;
+	void startBackgroundPreload();
+public:
+	// runs the first preloading pass of a method body, called from the background job
+	void backgroundPreload(uint32_t bodyindex);
+	// returns the result of the background preloading and takes ownership of it, nullptr if not available
+	preloadjumpinfo* takeBackgroundPreloadInfo(method_body_info* body);
 	/**
 		Construct and insert in the a object a given trait
 		@param obj the tarhget object
@@ -313,6 +302,77 @@ public:
 struct BasicBlock;
 struct InferenceData;
 
+/*
+ * operand sources, operations and conditions for the template generated optimized opcode handlers
+ */
+template<int N> struct abc_operand_constant;
+template<int N> struct abc_operand_local;
+template<> struct abc_operand_constant<1>
+{
+	static FORCE_INLINE asAtom& get(call_context* context) { return *context->exec_pos->arg1_constant; }
+	static const char* name() { return "c"; }
+	static const bool islocal = false;
+};
+template<> struct abc_operand_constant<2>
+{
+	static FORCE_INLINE asAtom& get(call_context* context) { return *context->exec_pos->arg2_constant; }
+	static const char* name() { return "c"; }
+	static const bool islocal = false;
+};
+template<> struct abc_operand_local<1>
+{
+	static FORCE_INLINE asAtom& get(call_context* context) { return CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1); }
+	static const char* name() { return "l"; }
+	static const bool islocal = true;
+};
+template<> struct abc_operand_local<2>
+{
+	static FORCE_INLINE asAtom& get(call_context* context) { return CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2); }
+	static const char* name() { return "l"; }
+	static const bool islocal = true;
+};
+
+#define ABC_ARITHMETIC_OPERATION(opname) \
+struct abc_op_##opname \
+{ \
+	static FORCE_INLINE void apply(asAtom& a, ASWorker* wrk, asAtom& v2, bool forceint) { asAtomHandler::opname(a,wrk,v2,forceint); } \
+	static FORCE_INLINE void replace(asAtom& ret, ASWorker* wrk, const asAtom& v1, const asAtom& v2, bool forceint) { asAtomHandler::opname##replace(ret,wrk,v1,v2,forceint); } \
+	static const char* name() { return #opname "_"; } \
+};
+ABC_ARITHMETIC_OPERATION(subtract)
+ABC_ARITHMETIC_OPERATION(multiply)
+ABC_ARITHMETIC_OPERATION(divide)
+ABC_ARITHMETIC_OPERATION(modulo)
+#undef ABC_ARITHMETIC_OPERATION
+// add has its own handler for the stack result (see abc_add_operands), so only replace is needed
+struct abc_op_add
+{
+	static FORCE_INLINE void replace(asAtom& ret, ASWorker* wrk, const asAtom& v1, const asAtom& v2, bool forceint) { asAtomHandler::addreplace(ret,wrk,v1,v2,forceint); }
+	static const char* name() { return "add_"; }
+};
+
+// constantfirst: the constant operand is passed as first argument if a local is compared to a constant
+#define ABC_COMPARE_CONDITION(condname,condition,constantfirst) \
+struct abc_compare_##condname \
+{ \
+	static FORCE_INLINE bool cond(asAtom& v1, ASWorker* wrk, asAtom& v2) { return condition; } \
+	static const char* name() { return "if" #condname "_"; } \
+	static const bool swaplocalconstant = constantfirst; \
+};
+ABC_COMPARE_CONDITION(lt,asAtomHandler::isLess(v1,wrk,v2) == TTRUE,false)
+ABC_COMPARE_CONDITION(le,asAtomHandler::isLess(v2,wrk,v1) == TFALSE,false)
+ABC_COMPARE_CONDITION(gt,asAtomHandler::isLess(v2,wrk,v1) == TTRUE,false)
+ABC_COMPARE_CONDITION(ge,asAtomHandler::isLess(v1,wrk,v2) == TFALSE,false)
+ABC_COMPARE_CONDITION(nlt,!(asAtomHandler::isLess(v1,wrk,v2) == TTRUE),false)
+ABC_COMPARE_CONDITION(nle,!(asAtomHandler::isLess(v2,wrk,v1) == TFALSE),false)
+ABC_COMPARE_CONDITION(ngt,!(asAtomHandler::isLess(v2,wrk,v1) == TTRUE),false)
+ABC_COMPARE_CONDITION(nge,!(asAtomHandler::isLess(v1,wrk,v2) == TFALSE),false)
+ABC_COMPARE_CONDITION(eq,asAtomHandler::isEqual(v1,wrk,v2),true)
+ABC_COMPARE_CONDITION(ne,!asAtomHandler::isEqual(v1,wrk,v2),true)
+ABC_COMPARE_CONDITION(stricteq,asAtomHandler::isEqualStrict(v1,wrk,v2),false)
+ABC_COMPARE_CONDITION(strictne,!asAtomHandler::isEqualStrict(v1,wrk,v2),false)
+#undef ABC_COMPARE_CONDITION
+
 class ABCVm
 {
 friend class ABCContext;
@@ -548,13 +608,23 @@ private:
 
 	//Event handling
 	volatile bool shuttingdown;
+	// set with event_queue_mutex held once the queued events won't be handled anymore
+	bool eventsclosed;
 	typedef std::pair<_NR<EventDispatcher>,_R<Event>> eventType;
 	std::deque<eventType, reporter_allocator<eventType>> events_queue;
+	// events added by addEvent(), moved to events_queue by the vm thread without blocking the producers
+	EventQueue<eventType> events_intake;
 	std::list<eventType, reporter_allocator<eventType>> idleevents_queue;
 	std::list<eventType, reporter_allocator<eventType>> event_buffer;
 	void handleEvent(std::pair<_NR<EventDispatcher>,_R<Event> > e);
 	void handleFrontEvent();
+	// moves the events from events_intake to events_queue, event_queue_mutex has to be locked
+	uint32_t drainEventIntake();
 	void signalEventWaiters();
+	// signals the waitable events in the queue and removes all events, event_queue_mutex has to be locked
+	void signalQueuedEvents();
+	// called by producers that found the vm shutting down after they added events, returns true if the events won't be handled
+	bool rejectLateEvents();
 	void buildClassAndInjectBase(const std::string& s, _R<RootMovieClip> base);
 	Class_inherit* findClassInherit(const std::string& s, RootMovieClip* r);
 
@@ -567,6 +637,112 @@ private:
 	// The base to assign to the next loaded context
 	ATOMIC_INT32(nextNamespaceBase);
 
+	// opcodes that can't finish the execution of a function, used by the jit
+	static bool isNonTerminatingOpcode(abc_function f);
+
+	/*
+	 * template generated optimized opcode handlers.
+	 * ARG1/ARG2 are the operand sources (abc_operand_constant/abc_operand_local),
+	 * the result is pushed on the stack, stored in a local or stored in a slot of a local without coercion
+	 */
+	template<class OP, class ARG1, class ARG2>
+	static void abc_arithmetic(call_context* context)
+	{
+		LOG_CALL(OP::name()<<ARG1::name()<<ARG2::name());
+		asAtom res = ARG1::get(context);
+		OP::apply(res,context->worker,ARG2::get(context),context->exec_pos->local3.flags & ABC_OP_FORCEINT);
+		RUNTIME_STACK_PUSH(context,res);
+		++(context->exec_pos);
+	}
+	template<class OP, class ARG1, class ARG2>
+	static void abc_arithmetic_localresult(call_context* context)
+	{
+		LOG_CALL(OP::name()<<ARG1::name()<<ARG2::name()<<"l");
+		OP::replace(CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos),context->worker,ARG1::get(context),ARG2::get(context),context->exec_pos->local3.flags & ABC_OP_FORCEINT);
+		++(context->exec_pos);
+	}
+	template<class OP, class ARG1, class ARG2>
+	static void abc_arithmetic_setslotnocoerce(call_context* context)
+	{
+		LOG_CALL(OP::name()<<ARG1::name()<<ARG2::name()<<"s");
+		asAtom res = asAtomHandler::invalidAtom;
+		OP::replace(res,context->worker,ARG1::get(context),ARG2::get(context),context->exec_pos->local3.flags & ABC_OP_FORCEINT);
+
+		asAtom obj = CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos);
+		uint32_t t = context->exec_pos->local3.flags & ~ABC_OP_BITMASK_USED;
+		asAtomHandler::getObjectNoCheck(obj)->setSlotNoCoerce(t,res);
+		++(context->exec_pos);
+	}
+	template<class ARG1, class ARG2>
+	static void abc_add_operands(call_context* context)
+	{
+		LOG_CALL("add_"<<ARG1::name()<<ARG2::name());
+		asAtom res = ARG1::get(context);
+		ASObject* o = ARG1::islocal ? asAtomHandler::getObject(res) : nullptr;
+		if (o)
+			o->incRef(); // ensure old value is not replaced
+		if (asAtomHandler::add(res,ARG2::get(context),context->worker,context->exec_pos->local3.flags & ABC_OP_FORCEINT))
+		{
+			if (o)
+				o->decRef();
+		}
+		RUNTIME_STACK_PUSH(context,res);
+		++(context->exec_pos);
+	}
+	// setslot/setslotNoCoerce, ARG1 is the object, ARG2 the value and the slot id is stored in arg3_uint
+	template<class ARG1, class ARG2, bool coerce>
+	static void abc_setslot_operands(call_context* context)
+	{
+		asAtom v1 = ARG1::get(context);
+		asAtom v2 = ARG2::get(context);
+		uint32_t t = context->exec_pos->arg3_uint;
+		LOG_CALL((coerce ? "setSlot_" : "setSlotNoCoerce_")<<ARG1::name()<<ARG2::name()<<" "<< t << " "<< asAtomHandler::toDebugString(v2) << " "<< asAtomHandler::toDebugString(v1));
+		if (!coerce)
+			asAtomHandler::getObjectNoCheck(v1)->setSlotNoCoerce(t,v2);
+		else if (asAtomHandler::getObject(v1)->setSlot(context->worker,t,v2))
+			ASATOM_INCREF(v2);
+		++(context->exec_pos);
+	}
+	// conditional jump, the jump offset is stored in arg3_int
+	template<class CMP, class ARG1, class ARG2>
+	static void abc_ifcompare(call_context* context)
+	{
+		bool cond;
+		if (CMP::swaplocalconstant && ARG1::islocal && !ARG2::islocal)
+			cond=CMP::cond(ARG2::get(context),context->worker,ARG1::get(context));
+		else
+			cond=CMP::cond(ARG1::get(context),context->worker,ARG2::get(context));
+		LOG_CALL(CMP::name()<<ARG1::name()<<ARG2::name()<<" (" << ((cond)?"taken)":"not taken)"));
+		if(cond)
+			context->exec_pos += context->exec_pos->arg3_int;
+		else
+			++(context->exec_pos);
+	}
+	/*
+	 * superinstruction for inclocal_i/declocal_i directly followed by a conditional jump:
+	 * the conditional jump is executed with the operands of the following instruction,
+	 * which is kept in place as it may be a jump target
+	 */
+	template<class CMP, class ARG1, class ARG2, bool increment>
+	static void abc_inclocal_i_ifcompare(call_context* context)
+	{
+		int32_t t = context->exec_pos->arg1_uint;
+		LOG_CALL((increment ? "incLocal_i_if " : "decLocal_i_if ") << t << " "<< context->exec_pos->arg2_int);
+		if (increment)
+			asAtomHandler::increment_i(CONTEXT_GETLOCAL(context,t),context->worker,context->exec_pos->arg2_int);
+		else
+			asAtomHandler::decrement_i(CONTEXT_GETLOCAL(context,t),context->worker,context->exec_pos->arg2_int);
+		++(context->exec_pos);
+		if (USUALLY_FALSE(context->exceptionthrown))
+			return;
+		abc_ifcompare<CMP,ARG1,ARG2>(context);
+	}
+	// replaces inclocal_i/declocal_i followed by a conditional jump with the corresponding superinstruction
+	static void fuseSuperInstructions(method_body_info* body);
+	// on-disk cache of preloaded code, see preloadcache.h
+	static bool loadFromPreloadCache(SyntheticFunction* function);
+	static void storeInPreloadCache(SyntheticFunction* function, const std::vector<uint8_t>& pointerslots, const std::set<Class_base*>& resolvedclasses);
+
 	static void abc_bkpt(call_context* context);// 0x01
 	static void abc_nop(call_context* context);
 	static void abc_throw(call_context* context);
@@ -577,25 +753,9 @@ private:
 	static void abc_kill(call_context* context);
 	static void abc_label(call_context* context);
 	static void abc_ifnlt(call_context* context);
-	static void abc_ifnlt_constant_constant(call_context* context);
-	static void abc_ifnlt_local_constant(call_context* context);
-	static void abc_ifnlt_constant_local(call_context* context);
-	static void abc_ifnlt_local_local(call_context* context);
 	static void abc_ifnle(call_context* context);
-	static void abc_ifnle_constant_constant(call_context* context);
-	static void abc_ifnle_local_constant(call_context* context);
-	static void abc_ifnle_constant_local(call_context* context);
-	static void abc_ifnle_local_local(call_context* context);
 	static void abc_ifngt(call_context* context);
-	static void abc_ifngt_constant_constant(call_context* context);
-	static void abc_ifngt_local_constant(call_context* context);
-	static void abc_ifngt_constant_local(call_context* context);
-	static void abc_ifngt_local_local(call_context* context);
 	static void abc_ifnge(call_context* context);
-	static void abc_ifnge_constant_constant(call_context* context);
-	static void abc_ifnge_local_constant(call_context* context);
-	static void abc_ifnge_constant_local(call_context* context);
-	static void abc_ifnge_local_local(call_context* context);
 
 	static void abc_jump(call_context* context);// 0x10
 	static void abc_iftrue(call_context* context);
@@ -609,45 +769,13 @@ private:
 	static void abc_iffalse_dup_constant(call_context* context);
 	static void abc_iffalse_dup_local(call_context* context);
 	static void abc_ifeq(call_context* context);
-	static void abc_ifeq_constant_constant(call_context* context);
-	static void abc_ifeq_local_constant(call_context* context);
-	static void abc_ifeq_constant_local(call_context* context);
-	static void abc_ifeq_local_local(call_context* context);
 	static void abc_ifne(call_context* context);
-	static void abc_ifne_constant_constant(call_context* context);
-	static void abc_ifne_local_constant(call_context* context);
-	static void abc_ifne_constant_local(call_context* context);
-	static void abc_ifne_local_local(call_context* context);
 	static void abc_iflt(call_context* context);
-	static void abc_iflt_constant_constant(call_context* context);
-	static void abc_iflt_local_constant(call_context* context);
-	static void abc_iflt_constant_local(call_context* context);
-	static void abc_iflt_local_local(call_context* context);
 	static void abc_ifle(call_context* context);
-	static void abc_ifle_constant_constant(call_context* context);
-	static void abc_ifle_local_constant(call_context* context);
-	static void abc_ifle_constant_local(call_context* context);
-	static void abc_ifle_local_local(call_context* context);
 	static void abc_ifgt(call_context* context);
-	static void abc_ifgt_constant_constant(call_context* context);
-	static void abc_ifgt_local_constant(call_context* context);
-	static void abc_ifgt_constant_local(call_context* context);
-	static void abc_ifgt_local_local(call_context* context);
 	static void abc_ifge(call_context* context);
-	static void abc_ifge_constant_constant(call_context* context);
-	static void abc_ifge_local_constant(call_context* context);
-	static void abc_ifge_constant_local(call_context* context);
-	static void abc_ifge_local_local(call_context* context);
 	static void abc_ifstricteq(call_context* context);
-	static void abc_ifstricteq_constant_constant(call_context* context);
-	static void abc_ifstricteq_local_constant(call_context* context);
-	static void abc_ifstricteq_constant_local(call_context* context);
-	static void abc_ifstricteq_local_local(call_context* context);
 	static void abc_ifstrictne(call_context* context);
-	static void abc_ifstrictne_constant_constant(call_context* context);
-	static void abc_ifstrictne_local_constant(call_context* context);
-	static void abc_ifstrictne_constant_local(call_context* context);
-	static void abc_ifstrictne_local_local(call_context* context);
 	static void abc_lookupswitch(call_context* context);
 	static void abc_lookupswitch_constant(call_context* context);
 	static void abc_lookupswitch_local(call_context* context);
@@ -919,14 +1047,6 @@ private:
 	static void abc_getslot_local_setslotnocoerce(call_context* context);
 
 	static void abc_setslot(call_context* context);
-	static void abc_setslot_constant_constant(call_context* context);
-	static void abc_setslot_local_constant(call_context* context);
-	static void abc_setslot_constant_local(call_context* context);
-	static void abc_setslot_local_local(call_context* context);
-	static void abc_setslotNoCoerce_constant_constant(call_context* context);
-	static void abc_setslotNoCoerce_local_constant(call_context* context);
-	static void abc_setslotNoCoerce_constant_local(call_context* context);
-	static void abc_setslotNoCoerce_local_local(call_context* context);
 	static void abc_setslotNoCoerce_local_local_li32(call_context* context);
 	
 	static void abc_getglobalSlot(call_context* context);
@@ -1010,70 +1130,10 @@ private:
 	static void abc_bitnot(call_context* context);
 
 	static void abc_add(call_context* context); //0xa0
-	static void abc_add_constant_constant(call_context* context);
-	static void abc_add_local_constant(call_context* context);
-	static void abc_add_constant_local(call_context* context);
-	static void abc_add_local_local(call_context* context);
-	static void abc_add_constant_constant_localresult(call_context* context);
-	static void abc_add_local_constant_localresult(call_context* context);
-	static void abc_add_constant_local_localresult(call_context* context);
-	static void abc_add_local_local_localresult(call_context* context);
-	static void abc_add_constant_constant_setslotnocoerce(call_context* context);
-	static void abc_add_local_constant_setslotnocoerce(call_context* context);
-	static void abc_add_constant_local_setslotnocoerce(call_context* context);
-	static void abc_add_local_local_setslotnocoerce(call_context* context);
 	static void abc_subtract(call_context* context);
-	static void abc_subtract_constant_constant(call_context* context);
-	static void abc_subtract_local_constant(call_context* context);
-	static void abc_subtract_constant_local(call_context* context);
-	static void abc_subtract_local_local(call_context* context);
-	static void abc_subtract_constant_constant_localresult(call_context* context);
-	static void abc_subtract_local_constant_localresult(call_context* context);
-	static void abc_subtract_constant_local_localresult(call_context* context);
-	static void abc_subtract_local_local_localresult(call_context* context);
-	static void abc_subtract_constant_constant_setslotnocoerce(call_context* context);
-	static void abc_subtract_local_constant_setslotnocoerce(call_context* context);
-	static void abc_subtract_constant_local_setslotnocoerce(call_context* context);
-	static void abc_subtract_local_local_setslotnocoerce(call_context* context);
 	static void abc_multiply(call_context* context);
-	static void abc_multiply_constant_constant(call_context* context);
-	static void abc_multiply_local_constant(call_context* context);
-	static void abc_multiply_constant_local(call_context* context);
-	static void abc_multiply_local_local(call_context* context);
-	static void abc_multiply_constant_constant_localresult(call_context* context);
-	static void abc_multiply_local_constant_localresult(call_context* context);
-	static void abc_multiply_constant_local_localresult(call_context* context);
-	static void abc_multiply_local_local_localresult(call_context* context);
-	static void abc_multiply_constant_constant_setslotnocoerce(call_context* context);
-	static void abc_multiply_local_constant_setslotnocoerce(call_context* context);
-	static void abc_multiply_constant_local_setslotnocoerce(call_context* context);
-	static void abc_multiply_local_local_setslotnocoerce(call_context* context);
 	static void abc_divide(call_context* context);
-	static void abc_divide_constant_constant(call_context* context);
-	static void abc_divide_local_constant(call_context* context);
-	static void abc_divide_constant_local(call_context* context);
-	static void abc_divide_local_local(call_context* context);
-	static void abc_divide_constant_constant_localresult(call_context* context);
-	static void abc_divide_local_constant_localresult(call_context* context);
-	static void abc_divide_constant_local_localresult(call_context* context);
-	static void abc_divide_local_local_localresult(call_context* context);
-	static void abc_divide_constant_constant_setslotnocoerce(call_context* context);
-	static void abc_divide_local_constant_setslotnocoerce(call_context* context);
-	static void abc_divide_constant_local_setslotnocoerce(call_context* context);
-	static void abc_divide_local_local_setslotnocoerce(call_context* context);
 	static void abc_modulo(call_context* context);
-	static void abc_modulo_constant_constant(call_context* context);
-	static void abc_modulo_local_constant(call_context* context);
-	static void abc_modulo_constant_local(call_context* context);
-	static void abc_modulo_local_local(call_context* context);
-	static void abc_modulo_constant_constant_localresult(call_context* context);
-	static void abc_modulo_local_constant_localresult(call_context* context);
-	static void abc_modulo_constant_local_localresult(call_context* context);
-	static void abc_modulo_local_local_localresult(call_context* context);
-	static void abc_modulo_constant_constant_setslotnocoerce(call_context* context);
-	static void abc_modulo_local_constant_setslotnocoerce(call_context* context);
-	static void abc_modulo_constant_local_setslotnocoerce(call_context* context);
-	static void abc_modulo_local_local_setslotnocoerce(call_context* context);
 	static void abc_lshift(call_context* context);
 	static void abc_lshift_constant_constant(call_context* context);
 	static void abc_lshift_local_constant(call_context* context);
@@ -1385,10 +1445,17 @@ public:
 	void registerClassesAVM1();
 	static int Run(void* d);
 	static void executeFunction(call_context* context);
+#ifdef JIT_ENABLED
+	// baseline jit for x86-64, see abc_jit.cpp
+	static bool jitFunction(method_body_info* body);
+	static void executeFunctionJit(call_context* context);
+	static void releaseJitCode(method_body_info* body);
+#endif
 	static void dumpOpcodeCounters(uint32_t threshhold);
 	static void clearOpcodeCounters();
 	
 	static void preloadFunction(SyntheticFunction *function,ASWorker* wrk);
+	static void scanJumpTargets(ABCContext* context, method_body_info* body, const std::vector<exception_info_abc>& exceptions, preloadjumpinfo& info);
 	static ASObject* executeFunctionFast(const SyntheticFunction* function, call_context* context, ASObject *caller);
 	static void optimizeFunction(SyntheticFunction* function);
 	static void verifyBranch(std::set<uint32_t>& pendingBlock,std::map<uint32_t,BasicBlock>& basicBlocks,
@@ -1407,6 +1474,7 @@ public:
 	static Type* getLocalType(const SyntheticFunction* f, unsigned localIndex);
 
 	bool addEvent(_NR<EventDispatcher>,_R<Event>, bool isGlobalMessage=false) DLL_PUBLIC;
+	void addEventBatch(std::vector<std::pair<_NR<EventDispatcher>,_R<Event>>>& events, bool sync);
 	bool prependEvent(_NR<EventDispatcher>, _R<Event> , bool force=false) DLL_PUBLIC;
 	bool addIdleEvent(_NR<EventDispatcher>, _R<Event> , bool removeprevious=false) DLL_PUBLIC;
 	bool addBufferEvent(_NR<EventDispatcher>, _R<Event>) DLL_PUBLIC;
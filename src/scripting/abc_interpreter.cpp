@@ -32,9 +32,11 @@
 #include "scripting/toplevel/UInteger.h"
 #include "scripting/toplevel/RegExp.h"
 #include "scripting/toplevel/Vector.h"
+#include "scripting/preloadcache.h"
 #include "parsing/streams.h"
 #include <string>
 #include <sstream>
+#include <algorithm>
 
 using namespace std;
 using namespace lightspark;
@@ -117,6 +119,24 @@ void ABCVm::clearOpcodeCounters()
 }
 #endif
 
+/*
+ * Opcodes that never set the return value and can't raise an exception.
+ * The only error they can encounter is a stack overflow/underflow, which is ruled out
+ * by the max_stack check of the method body
+ */
+bool ABCVm::isNonTerminatingOpcode(abc_function f)
+{
+	static const std::unordered_set<abc_function> opcodes = {
+		abc_nop, abc_label, abc_jump, abc_kill,
+		abc_pushnull, abc_pushundefined, abc_pushbyte, abc_pushshort,
+		abc_pushtrue, abc_pushfalse, abc_pushnan, abc_pushstring,
+		abc_pushint, abc_pushuint, abc_pushdouble,
+		abc_pop, abc_dup, abc_swap,
+		abc_getlocal, abc_getlocal_0, abc_getlocal_1, abc_getlocal_2, abc_getlocal_3
+	};
+	return opcodes.find(f) != opcodes.end();
+}
+
 void ABCVm::executeFunction(call_context* context)
 {
 #ifdef PROFILING_SUPPORT
@@ -463,14 +483,14 @@ abc_function ABCVm::abcfunctions[]={
 	abc_setPropertyStaticName_local_local,
 
 	// optimized arithmetical operations for all possible combinations of operand1/operand2/result
-	abc_multiply_constant_constant, // 0x120 ABC_OP_OPTIMZED_MULTIPLY
-	abc_multiply_local_constant,
-	abc_multiply_constant_local,
-	abc_multiply_local_local,
-	abc_multiply_constant_constant_localresult,
-	abc_multiply_local_constant_localresult,
-	abc_multiply_constant_local_localresult,
-	abc_multiply_local_local_localresult,
+	abc_arithmetic<abc_op_multiply,abc_operand_constant<1>,abc_operand_constant<2>>, // 0x120 ABC_OP_OPTIMZED_MULTIPLY
+	abc_arithmetic<abc_op_multiply,abc_operand_local<1>,abc_operand_constant<2>>,
+	abc_arithmetic<abc_op_multiply,abc_operand_constant<1>,abc_operand_local<2>>,
+	abc_arithmetic<abc_op_multiply,abc_operand_local<1>,abc_operand_local<2>>,
+	abc_arithmetic_localresult<abc_op_multiply,abc_operand_constant<1>,abc_operand_constant<2>>,
+	abc_arithmetic_localresult<abc_op_multiply,abc_operand_local<1>,abc_operand_constant<2>>,
+	abc_arithmetic_localresult<abc_op_multiply,abc_operand_constant<1>,abc_operand_local<2>>,
+	abc_arithmetic_localresult<abc_op_multiply,abc_operand_local<1>,abc_operand_local<2>>,
 	abc_bitor_constant_constant, // 0x128 ABC_OP_OPTIMZED_BITOR
 	abc_bitor_local_constant,
 	abc_bitor_constant_local,
@@ -488,40 +508,40 @@ abc_function ABCVm::abcfunctions[]={
 	abc_bitxor_local_constant_localresult,
 	abc_bitxor_constant_local_localresult,
 	abc_bitxor_local_local_localresult,
-	abc_subtract_constant_constant, // 0x138 ABC_OP_OPTIMZED_SUBTRACT
-	abc_subtract_local_constant,
-	abc_subtract_constant_local,
-	abc_subtract_local_local,
-	abc_subtract_constant_constant_localresult,
-	abc_subtract_local_constant_localresult,
-	abc_subtract_constant_local_localresult,
-	abc_subtract_local_local_localresult,
+	abc_arithmetic<abc_op_subtract,abc_operand_constant<1>,abc_operand_constant<2>>, // 0x138 ABC_OP_OPTIMZED_SUBTRACT
+	abc_arithmetic<abc_op_subtract,abc_operand_local<1>,abc_operand_constant<2>>,
+	abc_arithmetic<abc_op_subtract,abc_operand_constant<1>,abc_operand_local<2>>,
+	abc_arithmetic<abc_op_subtract,abc_operand_local<1>,abc_operand_local<2>>,
+	abc_arithmetic_localresult<abc_op_subtract,abc_operand_constant<1>,abc_operand_constant<2>>,
+	abc_arithmetic_localresult<abc_op_subtract,abc_operand_local<1>,abc_operand_constant<2>>,
+	abc_arithmetic_localresult<abc_op_subtract,abc_operand_constant<1>,abc_operand_local<2>>,
+	abc_arithmetic_localresult<abc_op_subtract,abc_operand_local<1>,abc_operand_local<2>>,
 
-	abc_add_constant_constant, // 0x140 ABC_OP_OPTIMZED_ADD
-	abc_add_local_constant,
-	abc_add_constant_local,
-	abc_add_local_local,
-	abc_add_constant_constant_localresult,
-	abc_add_local_constant_localresult,
-	abc_add_constant_local_localresult,
-	abc_add_local_local_localresult,
-	abc_divide_constant_constant, // 0x148 ABC_OP_OPTIMZED_DIVIDE
-	abc_divide_local_constant,
-	abc_divide_constant_local,
-	abc_divide_local_local,
-	abc_divide_constant_constant_localresult,
-	abc_divide_local_constant_localresult,
-	abc_divide_constant_local_localresult,
-	abc_divide_local_local_localresult,
+	abc_add_operands<abc_operand_constant<1>,abc_operand_constant<2>>, // 0x140 ABC_OP_OPTIMZED_ADD
+	abc_add_operands<abc_operand_local<1>,abc_operand_constant<2>>,
+	abc_add_operands<abc_operand_constant<1>,abc_operand_local<2>>,
+	abc_add_operands<abc_operand_local<1>,abc_operand_local<2>>,
+	abc_arithmetic_localresult<abc_op_add,abc_operand_constant<1>,abc_operand_constant<2>>,
+	abc_arithmetic_localresult<abc_op_add,abc_operand_local<1>,abc_operand_constant<2>>,
+	abc_arithmetic_localresult<abc_op_add,abc_operand_constant<1>,abc_operand_local<2>>,
+	abc_arithmetic_localresult<abc_op_add,abc_operand_local<1>,abc_operand_local<2>>,
+	abc_arithmetic<abc_op_divide,abc_operand_constant<1>,abc_operand_constant<2>>, // 0x148 ABC_OP_OPTIMZED_DIVIDE
+	abc_arithmetic<abc_op_divide,abc_operand_local<1>,abc_operand_constant<2>>,
+	abc_arithmetic<abc_op_divide,abc_operand_constant<1>,abc_operand_local<2>>,
+	abc_arithmetic<abc_op_divide,abc_operand_local<1>,abc_operand_local<2>>,
+	abc_arithmetic_localresult<abc_op_divide,abc_operand_constant<1>,abc_operand_constant<2>>,
+	abc_arithmetic_localresult<abc_op_divide,abc_operand_local<1>,abc_operand_constant<2>>,
+	abc_arithmetic_localresult<abc_op_divide,abc_operand_constant<1>,abc_operand_local<2>>,
+	abc_arithmetic_localresult<abc_op_divide,abc_operand_local<1>,abc_operand_local<2>>,
 
-	abc_modulo_constant_constant, // 0x150 ABC_OP_OPTIMZED_MODULO
-	abc_modulo_local_constant,
-	abc_modulo_constant_local,
-	abc_modulo_local_local,
-	abc_modulo_constant_constant_localresult,
-	abc_modulo_local_constant_localresult,
-	abc_modulo_constant_local_localresult,
-	abc_modulo_local_local_localresult,
+	abc_arithmetic<abc_op_modulo,abc_operand_constant<1>,abc_operand_constant<2>>, // 0x150 ABC_OP_OPTIMZED_MODULO
+	abc_arithmetic<abc_op_modulo,abc_operand_local<1>,abc_operand_constant<2>>,
+	abc_arithmetic<abc_op_modulo,abc_operand_constant<1>,abc_operand_local<2>>,
+	abc_arithmetic<abc_op_modulo,abc_operand_local<1>,abc_operand_local<2>>,
+	abc_arithmetic_localresult<abc_op_modulo,abc_operand_constant<1>,abc_operand_constant<2>>,
+	abc_arithmetic_localresult<abc_op_modulo,abc_operand_local<1>,abc_operand_constant<2>>,
+	abc_arithmetic_localresult<abc_op_modulo,abc_operand_constant<1>,abc_operand_local<2>>,
+	abc_arithmetic_localresult<abc_op_modulo,abc_operand_local<1>,abc_operand_local<2>>,
 	abc_lshift_constant_constant, // 0x158 ABC_OP_OPTIMZED_LSHIFT
 	abc_lshift_local_constant,
 	abc_lshift_constant_local,
@@ -564,38 +584,38 @@ abc_function ABCVm::abcfunctions[]={
 	abc_getProperty_local_constant_localresult,
 	abc_getProperty_constant_local_localresult,
 	abc_getProperty_local_local_localresult,
-	abc_ifeq_constant_constant, // 0x180 ABC_OP_OPTIMZED_IFEQ
-	abc_ifeq_local_constant,
-	abc_ifeq_constant_local,
-	abc_ifeq_local_local,
-	abc_ifne_constant_constant, // 0x184 ABC_OP_OPTIMZED_IFNE
-	abc_ifne_local_constant,
-	abc_ifne_constant_local,
-	abc_ifne_local_local,
-	abc_iflt_constant_constant, // 0x188 ABC_OP_OPTIMZED_IFLT
-	abc_iflt_local_constant,
-	abc_iflt_constant_local,
-	abc_iflt_local_local,
-	abc_ifle_constant_constant, // 0x18c ABC_OP_OPTIMZED_IFLE
-	abc_ifle_local_constant,
-	abc_ifle_constant_local,
-	abc_ifle_local_local,
-	abc_ifgt_constant_constant, // 0x190 ABC_OP_OPTIMZED_IFGT
-	abc_ifgt_local_constant,
-	abc_ifgt_constant_local,
-	abc_ifgt_local_local,
-	abc_ifge_constant_constant, // 0x194 ABC_OP_OPTIMZED_IFGE
-	abc_ifge_local_constant,
-	abc_ifge_constant_local,
-	abc_ifge_local_local,
-	abc_ifstricteq_constant_constant, // 0x198 ABC_OP_OPTIMZED_IFSTRICTEQ
-	abc_ifstricteq_local_constant,
-	abc_ifstricteq_constant_local,
-	abc_ifstricteq_local_local,
-	abc_ifstrictne_constant_constant, // 0x19c ABC_OP_OPTIMZED_IFSTRICTNE
-	abc_ifstrictne_local_constant,
-	abc_ifstrictne_constant_local,
-	abc_ifstrictne_local_local,
+	abc_ifcompare<abc_compare_eq,abc_operand_constant<1>,abc_operand_constant<2>>, // 0x180 ABC_OP_OPTIMZED_IFEQ
+	abc_ifcompare<abc_compare_eq,abc_operand_local<1>,abc_operand_constant<2>>,
+	abc_ifcompare<abc_compare_eq,abc_operand_constant<1>,abc_operand_local<2>>,
+	abc_ifcompare<abc_compare_eq,abc_operand_local<1>,abc_operand_local<2>>,
+	abc_ifcompare<abc_compare_ne,abc_operand_constant<1>,abc_operand_constant<2>>, // 0x184 ABC_OP_OPTIMZED_IFNE
+	abc_ifcompare<abc_compare_ne,abc_operand_local<1>,abc_operand_constant<2>>,
+	abc_ifcompare<abc_compare_ne,abc_operand_constant<1>,abc_operand_local<2>>,
+	abc_ifcompare<abc_compare_ne,abc_operand_local<1>,abc_operand_local<2>>,
+	abc_ifcompare<abc_compare_lt,abc_operand_constant<1>,abc_operand_constant<2>>, // 0x188 ABC_OP_OPTIMZED_IFLT
+	abc_ifcompare<abc_compare_lt,abc_operand_local<1>,abc_operand_constant<2>>,
+	abc_ifcompare<abc_compare_lt,abc_operand_constant<1>,abc_operand_local<2>>,
+	abc_ifcompare<abc_compare_lt,abc_operand_local<1>,abc_operand_local<2>>,
+	abc_ifcompare<abc_compare_le,abc_operand_constant<1>,abc_operand_constant<2>>, // 0x18c ABC_OP_OPTIMZED_IFLE
+	abc_ifcompare<abc_compare_le,abc_operand_local<1>,abc_operand_constant<2>>,
+	abc_ifcompare<abc_compare_le,abc_operand_constant<1>,abc_operand_local<2>>,
+	abc_ifcompare<abc_compare_le,abc_operand_local<1>,abc_operand_local<2>>,
+	abc_ifcompare<abc_compare_gt,abc_operand_constant<1>,abc_operand_constant<2>>, // 0x190 ABC_OP_OPTIMZED_IFGT
+	abc_ifcompare<abc_compare_gt,abc_operand_local<1>,abc_operand_constant<2>>,
+	abc_ifcompare<abc_compare_gt,abc_operand_constant<1>,abc_operand_local<2>>,
+	abc_ifcompare<abc_compare_gt,abc_operand_local<1>,abc_operand_local<2>>,
+	abc_ifcompare<abc_compare_ge,abc_operand_constant<1>,abc_operand_constant<2>>, // 0x194 ABC_OP_OPTIMZED_IFGE
+	abc_ifcompare<abc_compare_ge,abc_operand_local<1>,abc_operand_constant<2>>,
+	abc_ifcompare<abc_compare_ge,abc_operand_constant<1>,abc_operand_local<2>>,
+	abc_ifcompare<abc_compare_ge,abc_operand_local<1>,abc_operand_local<2>>,
+	abc_ifcompare<abc_compare_stricteq,abc_operand_constant<1>,abc_operand_constant<2>>, // 0x198 ABC_OP_OPTIMZED_IFSTRICTEQ
+	abc_ifcompare<abc_compare_stricteq,abc_operand_local<1>,abc_operand_constant<2>>,
+	abc_ifcompare<abc_compare_stricteq,abc_operand_constant<1>,abc_operand_local<2>>,
+	abc_ifcompare<abc_compare_stricteq,abc_operand_local<1>,abc_operand_local<2>>,
+	abc_ifcompare<abc_compare_strictne,abc_operand_constant<1>,abc_operand_constant<2>>, // 0x19c ABC_OP_OPTIMZED_IFSTRICTNE
+	abc_ifcompare<abc_compare_strictne,abc_operand_local<1>,abc_operand_constant<2>>,
+	abc_ifcompare<abc_compare_strictne,abc_operand_constant<1>,abc_operand_local<2>>,
+	abc_ifcompare<abc_compare_strictne,abc_operand_local<1>,abc_operand_local<2>>,
 
 	abc_callpropertyStaticName_constant_constant,// 0x1a0 ABC_OP_OPTIMZED_CALLPROPERTY_STATICNAME
 	abc_callpropertyStaticName_local_constant,
@@ -754,10 +774,10 @@ abc_function ABCVm::abcfunctions[]={
 	abc_sf64_constant_local,
 	abc_sf64_local_local,
 
-	abc_setslot_constant_constant, // 0x238 ABC_OP_OPTIMZED_SETSLOT
-	abc_setslot_local_constant,
-	abc_setslot_constant_local,
-	abc_setslot_local_local,
+	abc_setslot_operands<abc_operand_constant<1>,abc_operand_constant<2>,true>, // 0x238 ABC_OP_OPTIMZED_SETSLOT
+	abc_setslot_operands<abc_operand_local<1>,abc_operand_constant<2>,true>,
+	abc_setslot_operands<abc_operand_constant<1>,abc_operand_local<2>,true>,
+	abc_setslot_operands<abc_operand_local<1>,abc_operand_local<2>,true>,
 	abc_convert_i_constant,// 0x23c ABC_OP_OPTIMZED_CONVERTI
 	abc_convert_i_local,
 	abc_convert_i_constant_localresult,
@@ -780,10 +800,10 @@ abc_function ABCVm::abcfunctions[]={
 	abc_construct_constant_localresult,
 	abc_construct_local_localresult,
 
-	abc_setslotNoCoerce_constant_constant, // 0x250 ABC_OP_OPTIMZED_SETSLOT_NOCOERCE
-	abc_setslotNoCoerce_local_constant,
-	abc_setslotNoCoerce_constant_local,
-	abc_setslotNoCoerce_local_local,
+	abc_setslot_operands<abc_operand_constant<1>,abc_operand_constant<2>,false>, // 0x250 ABC_OP_OPTIMZED_SETSLOT_NOCOERCE
+	abc_setslot_operands<abc_operand_local<1>,abc_operand_constant<2>,false>,
+	abc_setslot_operands<abc_operand_constant<1>,abc_operand_local<2>,false>,
+	abc_setslot_operands<abc_operand_local<1>,abc_operand_local<2>,false>,
 	abc_callFunctionNoArgsVoid_constant, // 0x254 ABC_OP_OPTIMZED_CALLFUNCTION_NOARGS_VOID
 	abc_callFunctionNoArgsVoid_local,
 	abc_li8_constant_setslotnocoerce,// 0x256 ABC_OP_OPTIMZED_LI8_SETSLOT
@@ -856,14 +876,14 @@ abc_function ABCVm::abcfunctions[]={
 	abc_setPropertyInteger_local_local_constant,
 	abc_setPropertyInteger_local_constant_local,
 	abc_setPropertyInteger_local_local_local,
-	abc_ifnlt_constant_constant, // 0x298 ABC_OP_OPTIMZED_IFNLT
-	abc_ifnlt_local_constant,
-	abc_ifnlt_constant_local,
-	abc_ifnlt_local_local,
-	abc_ifnge_constant_constant, // 0x29c ABC_OP_OPTIMZED_IFNGE
-	abc_ifnge_local_constant,
-	abc_ifnge_constant_local,
-	abc_ifnge_local_local,
+	abc_ifcompare<abc_compare_nlt,abc_operand_constant<1>,abc_operand_constant<2>>, // 0x298 ABC_OP_OPTIMZED_IFNLT
+	abc_ifcompare<abc_compare_nlt,abc_operand_local<1>,abc_operand_constant<2>>,
+	abc_ifcompare<abc_compare_nlt,abc_operand_constant<1>,abc_operand_local<2>>,
+	abc_ifcompare<abc_compare_nlt,abc_operand_local<1>,abc_operand_local<2>>,
+	abc_ifcompare<abc_compare_nge,abc_operand_constant<1>,abc_operand_constant<2>>, // 0x29c ABC_OP_OPTIMZED_IFNGE
+	abc_ifcompare<abc_compare_nge,abc_operand_local<1>,abc_operand_constant<2>>,
+	abc_ifcompare<abc_compare_nge,abc_operand_constant<1>,abc_operand_local<2>>,
+	abc_ifcompare<abc_compare_nge,abc_operand_local<1>,abc_operand_local<2>>,
 
 	abc_setlocal_constant, // 0x2a0 ABC_OP_OPTIMZED_SETLOCAL
 	abc_setlocal_local,
@@ -920,27 +940,27 @@ abc_function ABCVm::abcfunctions[]={
 	abc_rshift_local_constant_setslotnocoerce,
 	abc_rshift_constant_local_setslotnocoerce,
 	abc_rshift_local_local_setslotnocoerce,
-	abc_add_constant_constant_setslotnocoerce,// 0x2d4 ABC_OP_OPTIMZED_ADD_SETSLOT
-	abc_add_local_constant_setslotnocoerce,
-	abc_add_constant_local_setslotnocoerce,
-	abc_add_local_local_setslotnocoerce,
-	abc_subtract_constant_constant_setslotnocoerce,// 0x2d8 ABC_OP_OPTIMZED_SUBTRACT_SETSLOT
-	abc_subtract_local_constant_setslotnocoerce,
-	abc_subtract_constant_local_setslotnocoerce,
-	abc_subtract_local_local_setslotnocoerce,
-	abc_multiply_constant_constant_setslotnocoerce,// 0x2dc ABC_OP_OPTIMZED_MULTIPLY_SETSLOT
-	abc_multiply_local_constant_setslotnocoerce,
-	abc_multiply_constant_local_setslotnocoerce,
-	abc_multiply_local_local_setslotnocoerce,
+	abc_arithmetic_setslotnocoerce<abc_op_add,abc_operand_constant<1>,abc_operand_constant<2>>,// 0x2d4 ABC_OP_OPTIMZED_ADD_SETSLOT
+	abc_arithmetic_setslotnocoerce<abc_op_add,abc_operand_local<1>,abc_operand_constant<2>>,
+	abc_arithmetic_setslotnocoerce<abc_op_add,abc_operand_constant<1>,abc_operand_local<2>>,
+	abc_arithmetic_setslotnocoerce<abc_op_add,abc_operand_local<1>,abc_operand_local<2>>,
+	abc_arithmetic_setslotnocoerce<abc_op_subtract,abc_operand_constant<1>,abc_operand_constant<2>>,// 0x2d8 ABC_OP_OPTIMZED_SUBTRACT_SETSLOT
+	abc_arithmetic_setslotnocoerce<abc_op_subtract,abc_operand_local<1>,abc_operand_constant<2>>,
+	abc_arithmetic_setslotnocoerce<abc_op_subtract,abc_operand_constant<1>,abc_operand_local<2>>,
+	abc_arithmetic_setslotnocoerce<abc_op_subtract,abc_operand_local<1>,abc_operand_local<2>>,
+	abc_arithmetic_setslotnocoerce<abc_op_multiply,abc_operand_constant<1>,abc_operand_constant<2>>,// 0x2dc ABC_OP_OPTIMZED_MULTIPLY_SETSLOT
+	abc_arithmetic_setslotnocoerce<abc_op_multiply,abc_operand_local<1>,abc_operand_constant<2>>,
+	abc_arithmetic_setslotnocoerce<abc_op_multiply,abc_operand_constant<1>,abc_operand_local<2>>,
+	abc_arithmetic_setslotnocoerce<abc_op_multiply,abc_operand_local<1>,abc_operand_local<2>>,
 
-	abc_divide_constant_constant_setslotnocoerce,// 0x2e0 ABC_OP_OPTIMZED_DIVIDE_SETSLOT
-	abc_divide_local_constant_setslotnocoerce,
-	abc_divide_constant_local_setslotnocoerce,
-	abc_divide_local_local_setslotnocoerce,
-	abc_modulo_constant_constant_setslotnocoerce,// 0x2e4 ABC_OP_OPTIMZED_MODULO_SETSLOT
-	abc_modulo_local_constant_setslotnocoerce,
-	abc_modulo_constant_local_setslotnocoerce,
-	abc_modulo_local_local_setslotnocoerce,
+	abc_arithmetic_setslotnocoerce<abc_op_divide,abc_operand_constant<1>,abc_operand_constant<2>>,// 0x2e0 ABC_OP_OPTIMZED_DIVIDE_SETSLOT
+	abc_arithmetic_setslotnocoerce<abc_op_divide,abc_operand_local<1>,abc_operand_constant<2>>,
+	abc_arithmetic_setslotnocoerce<abc_op_divide,abc_operand_constant<1>,abc_operand_local<2>>,
+	abc_arithmetic_setslotnocoerce<abc_op_divide,abc_operand_local<1>,abc_operand_local<2>>,
+	abc_arithmetic_setslotnocoerce<abc_op_modulo,abc_operand_constant<1>,abc_operand_constant<2>>,// 0x2e4 ABC_OP_OPTIMZED_MODULO_SETSLOT
+	abc_arithmetic_setslotnocoerce<abc_op_modulo,abc_operand_local<1>,abc_operand_constant<2>>,
+	abc_arithmetic_setslotnocoerce<abc_op_modulo,abc_operand_constant<1>,abc_operand_local<2>>,
+	abc_arithmetic_setslotnocoerce<abc_op_modulo,abc_operand_local<1>,abc_operand_local<2>>,
 	abc_urshift_constant_constant_setslotnocoerce,// 0x2e8 ABC_OP_OPTIMZED_URSHIFT_SETSLOT
 	abc_urshift_local_constant_setslotnocoerce,
 	abc_urshift_constant_local_setslotnocoerce,
@@ -1060,15 +1080,15 @@ abc_function ABCVm::abcfunctions[]={
 	abc_declocal_i_postfix, // 0x351 ABC_OP_OPTIMZED_DECLOCAL_I_POSTFIX
 	abc_lookupswitch_constant, // 0x352 ABC_OP_OPTIMZED_LOOKUPSWITCH
 	abc_lookupswitch_local,
-	abc_ifnle_constant_constant, // 0x354 ABC_OP_OPTIMZED_IFNLE
-	abc_ifnle_local_constant,
-	abc_ifnle_constant_local,
-	abc_ifnle_local_local,
+	abc_ifcompare<abc_compare_nle,abc_operand_constant<1>,abc_operand_constant<2>>, // 0x354 ABC_OP_OPTIMZED_IFNLE
+	abc_ifcompare<abc_compare_nle,abc_operand_local<1>,abc_operand_constant<2>>,
+	abc_ifcompare<abc_compare_nle,abc_operand_constant<1>,abc_operand_local<2>>,
+	abc_ifcompare<abc_compare_nle,abc_operand_local<1>,abc_operand_local<2>>,
 
-	abc_ifngt_constant_constant, // 0x358 ABC_OP_OPTIMZED_IFNGT
-	abc_ifngt_local_constant,
-	abc_ifngt_constant_local,
-	abc_ifngt_local_local,
+	abc_ifcompare<abc_compare_ngt,abc_operand_constant<1>,abc_operand_constant<2>>, // 0x358 ABC_OP_OPTIMZED_IFNGT
+	abc_ifcompare<abc_compare_ngt,abc_operand_local<1>,abc_operand_constant<2>>,
+	abc_ifcompare<abc_compare_ngt,abc_operand_constant<1>,abc_operand_local<2>>,
+	abc_ifcompare<abc_compare_ngt,abc_operand_local<1>,abc_operand_local<2>>,
 	abc_callvoid_constant_constant, // 0x35c ABC_OP_OPTIMZED_CALL_VOID
 	abc_callvoid_local_constant,
 	abc_callvoid_constant_local,
@@ -1130,7 +1150,11 @@ struct preloadedcodebuffer
 	bool cachedslot1;
 	bool cachedslot2;
 	bool cachedslot3;
-	preloadedcodebuffer(uint32_t d=0):pcode(),opcode(d),operator_start(d),operator_setslot(UINT32_MAX),cachedslot1(false),cachedslot2(false),cachedslot3(false){}
+	// slots of pcode that contain a pointer to a constant or a multiname (bit 0-2 for slot 1-3), used to relocate the code for the preload cache
+	uint8_t pointerslots;
+	// pcode contains objects or variables resolved at runtime, so the function can't be stored in the preload cache
+	bool runtimeobjects;
+	preloadedcodebuffer(uint32_t d=0):pcode(),opcode(d),operator_start(d),operator_setslot(UINT32_MAX),cachedslot1(false),cachedslot2(false),cachedslot3(false),pointerslots(0),runtimeobjects(false){}
 };
 struct preloadstate
 {
@@ -1152,6 +1176,8 @@ struct preloadstate
 	std::vector<preloadedcodebuffer> preloadedcode;
 	// used to keep first operand of dup opcode (defined as vector because of forward declaration)
 	std::vector<operands> dupoperands;
+	// non-builtin classes the generated code depends on, checked by the preload cache before the code is reused
+	std::set<Class_base*> resolvedclasses;
 	bool duplocalresult;
 	preloadstate(SyntheticFunction* _f, ASWorker* _w):function(_f),worker(_w),mi(_f->getMethodInfo()),duplocalresult(false) {}
 };
@@ -1228,9 +1254,11 @@ struct operands
 				{
 					case 0:
 						state.preloadedcode[codepos].pcode.arg1_constant = state.mi->context->getConstantAtom(type,index);
+						state.preloadedcode[codepos].pointerslots |= 1;
 						break;
 					case 1:
 						state.preloadedcode[codepos].pcode.arg2_constant = state.mi->context->getConstantAtom(type,index);
+						state.preloadedcode[codepos].pointerslots |= 2;
 						break;
 				}
 				break;
@@ -1238,6 +1266,18 @@ struct operands
 		return false;
 	}
 };
+void addResolvedClass(preloadstate& state, const Type* t)
+{
+	const Class_base* c = dynamic_cast<const Class_base*>(t);
+	if (c && !c->isBuiltin())
+		state.resolvedclasses.insert((Class_base*)c);
+}
+// adds an operand to the operand list and remembers its type
+void pushOperand(preloadstate& state, const operands& op)
+{
+	addResolvedClass(state,op.objtype);
+	state.operandlist.push_back(op);
+}
 #define ABC_OP_OPTIMZED_INCREMENT 0x00000100
 #define ABC_OP_OPTIMZED_DECREMENT 0x00000102
 #define ABC_OP_OPTIMZED_PUSHSCOPE 0x00000104
@@ -1549,6 +1589,7 @@ void setForceInt(preloadstate& state,memorystream& code,Class_base** resulttype)
 }
 bool checkForLocalResult(preloadstate& state,memorystream& code,uint32_t opcode_jumpspace, Class_base* restype,int preloadpos=-1,int preloadlocalpos=-1, bool checkchanged=false,bool fromdup = false, uint32_t opcode_setslot=UINT32_MAX)
 {
+	addResolvedClass(state,restype);
 #ifdef ENABLE_OPTIMIZATION
 	bool res = false;
 	uint32_t resultpos=0;
@@ -2192,7 +2233,7 @@ bool checkForLocalResult(preloadstate& state,memorystream& code,uint32_t opcode_
 				state.preloadedcode[preloadpos].opcode += opcode_jumpspace;
 				state.preloadedcode[preloadlocalpos].pcode.local3.pos = state.mi->body->getReturnValuePos()+1+resultpos;
 				state.preloadedcode[preloadlocalpos].operator_setslot=opcode_setslot;
-				state.operandlist.push_back(operands(OP_LOCAL,restype,state.mi->body->getReturnValuePos()+1+resultpos,0,0));
+				pushOperand(state,operands(OP_LOCAL,restype,state.mi->body->getReturnValuePos()+1+resultpos,0,0));
 				res = true;
 			}
 			else
@@ -2245,7 +2286,7 @@ bool checkForLocalResult(preloadstate& state,memorystream& code,uint32_t opcode_
 				state.preloadedcode[preloadpos].opcode += opcode_jumpspace;
 				state.preloadedcode[preloadlocalpos].pcode.local3.pos = state.mi->body->getReturnValuePos()+1+resultpos;
 				state.preloadedcode[preloadlocalpos].operator_setslot=opcode_setslot;
-				state.operandlist.push_back(operands(OP_LOCAL,restype,state.mi->body->getReturnValuePos()+1+resultpos,0,0));
+				pushOperand(state,operands(OP_LOCAL,restype,state.mi->body->getReturnValuePos()+1+resultpos,0,0));
 				res = true;
 				break;
 			}
@@ -2279,7 +2320,7 @@ bool checkForLocalResult(preloadstate& state,memorystream& code,uint32_t opcode_
 					state.preloadedcode[preloadpos].opcode += opcode_jumpspace;
 					state.preloadedcode[preloadlocalpos].pcode.local3.pos = state.mi->body->getReturnValuePos()+1+resultpos;
 					state.preloadedcode[preloadlocalpos].operator_setslot=opcode_setslot;
-					state.operandlist.push_back(operands(OP_LOCAL,restype,state.mi->body->getReturnValuePos()+1+resultpos,0,0));
+					pushOperand(state,operands(OP_LOCAL,restype,state.mi->body->getReturnValuePos()+1+resultpos,0,0));
 					break;
 				}
 			}
@@ -2297,7 +2338,7 @@ bool checkForLocalResult(preloadstate& state,memorystream& code,uint32_t opcode_
 				state.preloadedcode[preloadpos].opcode += opcode_jumpspace;
 				state.preloadedcode[preloadlocalpos].pcode.local3.pos = state.mi->body->getReturnValuePos()+1+resultpos;
 				state.preloadedcode[preloadlocalpos].operator_setslot=opcode_setslot;
-				state.operandlist.push_back(operands(OP_LOCAL,restype, state.mi->body->getReturnValuePos()+1+resultpos,0,0));
+				pushOperand(state,operands(OP_LOCAL,restype, state.mi->body->getReturnValuePos()+1+resultpos,0,0));
 				res = true;
 			}
 			else
@@ -2318,7 +2359,7 @@ bool checkForLocalResult(preloadstate& state,memorystream& code,uint32_t opcode_
 				state.preloadedcode[preloadpos].opcode += opcode_jumpspace;
 				state.preloadedcode[preloadlocalpos].pcode.local3.pos = state.mi->body->getReturnValuePos()+1+resultpos;
 				state.preloadedcode[preloadlocalpos].operator_setslot=opcode_setslot;
-				state.operandlist.push_back(operands(OP_LOCAL,restype,state.mi->body->getReturnValuePos()+1+resultpos,0,0));
+				pushOperand(state,operands(OP_LOCAL,restype,state.mi->body->getReturnValuePos()+1+resultpos,0,0));
 				res = true;
 			}
 			else
@@ -2343,7 +2384,7 @@ bool checkForLocalResult(preloadstate& state,memorystream& code,uint32_t opcode_
 				state.preloadedcode[preloadpos].opcode += opcode_jumpspace;
 				state.preloadedcode[preloadlocalpos].pcode.local3.pos = state.mi->body->getReturnValuePos()+1+resultpos;
 				state.preloadedcode[preloadlocalpos].operator_setslot=opcode_setslot;
-				state.operandlist.push_back(operands(OP_LOCAL,restype,state.mi->body->getReturnValuePos()+1+resultpos,0,0));
+				pushOperand(state,operands(OP_LOCAL,restype,state.mi->body->getReturnValuePos()+1+resultpos,0,0));
 				res = true;
 			}
 			else
@@ -2363,7 +2404,7 @@ bool checkForLocalResult(preloadstate& state,memorystream& code,uint32_t opcode_
 				state.preloadedcode[preloadpos].opcode += opcode_jumpspace;
 				state.preloadedcode[preloadlocalpos].pcode.local3.pos = state.mi->body->getReturnValuePos()+1+resultpos;
 				state.preloadedcode[preloadlocalpos].operator_setslot=opcode_setslot;
-				state.operandlist.push_back(operands(OP_LOCAL,restype,state.mi->body->getReturnValuePos()+1+resultpos,0,0));
+				pushOperand(state,operands(OP_LOCAL,restype,state.mi->body->getReturnValuePos()+1+resultpos,0,0));
 				res = true;
 			}
 			else
@@ -2378,7 +2419,7 @@ bool checkForLocalResult(preloadstate& state,memorystream& code,uint32_t opcode_
 				state.preloadedcode[preloadpos].opcode += opcode_jumpspace;
 				state.preloadedcode[preloadlocalpos].pcode.local3.pos = state.mi->body->getReturnValuePos()+1+resultpos;
 				state.preloadedcode[preloadlocalpos].operator_setslot=opcode_setslot;
-				state.operandlist.push_back(operands(OP_LOCAL,restype,state.mi->body->getReturnValuePos()+1+resultpos,0,0));
+				pushOperand(state,operands(OP_LOCAL,restype,state.mi->body->getReturnValuePos()+1+resultpos,0,0));
 				res = true;
 			}
 			else
@@ -2411,7 +2452,7 @@ bool checkForLocalResult(preloadstate& state,memorystream& code,uint32_t opcode_
 				state.preloadedcode[preloadpos].opcode += opcode_jumpspace;
 				state.preloadedcode[preloadlocalpos].pcode.local3.pos = state.mi->body->getReturnValuePos()+1+resultpos;
 				state.preloadedcode[preloadlocalpos].operator_setslot=opcode_setslot;
-				state.operandlist.push_back(operands(OP_LOCAL,restype,state.mi->body->getReturnValuePos()+1+resultpos,0,0));
+				pushOperand(state,operands(OP_LOCAL,restype,state.mi->body->getReturnValuePos()+1+resultpos,0,0));
 				res = true;
 			}
 			else
@@ -2457,7 +2498,7 @@ bool checkForLocalResult(preloadstate& state,memorystream& code,uint32_t opcode_
 				state.preloadedcode[preloadpos].opcode += opcode_jumpspace;
 				state.preloadedcode[preloadlocalpos].pcode.local3.pos = state.mi->body->getReturnValuePos()+1+resultpos;
 				state.preloadedcode[preloadlocalpos].operator_setslot=opcode_setslot;
-				state.operandlist.push_back(operands(OP_LOCAL,restype,state.mi->body->getReturnValuePos()+1+resultpos,0,0));
+				pushOperand(state,operands(OP_LOCAL,restype,state.mi->body->getReturnValuePos()+1+resultpos,0,0));
 				res = true;
 			}
 			else
@@ -2485,7 +2526,7 @@ bool checkForLocalResult(preloadstate& state,memorystream& code,uint32_t opcode_
 				state.preloadedcode[preloadpos].opcode += opcode_jumpspace;
 				state.preloadedcode[preloadlocalpos].pcode.local3.pos = state.mi->body->getReturnValuePos()+1+resultpos;
 				state.preloadedcode[preloadlocalpos].operator_setslot=opcode_setslot;
-				state.operandlist.push_back(operands(OP_LOCAL,restype,state.mi->body->getReturnValuePos()+1+resultpos,0,0));
+				pushOperand(state,operands(OP_LOCAL,restype,state.mi->body->getReturnValuePos()+1+resultpos,0,0));
 				res = true;
 			}
 			else
@@ -2498,7 +2539,7 @@ bool checkForLocalResult(preloadstate& state,memorystream& code,uint32_t opcode_
 				state.preloadedcode[preloadpos].opcode += opcode_jumpspace;
 				state.preloadedcode[preloadlocalpos].pcode.local3.pos = state.mi->body->getReturnValuePos();
 				state.preloadedcode[preloadlocalpos].operator_setslot=opcode_setslot;
-				state.operandlist.push_back(operands(OP_LOCAL,restype,state.mi->body->getReturnValuePos(),0,0));
+				pushOperand(state,operands(OP_LOCAL,restype,state.mi->body->getReturnValuePos(),0,0));
 				res = true;
 			}
 			else
@@ -2713,7 +2754,7 @@ bool setupInstructionTwoArguments(preloadstate& state,int operator_start,int opc
 			state.preloadedcode.push_back(ABC_OP_OPTIMZED_PUSHCACHEDCONSTANT);
 			state.oldnewpositions[code.tellg()] = (int32_t)state.preloadedcode.size();
 			state.preloadedcode.back().pcode.arg3_uint=value;
-			state.operandlist.push_back(operands(OP_CACHED_CONSTANT,asAtomHandler::getClass(res,state.mi->context->root->getSystemState()), value,1,state.preloadedcode.size()-1));
+			pushOperand(state,operands(OP_CACHED_CONSTANT,asAtomHandler::getClass(res,state.mi->context->root->getSystemState()), value,1,state.preloadedcode.size()-1));
 			return true;
 		}
 		it = state.operandlist.end();
@@ -2862,14 +2903,14 @@ void addOperand(preloadstate& state,operands& op,memorystream& code)
 		state.preloadedcode.push_back(ABC_OP_OPTIMZED_PUSHCACHEDSLOT);
 		state.oldnewpositions[code.tellg()] = (int32_t)state.preloadedcode.size();
 		state.preloadedcode.back().pcode.arg3_uint = op.index;
-		state.operandlist.push_back(operands(op.type,op.objtype,op.index,1,state.preloadedcode.size()-1));
+		pushOperand(state,operands(op.type,op.objtype,op.index,1,state.preloadedcode.size()-1));
 	}
 	else
 	{
 		state.preloadedcode.push_back(0x62); //getlocal
 		state.oldnewpositions[code.tellg()] = (int32_t)state.preloadedcode.size();
 		state.preloadedcode.back().pcode.arg3_uint = op.index;
-		state.operandlist.push_back(operands(op.type,op.objtype,op.index,1,state.preloadedcode.size()-1));
+		pushOperand(state,operands(op.type,op.objtype,op.index,1,state.preloadedcode.size()-1));
 	}
 	
 }
@@ -2881,7 +2922,7 @@ void addCachedConstant(preloadstate& state,method_info* mi, asAtom& val,memoryst
 	state.preloadedcode.push_back(ABC_OP_OPTIMZED_PUSHCACHEDCONSTANT);
 	state.oldnewpositions[code.tellg()] = (int32_t)state.preloadedcode.size();
 	state.preloadedcode.back().pcode.arg3_uint=value;
-	state.operandlist.push_back(operands(OP_CACHED_CONSTANT,asAtomHandler::getClass(val,mi->context->root->getSystemState()),value,1,state.preloadedcode.size()-1));
+	pushOperand(state,operands(OP_CACHED_CONSTANT,asAtomHandler::getClass(val,mi->context->root->getSystemState()),value,1,state.preloadedcode.size()-1));
 }
 void addCachedSlot(preloadstate& state, uint32_t localpos, uint32_t slotid,memorystream& code,Class_base* resulttype)
 {
@@ -2902,7 +2943,15 @@ void addCachedSlot(preloadstate& state, uint32_t localpos, uint32_t slotid,memor
 	state.preloadedcode.push_back(ABC_OP_OPTIMZED_PUSHCACHEDSLOT);
 	state.oldnewpositions[code.tellg()] = (int32_t)state.preloadedcode.size();
 	state.preloadedcode.back().pcode.arg3_uint = value;
-	state.operandlist.push_back(operands(OP_CACHED_SLOT,resulttype,value,1,state.preloadedcode.size()-1));
+	pushOperand(state,operands(OP_CACHED_SLOT,resulttype,value,1,state.preloadedcode.size()-1));
+}
+void setupPropertyCache(preloadstate& state, multiname* name)
+{
+	// the name and the index of the inline cache for the receiver classes are stored in the last instruction
+	state.preloadedcode.back().pcode.cachedmultiname2 = name;
+	state.preloadedcode.back().pointerslots |= 2;
+	state.mi->body->propertycaches.emplace_back();
+	state.preloadedcode.back().pcode.cacheindex = state.mi->body->propertycaches.size();
 }
 void setdefaultlocaltype(preloadstate& state,uint32_t t,Class_base* c)
 {
@@ -3320,56 +3369,154 @@ void removeInitializeLocalToConstant(preloadstate& state,int32_t value)
 	}
 }
 
-void ABCVm::preloadFunction(SyntheticFunction* function, ASWorker* wrk)
+static std::string preloadCacheTypeName(const Type* t)
 {
-	method_info* mi=function->mi;
-
-	const int code_len=mi->body->code.size();
-	preloadstate state(function,wrk);
-	std::map<int32_t,int32_t> jumppositions;
-	std::map<int32_t,int32_t> jumpstartpositions;
-	std::map<int32_t,int32_t> switchpositions;
-	std::map<int32_t,int32_t> switchstartpositions;
-	
-	// this is used in a simple mechanism to detect if kill opcodes can be skipped
-	// we just check if no getlocal opcode occurs after the kill
-	std::set<uint32_t> skippablekills;
-
-	// first pass:
-	// - store all jump target points
-	std::multimap<int32_t,int32_t> jumppoints;
-	std::set<int32_t> exceptionjumptargets;
-	std::map<int32_t,int32_t> unreachabletargets;
-
-	for (int32_t i = 0; i < (int32_t)(mi->numArgs()-mi->numOptions())+1; i++)
+	if (!t)
+		return std::string();
+	const Class_base* c = dynamic_cast<const Class_base*>(t);
+	return c ? std::string(c->getQualifiedClassName()) : std::string(t->getName());
+}
+// names of the types the preloaded code of a function depends on
+static void getPreloadCacheTypes(SyntheticFunction* function, std::vector<std::string>& types)
+{
+	method_info* mi = function->mi;
+	types.push_back(preloadCacheTypeName(function->inClass));
+	types.push_back(preloadCacheTypeName(mi->returnType));
+	for (auto it = mi->paramTypes.begin(); it != mi->paramTypes.end(); it++)
+		types.push_back(preloadCacheTypeName(*it));
+}
+static const OPERANDTYPES preloadCacheConstantKinds[] = { OP_STRING, OP_INTEGER, OP_UINTEGER, OP_DOUBLE, OP_NAMESPACE, OP_BYTE, OP_SHORT };
+static std::vector<asAtom>& getConstantPool(ABCContext* context, OPERANDTYPES kind)
+{
+	switch (kind)
 	{
-		state.unchangedlocals.insert(i);
+		case OP_STRING:
+			return context->constantAtoms_strings;
+		case OP_INTEGER:
+			return context->constantAtoms_integer;
+		case OP_UINTEGER:
+			return context->constantAtoms_uinteger;
+		case OP_DOUBLE:
+			return context->constantAtoms_doubles;
+		case OP_NAMESPACE:
+			return context->constantAtoms_namespaces;
+		case OP_BYTE:
+			return context->constantAtoms_byte;
+		default:
+			return context->constantAtoms_short;
 	}
-	if (!function->getMethodInfo()->returnType)
-		function->checkParamTypes();
-	state.localtypes.push_back(function->inClass);
-	state.defaultlocaltypes.push_back(function->inClass);
-	state.defaultlocaltypescacheable.push_back(true);
-	for (uint32_t i = 1; i < mi->body->getReturnValuePos(); i++)
+}
+// finds the kind and index of a pointer returned by ABCContext::getConstantAtom
+static bool findConstantAtom(ABCContext* context, const asAtom* a, uint64_t& res)
+{
+	for (OPERANDTYPES kind : preloadCacheConstantKinds)
 	{
-		state.localtypes.push_back(nullptr);
-		state.defaultlocaltypes.push_back(nullptr);
-		state.defaultlocaltypescacheable.push_back(true);
-		if (mi->needsArgs() && i == mi->numArgs()+1) // don't cache argument array
-			state.defaultlocaltypescacheable[i]=false;
-		if (i > 0 && i <= mi->paramTypes.size() && dynamic_cast<const Class_base*>(mi->paramTypes[i-1]))
-			state.defaultlocaltypes[i]= (Class_base*)mi->paramTypes[i-1]; // cache types of arguments
+		std::vector<asAtom>& pool = getConstantPool(context,kind);
+		if (!pool.empty() && a >= pool.data() && a < pool.data()+pool.size())
+		{
+			res = (uint64_t(kind)<<32) | uint32_t(a-pool.data());
+			return true;
+		}
 	}
-	for (uint32_t i = state.mi->numArgs()+1; i < state.mi->body->local_count; i++)
+	OPERANDTYPES kind;
+	if (a == &asAtomHandler::undefinedAtom)
+		kind = OP_UNDEFINED;
+	else if (a == &asAtomHandler::falseAtom)
+		kind = OP_FALSE;
+	else if (a == &asAtomHandler::trueAtom)
+		kind = OP_TRUE;
+	else if (a == &asAtomHandler::nullAtom)
+		kind = OP_NULL;
+	else if (a == &context->root->getSystemState()->nanAtom)
+		kind = OP_NAN;
+	else
+		return false;
+	res = uint64_t(kind)<<32;
+	return true;
+}
+// finds a constant with the same value as a, used for the initial values of locals
+static bool findConstantValue(ABCContext* context, const asAtom& a, uint64_t& res)
+{
+	if (asAtomHandler::isUndefined(a))
 	{
-		state.canlocalinitialize.push_back(true);
+		res = uint64_t(OP_UNDEFINED)<<32;
+		return true;
+	}
+	for (OPERANDTYPES kind : preloadCacheConstantKinds)
+	{
+		std::vector<asAtom>& pool = getConstantPool(context,kind);
+		for (uint32_t i = 0; i < pool.size(); i++)
+		{
+			if (pool[i].uintval == a.uintval)
+			{
+				res = (uint64_t(kind)<<32) | i;
+				return true;
+			}
+		}
 	}
+	const asAtom* statics[] = { &asAtomHandler::falseAtom, &asAtomHandler::trueAtom, &asAtomHandler::nullAtom, &context->root->getSystemState()->nanAtom };
+	for (const asAtom* c : statics)
+	{
+		if (c->uintval == a.uintval)
+			return findConstantAtom(context,c,res);
+	}
+	return false;
+}
+static asAtom* getPreloadCacheConstant(ABCContext* context, uint64_t v)
+{
+	OPERANDTYPES kind = OPERANDTYPES(v>>32);
+	uint32_t index = uint32_t(v);
+	switch (kind)
+	{
+		case OP_UNDEFINED:
+		case OP_FALSE:
+		case OP_TRUE:
+		case OP_NULL:
+		case OP_NAN:
+			return context->getConstantAtom(kind,0);
+		case OP_STRING:
+		case OP_INTEGER:
+		case OP_UINTEGER:
+		case OP_DOUBLE:
+		case OP_NAMESPACE:
+		case OP_BYTE:
+		case OP_SHORT:
+			if (index < getConstantPool(context,kind).size())
+				return context->getConstantAtom(kind,index);
+			return nullptr;
+		default:
+			return nullptr;
+	}
+}
+static uint32_t getPreloadCacheFunctionIndex(abc_function f)
+{
+	static std::unordered_map<abc_function,uint32_t> indices;
+	static Mutex indicesmutex;
+	Locker l(indicesmutex);
+	if (indices.empty())
+	{
+		for (uint32_t i = sizeof(ABCVm::abcfunctions)/sizeof(abc_function); i > 0; i--)
+			indices[ABCVm::abcfunctions[i-1]] = i-1;
+	}
+	auto it = indices.find(f);
+	return it == indices.end() ? UINT32_MAX : it->second;
+}
+
+/*
+ * first pass of preloadFunction: stores all jump target points.
+ * This only depends on the bytecode, the constant pool and the given copy of the exception handlers,
+ * so it is thread safe and can be done in the background before the method is called
+ */
+void ABCVm::scanJumpTargets(ABCContext* context, method_body_info* body, const std::vector<exception_info_abc>& exceptions, preloadjumpinfo& info)
+{
+	std::set<int32_t> exceptionjumptargets;
+	std::map<int32_t,int32_t> unreachabletargets;
 
-	auto itex = mi->body->exceptions.begin();
-	while (itex != mi->body->exceptions.end())
+	auto itex = exceptions.begin();
+	while (itex != exceptions.end())
 	{
 		// add exception jump targets
-		state.jumptargets[(int32_t)itex->target+1]=1;
+		info.jumptargets[(int32_t)itex->target+1]=1;
 		exceptionjumptargets.insert((int32_t)itex->target+1);
 		itex++;
 	}
@@ -3392,7 +3539,7 @@ void ABCVm::preloadFunction(SyntheticFunction* function, ASWorker* wrk)
 				0x00
 			};
 	uint8_t opcode=0;
-	memorystream codejumps(mi->body->code.data(), code_len);
+	memorystream codejumps(body->code.data(), body->code.size());
 	std::vector<asAtom> constantsstack;
 	while(!codejumps.atend())
 	{
@@ -3406,7 +3553,7 @@ void ABCVm::preloadFunction(SyntheticFunction* function, ASWorker* wrk)
 			++simple_setter_opcode_pos;
 		else
 			simple_setter_opcode_pos = UINT32_MAX;
-		//LOG(LOG_ERROR,"preload pass1:"<<function->getSystemState()->getStringFromUniqueId(function->functionname)<<" "<< codejumps.tellg()-1<<" "<<" "<<hex<<(int)opcode);
+		//LOG(LOG_ERROR,"preload pass1:"<< codejumps.tellg()-1<<" "<<" "<<hex<<(int)opcode);
 		switch(opcode)
 		{
 			case 0x04://getsuper
@@ -3443,14 +3590,14 @@ void ABCVm::preloadFunction(SyntheticFunction* function, ASWorker* wrk)
 			case 0x08://kill
 			{
 				uint32_t t = codejumps.readu30();
-				skippablekills.insert(t);
+				info.skippablekills.insert(t);
 				constantsstack.clear();
 				break;
 			}
 			case 0x62://getlocal
 			{
 				uint32_t t = codejumps.readu30();
-				skippablekills.erase(t);
+				info.skippablekills.erase(t);
 				constantsstack.clear();
 				break;
 			}
@@ -3458,7 +3605,7 @@ void ABCVm::preloadFunction(SyntheticFunction* function, ASWorker* wrk)
 			case 0xd1://getlocal_1
 			case 0xd2://getlocal_2
 			case 0xd3://getlocal_3
-				skippablekills.erase(opcode-0xd0);
+				info.skippablekills.erase(opcode-0xd0);
 				constantsstack.clear();
 				break;
 			case 0x80://coerce
@@ -3479,31 +3626,31 @@ void ABCVm::preloadFunction(SyntheticFunction* function, ASWorker* wrk)
 			case 0x2c://pushstring
 			{
 				uint32_t value = codejumps.readu30();
-				constantsstack.push_back(*function->mi->context->getConstantAtom(OP_STRING,value));
+				constantsstack.push_back(*context->getConstantAtom(OP_STRING,value));
 				break;
 			}
 			case 0x2d://pushint
 			{
 				uint32_t value = codejumps.readu30();
-				constantsstack.push_back(*function->mi->context->getConstantAtom(OP_INTEGER,value));
+				constantsstack.push_back(*context->getConstantAtom(OP_INTEGER,value));
 				break;
 			}
 			case 0x2e://pushuint
 			{
 				uint32_t value = codejumps.readu30();
-				constantsstack.push_back(*function->mi->context->getConstantAtom(OP_UINTEGER,value));
+				constantsstack.push_back(*context->getConstantAtom(OP_UINTEGER,value));
 				break;
 			}
 			case 0x2f://pushdouble
 			{
 				uint32_t value = codejumps.readu30();
-				constantsstack.push_back(*function->mi->context->getConstantAtom(OP_DOUBLE,value));
+				constantsstack.push_back(*context->getConstantAtom(OP_DOUBLE,value));
 				break;
 			}
 			case 0x31://pushnamespace
 			{
 				uint32_t value = codejumps.readu30();
-				constantsstack.push_back(*function->mi->context->getConstantAtom(OP_NAMESPACE,value));
+				constantsstack.push_back(*context->getConstantAtom(OP_NAMESPACE,value));
 				break;
 			}
 			case 0x10://jump
@@ -3514,8 +3661,8 @@ void ABCVm::preloadFunction(SyntheticFunction* function, ASWorker* wrk)
 				{
 					int32_t nextreachable = p1;
 					// find the first jump target after the current position
-					auto it = state.jumptargets.begin();
-					while (it != state.jumptargets.end() && it->first < nextreachable)
+					auto it = info.jumptargets.begin();
+					while (it != info.jumptargets.end() && it->first < nextreachable)
 					{
 						if (it->first > p && it->first <nextreachable)
 							nextreachable = it->first;
@@ -3523,10 +3670,9 @@ void ABCVm::preloadFunction(SyntheticFunction* function, ASWorker* wrk)
 					}
 					unreachabletargets[p] = nextreachable;
 				}
-				if (state.jumptargets.count(p1))
-					state.jumptargeteresulttypes.erase(p1);
-				state.jumptargets[p1]++;
-				jumppoints.insert(make_pair(p,p1));
+				if (info.jumptargets.count(p1))
+				info.jumptargets[p1]++;
+				info.jumppoints.insert(make_pair(p,p1));
 				constantsstack.clear();
 				break;
 			}
@@ -3544,9 +3690,8 @@ void ABCVm::preloadFunction(SyntheticFunction* function, ASWorker* wrk)
 				// TODO check for unreachable code
 				int32_t p = codejumps.tellg();
 				int32_t p1 = codejumps.reads24()+codejumps.tellg()+1;
-				state.jumptargeteresulttypes.erase(p1);
-				state.jumptargets[p1]++;
-				jumppoints.insert(make_pair(p,p1));
+				info.jumptargets[p1]++;
+				info.jumppoints.insert(make_pair(p,p1));
 				constantsstack.clear();
 				break;
 			}
@@ -3556,14 +3701,14 @@ void ABCVm::preloadFunction(SyntheticFunction* function, ASWorker* wrk)
 				int32_t p1 = codejumps.reads24()+codejumps.tellg()+1;
 				if (p1 > p && constantsstack.size()>1 && 
 						asAtomHandler::isEqual(constantsstack[constantsstack.size()-1]
-												, wrk
+												, nullptr
 												, constantsstack[constantsstack.size()-1])
 						)//opcode is preceded by two constants, so we can compare them and check for unreachable code
 				{
 					int32_t nextreachable = p1;
 					// find the first jump target after the current position
-					auto it = state.jumptargets.begin();
-					while (it != state.jumptargets.end() && it->first < nextreachable)
+					auto it = info.jumptargets.begin();
+					while (it != info.jumptargets.end() && it->first < nextreachable)
 					{
 						if (it->first > p && it->first <nextreachable)
 							nextreachable = it->first;
@@ -3571,9 +3716,8 @@ void ABCVm::preloadFunction(SyntheticFunction* function, ASWorker* wrk)
 					}
 					unreachabletargets[p] = nextreachable;
 				}
-				state.jumptargeteresulttypes.erase(p1);
-				state.jumptargets[p1]++;
-				jumppoints.insert(make_pair(p,p1));
+				info.jumptargets[p1]++;
+				info.jumppoints.insert(make_pair(p,p1));
 				constantsstack.clear();
 				break;
 			}
@@ -3583,14 +3727,14 @@ void ABCVm::preloadFunction(SyntheticFunction* function, ASWorker* wrk)
 				int32_t p1 = codejumps.reads24()+codejumps.tellg()+1;
 				if (p1 > p && constantsstack.size()>1 && 
 						!asAtomHandler::isEqual(constantsstack[constantsstack.size()-1]
-												, wrk
+												, nullptr
 												, constantsstack[constantsstack.size()-1])
 						)//opcode is preceded by two constants, so we can compare them and check for unreachable code
 				{
 					int32_t nextreachable = p1;
 					// find the first jump target after the current position
-					auto it = state.jumptargets.begin();
-					while (it != state.jumptargets.end() && it->first < nextreachable)
+					auto it = info.jumptargets.begin();
+					while (it != info.jumptargets.end() && it->first < nextreachable)
 					{
 						if (it->first > p && it->first <nextreachable)
 							nextreachable = it->first;
@@ -3598,9 +3742,8 @@ void ABCVm::preloadFunction(SyntheticFunction* function, ASWorker* wrk)
 					}
 					unreachabletargets[p] = nextreachable;
 				}
-				state.jumptargeteresulttypes.erase(p1);
-				state.jumptargets[p1]++;
-				jumppoints.insert(make_pair(p,p1));
+				info.jumptargets[p1]++;
+				info.jumppoints.insert(make_pair(p,p1));
 				constantsstack.clear();
 				break;
 			}
@@ -3608,12 +3751,12 @@ void ABCVm::preloadFunction(SyntheticFunction* function, ASWorker* wrk)
 			{
 				int32_t p = codejumps.tellg();
 				int32_t p1 = codejumps.reads24()+codejumps.tellg()+1;
-				if (p1 > p && state.jumptargets.find(p) == state.jumptargets.end() && prevopcode==0x26) //pushtrue
+				if (p1 > p && info.jumptargets.find(p) == info.jumptargets.end() && prevopcode==0x26) //pushtrue
 				{
 					int32_t nextreachable = p1;
 					// find the first jump target after the current position
-					auto it = state.jumptargets.begin();
-					while (it != state.jumptargets.end() && it->first < nextreachable)
+					auto it = info.jumptargets.begin();
+					while (it != info.jumptargets.end() && it->first < nextreachable)
 					{
 						if (it->first > p && it->first <nextreachable)
 							nextreachable = it->first;
@@ -3621,9 +3764,8 @@ void ABCVm::preloadFunction(SyntheticFunction* function, ASWorker* wrk)
 					}
 					unreachabletargets[p] = nextreachable;
 				}
-				state.jumptargeteresulttypes.erase(p1);
-				state.jumptargets[p1]++;
-				jumppoints.insert(make_pair(p,p1));
+				info.jumptargets[p1]++;
+				info.jumppoints.insert(make_pair(p,p1));
 				constantsstack.clear();
 				break;
 			}
@@ -3631,12 +3773,12 @@ void ABCVm::preloadFunction(SyntheticFunction* function, ASWorker* wrk)
 			{
 				int32_t p = codejumps.tellg();
 				int32_t p1 = codejumps.reads24()+codejumps.tellg()+1;
-				if (p1 > p && state.jumptargets.find(p) == state.jumptargets.end() && prevopcode==0x27) //pushfalse
+				if (p1 > p && info.jumptargets.find(p) == info.jumptargets.end() && prevopcode==0x27) //pushfalse
 				{
 					int32_t nextreachable = p1;
 					// find the first jump target after the current position
-					auto it = state.jumptargets.begin();
-					while (it != state.jumptargets.end() && it->first < nextreachable)
+					auto it = info.jumptargets.begin();
+					while (it != info.jumptargets.end() && it->first < nextreachable)
 					{
 						if (it->first > p && it->first <nextreachable)
 							nextreachable = it->first;
@@ -3644,9 +3786,8 @@ void ABCVm::preloadFunction(SyntheticFunction* function, ASWorker* wrk)
 					}
 					unreachabletargets[p] = nextreachable;
 				}
-				state.jumptargeteresulttypes.erase(p1);
-				state.jumptargets[p1]++;
-				jumppoints.insert(make_pair(p,p1));
+				info.jumptargets[p1]++;
+				info.jumppoints.insert(make_pair(p,p1));
 				constantsstack.clear();
 				break;
 			}
@@ -3654,16 +3795,14 @@ void ABCVm::preloadFunction(SyntheticFunction* function, ASWorker* wrk)
 			{
 				int32_t p = codejumps.tellg();
 				int32_t p1 = p+codejumps.reads24();
-				state.jumptargeteresulttypes.erase(p1);
-				state.jumptargets[p1]++;
-				jumppoints.insert(make_pair(p,p1));
+				info.jumptargets[p1]++;
+				info.jumppoints.insert(make_pair(p,p1));
 				uint32_t count = codejumps.readu30();
 				for(unsigned int i=0;i<count+1;i++)
 				{
 					p1 = p+codejumps.reads24();
-					state.jumptargeteresulttypes.erase(p1);
-					state.jumptargets[p1]++;
-					jumppoints.insert(make_pair(p,p1));
+					info.jumptargets[p1]++;
+					info.jumppoints.insert(make_pair(p,p1));
 				}
 				constantsstack.clear();
 				break;
@@ -3710,12 +3849,12 @@ void ABCVm::preloadFunction(SyntheticFunction* function, ASWorker* wrk)
 				int32_t p = codejumps.tellg();
 				int32_t nextreachable = codejumps.size();
 				// find the first jump target after the current position
-				auto it = state.jumptargets.begin();
-				while (it != state.jumptargets.end() && it->first <= (int)codejumps.tellg())
+				auto it = info.jumptargets.begin();
+				while (it != info.jumptargets.end() && it->first <= (int)codejumps.tellg())
 				{
 					it++;
 				}
-				if (it != state.jumptargets.end())
+				if (it != info.jumptargets.end())
 					nextreachable = it->first;
 				unreachabletargets[p] = nextreachable;
 				constantsstack.clear();
@@ -3726,6 +3865,8 @@ void ABCVm::preloadFunction(SyntheticFunction* function, ASWorker* wrk)
 				break;
 		}
 	}
+	info.simplegetter = simple_getter_opcode_pos != UINT32_MAX;
+	info.simplesetter = simple_setter_opcode_pos != UINT32_MAX;
 	// remove all really unreachable targets
 #ifdef ENABLE_OPTIMIZATION
 	auto it = unreachabletargets.begin();
@@ -3744,8 +3885,8 @@ void ABCVm::preloadFunction(SyntheticFunction* function, ASWorker* wrk)
 		}
 		
 		// search backwards for jumps that point inside the unreachable area and adjust realUnreachableEnd
-		auto itpoint = jumppoints.rbegin();
-		while (itpoint != jumppoints.rend())
+		auto itpoint = info.jumppoints.rbegin();
+		while (itpoint != info.jumppoints.rend())
 		{
 			if (itpoint->first < realNextReachable)
 				break; // jump is inside the unreachable area
@@ -3754,20 +3895,294 @@ void ABCVm::preloadFunction(SyntheticFunction* function, ASWorker* wrk)
 			itpoint++;
 		}
 		// remove all jump targets inside the adjusted unreachable area
-		auto ittarget = state.jumptargets.rbegin();
-		while (ittarget != state.jumptargets.rend())
+		auto ittarget = info.jumptargets.rbegin();
+		while (ittarget != info.jumptargets.rend())
 		{
 			if (ittarget->first <= realUnreachableStart)
 				break; // beginning of unreachable area reached, we can stop now
 			if (ittarget->first < realNextReachable && exceptionjumptargets.find(ittarget->first) == exceptionjumptargets.end())
 			{
-				state.jumptargets.erase(ittarget->first); // jump is inside unreachable area, can be removed
+				info.jumptargets.erase(ittarget->first); // jump is inside unreachable area, can be removed
 			}
 			ittarget++;
 		}
 		it++;
 	}
 #endif
+}
+
+/*
+ * stores the result of preloadFunction in the preload cache.
+ * pointerslots contains the slots of every instruction that contain pointers to constants or multinames,
+ * all other slots are stored as they are
+ */
+void ABCVm::storeInPreloadCache(SyntheticFunction* function, const std::vector<uint8_t>& pointerslots, const std::set<Class_base*>& resolvedclasses)
+{
+	method_info* mi = function->mi;
+	ABCContext* context = mi->context;
+	PreloadCache* cache = context->preloadcache;
+	uint32_t methodindex = mi-context->methods.data();
+	if (methodindex >= context->methods.size())
+		return;
+	preloadcacheentry e;
+	getPreloadCacheTypes(function,e.types);
+	for (auto it = resolvedclasses.begin(); it != resolvedclasses.end(); it++)
+	{
+		// classes from other abc tags are not covered by the cache key
+		if ((*it)->context != context || (*it)->class_index < 0)
+			return;
+		e.resolvedclasses.push_back((*it)->class_index);
+	}
+	std::sort(e.resolvedclasses.begin(),e.resolvedclasses.end());
+	e.code.resize(mi->body->preloadedcode.size());
+	for (uint32_t i = 0; i < mi->body->preloadedcode.size(); i++)
+	{
+		const preloadedcodedata& pcode = mi->body->preloadedcode[i];
+		preloadcacheinstruction& c = e.code[i];
+		c.func = pcode.func ? getPreloadCacheFunctionIndex(pcode.func) : UINT32_MAX;
+		if (pcode.func && c.func == UINT32_MAX)
+			return;
+		c.cacheindex = pcode.cacheindex;
+		const void* slots[3] = { &pcode.cacheobj1, &pcode.cacheobj2, &pcode.cacheobj3 };
+		for (uint32_t j = 0; j < 3; j++)
+		{
+			uint64_t v;
+			memcpy(&v,slots[j],sizeof(uint64_t));
+			c.slots[j] = v;
+			c.relocation[j] = PRELOADCACHE_RAW;
+			if (!(pointerslots[i] & (1<<j)))
+			{
+				// all non-pointer arguments are 32 bit values, anything larger is a pointer to a runtime object that can't be relocated
+				if (v > UINT32_MAX)
+					return;
+				continue;
+			}
+			if (v == 0)
+				continue;
+			if (findConstantAtom(context,(const asAtom*)v,c.slots[j]))
+				c.relocation[j] = PRELOADCACHE_CONSTANT;
+			else if ((c.slots[j] = cache->getMultinameIndex(context->constant_pool,(const multiname*)v)) != UINT32_MAX)
+				c.relocation[j] = PRELOADCACHE_MULTINAME;
+			else
+				return;
+		}
+	}
+	if (function->simpleGetterOrSetterName)
+	{
+		e.simplegetterorsettername = cache->getMultinameIndex(context->constant_pool,function->simpleGetterOrSetterName);
+		if (e.simplegetterorsettername == UINT32_MAX)
+			return;
+	}
+	if (mi->body->localsinitialvalues)
+	{
+		e.localsinitialvalues.resize(mi->body->local_count-(mi->numArgs()+1));
+		for (uint32_t i = 0; i < e.localsinitialvalues.size(); i++)
+		{
+			if (!findConstantValue(context,mi->body->localsinitialvalues[i],e.localsinitialvalues[i]))
+				return;
+		}
+	}
+	for (auto it = mi->body->exceptions.begin(); it != mi->body->exceptions.end(); it++)
+	{
+		e.exceptions.push_back(it->from);
+		e.exceptions.push_back(it->to);
+		e.exceptions.push_back(it->target);
+	}
+	e.localconstantslots = mi->body->localconstantslots;
+	e.propertycachecount = mi->body->propertycaches.size();
+	e.localresultcount = mi->body->localresultcount;
+	e.needscoerceresult = mi->needscoerceresult;
+	e.needsscope = mi->needsscope;
+	cache->add(methodindex,e);
+}
+
+/*
+ * sets up the preloaded code of the function from the preload cache.
+ * returns false if the function is not cached or the cached code was generated for different types,
+ * in that case the function has to be preloaded
+ */
+bool ABCVm::loadFromPreloadCache(SyntheticFunction* function)
+{
+	method_info* mi = function->mi;
+	ABCContext* context = mi->context;
+	PreloadCache* cache = context->preloadcache;
+	uint32_t methodindex = mi-context->methods.data();
+	preloadcacheentry e;
+	if (methodindex >= context->methods.size() || !cache->get(methodindex,e))
+		return false;
+	if (!mi->returnType)
+		function->checkParamTypes();
+	std::vector<std::string> types;
+	getPreloadCacheTypes(function,types);
+	bool classesresolved = true;
+	for (auto it = e.resolvedclasses.begin(); it != e.resolvedclasses.end() && classesresolved; it++)
+	{
+		// the code was generated with knowledge of this class, so it has to be defined now, too
+		classesresolved = false;
+		if (*it >= context->instances.size())
+			break;
+		multiname* name = context->getMultiname(context->instances[*it].name,nullptr);
+		const Class_base* cls = dynamic_cast<const Class_base*>(Type::getTypeFromMultiname(name,context,true));
+		classesresolved = cls && cls->context == context && cls->class_index == int32_t(*it);
+	}
+	if (!classesresolved || types != e.types || e.exceptions.size() != mi->body->exceptions.size()*3
+			|| (!e.localsinitialvalues.empty() && e.localsinitialvalues.size() != uint32_t(mi->body->local_count-(mi->numArgs()+1))))
+	{
+		LOG(LOG_INFO,"preload cache: types changed for "<<function->getSystemState()->getStringFromUniqueId(function->functionname));
+		cache->remove(methodindex);
+		return false;
+	}
+	const uint32_t funccount = sizeof(ABCVm::abcfunctions)/sizeof(abc_function);
+	std::vector<preloadedcodedata> code(e.code.size());
+	for (uint32_t i = 0; i < e.code.size(); i++)
+	{
+		const preloadcacheinstruction& c = e.code[i];
+		if (c.func != UINT32_MAX)
+		{
+			if (c.func >= funccount)
+				return false;
+			code[i].func = ABCVm::abcfunctions[c.func];
+		}
+		if (c.cacheindex > e.propertycachecount)
+			return false;
+		code[i].cacheindex = c.cacheindex;
+		void* slots[3] = { &code[i].cacheobj1, &code[i].cacheobj2, &code[i].cacheobj3 };
+		for (uint32_t j = 0; j < 3; j++)
+		{
+			uint64_t v = c.slots[j];
+			switch (c.relocation[j])
+			{
+				case PRELOADCACHE_RAW:
+					break;
+				case PRELOADCACHE_CONSTANT:
+				{
+					asAtom* a = getPreloadCacheConstant(context,v);
+					if (!a)
+						return false;
+					v = uint64_t(a);
+					break;
+				}
+				case PRELOADCACHE_MULTINAME:
+				{
+					if (v == 0 || v >= context->constant_pool.multinames.size() || context->getMultinameRTData(v))
+						return false;
+					v = uint64_t(context->getMultiname(v,nullptr));
+					break;
+				}
+				default:
+					return false;
+			}
+			memcpy(slots[j],&v,sizeof(uint64_t));
+		}
+	}
+	multiname* simplename = nullptr;
+	if (e.simplegetterorsettername != UINT32_MAX)
+	{
+		if (e.simplegetterorsettername == 0 || e.simplegetterorsettername >= context->constant_pool.multinames.size() || context->getMultinameRTData(e.simplegetterorsettername))
+			return false;
+		simplename = context->getMultiname(e.simplegetterorsettername,nullptr);
+	}
+	asAtom* localsinitialvalues = nullptr;
+	if (!e.localsinitialvalues.empty())
+	{
+		localsinitialvalues = new asAtom[e.localsinitialvalues.size()];
+		for (uint32_t i = 0; i < e.localsinitialvalues.size(); i++)
+		{
+			asAtom* a = getPreloadCacheConstant(context,e.localsinitialvalues[i]);
+			if (!a)
+			{
+				delete[] localsinitialvalues;
+				return false;
+			}
+			localsinitialvalues[i] = *a;
+		}
+	}
+
+	// everything is resolved, set up the method body
+	for (uint32_t i = 0; i < mi->body->exceptions.size(); i++)
+	{
+		mi->body->exceptions[i].from = e.exceptions[i*3];
+		mi->body->exceptions[i].to = e.exceptions[i*3+1];
+		mi->body->exceptions[i].target = e.exceptions[i*3+2];
+	}
+	mi->body->preloadedcode.swap(code);
+	mi->body->localconstantslots = e.localconstantslots;
+	mi->body->propertycaches.clear();
+	mi->body->propertycaches.resize(e.propertycachecount);
+	mi->body->localresultcount = e.localresultcount;
+	if (mi->body->localsinitialvalues)
+		delete[] mi->body->localsinitialvalues;
+	mi->body->localsinitialvalues = localsinitialvalues;
+	mi->body->jitfailed = false;
+	mi->needscoerceresult = e.needscoerceresult;
+	mi->needsscope = e.needsscope;
+	function->simpleGetterOrSetterName = simplename;
+	fuseSuperInstructions(mi->body);
+	return true;
+}
+
+void ABCVm::preloadFunction(SyntheticFunction* function, ASWorker* wrk)
+{
+	method_info* mi=function->mi;
+
+	// first pass:
+	// - store all jump target points
+	// this has to be taken before the preload cache changes the exception handlers
+	preloadjumpinfo* jumpinfo = mi->context->takeBackgroundPreloadInfo(mi->body);
+	if (mi->context->preloadcache && !mi->body->isspeculative && loadFromPreloadCache(function))
+	{
+		delete jumpinfo;
+		return;
+	}
+
+	const int code_len=mi->body->code.size();
+	preloadstate state(function,wrk);
+	std::map<int32_t,int32_t> jumppositions;
+	std::map<int32_t,int32_t> jumpstartpositions;
+	std::map<int32_t,int32_t> switchpositions;
+	std::map<int32_t,int32_t> switchstartpositions;
+
+	if (!jumpinfo)
+	{
+		jumpinfo = new preloadjumpinfo();
+		scanJumpTargets(mi->context,mi->body,mi->body->exceptions,*jumpinfo);
+	}
+	state.jumptargets.swap(jumpinfo->jumptargets);
+	// this is used in a simple mechanism to detect if kill opcodes can be skipped
+	// we just check if no getlocal opcode occurs after the kill
+	std::set<uint32_t> skippablekills;
+	skippablekills.swap(jumpinfo->skippablekills);
+	std::multimap<int32_t,int32_t> jumppoints;
+	jumppoints.swap(jumpinfo->jumppoints);
+	uint32_t simple_getter_opcode_pos = jumpinfo->simplegetter ? 0 : UINT32_MAX;
+	uint32_t simple_setter_opcode_pos = jumpinfo->simplesetter ? 0 : UINT32_MAX;
+	delete jumpinfo;
+
+	for (int32_t i = 0; i < (int32_t)(mi->numArgs()-mi->numOptions())+1; i++)
+	{
+		state.unchangedlocals.insert(i);
+	}
+	if (!function->getMethodInfo()->returnType)
+		function->checkParamTypes();
+	state.localtypes.push_back(function->inClass);
+	state.defaultlocaltypes.push_back(function->inClass);
+	state.defaultlocaltypescacheable.push_back(true);
+	for (uint32_t i = 1; i < mi->body->getReturnValuePos(); i++)
+	{
+		state.localtypes.push_back(nullptr);
+		state.defaultlocaltypes.push_back(nullptr);
+		state.defaultlocaltypescacheable.push_back(true);
+		if (mi->needsArgs() && i == mi->numArgs()+1) // don't cache argument array
+			state.defaultlocaltypescacheable[i]=false;
+		if (i > 0 && i <= mi->paramTypes.size() && dynamic_cast<const Class_base*>(mi->paramTypes[i-1]))
+			state.defaultlocaltypes[i]= (Class_base*)mi->paramTypes[i-1]; // cache types of arguments
+	}
+	for (uint32_t i = state.mi->numArgs()+1; i < state.mi->body->local_count; i++)
+	{
+		state.canlocalinitialize.push_back(true);
+	}
+
+	uint8_t opcode=0;
 	// second pass:
 	// - compute types of the locals and detect if they don't change during execution
 #ifdef ENABLE_OPTIMIZATION
@@ -4524,7 +4939,7 @@ void ABCVm::preloadFunction(SyntheticFunction* function, ASWorker* wrk)
 							{
 								state.preloadedcode.push_back((uint32_t)0xd0); // convert to getlocal_0
 								state.oldnewpositions[code.tellg()] = (int32_t)state.preloadedcode.size();
-								state.operandlist.push_back(operands(OP_LOCAL,function->inClass, 0,1,state.preloadedcode.size()-1));
+								pushOperand(state,operands(OP_LOCAL,function->inClass, 0,1,state.preloadedcode.size()-1));
 								typestack.push_back(typestackentry(function->inClass,isborrowed));
 								ASATOM_DECREF(otmp);
 								break;
@@ -4726,7 +5141,7 @@ void ABCVm::preloadFunction(SyntheticFunction* function, ASWorker* wrk)
 								{
 									// convert to getprop on class
 									setupInstructionOneArgument(state,ABC_OP_OPTIMZED_GETPROPERTY_STATICNAME,0x66,code,true, false,resulttype,p,true,false,false,false);
-									state.preloadedcode.at(state.preloadedcode.size()-1).pcode.cachedmultiname2 = name;
+									setupPropertyCache(state,name);
 								}
 								typestack.push_back(typestackentry(resulttype,false));
 								break;
@@ -4753,19 +5168,20 @@ void ABCVm::preloadFunction(SyntheticFunction* function, ASWorker* wrk)
 								resulttype = (Class_base*)(v->isResolved ? dynamic_cast<const Class_base*>(v->type):nullptr);
 								state.preloadedcode.push_back((uint32_t)0xd0);
 								state.oldnewpositions[code.tellg()] = (int32_t)state.preloadedcode.size();
-								state.operandlist.push_back(operands(OP_LOCAL,function->inClass, 0,1,state.preloadedcode.size()-1));
+								pushOperand(state,operands(OP_LOCAL,function->inClass, 0,1,state.preloadedcode.size()-1));
 								if (function->inClass->isInterfaceMethod(*name) ||
 									(function->inClass->is<Class_inherit>() && function->inClass->as<Class_inherit>()->hasoverriddenmethod(name)))
 								{
 									// convert to getprop on local[0]
 									setupInstructionOneArgument(state,ABC_OP_OPTIMZED_GETPROPERTY_STATICNAME,0x66,code,true, false,resulttype,p,true,false,false,false);
-									state.preloadedcode.at(state.preloadedcode.size()-1).pcode.cachedmultiname2 = name;
+									setupPropertyCache(state,name);
 								}
 								else
 								{
 									// convert to callprop on local[0] (this) with 0 args
 									setupInstructionOneArgument(state,ABC_OP_OPTIMZED_CALLFUNCTION_NOARGS,0x46,code,true, false,resulttype,p,true,false,false,false,ABC_OP_OPTIMZED_CALLFUNCTION_NOARGS_SETSLOT);
 									state.preloadedcode.at(state.preloadedcode.size()-1).pcode.cacheobj2 = asAtomHandler::getObject(v->getter);
+									state.preloadedcode.at(state.preloadedcode.size()-1).runtimeobjects = true;
 								}
 								typestack.push_back(typestackentry(resulttype,false));
 								break;
@@ -4776,7 +5192,7 @@ void ABCVm::preloadFunction(SyntheticFunction* function, ASWorker* wrk)
 								resulttype = (Class_base*)(v->isResolved ? dynamic_cast<const Class_base*>(v->type):nullptr);
 								state.preloadedcode.push_back((uint32_t)0xd0);
 								state.oldnewpositions[code.tellg()] = (int32_t)state.preloadedcode.size();
-								state.operandlist.push_back(operands(OP_LOCAL,function->inClass, 0,1,state.preloadedcode.size()-1));
+								pushOperand(state,operands(OP_LOCAL,function->inClass, 0,1,state.preloadedcode.size()-1));
 								if (function->inClass->is<Class_inherit>()
 									&& !function->inClass->as<Class_inherit>()->hasoverriddenmethod(name)
 									&& v->slotid)
@@ -4795,7 +5211,7 @@ void ABCVm::preloadFunction(SyntheticFunction* function, ASWorker* wrk)
 									{
 										// convert to getprop on local[0]
 										setupInstructionOneArgument(state,ABC_OP_OPTIMZED_GETPROPERTY_STATICNAME,0x66,code,true, false,resulttype,p,true,false,false,false);
-										state.preloadedcode.at(state.preloadedcode.size()-1).pcode.cachedmultiname2 = name;
+										setupPropertyCache(state,name);
 									}
 									ASATOM_DECREF(o);
 								}
@@ -4803,7 +5219,7 @@ void ABCVm::preloadFunction(SyntheticFunction* function, ASWorker* wrk)
 								{
 									// convert to getprop on local[0]
 									setupInstructionOneArgument(state,ABC_OP_OPTIMZED_GETPROPERTY_STATICNAME,0x66,code,true, false,resulttype,p,true,false,false,false);
-									state.preloadedcode.at(state.preloadedcode.size()-1).pcode.cachedmultiname2 = name;
+									setupPropertyCache(state,name);
 								}
 								typestack.push_back(typestackentry(resulttype,false));
 								break;
@@ -4825,7 +5241,7 @@ void ABCVm::preloadFunction(SyntheticFunction* function, ASWorker* wrk)
 								{
 									// convert to getprop on class
 									setupInstructionOneArgument(state,ABC_OP_OPTIMZED_GETPROPERTY_STATICNAME,0x66,code,true, false,resulttype,p,true,false,false,false);
-									state.preloadedcode.at(state.preloadedcode.size()-1).pcode.cachedmultiname2 = name;
+									setupPropertyCache(state,name);
 								}
 								typestack.push_back(typestackentry(resulttype,false));
 								break;
@@ -5072,6 +5488,7 @@ void ABCVm::preloadFunction(SyntheticFunction* function, ASWorker* wrk)
 				state.preloadedcode.push_back(ABC_OP_OPTIMZED_GETLEX);
 				state.oldnewpositions[code.tellg()] = (int32_t)state.preloadedcode.size();
 				state.preloadedcode[state.preloadedcode.size()-1].pcode.cachedmultiname2=name;
+				state.preloadedcode[state.preloadedcode.size()-1].pointerslots |= 2;
 				if (!checkForLocalResult(state,code,0,resulttype))
 				{
 					// no local result possible, use standard operation
@@ -5119,6 +5536,7 @@ void ABCVm::preloadFunction(SyntheticFunction* function, ASWorker* wrk)
 											}
 											state.preloadedcode.push_back(0);
 											state.preloadedcode.back().pcode.cacheobj3 = asAtomHandler::getObject(v->setter);
+											state.preloadedcode.back().runtimeobjects = true;
 											removetypestack(typestack,mi->context->constant_pool.multinames[t].runtimeargs+2);
 											break;
 										}
@@ -5126,6 +5544,7 @@ void ABCVm::preloadFunction(SyntheticFunction* function, ASWorker* wrk)
 										{
 											setupInstructionTwoArgumentsNoResult(state,ABC_OP_OPTIMZED_CALLFUNCTIONBUILTIN_ONEARG_VOID,opcode,code);
 											state.preloadedcode.at(state.preloadedcode.size()-1).pcode.cacheobj3 = asAtomHandler::getObject(v->setter);
+											state.preloadedcode.at(state.preloadedcode.size()-1).runtimeobjects = true;
 											removetypestack(typestack,mi->context->constant_pool.multinames[t].runtimeargs+2);
 											break;
 										}
@@ -5177,7 +5596,7 @@ void ABCVm::preloadFunction(SyntheticFunction* function, ASWorker* wrk)
 										bool getslotisvalue = state.preloadedcode.size() && state.preloadedcode.at(state.preloadedcode.size()-1).operator_start==ABC_OP_OPTIMZED_GETSLOT;
 										setupInstructionTwoArgumentsNoResult(state,operator_start,opcode,code);
 										if (getslotisvalue && state.preloadedcode.size() > 1 && v->slotid < ABC_OP_BITMASK_USED
-											&& state.preloadedcode.at(state.preloadedcode.size()-1).pcode.func == abc_setslotNoCoerce_local_local
+											&& state.preloadedcode.at(state.preloadedcode.size()-1).pcode.func == abc_setslot_operands<abc_operand_local<1>,abc_operand_local<2>,false>
 											&& state.preloadedcode.at(state.preloadedcode.size()-1).pcode.local_pos1 <0xffff // only optimize if local_pos1 fits in uint16_t
 											&& state.preloadedcode.at(state.preloadedcode.size()-2).operator_setslot != UINT32_MAX)
 										{
@@ -5188,9 +5607,13 @@ void ABCVm::preloadFunction(SyntheticFunction* function, ASWorker* wrk)
 											state.preloadedcode.at(state.preloadedcode.size()-1).cachedslot3 = state.preloadedcode.at(state.preloadedcode.size()-1).cachedslot1;
 											// move local1 of previous opcode to local1 of current opcode
 											state.preloadedcode.at(state.preloadedcode.size()-1).pcode.cacheobj1 = state.preloadedcode.at(state.preloadedcode.size()-2).pcode.cacheobj1;
+											state.preloadedcode.at(state.preloadedcode.size()-1).pointerslots |= state.preloadedcode.at(state.preloadedcode.size()-2).pointerslots & 1;
+											state.preloadedcode.at(state.preloadedcode.size()-1).runtimeobjects |= state.preloadedcode.at(state.preloadedcode.size()-2).runtimeobjects;
 											state.preloadedcode.at(state.preloadedcode.size()-1).cachedslot1 = state.preloadedcode.at(state.preloadedcode.size()-2).cachedslot1;
 											// move local2 of previous opcode to local2 of current opcode
 											state.preloadedcode.at(state.preloadedcode.size()-1).pcode.cacheobj2 = state.preloadedcode.at(state.preloadedcode.size()-2).pcode.cacheobj2;
+											state.preloadedcode.at(state.preloadedcode.size()-1).pointerslots |= state.preloadedcode.at(state.preloadedcode.size()-2).pointerslots & 2;
+											state.preloadedcode.at(state.preloadedcode.size()-1).runtimeobjects |= state.preloadedcode.at(state.preloadedcode.size()-2).runtimeobjects;
 											state.preloadedcode.at(state.preloadedcode.size()-1).cachedslot2 = state.preloadedcode.at(state.preloadedcode.size()-2).cachedslot2;
 											// move flags of previous opcode to flags of current opcode
 											state.preloadedcode.at(state.preloadedcode.size()-1).pcode.local3.flags = state.preloadedcode.at(state.preloadedcode.size()-2).pcode.local3.flags;
@@ -5222,7 +5645,7 @@ void ABCVm::preloadFunction(SyntheticFunction* function, ASWorker* wrk)
 								state.preloadedcode.at(state.preloadedcode.size()-1).pcode.func = abc_setPropertyStaticName;
 								clearOperands(state,false,&lastlocalresulttype);
 							}
-							state.preloadedcode.at(state.preloadedcode.size()-1).pcode.cachedmultiname2 =name;
+							setupPropertyCache(state,name);
 							state.preloadedcode.at(state.preloadedcode.size()-1).pcode.local3.pos = opcode; // use local3.pos as indicator for setproperty/initproperty
 							if ((simple_setter_opcode_pos != UINT32_MAX) // function is simple setter
 									&& function->inClass->isFinal // TODO also enable optimization for classes where it is guarranteed that the method is not overridden in derived classes
@@ -5269,6 +5692,7 @@ void ABCVm::preloadFunction(SyntheticFunction* function, ASWorker* wrk)
 									asAtom* arg = mi->context->getConstantAtom(state.operandlist[state.operandlist.size()-3].type,state.operandlist[state.operandlist.size()-3].index);
 									setupInstructionTwoArgumentsNoResult(state,startopcode,opcode,code);
 									state.preloadedcode.at(state.preloadedcode.size()-1).pcode.arg3_constant=arg;
+									state.preloadedcode.at(state.preloadedcode.size()-1).pointerslots |= 4;
 									state.preloadedcode.push_back(0);
 									state.preloadedcode.at(state.preloadedcode.size()-1).pcode.local3.pos = opcode; // use local3.pos as indicator for setproperty/initproperty
 									state.operandlist.back().removeArg(state);
@@ -5307,7 +5731,7 @@ void ABCVm::preloadFunction(SyntheticFunction* function, ASWorker* wrk)
 						{
 							multiname* name =  mi->context->getMultinameImpl(asAtomHandler::nullAtom,nullptr,t,false);
 							state.preloadedcode.push_back((uint32_t)ABC_OP_OPTIMZED_SETPROPERTY_STATICNAME_SIMPLE);
-							state.preloadedcode.at(state.preloadedcode.size()-1).pcode.cachedmultiname2 =name;
+							setupPropertyCache(state,name);
 							state.preloadedcode.at(state.preloadedcode.size()-1).pcode.local3.pos = opcode; // use local3.pos as indicator for setproperty/initproperty
 							if ((simple_setter_opcode_pos != UINT32_MAX) // function is simple setter
 									&& function->inClass->isFinal // TODO also enable optimization for classes where it is guarranteed that the method is not overridden in derived classes
@@ -5353,7 +5777,7 @@ void ABCVm::preloadFunction(SyntheticFunction* function, ASWorker* wrk)
 				state.preloadedcode.back().pcode.arg3_uint=value;
 				if (state.jumptargets.find(p) != state.jumptargets.end())
 					clearOperands(state,true,&lastlocalresulttype);
-				state.operandlist.push_back(operands(OP_LOCAL,state.localtypes[value],value,1,state.preloadedcode.size()-1));
+				pushOperand(state,operands(OP_LOCAL,state.localtypes[value],value,1,state.preloadedcode.size()-1));
 				typestack.push_back(typestackentry(state.localtypes[value],false));
 				break;
 			}
@@ -5589,6 +6013,7 @@ void ABCVm::preloadFunction(SyntheticFunction* function, ASWorker* wrk)
 				{
 					setupInstructionOneArgument(state,ABC_OP_OPTIMZED_COERCE,opcode,code,true,true,tobj && tobj->is<Class_base>() ? tobj->as<Class_base>() : nullptr,p,true);
 					state.preloadedcode.at(state.preloadedcode.size()-1).pcode.cachedmultiname2 = name;
+					state.preloadedcode.at(state.preloadedcode.size()-1).pointerslots |= 2;
 				}
 				else
 					opcode_skipped=true;
@@ -5640,7 +6065,7 @@ void ABCVm::preloadFunction(SyntheticFunction* function, ASWorker* wrk)
 				state.oldnewpositions[code.tellg()] = (int32_t)state.preloadedcode.size();
 				if (state.jumptargets.find(p) != state.jumptargets.end())
 					clearOperands(state,true,&lastlocalresulttype);
-				state.operandlist.push_back(operands(OP_LOCAL,state.localtypes[((uint32_t)opcode)-0xd0],((uint32_t)opcode)-0xd0,1,state.preloadedcode.size()-1));
+				pushOperand(state,operands(OP_LOCAL,state.localtypes[((uint32_t)opcode)-0xd0],((uint32_t)opcode)-0xd0,1,state.preloadedcode.size()-1));
 				typestack.push_back(typestackentry(state.localtypes[((uint32_t)opcode)-0xd0],false));
 				break;
 			}
@@ -5659,7 +6084,7 @@ void ABCVm::preloadFunction(SyntheticFunction* function, ASWorker* wrk)
 				bool dupoperand = !state.dupoperands.empty();
 				if (dupoperand)
 				{
-					state.operandlist.push_back(state.dupoperands.front());
+					pushOperand(state,state.dupoperands.front());
 					state.dupoperands.clear();
 				}
 				if (state.operandlist.size() > 0)
@@ -5824,7 +6249,7 @@ void ABCVm::preloadFunction(SyntheticFunction* function, ASWorker* wrk)
 							state.preloadedcode.back().pcode.func = abc_getlocal;
 							state.preloadedcode.back().pcode.arg3_uint = num2;
 							state.oldnewpositions[code.tellg()] = (int32_t)state.preloadedcode.size();
-							state.operandlist.push_back(operands(OP_LOCAL,restype,num2,1,state.preloadedcode.size()-1));
+							pushOperand(state,operands(OP_LOCAL,restype,num2,1,state.preloadedcode.size()-1));
 							state.operandlist.back().duparg1=true;
 							break;
 						}
@@ -5840,7 +6265,7 @@ void ABCVm::preloadFunction(SyntheticFunction* function, ASWorker* wrk)
 						state.preloadedcode.push_back(state.preloadedcode.back().opcode);
 						state.preloadedcode.back().pcode.arg3_uint=val;
 						state.oldnewpositions[code.tellg()] = (int32_t)state.preloadedcode.size();
-						state.operandlist.push_back(operands(op.type,op.objtype,op.index,1,state.preloadedcode.size()-1));
+						pushOperand(state,operands(op.type,op.objtype,op.index,1,state.preloadedcode.size()-1));
 					}
 				}
 				else
@@ -6264,7 +6689,7 @@ void ABCVm::preloadFunction(SyntheticFunction* function, ASWorker* wrk)
 				}
 				state.preloadedcode.push_back((uint32_t)opcode);
 				if (state.jumptargets.find(code.tellg()) == state.jumptargets.end())
-					state.operandlist.push_back(operands(OP_NULL, nullptr,0,1,state.preloadedcode.size()-1));
+					pushOperand(state,operands(OP_NULL, nullptr,0,1,state.preloadedcode.size()-1));
 				else
 					clearOperands(state,true,&lastlocalresulttype);
 				typestack.push_back(typestackentry(nullptr,false));
@@ -6277,7 +6702,7 @@ void ABCVm::preloadFunction(SyntheticFunction* function, ASWorker* wrk)
 				}
 				state.preloadedcode.push_back((uint32_t)opcode);
 				if (state.jumptargets.find(code.tellg()) == state.jumptargets.end())
-					state.operandlist.push_back(operands(OP_UNDEFINED, nullptr,0,1,state.preloadedcode.size()-1));
+					pushOperand(state,operands(OP_UNDEFINED, nullptr,0,1,state.preloadedcode.size()-1));
 				else
 					clearOperands(state,true,&lastlocalresulttype);
 				typestack.push_back(typestackentry(nullptr,false));
@@ -6298,13 +6723,13 @@ void ABCVm::preloadFunction(SyntheticFunction* function, ASWorker* wrk)
 					clearOperands(state,true,&lastlocalresulttype);
 				if (state.jumptargets.find(code.tellg()) != state.jumptargets.end() && code.peekbyte() == 0x74)//convert_u
 				{
-					state.operandlist.push_back(operands(OP_UINTEGER,Class<UInteger>::getRef(mi->context->root->getSystemState()).getPtr(),(uint32_t)value,1,state.preloadedcode.size()-1));
+					pushOperand(state,operands(OP_UINTEGER,Class<UInteger>::getRef(mi->context->root->getSystemState()).getPtr(),(uint32_t)value,1,state.preloadedcode.size()-1));
 					typestack.push_back(typestackentry(Class<UInteger>::getRef(function->getSystemState()).getPtr(),false));
 					code.readbyte();
 				}
 				else
 				{
-					state.operandlist.push_back(operands(OP_BYTE,Class<Integer>::getRef(mi->context->root->getSystemState()).getPtr(),index,1,state.preloadedcode.size()-1));
+					pushOperand(state,operands(OP_BYTE,Class<Integer>::getRef(mi->context->root->getSystemState()).getPtr(),index,1,state.preloadedcode.size()-1));
 					typestack.push_back(typestackentry(Class<Integer>::getRef(function->getSystemState()).getPtr(),false));
 				}
 				break;
@@ -6323,7 +6748,7 @@ void ABCVm::preloadFunction(SyntheticFunction* function, ASWorker* wrk)
 				state.preloadedcode.back().pcode.arg3_int=value;
 				if (state.jumptargets.find(p) != state.jumptargets.end())
 					clearOperands(state,true,&lastlocalresulttype);
-				state.operandlist.push_back(operands(OP_SHORT,Class<Integer>::getRef(mi->context->root->getSystemState()).getPtr(),index,1,state.preloadedcode.size()-1));
+				pushOperand(state,operands(OP_SHORT,Class<Integer>::getRef(mi->context->root->getSystemState()).getPtr(),index,1,state.preloadedcode.size()-1));
 				typestack.push_back(typestackentry(Class<Integer>::getRef(function->getSystemState()).getPtr(),false));
 				break;
 			}
@@ -6339,7 +6764,7 @@ void ABCVm::preloadFunction(SyntheticFunction* function, ASWorker* wrk)
 				state.oldnewpositions[code.tellg()] = (int32_t)state.preloadedcode.size();
 				if (state.jumptargets.find(p) != state.jumptargets.end())
 					clearOperands(state,true,&lastlocalresulttype);
-				state.operandlist.push_back(operands(OP_TRUE, Class<Boolean>::getRef(mi->context->root->getSystemState()).getPtr(),0,1,state.preloadedcode.size()-1));
+				pushOperand(state,operands(OP_TRUE, Class<Boolean>::getRef(mi->context->root->getSystemState()).getPtr(),0,1,state.preloadedcode.size()-1));
 				typestack.push_back(typestackentry(Class<Boolean>::getRef(function->getSystemState()).getPtr(),false));
 				break;
 			}
@@ -6355,7 +6780,7 @@ void ABCVm::preloadFunction(SyntheticFunction* function, ASWorker* wrk)
 				state.oldnewpositions[code.tellg()] = (int32_t)state.preloadedcode.size();
 				if (state.jumptargets.find(p) != state.jumptargets.end())
 					clearOperands(state,true,&lastlocalresulttype);
-				state.operandlist.push_back(operands(OP_FALSE, Class<Boolean>::getRef(mi->context->root->getSystemState()).getPtr(),0,1,state.preloadedcode.size()-1));
+				pushOperand(state,operands(OP_FALSE, Class<Boolean>::getRef(mi->context->root->getSystemState()).getPtr(),0,1,state.preloadedcode.size()-1));
 				typestack.push_back(typestackentry(Class<Boolean>::getRef(function->getSystemState()).getPtr(),false));
 				break;
 			}
@@ -6371,7 +6796,7 @@ void ABCVm::preloadFunction(SyntheticFunction* function, ASWorker* wrk)
 				state.oldnewpositions[code.tellg()] = (int32_t)state.preloadedcode.size();
 				if (state.jumptargets.find(p) != state.jumptargets.end())
 					clearOperands(state,true,&lastlocalresulttype);
-				state.operandlist.push_back(operands(OP_NAN, Class<Number>::getRef(mi->context->root->getSystemState()).getPtr(),0,1,state.preloadedcode.size()-1));
+				pushOperand(state,operands(OP_NAN, Class<Number>::getRef(mi->context->root->getSystemState()).getPtr(),0,1,state.preloadedcode.size()-1));
 				typestack.push_back(typestackentry(Class<Number>::getRef(function->getSystemState()).getPtr(),false));
 				break;
 			}
@@ -6388,7 +6813,7 @@ void ABCVm::preloadFunction(SyntheticFunction* function, ASWorker* wrk)
 				state.preloadedcode.back().pcode.arg3_uint = value;
 				if (state.jumptargets.find(p) != state.jumptargets.end())
 					clearOperands(state,true,&lastlocalresulttype);
-				state.operandlist.push_back(operands(OP_STRING,Class<ASString>::getRef(mi->context->root->getSystemState()).getPtr(),value,1,state.preloadedcode.size()-1));
+				pushOperand(state,operands(OP_STRING,Class<ASString>::getRef(mi->context->root->getSystemState()).getPtr(),value,1,state.preloadedcode.size()-1));
 				typestack.push_back(typestackentry(Class<ASString>::getRef(function->getSystemState()).getPtr(),false));
 				break;
 			}
@@ -6405,7 +6830,7 @@ void ABCVm::preloadFunction(SyntheticFunction* function, ASWorker* wrk)
 				state.preloadedcode.back().pcode.arg3_uint = value;
 				if (state.jumptargets.find(p) != state.jumptargets.end())
 					clearOperands(state,true,&lastlocalresulttype);
-				state.operandlist.push_back(operands(OP_INTEGER,Class<Integer>::getRef(mi->context->root->getSystemState()).getPtr(),value,1,state.preloadedcode.size()-1));
+				pushOperand(state,operands(OP_INTEGER,Class<Integer>::getRef(mi->context->root->getSystemState()).getPtr(),value,1,state.preloadedcode.size()-1));
 				typestack.push_back(typestackentry(Class<Integer>::getRef(function->getSystemState()).getPtr(),false));
 				break;
 			}
@@ -6422,7 +6847,7 @@ void ABCVm::preloadFunction(SyntheticFunction* function, ASWorker* wrk)
 				state.preloadedcode.back().pcode.arg3_uint = value;
 				if (state.jumptargets.find(p) != state.jumptargets.end())
 					clearOperands(state,true,&lastlocalresulttype);
-				state.operandlist.push_back(operands(OP_UINTEGER,Class<UInteger>::getRef(mi->context->root->getSystemState()).getPtr(),value,1,state.preloadedcode.size()-1));
+				pushOperand(state,operands(OP_UINTEGER,Class<UInteger>::getRef(mi->context->root->getSystemState()).getPtr(),value,1,state.preloadedcode.size()-1));
 				typestack.push_back(typestackentry(Class<UInteger>::getRef(function->getSystemState()).getPtr(),false));
 				break;
 			}
@@ -6439,7 +6864,7 @@ void ABCVm::preloadFunction(SyntheticFunction* function, ASWorker* wrk)
 				state.preloadedcode.back().pcode.arg3_uint = value;
 				if (state.jumptargets.find(p) != state.jumptargets.end())
 					clearOperands(state,true,&lastlocalresulttype);
-				state.operandlist.push_back(operands(OP_DOUBLE,Class<Number>::getRef(mi->context->root->getSystemState()).getPtr(),value,1,state.preloadedcode.size()-1));
+				pushOperand(state,operands(OP_DOUBLE,Class<Number>::getRef(mi->context->root->getSystemState()).getPtr(),value,1,state.preloadedcode.size()-1));
 				typestack.push_back(typestackentry(Class<Number>::getRef(function->getSystemState()).getPtr(),false));
 				break;
 			}
@@ -6464,7 +6889,7 @@ void ABCVm::preloadFunction(SyntheticFunction* function, ASWorker* wrk)
 				state.preloadedcode.back().pcode.arg3_uint = value;
 				if (state.jumptargets.find(p) != state.jumptargets.end())
 					clearOperands(state,true,&lastlocalresulttype);
-				state.operandlist.push_back(operands(OP_NAMESPACE,Class<Namespace>::getRef(mi->context->root->getSystemState()).getPtr(),value,1,state.preloadedcode.size()-1));
+				pushOperand(state,operands(OP_NAMESPACE,Class<Namespace>::getRef(mi->context->root->getSystemState()).getPtr(),value,1,state.preloadedcode.size()-1));
 				typestack.push_back(typestackentry(Class<Namespace>::getRef(function->getSystemState()).getPtr(),false));
 				break;
 			}
@@ -6762,8 +7187,10 @@ void ABCVm::preloadFunction(SyntheticFunction* function, ASWorker* wrk)
 									if (setupInstructionOneArgument(state,ABC_OP_OPTIMZED_CONSTRUCTPROP_STATICNAME_NOARGS,opcode,code,true,false,resulttype,p,true))
 									{
 										state.preloadedcode.at(state.preloadedcode.size()-1).pcode.cachedmultiname2 = name;
+										state.preloadedcode.at(state.preloadedcode.size()-1).pointerslots |= 2;
 										state.preloadedcode.push_back(0);
 										state.preloadedcode.at(state.preloadedcode.size()-1).pcode.cacheobj2 = constructor;
+										state.preloadedcode.at(state.preloadedcode.size()-1).runtimeobjects = true;
 									}
 									else
 									{
@@ -6932,6 +7359,7 @@ void ABCVm::preloadFunction(SyntheticFunction* function, ASWorker* wrk)
 												else
 													setupInstructionOneArgumentNoResult(state,ABC_OP_OPTIMZED_CALLFUNCTION_NOARGS_VOID,opcode,code,p);
 												state.preloadedcode.at(state.preloadedcode.size()-1).pcode.cacheobj2 = asAtomHandler::getObject(v->var);
+												state.preloadedcode.at(state.preloadedcode.size()-1).runtimeobjects = true;
 												removetypestack(typestack,argcount+mi->context->constant_pool.multinames[t].runtimeargs+1);
 												if (opcode == 0x46)
 												{
@@ -6951,11 +7379,13 @@ void ABCVm::preloadFunction(SyntheticFunction* function, ASWorker* wrk)
 									   ((opcode == 0x46 && setupInstructionOneArgument(state,ABC_OP_OPTIMZED_CALLPROPERTY_STATICNAME_NOARGS,opcode,code,true,false,resulttype,p,true))))
 									{
 										state.preloadedcode.at(state.preloadedcode.size()-1).pcode.cachedmultiname2 = name;
+										state.preloadedcode.at(state.preloadedcode.size()-1).pointerslots |= 2;
 										state.preloadedcode.push_back(0);
 										if (fromglobal && v)
 										{
 											state.preloadedcode.back().pcode.local2.flags |= ABC_OP_FROMGLOBAL;
 											state.preloadedcode.back().pcode.cachedvar3 = v;
+											state.preloadedcode.back().runtimeobjects = true;
 										}
 									}
 									else
@@ -6970,9 +7400,13 @@ void ABCVm::preloadFunction(SyntheticFunction* function, ASWorker* wrk)
 											{
 												state.preloadedcode.back().pcode.local2.flags |= ABC_OP_FROMGLOBAL;
 												state.preloadedcode.back().pcode.cachedvar3 = v;
+												state.preloadedcode.back().runtimeobjects = true;
 											}
 											else
+											{
 												state.preloadedcode.at(state.preloadedcode.size()-1).pcode.cacheobj3 = func;
+												state.preloadedcode.at(state.preloadedcode.size()-1).runtimeobjects = true;
+											}
 										}
 										else
 										{
@@ -6984,9 +7418,11 @@ void ABCVm::preloadFunction(SyntheticFunction* function, ASWorker* wrk)
 											{
 												state.preloadedcode.back().pcode.local2.flags |= ABC_OP_FROMGLOBAL;
 												state.preloadedcode.back().pcode.cachedvar3 = v;
+												state.preloadedcode.back().runtimeobjects = true;
 											}
 											state.preloadedcode.push_back(0);
 											state.preloadedcode.at(state.preloadedcode.size()-1).pcode.cachedmultiname2 = name;
+											state.preloadedcode.at(state.preloadedcode.size()-1).pointerslots |= 2;
 										}
 										clearOperands(state,true,&lastlocalresulttype);
 									}
@@ -7080,9 +7516,13 @@ void ABCVm::preloadFunction(SyntheticFunction* function, ASWorker* wrk)
 													{
 														state.preloadedcode.back().pcode.local2.flags |= ABC_OP_FROMGLOBAL;
 														state.preloadedcode.back().pcode.cachedvar3 = v;
+														state.preloadedcode.back().runtimeobjects = true;
 													}
 													else
+													{
 														state.preloadedcode.back().pcode.cacheobj3 = asAtomHandler::getObject(v->var);
+														state.preloadedcode.back().runtimeobjects = true;
+													}
 													removetypestack(typestack,argcount+mi->context->constant_pool.multinames[t].runtimeargs+1);
 													if (opcode == 0x46)
 														typestack.push_back(typestackentry(resulttype,false));
@@ -7100,6 +7540,7 @@ void ABCVm::preloadFunction(SyntheticFunction* function, ASWorker* wrk)
 														state.preloadedcode.push_back(0);
 													}
 													state.preloadedcode.at(state.preloadedcode.size()-1).pcode.cacheobj3 = asAtomHandler::getObject(v->var);
+													state.preloadedcode.at(state.preloadedcode.size()-1).runtimeobjects = true;
 													removetypestack(typestack,argcount+mi->context->constant_pool.multinames[t].runtimeargs+1);
 													if (opcode == 0x46)
 														typestack.push_back(typestackentry(resulttype,false));
@@ -7161,6 +7602,7 @@ void ABCVm::preloadFunction(SyntheticFunction* function, ASWorker* wrk)
 										}
 										state.preloadedcode.push_back(0);
 										state.preloadedcode.at(state.preloadedcode.size()-1).pcode.cachedmultiname2 = name;
+										state.preloadedcode.at(state.preloadedcode.size()-1).pointerslots |= 2;
 										state.preloadedcode.push_back(0);
 										state.preloadedcode.at(state.preloadedcode.size()-1).pcode.local2.flags =(skipcoerce ? ABC_OP_COERCED : 0);
 									}
@@ -7168,6 +7610,7 @@ void ABCVm::preloadFunction(SyntheticFunction* function, ASWorker* wrk)
 									{
 										state.preloadedcode.at(state.preloadedcode.size()-1).opcode=ABC_OP_OPTIMZED_CALLPROPERTY_STATICNAME_LOCALRESULT;
 										state.preloadedcode.at(state.preloadedcode.size()-1).pcode.cachedmultiname2 = name;
+										state.preloadedcode.at(state.preloadedcode.size()-1).pointerslots |= 2;
 										state.preloadedcode.push_back(0);
 										state.preloadedcode.back().pcode.local2.flags = (skipcoerce ? ABC_OP_COERCED : 0);
 									}
@@ -7180,6 +7623,7 @@ void ABCVm::preloadFunction(SyntheticFunction* function, ASWorker* wrk)
 											if (skipcoerce)
 												state.preloadedcode.back().pcode.local2.flags = ABC_OP_COERCED;
 											state.preloadedcode.at(state.preloadedcode.size()-1).pcode.cacheobj3 = func;
+											state.preloadedcode.at(state.preloadedcode.size()-1).runtimeobjects = true;
 										}
 										else
 										{
@@ -7189,6 +7633,7 @@ void ABCVm::preloadFunction(SyntheticFunction* function, ASWorker* wrk)
 												state.preloadedcode.back().pcode.local2.flags = ABC_OP_COERCED;
 											state.preloadedcode.push_back(0);
 											state.preloadedcode.at(state.preloadedcode.size()-1).pcode.cachedmultiname2 = name;
+											state.preloadedcode.at(state.preloadedcode.size()-1).pointerslots |= 2;
 										}
 										clearOperands(state,true,&lastlocalresulttype);
 									}
@@ -7216,6 +7661,7 @@ void ABCVm::preloadFunction(SyntheticFunction* function, ASWorker* wrk)
 										
 										uint32_t oppos = state.preloadedcode.size()-1-argcount;
 										state.preloadedcode.at(oppos+1).pcode.cachedmultiname3 = name;
+										state.preloadedcode.at(oppos+1).pointerslots |= 4;
 										if (state.operandlist.size() > argcount)
 										{
 											if (canCallFunctionDirect((*it),name))
@@ -7235,9 +7681,13 @@ void ABCVm::preloadFunction(SyntheticFunction* function, ASWorker* wrk)
 														{
 															state.preloadedcode.at(oppos).pcode.local2.flags |= ABC_OP_FROMGLOBAL;
 															state.preloadedcode.at(oppos).pcode.cachedvar3 = v;
+															state.preloadedcode.at(oppos).runtimeobjects = true;
 														}
 														else
+														{
 															state.preloadedcode.at(oppos).pcode.cacheobj3 = asAtomHandler::getObject(v->var);
+															state.preloadedcode.at(oppos).runtimeobjects = true;
+														}
 														removeOperands(state,true,&lastlocalresulttype,argcount+1);
 														if (opcode == 0x46)
 															checkForLocalResult(state,code,2,resulttype,oppos,state.preloadedcode.size()-1);
@@ -7258,6 +7708,7 @@ void ABCVm::preloadFunction(SyntheticFunction* function, ASWorker* wrk)
 														it->removeArg(state);
 														oppos = state.preloadedcode.size()-1-argcount;
 														state.preloadedcode.at(oppos).pcode.cacheobj3 = asAtomHandler::getObject(v->var);
+														state.preloadedcode.at(oppos).runtimeobjects = true;
 														removeOperands(state,true,&lastlocalresulttype,argcount+1);
 														if (opcode == 0x46)
 															checkForLocalResult(state,code,2,resulttype,oppos,state.preloadedcode.size()-1);
@@ -7275,6 +7726,7 @@ void ABCVm::preloadFunction(SyntheticFunction* function, ASWorker* wrk)
 											{
 												state.preloadedcode.at(oppos).pcode.local2.flags |= ABC_OP_FROMGLOBAL;
 												state.preloadedcode.at(oppos).pcode.cachedvar3 = v;
+												state.preloadedcode.at(oppos).runtimeobjects = true;
 											}
 											it->removeArg(state);
 											oppos = state.preloadedcode.size()-1-argcount;
@@ -7307,6 +7759,7 @@ void ABCVm::preloadFunction(SyntheticFunction* function, ASWorker* wrk)
 											if (skipcoerce)
 												state.preloadedcode.back().pcode.local2.flags = ABC_OP_COERCED;
 											state.preloadedcode.at(state.preloadedcode.size()-1).pcode.cacheobj3 = func;
+											state.preloadedcode.at(state.preloadedcode.size()-1).runtimeobjects = true;
 										}
 										else
 										{
@@ -7318,9 +7771,11 @@ void ABCVm::preloadFunction(SyntheticFunction* function, ASWorker* wrk)
 											{
 												state.preloadedcode.back().pcode.local2.flags |= ABC_OP_FROMGLOBAL;
 												state.preloadedcode.back().pcode.cachedvar3 = v;
+												state.preloadedcode.back().runtimeobjects = true;
 											}
 											state.preloadedcode.push_back(0);
 											state.preloadedcode.back().pcode.cachedmultiname2 = name;
+											state.preloadedcode.back().pointerslots |= 2;
 										}
 										clearOperands(state,true,&lastlocalresulttype);
 										removetypestack(typestack,argcount+mi->context->constant_pool.multinames[t].runtimeargs+1);
@@ -7436,6 +7891,7 @@ void ABCVm::preloadFunction(SyntheticFunction* function, ASWorker* wrk)
 										if (!setupInstructionOneArgument(state,ABC_OP_OPTIMZED_CALLFUNCTION_NOARGS,opcode,code,true, false,resulttype,p,true,false,false,true,ABC_OP_OPTIMZED_CALLFUNCTION_NOARGS_SETSLOT))
 											lastlocalresulttype = resulttype;
 										state.preloadedcode.at(state.preloadedcode.size()-1).pcode.cacheobj2 = asAtomHandler::getObject(v->getter);
+										state.preloadedcode.at(state.preloadedcode.size()-1).runtimeobjects = true;
 										addname = false;
 										removetypestack(typestack,mi->context->constant_pool.multinames[t].runtimeargs+1);
 										typestack.push_back(typestackentry(resulttype,false));
@@ -7490,6 +7946,7 @@ void ABCVm::preloadFunction(SyntheticFunction* function, ASWorker* wrk)
 										if (!setupInstructionOneArgument(state,ABC_OP_OPTIMZED_CALLFUNCTION_NOARGS,opcode,code,true, false,resulttype,p,true,false,false,true,ABC_OP_OPTIMZED_CALLFUNCTION_NOARGS_SETSLOT))
 											lastlocalresulttype = resulttype;
 										state.preloadedcode.at(state.preloadedcode.size()-1).pcode.cacheobj2 = asAtomHandler::getObject(v->getter);
+										state.preloadedcode.at(state.preloadedcode.size()-1).runtimeobjects = true;
 										addname = false;
 										removetypestack(typestack,mi->context->constant_pool.multinames[t].runtimeargs+1);
 										typestack.push_back(typestackentry(resulttype,false));
@@ -7565,7 +8022,7 @@ void ABCVm::preloadFunction(SyntheticFunction* function, ASWorker* wrk)
 											}
 											else
 												lastlocalresulttype = resulttype;
-											state.preloadedcode.at(state.preloadedcode.size()-1).pcode.cachedmultiname2 = name;
+											setupPropertyCache(state,name);
 											ASATOM_DECREF(o);
 											removetypestack(typestack,mi->context->constant_pool.multinames[t].runtimeargs+1);
 											typestack.push_back(typestackentry(resulttype,false));
@@ -7583,7 +8040,7 @@ void ABCVm::preloadFunction(SyntheticFunction* function, ASWorker* wrk)
 								state.preloadedcode.at(state.preloadedcode.size()-1).pcode.func=abc_getPropertyStaticName_localresult;
 								addname = false;
 							}
-							state.preloadedcode.at(state.preloadedcode.size()-1).pcode.cachedmultiname2 = name;
+							setupPropertyCache(state,name);
 							removetypestack(typestack,mi->context->constant_pool.multinames[t].runtimeargs+1);
 							typestack.push_back(typestackentry(resulttype,false));
 							break;
@@ -8212,8 +8669,12 @@ void ABCVm::preloadFunction(SyntheticFunction* function, ASWorker* wrk)
 		itexc++;
 	}
 	assert(mi->body->preloadedcode.size()==0);
+	bool storeinpreloadcache = mi->context->preloadcache && !mi->body->isspeculative && !(wrk->currentCallContext && wrk->currentCallContext->exceptionthrown);
+	std::vector<uint8_t> pointerslots;
 	for (auto itc = state.preloadedcode.begin(); itc != state.preloadedcode.end(); itc++)
 	{
+		storeinpreloadcache = storeinpreloadcache && !itc->runtimeobjects;
+		pointerslots.push_back(itc->pointerslots);
 		mi->body->preloadedcode.push_back((*itc).pcode);
 		if (!mi->body->preloadedcode[mi->body->preloadedcode.size()-1].func)
 			mi->body->preloadedcode[mi->body->preloadedcode.size()-1].func = ABCVm::abcfunctions[itc->opcode];
@@ -8225,7 +8686,60 @@ void ABCVm::preloadFunction(SyntheticFunction* function, ASWorker* wrk)
 		if ((*itc).cachedslot3)
 			mi->body->preloadedcode[mi->body->preloadedcode.size()-1].local3.pos+= mi->body->getReturnValuePos()+1+mi->body->localresultcount;
 	}
+	if (storeinpreloadcache)
+	{
+		for (auto it = state.localtypes.begin(); it != state.localtypes.end(); it++)
+			addResolvedClass(state,*it);
+		for (auto it = state.defaultlocaltypes.begin(); it != state.defaultlocaltypes.end(); it++)
+			addResolvedClass(state,*it);
+		for (auto it = state.jumptargeteresulttypes.begin(); it != state.jumptargeteresulttypes.end(); it++)
+			addResolvedClass(state,it->second);
+		storeInPreloadCache(function,pointerslots,state.resolvedclasses);
+	}
+	fuseSuperInstructions(mi->body);
 	if (activationobject)
 		activationobject->decRef();
 }
 
+#define ABC_SUPERINSTRUCTION_INCLOCAL_I(cmp,arg1,arg2) \
+	{ abc_ifcompare<abc_compare_##cmp,arg1<1>,arg2<2>>, \
+	  { abc_inclocal_i_ifcompare<abc_compare_##cmp,arg1<1>,arg2<2>,true>, abc_inclocal_i_ifcompare<abc_compare_##cmp,arg1<1>,arg2<2>,false> } }
+#define ABC_SUPERINSTRUCTION_INCLOCAL_I_ALL_OPERANDS(cmp) \
+	ABC_SUPERINSTRUCTION_INCLOCAL_I(cmp,abc_operand_constant,abc_operand_constant), \
+	ABC_SUPERINSTRUCTION_INCLOCAL_I(cmp,abc_operand_local,abc_operand_constant), \
+	ABC_SUPERINSTRUCTION_INCLOCAL_I(cmp,abc_operand_constant,abc_operand_local), \
+	ABC_SUPERINSTRUCTION_INCLOCAL_I(cmp,abc_operand_local,abc_operand_local)
+
+void ABCVm::fuseSuperInstructions(method_body_info* body)
+{
+	// maps the conditional jumps to the superinstructions for inclocal_i/declocal_i followed by this conditional jump
+	static const std::unordered_map<abc_function,std::pair<abc_function,abc_function>> inclocal_i_superinstructions = {
+		ABC_SUPERINSTRUCTION_INCLOCAL_I_ALL_OPERANDS(lt),
+		ABC_SUPERINSTRUCTION_INCLOCAL_I_ALL_OPERANDS(le),
+		ABC_SUPERINSTRUCTION_INCLOCAL_I_ALL_OPERANDS(gt),
+		ABC_SUPERINSTRUCTION_INCLOCAL_I_ALL_OPERANDS(ge),
+		ABC_SUPERINSTRUCTION_INCLOCAL_I_ALL_OPERANDS(nlt),
+		ABC_SUPERINSTRUCTION_INCLOCAL_I_ALL_OPERANDS(nle),
+		ABC_SUPERINSTRUCTION_INCLOCAL_I_ALL_OPERANDS(ngt),
+		ABC_SUPERINSTRUCTION_INCLOCAL_I_ALL_OPERANDS(nge),
+		ABC_SUPERINSTRUCTION_INCLOCAL_I_ALL_OPERANDS(eq),
+		ABC_SUPERINSTRUCTION_INCLOCAL_I_ALL_OPERANDS(ne),
+		ABC_SUPERINSTRUCTION_INCLOCAL_I_ALL_OPERANDS(stricteq),
+		ABC_SUPERINSTRUCTION_INCLOCAL_I_ALL_OPERANDS(strictne)
+	};
+	for (uint32_t i = 1; i < body->preloadedcode.size(); i++)
+	{
+		preloadedcodedata& code = body->preloadedcode[i-1];
+		bool increment = code.func == abc_inclocal_i_optimized;
+		if (!increment && code.func != abc_declocal_i_optimized)
+			continue;
+		auto it = inclocal_i_superinstructions.find(body->preloadedcode[i].func);
+		// the superinstruction moves exec_pos to the conditional jump before evaluating it,
+		// so exceptions are reported from the same positions as without fusing
+		if (it != inclocal_i_superinstructions.end())
+			code.func = increment ? it->second.first : it->second.second;
+	}
+}
+#undef ABC_SUPERINSTRUCTION_INCLOCAL_I_ALL_OPERANDS
+#undef ABC_SUPERINSTRUCTION_INCLOCAL_I
+
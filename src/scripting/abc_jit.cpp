@@ -0,0 +1,260 @@
+/**************************************************************************
+    Lightspark, a free flash player implementation
+
+    Copyright (C) 2009-2013  Alessandro Pignotti (a.pignotti@sssup.it)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+#ifdef JIT_ENABLED
+/*
+ * Baseline jit for x86-64.
+ * The preloaded code of a method body is translated into a sequence of native calls to the same
+ * opcode handlers the interpreter uses, so the semantics are exactly the ones of ABCVm::executeFunction.
+ * What is saved is the dispatch overhead:
+ * - every handler is called through an immediate address instead of loading it from the preloaded code
+ * - if a handler continues with the next instruction, execution falls through to the next native block
+ * - unconditional jumps are resolved at compile time
+ * Only opcodes that may finish the function check the return value and the exception state.
+ * All other control flow changes go through a dispatch table indexed by the byte offset of exec_pos.
+ */
+#include <sys/mman.h>
+#include <unistd.h>
+#include <cstddef>
+#include <cstring>
+#include "scripting/abc.h"
+#include "scripting/abcutils.h"
+#include "logger.h"
+
+using namespace std;
+using namespace lightspark;
+
+namespace
+{
+/*
+ * registers used by the generated code (all callee saved):
+ * rbx: call_context
+ * r12: return value of the function
+ * r13: start of the preloaded code
+ * r14: dispatch table
+ */
+class jitemitter
+{
+public:
+	std::vector<uint8_t> code;
+	uint32_t pos() const { return code.size(); }
+	void bytes(std::initializer_list<uint8_t> l) { code.insert(code.end(),l); }
+	void imm32(uint32_t v)
+	{
+		for (uint32_t i = 0; i < 4; i++)
+			code.push_back(uint8_t(v>>(8*i)));
+	}
+	void imm64(uint64_t v)
+	{
+		for (uint32_t i = 0; i < 8; i++)
+			code.push_back(uint8_t(v>>(8*i)));
+	}
+	// emits a rel32 placeholder and returns its position
+	uint32_t rel32()
+	{
+		uint32_t p = pos();
+		imm32(0);
+		return p;
+	}
+	void patch(uint32_t p, uint32_t target)
+	{
+		int32_t rel = int32_t(target)-int32_t(p+4);
+		memcpy(&code[p],&rel,4);
+	}
+	void jmp(uint32_t target)
+	{
+		bytes({0xe9});
+		patch(rel32(),target);
+	}
+	void jne(uint32_t target)
+	{
+		bytes({0x0f,0x85});
+		patch(rel32(),target);
+	}
+	// mov rax,[rbx+offset]
+	void loadContextRax(uint32_t offset)
+	{
+		bytes({0x48,0x8b,0x83});
+		imm32(offset);
+	}
+	// mov [rbx+offset],rax
+	void storeContextRax(uint32_t offset)
+	{
+		bytes({0x48,0x89,0x83});
+		imm32(offset);
+	}
+};
+}
+
+bool ABCVm::jitFunction(method_body_info* body)
+{
+	static_assert(sizeof(preloadedcodedata)%sizeof(void*)==0,"preloadedcodedata has to be pointer aligned");
+	const uint32_t stride = sizeof(preloadedcodedata)/sizeof(void*);
+	const uint32_t execposoffset = offsetof(call_context,exec_pos);
+	const uint32_t exceptionoffset = offsetof(call_context,exceptionthrown);
+
+	// functions with exception handlers stay in the interpreter
+	if (!body->exceptions.empty() || body->preloadedcode.empty())
+	{
+		body->jitfailed = true;
+		return false;
+	}
+	const uint32_t count = body->preloadedcode.size();
+	const preloadedcodedata* codestart = body->preloadedcode.data();
+	std::vector<const void*> dispatch(count*stride,nullptr);
+	std::vector<uint32_t> blockpos(count,UINT32_MAX);
+	// rel32 positions of jumps and their target instruction
+	std::vector<std::pair<uint32_t,uint32_t>> jumps;
+
+	jitemitter e;
+	// prologue: push rbx; push r12; push r13; push r14; sub rsp,8 (keeps the stack 16 byte aligned)
+	e.bytes({0x53,0x41,0x54,0x41,0x55,0x41,0x56,0x48,0x83,0xec,0x08});
+	// mov rbx,rdi; mov r12,rsi
+	e.bytes({0x48,0x89,0xfb,0x49,0x89,0xf4});
+	// mov r13,codestart
+	e.bytes({0x49,0xbd});
+	e.imm64(uint64_t(codestart));
+	// mov r14,dispatch table
+	e.bytes({0x49,0xbe});
+	e.imm64(uint64_t(dispatch.data()));
+	// dispatch to exec_pos
+	e.loadContextRax(execposoffset);
+	const uint32_t dispatchlabel = e.pos();
+	// sub rax,r13; jmp [r14+rax]
+	e.bytes({0x4c,0x29,0xe8,0x41,0xff,0x24,0x06});
+	const uint32_t exitlabel = e.pos();
+	// add rsp,8; pop r14; pop r13; pop r12; pop rbx; ret
+	e.bytes({0x48,0x83,0xc4,0x08,0x41,0x5e,0x41,0x5d,0x41,0x5c,0x5b,0xc3});
+	// exec_pos points to something that isn't an instruction, report it like the interpreter does
+	// mov rdi,rbx; mov rax,abc_invalidinstruction; call rax; jmp exit
+	const uint32_t invalidlabel = e.pos();
+	e.bytes({0x48,0x89,0xdf,0x48,0xb8});
+	e.imm64(uint64_t(abc_invalidinstruction));
+	e.bytes({0xff,0xd0});
+	e.jmp(exitlabel);
+
+	// preloadFunction sets the handler of the entries that only contain the arguments of the previous instruction to abc_invalidinstruction
+	auto isdata = [body](uint32_t i) { return body->preloadedcode[i].func == nullptr || body->preloadedcode[i].func == abc_invalidinstruction; };
+	for (uint32_t i = 0; i < count; i++)
+	{
+		if (isdata(i))
+			continue;
+		abc_function f = body->preloadedcode[i].func;
+		blockpos[i] = e.pos();
+		if (f == abc_jump)
+		{
+			int64_t target = int64_t(i)+body->preloadedcode[i].arg3_int;
+			if (target >= 0 && target < count && !isdata(target))
+			{
+				// mov rax,target; mov [rbx+exec_pos],rax; jmp target
+				e.bytes({0x48,0xb8});
+				e.imm64(uint64_t(codestart+target));
+				e.storeContextRax(execposoffset);
+				e.bytes({0xe9});
+				jumps.push_back(make_pair(e.rel32(),uint32_t(target)));
+				continue;
+			}
+		}
+		// mov rdi,rbx; mov rax,f; call rax
+		e.bytes({0x48,0x89,0xdf,0x48,0xb8});
+		e.imm64(uint64_t(f));
+		e.bytes({0xff,0xd0});
+		if (!isNonTerminatingOpcode(f))
+		{
+			// cmp qword [r12],0 (return value is set)
+			e.bytes({0x49,0x83,0x3c,0x24,0x00});
+			e.jne(exitlabel);
+			// cmp qword [rbx+exceptionthrown],0
+			e.bytes({0x48,0x83,0xbb});
+			e.imm32(exceptionoffset);
+			e.bytes({0x00});
+			e.jne(exitlabel);
+		}
+		e.loadContextRax(execposoffset);
+		uint32_t next = i+1;
+		while (next < count && isdata(next))
+			next++;
+		if (next < count)
+		{
+			// mov rdx,next; cmp rax,rdx; jne dispatch, otherwise fall through to the next block
+			e.bytes({0x48,0xba});
+			e.imm64(uint64_t(codestart+next));
+			e.bytes({0x48,0x39,0xd0});
+			e.jne(dispatchlabel);
+		}
+		else
+			e.jmp(dispatchlabel);
+	}
+	for (auto it = jumps.begin(); it != jumps.end(); it++)
+		e.patch(it->first,blockpos[it->second]);
+
+	size_t pagesize = sysconf(_SC_PAGESIZE);
+	size_t size = ((e.pos()+pagesize-1)/pagesize)*pagesize;
+	void* mem = mmap(nullptr,size,PROT_READ|PROT_WRITE,MAP_PRIVATE|MAP_ANONYMOUS,-1,0);
+	if (mem == MAP_FAILED)
+	{
+		LOG(LOG_ERROR,"jit: unable to allocate executable memory");
+		body->jitfailed = true;
+		return false;
+	}
+	memcpy(mem,e.code.data(),e.pos());
+	if (mprotect(mem,size,PROT_READ|PROT_EXEC) != 0)
+	{
+		LOG(LOG_ERROR,"jit: unable to make code executable");
+		munmap(mem,size);
+		body->jitfailed = true;
+		return false;
+	}
+	uint8_t* native = (uint8_t*)mem;
+	for (uint32_t i = 0; i < count; i++)
+		dispatch[i*stride] = native + (blockpos[i] == UINT32_MAX ? invalidlabel : blockpos[i]);
+	// the vector buffer is moved, so the address embedded in the code stays valid
+	body->jitdispatch.swap(dispatch);
+	body->jitcodestart = codestart;
+	body->jitcodesize = size;
+	body->jitcode = (jit_function)mem;
+	LOG_CALL("jitted "<<count<<" instructions to "<<e.pos()<<" bytes");
+	return true;
+}
+
+void ABCVm::executeFunctionJit(call_context* context)
+{
+	method_body_info* body = context->mi->body;
+	if (body->jitcodestart != body->preloadedcode.data() || body->jitdispatch.size() != body->preloadedcode.size()*(sizeof(preloadedcodedata)/sizeof(void*)))
+	{
+		// the preloaded code was regenerated after jitting.
+		// The native code may still be in use further up the stack, so it is kept until the body is destroyed
+		executeFunction(context);
+		return;
+	}
+	asAtom* ret = &context->locals[body->getReturnValuePos()];
+	if (asAtomHandler::isValid(*ret) || context->exceptionthrown)
+		return;
+	body->jitcode(context,ret);
+}
+
+void ABCVm::releaseJitCode(method_body_info* body)
+{
+	munmap((void*)body->jitcode,body->jitcodesize);
+	body->jitcode = nullptr;
+	body->jitcodesize = 0;
+	body->jitcodestart = nullptr;
+	body->jitdispatch.clear();
+}
+#endif //JIT_ENABLED
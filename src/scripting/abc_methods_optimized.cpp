@@ -40,149 +40,146 @@ FORCE_INLINE void replacelocalresult(call_context* context,uint16_t pos,asAtom&
 	asAtomHandler::set(CONTEXT_GETLOCAL(context,pos),ret);
 	ASATOM_DECREF(oldres);
 }
-void ABCVm::abc_ifnlt_constant_constant(call_context* context)
+FORCE_INLINE propertycacheentry* findPropertyCacheEntry(call_context* context,uint32_t cacheindex,ASObject* obj)
 {
-	bool cond=!(asAtomHandler::isLess(*context->exec_pos->arg1_constant,context->worker,*context->exec_pos->arg2_constant) == TTRUE);
-	LOG_CALL("ifNLT_cc (" << ((cond)?"taken)":"not taken)"));
-	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
-	else
-		++(context->exec_pos);
-}
-void ABCVm::abc_ifnlt_local_constant(call_context* context)
-{
-	bool cond=!(asAtomHandler::isLess(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1),context->worker,*context->exec_pos->arg2_constant) == TTRUE);
-	LOG_CALL("ifNLT_lc (" << ((cond)?"taken)":"not taken)"));
-	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
-	else
-		++(context->exec_pos);
-}
-void ABCVm::abc_ifnlt_constant_local(call_context* context)
-{
-	bool cond=!(asAtomHandler::isLess(*context->exec_pos->arg1_constant,context->worker,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2)) == TTRUE);
-	LOG_CALL("ifNLT_cl (" << ((cond)?"taken)":"not taken)"));
-	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
-	else
-		++(context->exec_pos);
-}
-void ABCVm::abc_ifnlt_local_local(call_context* context)
-{
-	bool cond=!(asAtomHandler::isLess(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1),context->worker,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2)) == TTRUE);
-	LOG_CALL("ifNLT_ll (" << ((cond)?"taken)":"not taken)"));
-	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
-	else
-		++(context->exec_pos);
-}
-void ABCVm::abc_ifnge_constant_constant(call_context* context)
-{
-	bool cond=!(asAtomHandler::isLess(*context->exec_pos->arg1_constant,context->worker,*context->exec_pos->arg2_constant) == TFALSE);
-	LOG_CALL("ifNGE_cc (" << ((cond)?"taken)":"not taken)"));
-	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
-	else
-		++(context->exec_pos);
-}
-void ABCVm::abc_ifnge_local_constant(call_context* context)
-{
-	bool cond=!(asAtomHandler::isLess(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1),context->worker,*context->exec_pos->arg2_constant) == TFALSE);
-	LOG_CALL("ifNGE_lc (" << ((cond)?"taken)":"not taken)"));
-	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
-	else
-		++(context->exec_pos);
-}
-void ABCVm::abc_ifnge_constant_local(call_context* context)
-{
-	bool cond=!(asAtomHandler::isLess(*context->exec_pos->arg1_constant,context->worker,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2)) == TFALSE);
-	LOG_CALL("ifNGE_cl (" << ((cond)?"taken)":"not taken)"));
-	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
-	else
-		++(context->exec_pos);
-}
-void ABCVm::abc_ifnge_local_local(call_context* context)
-{
-	bool cond=!(asAtomHandler::isLess(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1),context->worker,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2)) == TFALSE);
-	LOG_CALL("ifNGE_ll (" << ((cond)?"taken)":"not taken)")<<" "<<asAtomHandler::toDebugString(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1))<<" "<<asAtomHandler::toDebugString(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2)));
-	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
-	else
-		++(context->exec_pos);
-}
-void ABCVm::abc_ifnle_constant_constant(call_context* context)
-{
-	bool cond=!(asAtomHandler::isLess(*context->exec_pos->arg2_constant,context->worker,*context->exec_pos->arg1_constant) == TFALSE);
-	LOG_CALL("ifNLE_cc (" << ((cond)?"taken)":"not taken)"));
-	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
-	else
-		++(context->exec_pos);
-}
-void ABCVm::abc_ifnle_local_constant(call_context* context)
-{
-	bool cond=!(asAtomHandler::isLess(*context->exec_pos->arg2_constant,context->worker,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1)) == TFALSE);
-	LOG_CALL("ifNLE_lc (" << ((cond)?"taken)":"not taken)"));
-	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
-	else
-		++(context->exec_pos);
-}
-void ABCVm::abc_ifnle_constant_local(call_context* context)
-{
-	bool cond=!(asAtomHandler::isLess(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2),context->worker,*context->exec_pos->arg1_constant) == TFALSE);
-	LOG_CALL("ifNLE_cl (" << ((cond)?"taken)":"not taken)"));
-	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
-	else
-		++(context->exec_pos);
-}
-void ABCVm::abc_ifnle_local_local(call_context* context)
-{
-	bool cond=!(asAtomHandler::isLess(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2),context->worker,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1)) == TFALSE);
-	LOG_CALL("ifNLE_ll (" << ((cond)?"taken)":"not taken)")<<" "<<asAtomHandler::toDebugString(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1))<<" "<<asAtomHandler::toDebugString(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2)));
-	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
-	else
-		++(context->exec_pos);
-}
-void ABCVm::abc_ifngt_constant_constant(call_context* context)
-{
-	bool cond=!(asAtomHandler::isLess(*context->exec_pos->arg2_constant,context->worker,*context->exec_pos->arg1_constant) == TTRUE);
-	LOG_CALL("ifNGT_cc (" << ((cond)?"taken)":"not taken)"));
-	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
-	else
-		++(context->exec_pos);
-}
-void ABCVm::abc_ifngt_local_constant(call_context* context)
-{
-	bool cond=!(asAtomHandler::isLess(*context->exec_pos->arg2_constant,context->worker,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1)) == TTRUE);
-	LOG_CALL("ifNGT_lc (" << ((cond)?"taken)":"not taken)"));
-	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
-	else
-		++(context->exec_pos);
+	if (cacheindex == 0)
+		return nullptr;
+	propertycache& cache = context->mi->body->propertycaches[cacheindex-1];
+	Class_base* cls = obj->getClass();
+	for (uint32_t i = 0; i < cache.count; i++)
+	{
+		if (cache.entries[i].cls == cls)
+			return cache.entries[i].revision == cls->traitsRevision ? &cache.entries[i] : nullptr;
+	}
+	return nullptr;
 }
-void ABCVm::abc_ifngt_constant_local(call_context* context)
+void addPropertyCacheEntry(call_context* context,uint32_t cacheindex,ASObject* obj,multiname* name,bool forsetting)
 {
-	bool cond=!(asAtomHandler::isLess(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2),context->worker,*context->exec_pos->arg1_constant) == TTRUE);
-	LOG_CALL("ifNGT_cl (" << ((cond)?"taken)":"not taken)"));
-	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
+	if (cacheindex == 0)
+		return;
+	propertycache& cache = context->mi->body->propertycaches[cacheindex-1];
+	if (cache.megamorphic)
+		return;
+	uint32_t slotid;
+	variable* var;
+	if (!obj->getCacheableVariable(*name,forsetting,slotid,var))
+		return;
+	Class_base* cls = obj->getClass();
+	propertycacheentry* entry = nullptr;
+	for (uint32_t i = 0; i < cache.count; i++)
+	{
+		// entry is outdated because the traits of the class have changed
+		if (cache.entries[i].cls == cls)
+			entry = &cache.entries[i];
+	}
+	if (!entry)
+	{
+		if (cache.count == PROPERTYCACHE_SIZE)
+		{
+			LOG_CALL("property cache is megamorphic:"<<*name);
+			cache.megamorphic = true;
+			return;
+		}
+		entry = &cache.entries[cache.count++];
+	}
+	entry->cls = cls;
+	entry->var = var;
+	entry->slotid = slotid;
+	entry->revision = cls->traitsRevision;
+	entry->shapeid = 0;
+	entry->flatindex = 0;
+	if (slotid)
+		obj->getFlatIndex(obj->getSlotVar(slotid),entry->shapeid,entry->flatindex);
+	LOG_CALL("caching property:"<<*name<<" "<<cls->toDebugString()<<" "<<slotid);
+}
+// gets the property using the inline cache of the instruction, returns false if the class of obj is not in the cache
+FORCE_INLINE bool getPropertyCached(call_context* context,uint32_t cacheindex,ASObject* obj,asAtom& prop)
+{
+	propertycacheentry* entry = findPropertyCacheEntry(context,cacheindex,obj);
+	if (!entry)
+		return false;
+	if (entry->slotid)
+	{
+		// objects created from the cached shape are read directly from their flat layout
+		variable* v = entry->shapeid ? obj->getFlatVar(entry->shapeid,entry->flatindex) : nullptr;
+		if (!v)
+		{
+			// object may not be completely initialized yet
+			if (entry->slotid > obj->getSlotCount())
+				return false;
+			v = obj->getSlotVar(entry->slotid);
+		}
+		if (asAtomHandler::isInvalid(v->var))
+			return false;
+		prop = v->var;
+		ASATOM_INCREF(prop);
+		LOG_CALL("getProperty from cached slot "<<entry->slotid<<" "<<asAtomHandler::toDebugString(prop));
+		return true;
+	}
+	variable* v = entry->var;
+	if (asAtomHandler::isValid(v->getter))
+	{
+		LOG_CALL("Calling the cached getter on " << obj->toDebugString());
+		IFunction* f = asAtomHandler::as<IFunction>(v->getter);
+		ASObject* closure = asAtomHandler::getClosure(v->getter);
+		f->callGetter(prop,closure ? closure : obj,context->worker);
+		LOG_CALL("End of getter"<< ' ' << f->toDebugString()<<" result:"<<asAtomHandler::toDebugString(prop));
+	}
+	else if (asAtomHandler::as<IFunction>(v->var)->isMethod() && !asAtomHandler::getClosure(v->var))
+		asAtomHandler::setFunction(prop,asAtomHandler::getObjectNoCheck(v->var),obj,context->worker);
 	else
-		++(context->exec_pos);
+	{
+		if (!asAtomHandler::as<IFunction>(v->var)->isMethod() || asAtomHandler::as<IFunction>(v->var)->clonedFrom)
+			ASATOM_INCREF(v->var);
+		prop = v->var;
+	}
+	return true;
 }
-void ABCVm::abc_ifngt_local_local(call_context* context)
+// sets the property using the inline cache of the instruction, returns false if the class of obj is not in the cache
+// this has the same semantics as ASObject::setVariableByMultiname
+FORCE_INLINE bool setPropertyCached(call_context* context,uint32_t cacheindex,ASObject* obj,asAtom& value,bool* alreadyset)
 {
-	bool cond=!(asAtomHandler::isLess(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2),context->worker,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1)) == TTRUE);
-	LOG_CALL("ifNGT_ll (" << ((cond)?"taken)":"not taken)")<<" "<<asAtomHandler::toDebugString(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1))<<" "<<asAtomHandler::toDebugString(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2)));
-	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
-	else
-		++(context->exec_pos);
+	propertycacheentry* entry = findPropertyCacheEntry(context,cacheindex,obj);
+	if (!entry)
+		return false;
+	if (entry->slotid)
+	{
+		if (asAtomHandler::is<SyntheticFunction>(value))
+			return false;
+		variable* v = entry->shapeid ? obj->getFlatVar(entry->shapeid,entry->flatindex) : nullptr;
+		if (!v)
+		{
+			if (entry->slotid > obj->getSlotCount())
+				return false;
+			v = obj->getSlotVar(entry->slotid);
+		}
+		LOG_CALL("setProperty to cached slot "<<entry->slotid);
+		if (alreadyset)
+		{
+			if (value.uintval == v->var.uintval)
+				*alreadyset = true;
+			else
+			{
+				v->setVar(context->worker,value);
+				*alreadyset = value.uintval != v->var.uintval; // setVar may coerce the object into a new instance, so we need to check if decRef is necessary
+			}
+		}
+		else
+			v->setVar(context->worker,value);
+		return true;
+	}
+	LOG_CALL("Calling the cached setter on " << obj->toDebugString());
+	asAtom target = asAtomHandler::fromObject(obj);
+	asAtom ret=asAtomHandler::invalidAtom;
+	asAtomHandler::callFunction(entry->var->setter,context->worker,ret,target,&value,1,false);
+	ASATOM_DECREF(ret);
+	if (alreadyset)
+		*alreadyset=false;
+	// the callers release the value if the setter has thrown an exception
+	if (!context->exceptionthrown)
+		ASATOM_DECREF(value);
+	LOG_CALL("End of setter");
+	return true;
 }
 void ABCVm::abc_iftrue_constant(call_context* context)
 {
@@ -274,400 +271,111 @@ void ABCVm::abc_iffalse_dup_local(call_context* context)
 	else
 		++(context->exec_pos);
 }
-void ABCVm::abc_ifeq_constant_constant(call_context* context)
-{
-	bool cond=asAtomHandler::isEqual(*context->exec_pos->arg1_constant,context->worker,*context->exec_pos->arg2_constant);
-	LOG_CALL("ifEq_cc (" << ((cond)?"taken)":"not taken)"));
-	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
-	else
-		++(context->exec_pos);
-}
-void ABCVm::abc_ifeq_local_constant(call_context* context)
-{
-	bool cond=asAtomHandler::isEqual(*context->exec_pos->arg2_constant,context->worker,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1));
-	LOG_CALL("ifEq_lc (" << ((cond)?"taken)":"not taken)"));
-	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
-	else
-		++(context->exec_pos);
-}
-void ABCVm::abc_ifeq_constant_local(call_context* context)
+
+void ABCVm::abc_pushcachedconstant(call_context* context)
 {
-	bool cond=asAtomHandler::isEqual(*context->exec_pos->arg1_constant,context->worker,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2));
-	LOG_CALL("ifEq_cl (" << ((cond)?"taken)":"not taken)"));
-	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
-	else
-		++(context->exec_pos);
+	uint32_t t = context->exec_pos->arg3_uint;
+	assert(t <= (uint32_t)context->mi->context->atomsCachedMaxID);
+	asAtom a = context->mi->context->constantAtoms_cached[t];
+	LOG_CALL("pushcachedconstant "<<t<<" "<<asAtomHandler::toDebugString(a));
+	ASATOM_INCREF(a);
+	RUNTIME_STACK_PUSH(context,a);
+	++(context->exec_pos);
 }
-void ABCVm::abc_ifeq_local_local(call_context* context)
+void ABCVm::abc_pushcachedslot(call_context* context)
 {
-	bool cond=asAtomHandler::isEqual(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1),context->worker,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2));
-	LOG_CALL("ifEq_ll (" << ((cond)?"taken)":"not taken)"));
-	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
-	else
-		++(context->exec_pos);
+	uint32_t t = context->exec_pos->arg3_uint;
+	assert(t < context->mi->body->localconstantslots.size());
+	asAtom a = *(context->localslots[context->mi->body->getReturnValuePos()+1+context->mi->body->localresultcount+t]);
+	LOG_CALL("pushcachedslot "<<t<<" "<<asAtomHandler::toDebugString(a));
+	ASATOM_INCREF(a);
+	RUNTIME_STACK_PUSH(context,a);
+	++(context->exec_pos);
 }
-void ABCVm::abc_ifne_constant_constant(call_context* context)
+void ABCVm::abc_getlexfromslot(call_context* context)
 {
-	bool cond=!asAtomHandler::isEqual(*context->exec_pos->arg1_constant,context->worker,*context->exec_pos->arg2_constant);
-	LOG_CALL("ifNE_cc (" << ((cond)?"taken)":"not taken)"));
-	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
-	else
-		++(context->exec_pos);
+	uint32_t t = context->exec_pos->arg1_uint;
+	int32_t num = context->exec_pos->arg2_int;
+	asAtom o = num ==-1 ? *context->locals : (context->function->func_scope->scope.rbegin()+num)->object;
+	ASObject* s = asAtomHandler::toObject(o,context->worker);
+	asAtom a = s->getSlot(t);
+	LOG_CALL("getlexfromslot "<<s->toDebugString()<<" "<<t);
+	ASATOM_INCREF(a);
+	RUNTIME_STACK_PUSH(context,a);
+	++(context->exec_pos);
 }
-void ABCVm::abc_ifne_local_constant(call_context* context)
+void ABCVm::abc_getlexfromslot_localresult(call_context* context)
 {
-	bool cond=!asAtomHandler::isEqual(*context->exec_pos->arg2_constant,context->worker,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1));
-	LOG_CALL("ifNE_lc (" << ((cond)?"taken)":"not taken)"));
-	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
-	else
-		++(context->exec_pos);
+	uint32_t t = context->exec_pos->arg1_uint;
+	int32_t num = context->exec_pos->arg2_int;
+	asAtom o = num ==-1 ? *context->locals : (context->function->func_scope->scope.rbegin()+num)->object;
+	ASObject* s = asAtomHandler::toObject(o,context->worker);
+	asAtom a = s->getSlot(t);
+	LOG_CALL("getlexfromslot_l "<<s->toDebugString()<<" "<<t);
+	ASATOM_INCREF(a);
+	replacelocalresult(context,context->exec_pos->local3.pos,a);
+	++(context->exec_pos);
 }
-void ABCVm::abc_ifne_constant_local(call_context* context)
+void ABCVm::abc_pushScope_constant(call_context* context)
 {
-	bool cond=!asAtomHandler::isEqual(*context->exec_pos->arg1_constant,context->worker,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2));
-	LOG_CALL("ifNE_cl (" << ((cond)?"taken)":"not taken)"));
-	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
-	else
-		++(context->exec_pos);
+	//pushscope
+	asAtom* t = context->exec_pos->arg1_constant;
+	LOG_CALL( "pushScope_c " << asAtomHandler::toDebugString(*t) );
+	assert_and_throw(context->curr_scope_stack < context->mi->body->max_scope_depth);
+	if (asAtomHandler::isObject(*t))
+	{
+		asAtomHandler::getObjectNoCheck(*t)->incRef();
+		asAtomHandler::getObjectNoCheck(*t)->addStoredMember();
+	}
+	context->scope_stack[context->curr_scope_stack] = *t;
+	context->scope_stack_dynamic[context->curr_scope_stack] = false;
+	context->curr_scope_stack++;
+	++(context->exec_pos);
 }
-void ABCVm::abc_ifne_local_local(call_context* context)
+void ABCVm::abc_pushScope_local(call_context* context)
 {
-	bool cond=!asAtomHandler::isEqual(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1),context->worker,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2));
-	LOG_CALL("ifNE_ll (" << ((cond)?"taken)":"not taken)"));
-	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
-	else
-		++(context->exec_pos);
+	//pushscope
+	asAtom* t = &CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1);
+	LOG_CALL( "pushScope_l " << asAtomHandler::toDebugString(*t) );
+	assert_and_throw(context->curr_scope_stack < context->mi->body->max_scope_depth);
+	if (asAtomHandler::isObject(*t))
+	{
+		asAtomHandler::getObjectNoCheck(*t)->incRef();
+		asAtomHandler::getObjectNoCheck(*t)->addStoredMember();
+	}
+	context->scope_stack[context->curr_scope_stack] = *t;
+	context->scope_stack_dynamic[context->curr_scope_stack] = false;
+	context->curr_scope_stack++;
+	++(context->exec_pos);
 }
-
-void ABCVm::abc_iflt_constant_constant(call_context* context)
+void ABCVm::abc_li8_constant(call_context* context)
 {
-	bool cond=asAtomHandler::isLess(*context->exec_pos->arg1_constant,context->worker,*context->exec_pos->arg2_constant) == TTRUE;
-	LOG_CALL("ifLT_cc (" << ((cond)?"taken)":"not taken)"));
-	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
-	else
-		++(context->exec_pos);
+	preloadedcodedata* instrptr = context->exec_pos;
+	LOG_CALL( "li8_c");
+	asAtom ret=asAtomHandler::invalidAtom;
+	ApplicationDomain::loadIntN<uint8_t>(context->mi->context->root->applicationDomain.getPtr(),ret,*instrptr->arg1_constant);
+	RUNTIME_STACK_PUSH(context,ret);
+	++(context->exec_pos);
 }
-void ABCVm::abc_iflt_local_constant(call_context* context)
+void ABCVm::abc_li8_local(call_context* context)
 {
-	bool cond=asAtomHandler::isLess(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1),context->worker,*context->exec_pos->arg2_constant) == TTRUE;
-	LOG_CALL("ifLT_lc (" << ((cond)?"taken)":"not taken)"));
-	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
-	else
-		++(context->exec_pos);
+	preloadedcodedata* instrptr = context->exec_pos;
+	LOG_CALL( "li8_l");
+	asAtom ret=asAtomHandler::invalidAtom;
+	ApplicationDomain::loadIntN<uint8_t>(context->mi->context->root->applicationDomain.getPtr(),ret,CONTEXT_GETLOCAL(context,instrptr->local_pos1));
+	RUNTIME_STACK_PUSH(context,ret);
+	++(context->exec_pos);
 }
-void ABCVm::abc_iflt_constant_local(call_context* context)
+void ABCVm::abc_li8_constant_localresult(call_context* context)
 {
-	bool cond=asAtomHandler::isLess(*context->exec_pos->arg1_constant,context->worker,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2)) == TTRUE;
-	LOG_CALL("ifLT_cl (" << ((cond)?"taken)":"not taken)"));
-	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
-	else
-		++(context->exec_pos);
+	preloadedcodedata* instrptr = context->exec_pos;
+	LOG_CALL( "li8_cl");
+	asAtom ret=asAtomHandler::invalidAtom;
+	ApplicationDomain::loadIntN<uint8_t>(context->mi->context->root->applicationDomain.getPtr(),ret,*instrptr->arg1_constant);
+	replacelocalresult(context,instrptr->local3.pos,ret);
+	++(context->exec_pos);
 }
-void ABCVm::abc_iflt_local_local(call_context* context)
-{
-	bool cond=asAtomHandler::isLess(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1),context->worker,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2)) == TTRUE;
-	LOG_CALL("ifLT_ll (" << ((cond)?"taken)":"not taken)"));
-	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
-	else
-		++(context->exec_pos);
-}
-void ABCVm::abc_ifle_constant_constant(call_context* context)
-{
-	bool cond=asAtomHandler::isLess(*context->exec_pos->arg2_constant,context->worker,*context->exec_pos->arg1_constant) == TFALSE;
-	LOG_CALL("ifLE_cc (" << ((cond)?"taken)":"not taken)"));
-	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
-	else
-		++(context->exec_pos);
-}
-void ABCVm::abc_ifle_local_constant(call_context* context)
-{
-	bool cond=asAtomHandler::isLess(*context->exec_pos->arg2_constant,context->worker,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1)) == TFALSE;
-	LOG_CALL("ifLE_lc (" << ((cond)?"taken)":"not taken)"));
-	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
-	else
-		++(context->exec_pos);
-}
-void ABCVm::abc_ifle_constant_local(call_context* context)
-{
-	bool cond=asAtomHandler::isLess(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2),context->worker,*context->exec_pos->arg1_constant) == TFALSE;
-	LOG_CALL("ifLE_cl (" << ((cond)?"taken)":"not taken)"));
-	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
-	else
-		++(context->exec_pos);
-}
-void ABCVm::abc_ifle_local_local(call_context* context)
-{
-	bool cond=asAtomHandler::isLess(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2),context->worker,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1)) == TFALSE;
-	LOG_CALL("ifLE_ll (" << ((cond)?"taken)":"not taken)"));
-	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
-	else
-		++(context->exec_pos);
-}
-void ABCVm::abc_ifgt_constant_constant(call_context* context)
-{
-	bool cond=asAtomHandler::isLess(*context->exec_pos->arg2_constant,context->worker,*context->exec_pos->arg1_constant) == TTRUE;
-	LOG_CALL("ifGT_cc (" << ((cond)?"taken)":"not taken)"));
-	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
-	else
-		++(context->exec_pos);
-}
-void ABCVm::abc_ifgt_local_constant(call_context* context)
-{
-	bool cond=asAtomHandler::isLess(*context->exec_pos->arg2_constant,context->worker,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1)) == TTRUE;
-	LOG_CALL("ifGT_lc (" << ((cond)?"taken)":"not taken)"));
-	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
-	else
-		++(context->exec_pos);
-}
-void ABCVm::abc_ifgt_constant_local(call_context* context)
-{
-	bool cond=asAtomHandler::isLess(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2),context->worker,*context->exec_pos->arg1_constant) == TTRUE;
-	LOG_CALL("ifGT_cl (" << ((cond)?"taken)":"not taken)"));
-	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
-	else
-		++(context->exec_pos);
-}
-void ABCVm::abc_ifgt_local_local(call_context* context)
-{
-	bool cond=asAtomHandler::isLess(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2),context->worker,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1)) == TTRUE;
-	LOG_CALL("ifGT_ll (" << ((cond)?"taken)":"not taken)"));
-	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
-	else
-		++(context->exec_pos);
-}
-void ABCVm::abc_ifge_constant_constant(call_context* context)
-{
-	bool cond=asAtomHandler::isLess(*context->exec_pos->arg1_constant,context->worker,*context->exec_pos->arg2_constant) == TFALSE;
-	LOG_CALL("ifGE_cc (" << ((cond)?"taken)":"not taken)"));
-	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
-	else
-		++(context->exec_pos);
-}
-void ABCVm::abc_ifge_local_constant(call_context* context)
-{
-	bool cond=asAtomHandler::isLess(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1),context->worker,*context->exec_pos->arg2_constant) == TFALSE;
-	LOG_CALL("ifGE_lc (" << ((cond)?"taken)":"not taken)"));
-	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
-	else
-		++(context->exec_pos);
-}
-void ABCVm::abc_ifge_constant_local(call_context* context)
-{
-	bool cond=asAtomHandler::isLess(*context->exec_pos->arg1_constant,context->worker,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2)) == TFALSE;
-	LOG_CALL("ifGE_cl (" << ((cond)?"taken)":"not taken)"));
-	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
-	else
-		++(context->exec_pos);
-}
-void ABCVm::abc_ifge_local_local(call_context* context)
-{
-	bool cond=asAtomHandler::isLess(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1),context->worker,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2)) == TFALSE;
-	LOG_CALL("ifGE_ll (" << ((cond)?"taken)":"not taken)"));
-	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
-	else
-		++(context->exec_pos);
-}
-void ABCVm::abc_ifstricteq_constant_constant(call_context* context)
-{
-	bool cond=asAtomHandler::isEqualStrict(*context->exec_pos->arg1_constant,context->worker,*context->exec_pos->arg2_constant);
-	LOG_CALL("ifstricteq_cc (" << ((cond)?"taken)":"not taken)"));
-	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
-	else
-		++(context->exec_pos);
-}
-void ABCVm::abc_ifstricteq_local_constant(call_context* context)
-{
-	bool cond=asAtomHandler::isEqualStrict(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1),context->worker,*context->exec_pos->arg2_constant);
-	LOG_CALL("ifstricteq_lc (" << ((cond)?"taken)":"not taken)"));
-	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
-	else
-		++(context->exec_pos);
-}
-void ABCVm::abc_ifstricteq_constant_local(call_context* context)
-{
-	bool cond=asAtomHandler::isEqualStrict(*context->exec_pos->arg1_constant,context->worker,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2));
-	LOG_CALL("ifstricteq_cl (" << ((cond)?"taken)":"not taken)"));
-	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
-	else
-		++(context->exec_pos);
-}
-void ABCVm::abc_ifstricteq_local_local(call_context* context)
-{
-	LOG_CALL("ifstricteq_ll (" << asAtomHandler::toDebugString(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1))<<" "<<asAtomHandler::toDebugString(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2)));
-	bool cond=asAtomHandler::isEqualStrict(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1),context->worker,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2));
-	LOG_CALL("ifstricteq_ll (" << ((cond)?"taken)":"not taken)"));
-	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
-	else
-		++(context->exec_pos);
-}
-void ABCVm::abc_ifstrictne_constant_constant(call_context* context)
-{
-	bool cond=!asAtomHandler::isEqualStrict(*context->exec_pos->arg1_constant,context->worker,*context->exec_pos->arg2_constant);
-	LOG_CALL("ifstrictne_cc (" << ((cond)?"taken)":"not taken)"));
-	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
-	else
-		++(context->exec_pos);
-}
-void ABCVm::abc_ifstrictne_local_constant(call_context* context)
-{
-	bool cond=!asAtomHandler::isEqualStrict(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1),context->worker,*context->exec_pos->arg2_constant);
-	LOG_CALL("ifstrictne_lc (" << ((cond)?"taken)":"not taken)"));
-	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
-	else
-		++(context->exec_pos);
-}
-void ABCVm::abc_ifstrictne_constant_local(call_context* context)
-{
-	bool cond=!asAtomHandler::isEqualStrict(*context->exec_pos->arg1_constant,context->worker,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2));
-	LOG_CALL("ifstrictne_cl (" << ((cond)?"taken)":"not taken)"));
-	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
-	else
-		++(context->exec_pos);
-}
-void ABCVm::abc_ifstrictne_local_local(call_context* context)
-{
-	bool cond=!asAtomHandler::isEqualStrict(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1),context->worker,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2));
-	LOG_CALL("ifstrictne_ll (" << ((cond)?"taken)":"not taken)"));
-	if(cond)
-		context->exec_pos += context->exec_pos->arg3_int;
-	else
-		++(context->exec_pos);
-}
-void ABCVm::abc_pushcachedconstant(call_context* context)
-{
-	uint32_t t = context->exec_pos->arg3_uint;
-	assert(t <= (uint32_t)context->mi->context->atomsCachedMaxID);
-	asAtom a = context->mi->context->constantAtoms_cached[t];
-	LOG_CALL("pushcachedconstant "<<t<<" "<<asAtomHandler::toDebugString(a));
-	ASATOM_INCREF(a);
-	RUNTIME_STACK_PUSH(context,a);
-	++(context->exec_pos);
-}
-void ABCVm::abc_pushcachedslot(call_context* context)
-{
-	uint32_t t = context->exec_pos->arg3_uint;
-	assert(t < context->mi->body->localconstantslots.size());
-	asAtom a = *(context->localslots[context->mi->body->getReturnValuePos()+1+context->mi->body->localresultcount+t]);
-	LOG_CALL("pushcachedslot "<<t<<" "<<asAtomHandler::toDebugString(a));
-	ASATOM_INCREF(a);
-	RUNTIME_STACK_PUSH(context,a);
-	++(context->exec_pos);
-}
-void ABCVm::abc_getlexfromslot(call_context* context)
-{
-	uint32_t t = context->exec_pos->arg1_uint;
-	int32_t num = context->exec_pos->arg2_int;
-	asAtom o = num ==-1 ? *context->locals : (context->function->func_scope->scope.rbegin()+num)->object;
-	ASObject* s = asAtomHandler::toObject(o,context->worker);
-	asAtom a = s->getSlot(t);
-	LOG_CALL("getlexfromslot "<<s->toDebugString()<<" "<<t);
-	ASATOM_INCREF(a);
-	RUNTIME_STACK_PUSH(context,a);
-	++(context->exec_pos);
-}
-void ABCVm::abc_getlexfromslot_localresult(call_context* context)
-{
-	uint32_t t = context->exec_pos->arg1_uint;
-	int32_t num = context->exec_pos->arg2_int;
-	asAtom o = num ==-1 ? *context->locals : (context->function->func_scope->scope.rbegin()+num)->object;
-	ASObject* s = asAtomHandler::toObject(o,context->worker);
-	asAtom a = s->getSlot(t);
-	LOG_CALL("getlexfromslot_l "<<s->toDebugString()<<" "<<t);
-	ASATOM_INCREF(a);
-	replacelocalresult(context,context->exec_pos->local3.pos,a);
-	++(context->exec_pos);
-}
-void ABCVm::abc_pushScope_constant(call_context* context)
-{
-	//pushscope
-	asAtom* t = context->exec_pos->arg1_constant;
-	LOG_CALL( "pushScope_c " << asAtomHandler::toDebugString(*t) );
-	assert_and_throw(context->curr_scope_stack < context->mi->body->max_scope_depth);
-	if (asAtomHandler::isObject(*t))
-	{
-		asAtomHandler::getObjectNoCheck(*t)->incRef();
-		asAtomHandler::getObjectNoCheck(*t)->addStoredMember();
-	}
-	context->scope_stack[context->curr_scope_stack] = *t;
-	context->scope_stack_dynamic[context->curr_scope_stack] = false;
-	context->curr_scope_stack++;
-	++(context->exec_pos);
-}
-void ABCVm::abc_pushScope_local(call_context* context)
-{
-	//pushscope
-	asAtom* t = &CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1);
-	LOG_CALL( "pushScope_l " << asAtomHandler::toDebugString(*t) );
-	assert_and_throw(context->curr_scope_stack < context->mi->body->max_scope_depth);
-	if (asAtomHandler::isObject(*t))
-	{
-		asAtomHandler::getObjectNoCheck(*t)->incRef();
-		asAtomHandler::getObjectNoCheck(*t)->addStoredMember();
-	}
-	context->scope_stack[context->curr_scope_stack] = *t;
-	context->scope_stack_dynamic[context->curr_scope_stack] = false;
-	context->curr_scope_stack++;
-	++(context->exec_pos);
-}
-void ABCVm::abc_li8_constant(call_context* context)
-{
-	preloadedcodedata* instrptr = context->exec_pos;
-	LOG_CALL( "li8_c");
-	asAtom ret=asAtomHandler::invalidAtom;
-	ApplicationDomain::loadIntN<uint8_t>(context->mi->context->root->applicationDomain.getPtr(),ret,*instrptr->arg1_constant);
-	RUNTIME_STACK_PUSH(context,ret);
-	++(context->exec_pos);
-}
-void ABCVm::abc_li8_local(call_context* context)
-{
-	preloadedcodedata* instrptr = context->exec_pos;
-	LOG_CALL( "li8_l");
-	asAtom ret=asAtomHandler::invalidAtom;
-	ApplicationDomain::loadIntN<uint8_t>(context->mi->context->root->applicationDomain.getPtr(),ret,CONTEXT_GETLOCAL(context,instrptr->local_pos1));
-	RUNTIME_STACK_PUSH(context,ret);
-	++(context->exec_pos);
-}
-void ABCVm::abc_li8_constant_localresult(call_context* context)
-{
-	preloadedcodedata* instrptr = context->exec_pos;
-	LOG_CALL( "li8_cl");
-	asAtom ret=asAtomHandler::invalidAtom;
-	ApplicationDomain::loadIntN<uint8_t>(context->mi->context->root->applicationDomain.getPtr(),ret,*instrptr->arg1_constant);
-	replacelocalresult(context,instrptr->local3.pos,ret);
-	++(context->exec_pos);
-}
-void ABCVm::abc_li8_local_localresult(call_context* context)
+void ABCVm::abc_li8_local_localresult(call_context* context)
 {
 	preloadedcodedata* instrptr = context->exec_pos;
 	LOG_CALL( "li8_ll");
@@ -2158,12 +1866,17 @@ void ABCVm::abc_setPropertyStaticName(call_context* context)
 	ASObject* o = asAtomHandler::toObject(*obj,context->worker);
 	bool alreadyset=false;
 	multiname* simplesettername = nullptr;
-	if (context->exec_pos->local3.pos == 0x68)//initproperty
-		simplesettername =o->setVariableByMultiname(*name,*value,ASObject::CONST_ALLOWED,&alreadyset,context->worker);
-	else//Do not allow to set contant traits
-		simplesettername =o->setVariableByMultiname(*name,*value,ASObject::CONST_NOT_ALLOWED,&alreadyset,context->worker);
-	if (simplesettername)
-		context->exec_pos->cachedmultiname2 = simplesettername;
+	if (!setPropertyCached(context,context->exec_pos->cacheindex,o,*value,&alreadyset))
+	{
+		if (context->exec_pos->local3.pos == 0x68)//initproperty
+			simplesettername =o->setVariableByMultiname(*name,*value,ASObject::CONST_ALLOWED,&alreadyset,context->worker);
+		else//Do not allow to set contant traits
+			simplesettername =o->setVariableByMultiname(*name,*value,ASObject::CONST_NOT_ALLOWED,&alreadyset,context->worker);
+		if (simplesettername)
+			context->exec_pos->cachedmultiname2 = simplesettername;
+		if (!context->exceptionthrown)
+			addPropertyCacheEntry(context,context->exec_pos->cacheindex,o,name,true);
+	}
 	if (alreadyset || context->exceptionthrown)
 		ASATOM_DECREF_POINTER(value);
 	ASATOM_DECREF_POINTER(obj);
@@ -2194,12 +1907,17 @@ void ABCVm::abc_setPropertyStaticName_constant_constant(call_context* context)
 
 	ASObject* o = asAtomHandler::toObject(*obj,context->worker);
 	multiname* simplesettername = nullptr;
-	if (context->exec_pos->local3.pos == 0x68)//initproperty
-		simplesettername =o->setVariableByMultiname(*name,*value,ASObject::CONST_ALLOWED,nullptr,context->worker);
-	else//Do not allow to set contant traits
-		simplesettername =o->setVariableByMultiname(*name,*value,ASObject::CONST_NOT_ALLOWED,nullptr,context->worker);
-	if (simplesettername)
-		context->exec_pos->cachedmultiname2 = simplesettername;
+	if (!setPropertyCached(context,context->exec_pos->cacheindex,o,*value,nullptr))
+	{
+		if (context->exec_pos->local3.pos == 0x68)//initproperty
+			simplesettername =o->setVariableByMultiname(*name,*value,ASObject::CONST_ALLOWED,nullptr,context->worker);
+		else//Do not allow to set contant traits
+			simplesettername =o->setVariableByMultiname(*name,*value,ASObject::CONST_NOT_ALLOWED,nullptr,context->worker);
+		if (simplesettername)
+			context->exec_pos->cachedmultiname2 = simplesettername;
+		if (!context->exceptionthrown)
+			addPropertyCacheEntry(context,context->exec_pos->cacheindex,o,name,true);
+	}
 	++(context->exec_pos);
 }
 void ABCVm::abc_setPropertyStaticName_local_constant(call_context* context)
@@ -2227,12 +1945,17 @@ void ABCVm::abc_setPropertyStaticName_local_constant(call_context* context)
 	ASObject* o = asAtomHandler::toObject(*obj,context->worker);
 	o->incRef(); // this is neccessary for reference counting in case of exception thrown in setVariableByMultiname
 	multiname* simplesettername = nullptr;
-	if (context->exec_pos->local3.pos == 0x68)//initproperty
-		simplesettername =o->setVariableByMultiname(*name,*value,ASObject::CONST_ALLOWED,nullptr,context->worker);
-	else//Do not allow to set contant traits
-		simplesettername =o->setVariableByMultiname(*name,*value,ASObject::CONST_NOT_ALLOWED,nullptr,context->worker);
-	if (simplesettername)
-		context->exec_pos->cachedmultiname2 = simplesettername;
+	if (!setPropertyCached(context,context->exec_pos->cacheindex,o,*value,nullptr))
+	{
+		if (context->exec_pos->local3.pos == 0x68)//initproperty
+			simplesettername =o->setVariableByMultiname(*name,*value,ASObject::CONST_ALLOWED,nullptr,context->worker);
+		else//Do not allow to set contant traits
+			simplesettername =o->setVariableByMultiname(*name,*value,ASObject::CONST_NOT_ALLOWED,nullptr,context->worker);
+		if (simplesettername)
+			context->exec_pos->cachedmultiname2 = simplesettername;
+		if (!context->exceptionthrown)
+			addPropertyCacheEntry(context,context->exec_pos->cacheindex,o,name,true);
+	}
 	o->decRef(); // this is neccessary for reference counting in case of exception thrown in setVariableByMultiname
 	++(context->exec_pos);
 }
@@ -2262,12 +1985,17 @@ void ABCVm::abc_setPropertyStaticName_constant_local(call_context* context)
 	ASATOM_INCREF_POINTER(value);
 	bool alreadyset=false;
 	multiname* simplesettername = nullptr;
-	if (context->exec_pos->local3.pos == 0x68)//initproperty
-		simplesettername =o->setVariableByMultiname(*name,*value,ASObject::CONST_ALLOWED,&alreadyset,context->worker);
-	else//Do not allow to set contant traits
-		simplesettername =o->setVariableByMultiname(*name,*value,ASObject::CONST_NOT_ALLOWED,&alreadyset,context->worker);
-	if (simplesettername)
-		context->exec_pos->cachedmultiname2 = simplesettername;
+	if (!setPropertyCached(context,context->exec_pos->cacheindex,o,*value,&alreadyset))
+	{
+		if (context->exec_pos->local3.pos == 0x68)//initproperty
+			simplesettername =o->setVariableByMultiname(*name,*value,ASObject::CONST_ALLOWED,&alreadyset,context->worker);
+		else//Do not allow to set contant traits
+			simplesettername =o->setVariableByMultiname(*name,*value,ASObject::CONST_NOT_ALLOWED,&alreadyset,context->worker);
+		if (simplesettername)
+			context->exec_pos->cachedmultiname2 = simplesettername;
+		if (!context->exceptionthrown)
+			addPropertyCacheEntry(context,context->exec_pos->cacheindex,o,name,true);
+	}
 	if (alreadyset || context->exceptionthrown)
 		ASATOM_DECREF_POINTER(value);
 	++(context->exec_pos);
@@ -2299,12 +2027,17 @@ void ABCVm::abc_setPropertyStaticName_local_local(call_context* context)
 	ASATOM_INCREF_POINTER(value);
 	bool alreadyset=false;
 	multiname* simplesettername = nullptr;
-	if (context->exec_pos->local3.pos == 0x68)//initproperty
-		simplesettername =o->setVariableByMultiname(*name,*value,ASObject::CONST_ALLOWED,&alreadyset,context->worker);
-	else//Do not allow to set contant traits
-		simplesettername =o->setVariableByMultiname(*name,*value,ASObject::CONST_NOT_ALLOWED,&alreadyset,context->worker);
-	if (simplesettername)
-		context->exec_pos->cachedmultiname2 = simplesettername;
+	if (!setPropertyCached(context,context->exec_pos->cacheindex,o,*value,&alreadyset))
+	{
+		if (context->exec_pos->local3.pos == 0x68)//initproperty
+			simplesettername =o->setVariableByMultiname(*name,*value,ASObject::CONST_ALLOWED,&alreadyset,context->worker);
+		else//Do not allow to set contant traits
+			simplesettername =o->setVariableByMultiname(*name,*value,ASObject::CONST_NOT_ALLOWED,&alreadyset,context->worker);
+		if (simplesettername)
+			context->exec_pos->cachedmultiname2 = simplesettername;
+		if (!context->exceptionthrown)
+			addPropertyCacheEntry(context,context->exec_pos->cacheindex,o,name,true);
+	}
 	if (alreadyset || context->exceptionthrown)
 		ASATOM_DECREF_POINTER(value);
 	o->decRef(); // this is neccessary for reference counting in case of exception thrown in setVariableByMultiname
@@ -3269,7 +3002,7 @@ void ABCVm::abc_getPropertyStaticName_constant(call_context* context)
 	ASObject* obj= asAtomHandler::toObject(*instrptr->arg1_constant,context->worker);
 	LOG_CALL( "getProperty_sc " << *name << ' ' << obj->toDebugString() << ' '<<obj->isInitialized());
 	asAtom prop=asAtomHandler::invalidAtom;
-	if(asAtomHandler::isInvalid(prop))
+	if(!getPropertyCached(context,instrptr->cacheindex,obj,prop))
 	{
 		bool isgetter = obj->getVariableByMultiname(prop,*name,GET_VARIABLE_OPTION::DONT_CALL_GETTER,context->worker) & GET_VARIABLE_RESULT::GETVAR_ISGETTER;
 		if (isgetter)
@@ -3288,6 +3021,8 @@ void ABCVm::abc_getPropertyStaticName_constant(call_context* context)
 			}
 			LOG_CALL("End of getter"<< ' ' << f->toDebugString()<<" result:"<<asAtomHandler::toDebugString(prop));
 		}
+		if (asAtomHandler::isValid(prop))
+			addPropertyCacheEntry(context,instrptr->cacheindex,obj,name,false);
 	}
 	if(checkPropertyException(obj,name,prop))
 		return;
@@ -3313,7 +3048,7 @@ void ABCVm::abc_getPropertyStaticName_local(call_context* context)
 	{
 		ASObject* obj= asAtomHandler::toObject(CONTEXT_GETLOCAL(context,instrptr->local_pos1),context->worker);
 		LOG_CALL( "getProperty_sl " << *name << ' ' << obj->toDebugString() << ' '<<obj->isInitialized());
-		if(asAtomHandler::isInvalid(prop))
+		if(!getPropertyCached(context,instrptr->cacheindex,obj,prop))
 		{
 			bool isgetter = obj->getVariableByMultiname(prop,*name,GET_VARIABLE_OPTION::DONT_CALL_GETTER,context->worker) & GET_VARIABLE_RESULT::GETVAR_ISGETTER;
 			if (isgetter)
@@ -3332,6 +3067,8 @@ void ABCVm::abc_getPropertyStaticName_local(call_context* context)
 				}
 				LOG_CALL("End of getter"<< ' ' << f->toDebugString()<<" result:"<<asAtomHandler::toDebugString(prop));
 			}
+			if (asAtomHandler::isValid(prop))
+				addPropertyCacheEntry(context,instrptr->cacheindex,obj,name,false);
 		}
 		if(checkPropertyException(obj,name,prop))
 			return;
@@ -3347,7 +3084,7 @@ void ABCVm::abc_getPropertyStaticName_constant_localresult(call_context* context
 	ASObject* obj= asAtomHandler::toObject(*instrptr->arg1_constant,context->worker,true);
 	LOG_CALL( "getProperty_scl " << *name << ' ' << obj->toDebugString() << ' '<<obj->isInitialized());
 	asAtom prop=asAtomHandler::invalidAtom;
-	if(asAtomHandler::isInvalid(prop))
+	if(!getPropertyCached(context,instrptr->cacheindex,obj,prop))
 	{
 		GET_VARIABLE_RESULT getvarres = obj->getVariableByMultiname(prop,*name,GET_VARIABLE_OPTION::DONT_CALL_GETTER,context->worker);
 		bool isgetter = getvarres & GET_VARIABLE_RESULT::GETVAR_ISGETTER;
@@ -3367,6 +3104,8 @@ void ABCVm::abc_getPropertyStaticName_constant_localresult(call_context* context
 			}
 			LOG_CALL("End of getter"<< ' ' << f->toDebugString()<<" result:"<<asAtomHandler::toDebugString(prop));
 		}
+		if (asAtomHandler::isValid(prop))
+			addPropertyCacheEntry(context,instrptr->cacheindex,obj,name,false);
 	}
 	if(checkPropertyException(obj,name,prop))
 		return;
@@ -3393,39 +3132,7 @@ void ABCVm::abc_getPropertyStaticName_local_localresult(call_context* context)
 	{
 		ASObject* obj= asAtomHandler::toObject(CONTEXT_GETLOCAL(context,instrptr->local_pos1),context->worker);
 		asAtom prop=asAtomHandler::invalidAtom;
-// TODO caching doesn't work until we find a way to detect if obj is a reused object
-// that has been destroyed since the last call
-//		if (((context->exec_pos->data&ABC_OP_NOTCACHEABLE) == 0)
-//				&& ((obj->is<Class_base>() && obj->as<Class_base>()->isSealed) ||
-//					(obj->getClass()
-//					 && (obj->getClass()->isSealed
-//						 || (obj->getClass() == Class<Array>::getRef(obj->getSystemState()).getPtr())))))
-//		{
-//			variable* v = obj->findVariableByMultiname(*name,obj->getClass());
-//			if (v)
-//			{
-//				context->exec_pos->data |= ABC_OP_CACHED;
-//				context->exec_pos->cachedvar2=v;
-//				context->exec_pos->cacheobj1=obj;
-//				if (asAtomHandler::isValid(v->getter))
-//				{
-//					asAtomHandler::set(prop,v->getter);
-//					//Call the getter
-//					LOG_CALL("Calling the getter for " << *name << " on " << obj->toDebugString());
-//					assert(asAtomHandler::isFunction(prop));
-//					IFunction* f = asAtomHandler::as<IFunction>(prop);
-//					ASObject* closure = asAtomHandler::getClosure(prop);
-//					f->callGetter(prop,closure ? closure : obj);
-//					LOG_CALL("End of getter"<< ' ' << f->toDebugString()<<" result:"<<asAtomHandler::toDebugString(prop));
-//				}
-//				else
-//				{
-//					asAtomHandler::set(prop,v->var);
-//					ASATOM_INCREF(prop);
-//				}
-//			}
-//		}
-		if(asAtomHandler::isInvalid(prop))
+		if(!getPropertyCached(context,instrptr->cacheindex,obj,prop))
 		{
 			GET_VARIABLE_RESULT getvarres = obj->getVariableByMultiname(prop,*name,GET_VARIABLE_OPTION::DONT_CALL_GETTER,context->worker);
 			bool isgetter = getvarres & GET_VARIABLE_RESULT::GETVAR_ISGETTER;
@@ -3450,6 +3157,8 @@ void ABCVm::abc_getPropertyStaticName_local_localresult(call_context* context)
 				LOG_CALL("getProperty_sll " << *name << ' ' << obj->toDebugString()<<" "<<instrptr->local3.pos<<" "<<asAtomHandler::toDebugString(prop));
 			}
 
+			if (asAtomHandler::isValid(prop))
+				addPropertyCacheEntry(context,instrptr->cacheindex,obj,name,false);
 		}
 		if(checkPropertyException(obj,name,prop))
 			return;
@@ -3465,7 +3174,7 @@ void ABCVm::abc_getPropertyStaticName_localresult(call_context* context)
 	RUNTIME_STACK_POP_CREATE_ASOBJECT(context,obj);
 	LOG_CALL( "getProperty_slr " << *name << ' ' << obj->toDebugString() << ' '<<obj->isInitialized()<<" "<<instrptr->local3.pos);
 	asAtom prop=asAtomHandler::invalidAtom;
-	if(asAtomHandler::isInvalid(prop))
+	if(!getPropertyCached(context,instrptr->cacheindex,obj,prop))
 	{
 		GET_VARIABLE_RESULT getvarres = obj->getVariableByMultiname(prop,*name,GET_VARIABLE_OPTION::DONT_CALL_GETTER,context->worker);
 		bool isgetter = getvarres & GET_VARIABLE_RESULT::GETVAR_ISGETTER;
@@ -3485,6 +3194,8 @@ void ABCVm::abc_getPropertyStaticName_localresult(call_context* context)
 			}
 			LOG_CALL("End of getter"<< ' ' << f->toDebugString()<<" result:"<<asAtomHandler::toDebugString(prop));
 		}
+		if (asAtomHandler::isValid(prop))
+			addPropertyCacheEntry(context,instrptr->cacheindex,obj,name,false);
 	}
 	if(checkPropertyException(obj,name,prop))
 		return;
@@ -4503,83 +4214,7 @@ void ABCVm::abc_getslot_local_setslotnocoerce(call_context* context)
 	asAtomHandler::getObjectNoCheck(obj)->setSlotNoCoerce(t,res);
 	++(context->exec_pos);
 }
-void ABCVm::abc_setslot_constant_constant(call_context* context)
-{
-	asAtom v1 = *context->exec_pos->arg1_constant;
-	asAtom v2 = *context->exec_pos->arg2_constant;
-	uint32_t t = context->exec_pos->arg3_uint;
-	LOG_CALL("setSlot_cc " << t << " "<< asAtomHandler::toDebugString(v2) << " "<< asAtomHandler::toDebugString(v1));
-	if (asAtomHandler::getObject(v1)->setSlot(context->worker,t,v2))
-		ASATOM_INCREF(v2);
-	++(context->exec_pos);
-}
-void ABCVm::abc_setslot_local_constant(call_context* context)
-{
-	asAtom v1 = CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1);
-	asAtom v2 = *context->exec_pos->arg2_constant;
-	uint32_t t = context->exec_pos->arg3_uint;
-	LOG_CALL("setSlot_lc " << t << " "<< asAtomHandler::toDebugString(v2) << " "<< asAtomHandler::toDebugString(v1));
-	if (asAtomHandler::getObject(v1)->setSlot(context->worker,t,v2))
-		ASATOM_INCREF(v2);
-	++(context->exec_pos);
-}
-void ABCVm::abc_setslot_constant_local(call_context* context)
-{
-	asAtom v1 = *context->exec_pos->arg1_constant;
-	asAtom v2 = CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2);
-	uint32_t t = context->exec_pos->arg3_uint;
-	LOG_CALL("setSlot_cl " << t << " "<< asAtomHandler::toDebugString(v2) << " "<< asAtomHandler::toDebugString(v1));
-	if (asAtomHandler::getObject(v1)->setSlot(context->worker,t,v2))
-		ASATOM_INCREF(v2);
-	++(context->exec_pos);
-}
-void ABCVm::abc_setslot_local_local(call_context* context)
-{
-	asAtom v1 = CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1);
-	asAtom v2 = CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2);
-	uint32_t t = context->exec_pos->arg3_uint;
-	LOG_CALL("setSlot_ll " << t << " "<< asAtomHandler::toDebugString(v2) << " "<< asAtomHandler::toDebugString(v1));
-	if (asAtomHandler::getObject(v1)->setSlot(context->worker,t,v2))
-		ASATOM_INCREF(v2);
-	++(context->exec_pos);
-}
-void ABCVm::abc_setslotNoCoerce_constant_constant(call_context* context)
-{
-	asAtom v1 = *context->exec_pos->arg1_constant;
-	asAtom v2 = *context->exec_pos->arg2_constant;
-	uint32_t t = context->exec_pos->arg3_uint;
-	LOG_CALL("setSlotNoCoerce_cc " << t << " "<< asAtomHandler::toDebugString(v2) << " "<< asAtomHandler::toDebugString(v1));
-	asAtomHandler::getObjectNoCheck(v1)->setSlotNoCoerce(t,v2);
-	++(context->exec_pos);
-}
-void ABCVm::abc_setslotNoCoerce_local_constant(call_context* context)
-{
-	asAtom v1 = CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1);
-	asAtom v2 = *context->exec_pos->arg2_constant;
-	uint32_t t = context->exec_pos->arg3_uint;
-	LOG_CALL("setSlotNoCoerce_lc " << t << " "<< asAtomHandler::toDebugString(v2) << " "<< asAtomHandler::toDebugString(v1));
-	asAtomHandler::getObjectNoCheck(v1)->setSlotNoCoerce(t,v2);
-	++(context->exec_pos);
-}
-void ABCVm::abc_setslotNoCoerce_constant_local(call_context* context)
-{
-	asAtom v1 = *context->exec_pos->arg1_constant;
-	asAtom v2 = CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2);
-	uint32_t t = context->exec_pos->arg3_uint;
-	LOG_CALL("setSlotNoCoerce_cl " << t << " "<< asAtomHandler::toDebugString(v2) << " "<< asAtomHandler::toDebugString(v1));
-	asAtomHandler::getObjectNoCheck(v1)->setSlotNoCoerce(t,v2);
-	++(context->exec_pos);
-}
-void ABCVm::abc_setslotNoCoerce_local_local(call_context* context)
-{
-	asAtom v1 = CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1);
-	asAtom v2 = CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2);
-	uint32_t t = context->exec_pos->arg3_uint;
-	LOG_CALL("setSlotNoCoerce_ll " << t << " "<< asAtomHandler::toDebugString(v2) << " "<< asAtomHandler::toDebugString(v1));
-	asAtomHandler::getObjectNoCheck(v1)->setSlotNoCoerce(t,v2);
-	++(context->exec_pos);
-}
-void ABCVm::abc_convert_i_constant(call_context* context)
+void ABCVm::abc_convert_i_constant(call_context* context)
 {
 	LOG_CALL("convert_i_c");
 	asAtom res = *context->exec_pos->arg1_constant;
@@ -4728,860 +4363,348 @@ void ABCVm::abc_convert_u_local_setslotnocoerce(call_context* context)
 	asAtomHandler::getObjectNoCheck(obj)->setSlotNoCoerce(t,res);
 	++(context->exec_pos);
 }
-void ABCVm::abc_convert_d_constant(call_context* context)
-{
-	LOG_CALL("convert_d_c");
-	asAtom res = *context->exec_pos->arg1_constant;
-	if(!asAtomHandler::isNumeric(res))
-		asAtomHandler::setNumber(res,context->worker,asAtomHandler::toNumber(res));
-	RUNTIME_STACK_PUSH(context,res);
-	++(context->exec_pos);
-}
-void ABCVm::abc_convert_d_local(call_context* context)
-{
-	LOG_CALL("convert_d_l:"<<asAtomHandler::toDebugString(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1)));
-	asAtom res =CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1);
-	if(!asAtomHandler::isNumeric(res))
-		asAtomHandler::setNumber(res,context->worker,asAtomHandler::toNumber(res));
-	else
-		ASATOM_INCREF(res);
-	RUNTIME_STACK_PUSH(context,res);
-	++(context->exec_pos);
-}
-void ABCVm::abc_convert_d_constant_localresult(call_context* context)
-{
-	LOG_CALL("convert_d_cl");
-	asAtom res = *context->exec_pos->arg1_constant;
-	if(!asAtomHandler::isNumeric(res))
-		asAtomHandler::setNumber(res,context->worker,asAtomHandler::toNumber(res));
-	else
-		ASATOM_INCREF(res);
-	replacelocalresult(context,context->exec_pos->local3.pos,res);
-	++(context->exec_pos);
-}
-void ABCVm::abc_convert_d_local_localresult(call_context* context)
-{
-	asAtom res = CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1);
-	LOG_CALL("convert_d_ll "<<asAtomHandler::toDebugString(res)<<" "<<asAtomHandler::getObject(res)<<" "<< context->exec_pos->local_pos1<<" "<<(context->exec_pos->local3.pos));
-	if(!asAtomHandler::isNumeric(res))
-		asAtomHandler::setNumber(res,context->worker,asAtomHandler::toNumber(res));
-	else
-		ASATOM_INCREF(res);
-	replacelocalresult(context,context->exec_pos->local3.pos,res);
-	++(context->exec_pos);
-}
-void ABCVm::abc_convert_d_constant_setslotnocoerce(call_context* context)
-{
-	LOG_CALL("convert_d_cs");
-	asAtom res = *context->exec_pos->arg1_constant;
-	if(!asAtomHandler::isNumeric(res))
-		asAtomHandler::setNumber(res,context->worker,asAtomHandler::toNumber(res));
-	else
-		ASATOM_INCREF(res);
-	asAtom obj = CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos);
-	uint32_t t = context->exec_pos->local3.flags & ~ABC_OP_BITMASK_USED;
-	asAtomHandler::getObjectNoCheck(obj)->setSlotNoCoerce(t,res);
-	++(context->exec_pos);
-}
-void ABCVm::abc_convert_d_local_setslotnocoerce(call_context* context)
-{
-	LOG_CALL("convert_d_ls");
-	asAtom res = CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1);
-	if(!asAtomHandler::isNumeric(res))
-		asAtomHandler::setNumber(res,context->worker,asAtomHandler::toNumber(res));
-	else
-		ASATOM_INCREF(res);
-	asAtom obj = CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos);
-	uint32_t t = context->exec_pos->local3.flags & ~ABC_OP_BITMASK_USED;
-	asAtomHandler::getObjectNoCheck(obj)->setSlotNoCoerce(t,res);
-	++(context->exec_pos);
-}
-void ABCVm::abc_convert_b_constant(call_context* context)
-{
-	LOG_CALL("convert_b_c");
-	asAtom res = *context->exec_pos->arg1_constant;
-	if(!asAtomHandler::isBool(res))
-		asAtomHandler::convert_b(res,false);
-	RUNTIME_STACK_PUSH(context,res);
-	++(context->exec_pos);
-}
-void ABCVm::abc_convert_b_local(call_context* context)
-{
-	LOG_CALL("convert_b_l:"<<asAtomHandler::toDebugString(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1)));
-	asAtom res =CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1);
-	if(!asAtomHandler::isBool(res))
-		asAtomHandler::convert_b(res,false);
-	RUNTIME_STACK_PUSH(context,res);
-	++(context->exec_pos);
-}
-void ABCVm::abc_convert_b_constant_localresult(call_context* context)
-{
-	LOG_CALL("convert_b_cl");
-	asAtom res = *context->exec_pos->arg1_constant;
-	if(!asAtomHandler::isBool(res))
-		asAtomHandler::convert_b(res,false);
-	replacelocalresult(context,context->exec_pos->local3.pos,res);
-	++(context->exec_pos);
-}
-void ABCVm::abc_convert_b_local_localresult(call_context* context)
-{
-	LOG_CALL("convert_b_ll");
-	asAtom res = CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1);
-	if(!asAtomHandler::isBool(res))
-		asAtomHandler::convert_b(res,false);
-	replacelocalresult(context,context->exec_pos->local3.pos,res);
-	++(context->exec_pos);
-}
-void ABCVm::abc_convert_b_constant_setslotnocoerce(call_context* context)
-{
-	LOG_CALL("convert_b_cs");
-	asAtom res = *context->exec_pos->arg1_constant;
-	if(!asAtomHandler::isBool(res))
-		asAtomHandler::convert_b(res,false);
-	asAtom obj = CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos);
-	uint32_t t = context->exec_pos->local3.flags & ~ABC_OP_BITMASK_USED;
-	asAtomHandler::getObjectNoCheck(obj)->setSlotNoCoerce(t,res);
-	++(context->exec_pos);
-}
-void ABCVm::abc_convert_b_local_setslotnocoerce(call_context* context)
-{
-	LOG_CALL("convert_b_ls");
-	asAtom res = CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1);
-	if(!asAtomHandler::isBool(res))
-		asAtomHandler::convert_b(res,false);
-	asAtom obj = CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos);
-	uint32_t t = context->exec_pos->local3.flags & ~ABC_OP_BITMASK_USED;
-	asAtomHandler::getObjectNoCheck(obj)->setSlotNoCoerce(t,res);
-	++(context->exec_pos);
-}
-
-void ABCVm::abc_astypelate_constant_constant(call_context* context)
-{
-	LOG_CALL("astypelate_cc");
-	asAtom ret = asAtomHandler::asTypelate(*context->exec_pos->arg1_constant,*context->exec_pos->arg2_constant,context->worker);
-	ASATOM_INCREF(ret);
-	RUNTIME_STACK_PUSH(context,ret);
-	++(context->exec_pos);
-}
-void ABCVm::abc_astypelate_local_constant(call_context* context)
-{
-	LOG_CALL("astypelate_lc");
-	asAtom ret = asAtomHandler::asTypelate(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1),*context->exec_pos->arg2_constant,context->worker);
-	ASATOM_INCREF(ret);
-	RUNTIME_STACK_PUSH(context,ret);
-	++(context->exec_pos);
-}
-void ABCVm::abc_astypelate_constant_local(call_context* context)
-{
-	LOG_CALL("astypelate_cl");
-	asAtom ret = asAtomHandler::asTypelate(*context->exec_pos->arg1_constant,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2),context->worker);
-	ASATOM_INCREF(ret);
-	RUNTIME_STACK_PUSH(context,ret);
-	++(context->exec_pos);
-}
-void ABCVm::abc_astypelate_local_local(call_context* context)
-{
-	LOG_CALL("astypelate_ll");
-	asAtom ret = asAtomHandler::asTypelate(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1),CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2),context->worker);
-	ASATOM_INCREF(ret);
-	RUNTIME_STACK_PUSH(context,ret);
-	++(context->exec_pos);
-}
-void ABCVm::abc_astypelate_constant_constant_localresult(call_context* context)
-{
-	LOG_CALL("astypelate_ccl");
-	asAtom ret = asAtomHandler::asTypelate(*context->exec_pos->arg1_constant,*context->exec_pos->arg2_constant,context->worker);
-	ASATOM_INCREF(ret);
-	replacelocalresult(context,context->exec_pos->local3.pos,ret);
-	++(context->exec_pos);
-}
-void ABCVm::abc_astypelate_local_constant_localresult(call_context* context)
-{
-	LOG_CALL("astypelate_lcl");
-	asAtom ret = asAtomHandler::asTypelate(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1),*context->exec_pos->arg2_constant,context->worker);
-	ASATOM_INCREF(ret);
-	replacelocalresult(context,context->exec_pos->local3.pos,ret);
-	++(context->exec_pos);
-}
-void ABCVm::abc_astypelate_constant_local_localresult(call_context* context)
-{
-	LOG_CALL("astypelate_cll");
-	asAtom ret = asAtomHandler::asTypelate(*context->exec_pos->arg1_constant,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2),context->worker);
-	ASATOM_INCREF(ret);
-	replacelocalresult(context,context->exec_pos->local3.pos,ret);
-	++(context->exec_pos);
-}
-void ABCVm::abc_astypelate_local_local_localresult(call_context* context)
-{
-	LOG_CALL("astypelate_lll");
-	asAtom ret = asAtomHandler::asTypelate(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1),CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2),context->worker);
-	ASATOM_INCREF(ret);
-	replacelocalresult(context,context->exec_pos->local3.pos,ret);
-	++(context->exec_pos);
-}
-void ABCVm::abc_astypelate_constant_constant_setslotnocoerce(call_context* context)
-{
-	LOG_CALL("astypelate_ccs");
-	asAtom res = asAtomHandler::asTypelate(*context->exec_pos->arg1_constant,*context->exec_pos->arg2_constant,context->worker);
-
-	asAtom obj = CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos);
-	uint32_t t = context->exec_pos->local3.flags & ~ABC_OP_BITMASK_USED;
-	asAtomHandler::getObjectNoCheck(obj)->setSlotNoCoerce(t,res);
-	++(context->exec_pos);
-}
-void ABCVm::abc_astypelate_local_constant_setslotnocoerce(call_context* context)
-{
-	LOG_CALL("astypelate_lcs");
-	asAtom res = asAtomHandler::asTypelate(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1),*context->exec_pos->arg2_constant,context->worker);
-
-	asAtom obj = CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos);
-	uint32_t t = context->exec_pos->local3.flags & ~ABC_OP_BITMASK_USED;
-	asAtomHandler::getObjectNoCheck(obj)->setSlotNoCoerce(t,res);
-	++(context->exec_pos);
-}
-void ABCVm::abc_astypelate_constant_local_setslotnocoerce(call_context* context)
-{
-	LOG_CALL("astypelate_cls");
-	asAtom res = asAtomHandler::asTypelate(*context->exec_pos->arg1_constant,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2),context->worker);
-
-	asAtom obj = CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos);
-	uint32_t t = context->exec_pos->local3.flags & ~ABC_OP_BITMASK_USED;
-	asAtomHandler::getObjectNoCheck(obj)->setSlotNoCoerce(t,res);
-	++(context->exec_pos);
-}
-void ABCVm::abc_astypelate_local_local_setslotnocoerce(call_context* context)
-{
-	LOG_CALL("astypelate_lls");
-	asAtom res = asAtomHandler::asTypelate(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1),CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2),context->worker);
-
-	asAtom obj = CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos);
-	uint32_t t = context->exec_pos->local3.flags & ~ABC_OP_BITMASK_USED;
-	asAtomHandler::getObjectNoCheck(obj)->setSlotNoCoerce(t,res);
-	++(context->exec_pos);
-}
-
-void ABCVm::abc_increment_local(call_context* context)
-{
-	asAtom res = CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1);
-	LOG_CALL("increment_l "<<context->exec_pos->local_pos1<<" "<<asAtomHandler::toDebugString(res));
-	if (!asAtomHandler::increment(res,context->worker,false))
-		ASATOM_INCREF(res);
-	RUNTIME_STACK_PUSH(context,res);
-	++(context->exec_pos);
-}
-void ABCVm::abc_increment_local_localresult(call_context* context)
-{
-	LOG_CALL("increment_ll "<<context->exec_pos->local_pos1<<" "<<context->exec_pos->local3.pos<<" "<<asAtomHandler::toDebugString(CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos))<<" "<<asAtomHandler::toDebugString(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1)));
-	asAtom res = CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1);
-	if (context->exec_pos->local_pos1 != context->exec_pos->local3.pos)
-	{
-		ASATOM_DECREF(CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos));
-		if (asAtomHandler::isNumber(res))
-			asAtomHandler::setNumber(CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos),context->worker,asAtomHandler::getObjectNoCheck(res)->toNumber());
-		else
-			asAtomHandler::set(CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos),res);
-	}
-	else
-		asAtomHandler::set(CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos),res);
-	asAtomHandler::increment(CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos),context->worker,context->exec_pos->local3.pos == context->exec_pos->local_pos1);
-	++(context->exec_pos);
-}
-void ABCVm::abc_decrement_local(call_context* context)
-{
-	asAtom res = CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1);
-	LOG_CALL("decrement_l "<<context->exec_pos->local_pos1<<" "<<asAtomHandler::toDebugString(res));
-	if (!asAtomHandler::decrement(res,context->worker,false))
-		ASATOM_INCREF(res);
-	RUNTIME_STACK_PUSH(context,res);
-	++(context->exec_pos);
-}
-void ABCVm::abc_decrement_local_localresult(call_context* context)
-{
-	LOG_CALL("decrement_ll "<<context->exec_pos->local_pos1<<" "<<context->exec_pos->local3.pos<<" "<<asAtomHandler::toDebugString(CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos)));
-	asAtom res = CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1);
-	if (context->exec_pos->local_pos1 != context->exec_pos->local3.pos)
-	{
-		ASATOM_DECREF(CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos));
-		if (asAtomHandler::isNumber(res))
-			asAtomHandler::setNumber(CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos),context->worker,asAtomHandler::getObjectNoCheck(res)->toNumber());
-		else
-			asAtomHandler::set(CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos),res);
-	}
-	else
-		asAtomHandler::set(CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos),res);
-	asAtomHandler::decrement(CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos),context->worker,context->exec_pos->local3.pos == context->exec_pos->local_pos1);
-	++(context->exec_pos);
-}
-void ABCVm::abc_typeof_constant(call_context* context)
-{
-	LOG_CALL("typeof_c");
-	asAtom res = asAtomHandler::typeOf(*context->exec_pos->arg1_constant);
-	RUNTIME_STACK_PUSH(context,res);
-	++(context->exec_pos);
-}
-void ABCVm::abc_typeof_local(call_context* context)
-{
-	LOG_CALL("typeof_l "<<asAtomHandler::toDebugString(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1)));
-	asAtom res = asAtomHandler::typeOf(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1));
-	RUNTIME_STACK_PUSH(context,res);
-	++(context->exec_pos);
-}
-void ABCVm::abc_typeof_constant_localresult(call_context* context)
-{
-	LOG_CALL("typeof_cl");
-	asAtom res = asAtomHandler::typeOf(*context->exec_pos->arg1_constant);
-	replacelocalresult(context,context->exec_pos->local3.pos,res);
-	++(context->exec_pos);
-}
-void ABCVm::abc_typeof_local_localresult(call_context* context)
-{
-	LOG_CALL("typeof_ll");
-	asAtom res = asAtomHandler::typeOf(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1));
-	replacelocalresult(context,context->exec_pos->local3.pos,res);
-	++(context->exec_pos);
-}void ABCVm::abc_not_constant(call_context* context)
-{
-	LOG_CALL("not_c");
-	asAtom res = asAtomHandler::fromBool(!asAtomHandler::Boolean_concrete(*context->exec_pos->arg1_constant));
-	RUNTIME_STACK_PUSH(context,res);
-	++(context->exec_pos);
-}
-void ABCVm::abc_not_local(call_context* context)
-{
-	LOG_CALL("not_l "<<asAtomHandler::toDebugString(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1)));
-	asAtom res = asAtomHandler::fromBool(!asAtomHandler::Boolean_concrete(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1)));
-	RUNTIME_STACK_PUSH(context,res);
-	++(context->exec_pos);
-}
-void ABCVm::abc_not_constant_localresult(call_context* context)
-{
-	LOG_CALL("not_cl");
-	bool res = !asAtomHandler::Boolean_concrete(*context->exec_pos->arg1_constant);
-	ASATOM_DECREF(CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos));
-	asAtomHandler::setBool(CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos),res);
-	++(context->exec_pos);
-}
-void ABCVm::abc_not_local_localresult(call_context* context)
-{
-	LOG_CALL("not_ll");
-	bool res = !asAtomHandler::Boolean_concrete(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1));
-	ASATOM_DECREF(CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos));
-	asAtomHandler::setBool(CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos),res);
-	++(context->exec_pos);
-}
-void ABCVm::abc_add_constant_constant(call_context* context)
-{
-	LOG_CALL("add_cc");
-	asAtom res = *context->exec_pos->arg1_constant;
-	asAtomHandler::add(res,*context->exec_pos->arg2_constant,context->worker,context->exec_pos->local3.flags & ABC_OP_FORCEINT);
-	RUNTIME_STACK_PUSH(context,res);
-	++(context->exec_pos);
-}
-void ABCVm::abc_add_local_constant(call_context* context)
-{
-	LOG_CALL("add_lc");
-	asAtom res = CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1);
-	ASObject* o = asAtomHandler::getObject(res);
-	if (o)
-		o->incRef(); // ensure old value is not replaced
-	if (asAtomHandler::add(res,*context->exec_pos->arg2_constant,context->worker,context->exec_pos->local3.flags & ABC_OP_FORCEINT))
-	{
-		if (o)
-			o->decRef();
-	}
-	RUNTIME_STACK_PUSH(context,res);
-	++(context->exec_pos);
-}
-void ABCVm::abc_add_constant_local(call_context* context)
-{
-	LOG_CALL("add_cl");
-	asAtom res = *context->exec_pos->arg1_constant;
-	asAtomHandler::add(res,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2),context->worker,context->exec_pos->local3.flags & ABC_OP_FORCEINT);
-	RUNTIME_STACK_PUSH(context,res);
-	++(context->exec_pos);
-}
-void ABCVm::abc_add_local_local(call_context* context)
-{
-	LOG_CALL("add_ll");
-	asAtom res = CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1);
-	ASObject* o = asAtomHandler::getObject(res);
-	if (o)
-		o->incRef(); // ensure old value is not replaced
-	if (asAtomHandler::add(res,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2),context->worker,context->exec_pos->local3.flags & ABC_OP_FORCEINT))
-	{
-		if (o)
-			o->decRef();
-	}
-	RUNTIME_STACK_PUSH(context,res);
-	++(context->exec_pos);
-}
-void ABCVm::abc_add_constant_constant_localresult(call_context* context)
-{
-	LOG_CALL("add_ccl");
-	asAtomHandler::addreplace(CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos),context->worker,*context->exec_pos->arg1_constant,*context->exec_pos->arg2_constant,context->exec_pos->local3.flags & ABC_OP_FORCEINT);
-	++(context->exec_pos);
-}
-void ABCVm::abc_add_local_constant_localresult(call_context* context)
-{
-	LOG_CALL("add_lcl");
-	asAtomHandler::addreplace(CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos),context->worker,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1),*context->exec_pos->arg2_constant,context->exec_pos->local3.flags & ABC_OP_FORCEINT);
-	++(context->exec_pos);
-}
-void ABCVm::abc_add_constant_local_localresult(call_context* context)
-{
-	LOG_CALL("add_cll");
-	asAtomHandler::addreplace(CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos),context->worker,*context->exec_pos->arg1_constant,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2),context->exec_pos->local3.flags & ABC_OP_FORCEINT);
-	++(context->exec_pos);
-}
-void ABCVm::abc_add_local_local_localresult(call_context* context)
-{
-	LOG_CALL("add_lll");
-	asAtomHandler::addreplace(CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos),context->worker,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1),CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2),context->exec_pos->local3.flags & ABC_OP_FORCEINT);
-	++(context->exec_pos);
-}
-void ABCVm::abc_add_constant_constant_setslotnocoerce(call_context* context)
-{
-	LOG_CALL("add_ccs");
-	asAtom res = asAtomHandler::invalidAtom;
-	asAtomHandler::addreplace(res,context->worker,*context->exec_pos->arg1_constant,*context->exec_pos->arg2_constant,context->exec_pos->local3.flags & ABC_OP_FORCEINT);
-
-	asAtom obj = CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos);
-	uint32_t t = context->exec_pos->local3.flags & ~ABC_OP_BITMASK_USED;
-	asAtomHandler::getObjectNoCheck(obj)->setSlotNoCoerce(t,res);
-	++(context->exec_pos);
-}
-void ABCVm::abc_add_local_constant_setslotnocoerce(call_context* context)
-{
-	LOG_CALL("add_lcs");
-	asAtom res = asAtomHandler::invalidAtom;
-	asAtomHandler::addreplace(res,context->worker,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1),*context->exec_pos->arg2_constant,context->exec_pos->local3.flags & ABC_OP_FORCEINT);
-
-	asAtom obj = CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos);
-	uint32_t t = context->exec_pos->local3.flags & ~ABC_OP_BITMASK_USED;
-	asAtomHandler::getObjectNoCheck(obj)->setSlotNoCoerce(t,res);
-	++(context->exec_pos);
-}
-void ABCVm::abc_add_constant_local_setslotnocoerce(call_context* context)
-{
-	LOG_CALL("add_cls");
-	asAtom res = asAtomHandler::invalidAtom;
-	asAtomHandler::addreplace(res,context->worker,*context->exec_pos->arg1_constant,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2),context->exec_pos->local3.flags & ABC_OP_FORCEINT);
-	
-	asAtom obj = CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos);
-	uint32_t t = context->exec_pos->local3.flags & ~ABC_OP_BITMASK_USED;
-	asAtomHandler::getObjectNoCheck(obj)->setSlotNoCoerce(t,res);
-	++(context->exec_pos);
-}
-void ABCVm::abc_add_local_local_setslotnocoerce(call_context* context)
-{
-	LOG_CALL("add_lls");
-	asAtom res = asAtomHandler::invalidAtom;
-	asAtomHandler::addreplace(res,context->worker,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1),CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2),context->exec_pos->local3.flags & ABC_OP_FORCEINT);
-
-	asAtom obj = CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos);
-	uint32_t t = context->exec_pos->local3.flags & ~ABC_OP_BITMASK_USED;
-	asAtomHandler::getObjectNoCheck(obj)->setSlotNoCoerce(t,res);
-	++(context->exec_pos);
-}
-void ABCVm::abc_subtract_constant_constant(call_context* context)
-{
-	LOG_CALL("subtract_cc");
-	asAtom res = *context->exec_pos->arg1_constant;
-	asAtomHandler::subtract(res,context->worker,*context->exec_pos->arg2_constant,context->exec_pos->local3.flags & ABC_OP_FORCEINT);
-	RUNTIME_STACK_PUSH(context,res);
-	++(context->exec_pos);
-}
-void ABCVm::abc_subtract_local_constant(call_context* context)
-{
-	LOG_CALL("subtract_lc");
-	asAtom res = CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1);
-	asAtomHandler::subtract(res,context->worker,*context->exec_pos->arg2_constant,context->exec_pos->local3.flags & ABC_OP_FORCEINT);
-
-	RUNTIME_STACK_PUSH(context,res);
-	++(context->exec_pos);
-}
-void ABCVm::abc_subtract_constant_local(call_context* context)
-{
-	LOG_CALL("subtract_cl");
-	asAtom res = *context->exec_pos->arg1_constant;
-	asAtomHandler::subtract(res,context->worker,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2),context->exec_pos->local3.flags & ABC_OP_FORCEINT);
-	RUNTIME_STACK_PUSH(context,res);
-	++(context->exec_pos);
-}
-void ABCVm::abc_subtract_local_local(call_context* context)
-{
-	LOG_CALL("subtract_ll");
-	asAtom res = CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1);
-	asAtomHandler::subtract(res,context->worker,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2),context->exec_pos->local3.flags & ABC_OP_FORCEINT);
-	RUNTIME_STACK_PUSH(context,res);
-	++(context->exec_pos);
-}
-void ABCVm::abc_subtract_constant_constant_localresult(call_context* context)
-{
-	LOG_CALL("subtract_ccl");
-	asAtomHandler::subtractreplace(CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos),context->worker,*context->exec_pos->arg1_constant,*context->exec_pos->arg2_constant,context->exec_pos->local3.flags & ABC_OP_FORCEINT);
-	++(context->exec_pos);
-}
-void ABCVm::abc_subtract_local_constant_localresult(call_context* context)
-{
-	LOG_CALL("subtract_lcl");
-	asAtomHandler::subtractreplace(CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos),context->worker,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1),*context->exec_pos->arg2_constant,context->exec_pos->local3.flags & ABC_OP_FORCEINT);
-	++(context->exec_pos);
-}
-void ABCVm::abc_subtract_constant_local_localresult(call_context* context)
-{
-	LOG_CALL("subtract_cll");
-	asAtomHandler::subtractreplace(CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos),context->worker,*context->exec_pos->arg1_constant,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2),context->exec_pos->local3.flags & ABC_OP_FORCEINT);
-	++(context->exec_pos);
-}
-void ABCVm::abc_subtract_local_local_localresult(call_context* context)
-{
-	LOG_CALL("subtract_lll");
-	asAtomHandler::subtractreplace(CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos),context->worker,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1),CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2),context->exec_pos->local3.flags & ABC_OP_FORCEINT);
-	++(context->exec_pos);
-}
-void ABCVm::abc_subtract_constant_constant_setslotnocoerce(call_context* context)
-{
-	LOG_CALL("subtract_ccs");
-	asAtom res = asAtomHandler::invalidAtom;
-	asAtomHandler::subtractreplace(res,context->worker,*context->exec_pos->arg1_constant,*context->exec_pos->arg2_constant,context->exec_pos->local3.flags & ABC_OP_FORCEINT);
-
-	asAtom obj = CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos);
-	uint32_t t = context->exec_pos->local3.flags & ~ABC_OP_BITMASK_USED;
-	asAtomHandler::getObjectNoCheck(obj)->setSlotNoCoerce(t,res);
-	++(context->exec_pos);
-}
-void ABCVm::abc_subtract_local_constant_setslotnocoerce(call_context* context)
-{
-	LOG_CALL("subtract_lcs");
-	asAtom res = asAtomHandler::invalidAtom;
-	asAtomHandler::subtractreplace(res,context->worker,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1),*context->exec_pos->arg2_constant,context->exec_pos->local3.flags & ABC_OP_FORCEINT);
-
-	asAtom obj = CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos);
-	uint32_t t = context->exec_pos->local3.flags & ~ABC_OP_BITMASK_USED;
-	asAtomHandler::getObjectNoCheck(obj)->setSlotNoCoerce(t,res);
-	++(context->exec_pos);
-}
-void ABCVm::abc_subtract_constant_local_setslotnocoerce(call_context* context)
-{
-	LOG_CALL("subtract_cls");
-	asAtom res = asAtomHandler::invalidAtom;
-	asAtomHandler::subtractreplace(res,context->worker,*context->exec_pos->arg1_constant,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2),context->exec_pos->local3.flags & ABC_OP_FORCEINT);
-
-	asAtom obj = CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos);
-	uint32_t t = context->exec_pos->local3.flags & ~ABC_OP_BITMASK_USED;
-	asAtomHandler::getObjectNoCheck(obj)->setSlotNoCoerce(t,res);
-	++(context->exec_pos);
-}
-void ABCVm::abc_subtract_local_local_setslotnocoerce(call_context* context)
-{
-	LOG_CALL("subtract_lls");
-	asAtom res = asAtomHandler::invalidAtom;
-	asAtomHandler::subtractreplace(res,context->worker,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1),CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2),context->exec_pos->local3.flags & ABC_OP_FORCEINT);
-
-	asAtom obj = CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos);
-	uint32_t t = context->exec_pos->local3.flags & ~ABC_OP_BITMASK_USED;
-	asAtomHandler::getObjectNoCheck(obj)->setSlotNoCoerce(t,res);
-	++(context->exec_pos);
-}
-
-void ABCVm::abc_multiply_constant_constant(call_context* context)
+void ABCVm::abc_convert_d_constant(call_context* context)
 {
-	LOG_CALL("multiply_cc");
+	LOG_CALL("convert_d_c");
 	asAtom res = *context->exec_pos->arg1_constant;
-	asAtomHandler::multiply(res,context->worker,*context->exec_pos->arg2_constant,context->exec_pos->local3.flags & ABC_OP_FORCEINT);
+	if(!asAtomHandler::isNumeric(res))
+		asAtomHandler::setNumber(res,context->worker,asAtomHandler::toNumber(res));
 	RUNTIME_STACK_PUSH(context,res);
 	++(context->exec_pos);
 }
-void ABCVm::abc_multiply_local_constant(call_context* context)
+void ABCVm::abc_convert_d_local(call_context* context)
 {
-	LOG_CALL("multiply_lc");
-	asAtom res = CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1);
-	asAtomHandler::multiply(res,context->worker,*context->exec_pos->arg2_constant,context->exec_pos->local3.flags & ABC_OP_FORCEINT);
+	LOG_CALL("convert_d_l:"<<asAtomHandler::toDebugString(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1)));
+	asAtom res =CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1);
+	if(!asAtomHandler::isNumeric(res))
+		asAtomHandler::setNumber(res,context->worker,asAtomHandler::toNumber(res));
+	else
+		ASATOM_INCREF(res);
 	RUNTIME_STACK_PUSH(context,res);
 	++(context->exec_pos);
 }
-void ABCVm::abc_multiply_constant_local(call_context* context)
+void ABCVm::abc_convert_d_constant_localresult(call_context* context)
 {
-	LOG_CALL("multiply_cl");
+	LOG_CALL("convert_d_cl");
 	asAtom res = *context->exec_pos->arg1_constant;
-	asAtomHandler::multiply(res,context->worker,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2),context->exec_pos->local3.flags & ABC_OP_FORCEINT);
-	RUNTIME_STACK_PUSH(context,res);
+	if(!asAtomHandler::isNumeric(res))
+		asAtomHandler::setNumber(res,context->worker,asAtomHandler::toNumber(res));
+	else
+		ASATOM_INCREF(res);
+	replacelocalresult(context,context->exec_pos->local3.pos,res);
 	++(context->exec_pos);
 }
-void ABCVm::abc_multiply_local_local(call_context* context)
+void ABCVm::abc_convert_d_local_localresult(call_context* context)
 {
-	LOG_CALL("multiply_ll");
 	asAtom res = CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1);
-	asAtomHandler::multiply(res,context->worker,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2),context->exec_pos->local3.flags & ABC_OP_FORCEINT);
-	RUNTIME_STACK_PUSH(context,res);
+	LOG_CALL("convert_d_ll "<<asAtomHandler::toDebugString(res)<<" "<<asAtomHandler::getObject(res)<<" "<< context->exec_pos->local_pos1<<" "<<(context->exec_pos->local3.pos));
+	if(!asAtomHandler::isNumeric(res))
+		asAtomHandler::setNumber(res,context->worker,asAtomHandler::toNumber(res));
+	else
+		ASATOM_INCREF(res);
+	replacelocalresult(context,context->exec_pos->local3.pos,res);
 	++(context->exec_pos);
 }
-void ABCVm::abc_multiply_constant_constant_localresult(call_context* context)
+void ABCVm::abc_convert_d_constant_setslotnocoerce(call_context* context)
 {
-	LOG_CALL("multiply_ccl");
-	asAtomHandler::multiplyreplace(CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos),context->worker,*context->exec_pos->arg1_constant,*context->exec_pos->arg2_constant,context->exec_pos->local3.flags & ABC_OP_FORCEINT);
+	LOG_CALL("convert_d_cs");
+	asAtom res = *context->exec_pos->arg1_constant;
+	if(!asAtomHandler::isNumeric(res))
+		asAtomHandler::setNumber(res,context->worker,asAtomHandler::toNumber(res));
+	else
+		ASATOM_INCREF(res);
+	asAtom obj = CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos);
+	uint32_t t = context->exec_pos->local3.flags & ~ABC_OP_BITMASK_USED;
+	asAtomHandler::getObjectNoCheck(obj)->setSlotNoCoerce(t,res);
 	++(context->exec_pos);
 }
-void ABCVm::abc_multiply_local_constant_localresult(call_context* context)
+void ABCVm::abc_convert_d_local_setslotnocoerce(call_context* context)
 {
-	LOG_CALL("multiply_lcl");
-	asAtomHandler::multiplyreplace(CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos),context->worker,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1),*context->exec_pos->arg2_constant,context->exec_pos->local3.flags & ABC_OP_FORCEINT);
+	LOG_CALL("convert_d_ls");
+	asAtom res = CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1);
+	if(!asAtomHandler::isNumeric(res))
+		asAtomHandler::setNumber(res,context->worker,asAtomHandler::toNumber(res));
+	else
+		ASATOM_INCREF(res);
+	asAtom obj = CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos);
+	uint32_t t = context->exec_pos->local3.flags & ~ABC_OP_BITMASK_USED;
+	asAtomHandler::getObjectNoCheck(obj)->setSlotNoCoerce(t,res);
 	++(context->exec_pos);
 }
-void ABCVm::abc_multiply_constant_local_localresult(call_context* context)
+void ABCVm::abc_convert_b_constant(call_context* context)
 {
-	LOG_CALL("multiply_cll");
-	asAtomHandler::multiplyreplace(CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos),context->worker,*context->exec_pos->arg1_constant,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2),context->exec_pos->local3.flags & ABC_OP_FORCEINT);
+	LOG_CALL("convert_b_c");
+	asAtom res = *context->exec_pos->arg1_constant;
+	if(!asAtomHandler::isBool(res))
+		asAtomHandler::convert_b(res,false);
+	RUNTIME_STACK_PUSH(context,res);
 	++(context->exec_pos);
 }
-void ABCVm::abc_multiply_local_local_localresult(call_context* context)
+void ABCVm::abc_convert_b_local(call_context* context)
 {
-	LOG_CALL("multiply_lll");
-	asAtomHandler::multiplyreplace(CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos),context->worker,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1),CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2),context->exec_pos->local3.flags & ABC_OP_FORCEINT);
+	LOG_CALL("convert_b_l:"<<asAtomHandler::toDebugString(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1)));
+	asAtom res =CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1);
+	if(!asAtomHandler::isBool(res))
+		asAtomHandler::convert_b(res,false);
+	RUNTIME_STACK_PUSH(context,res);
 	++(context->exec_pos);
 }
-void ABCVm::abc_multiply_constant_constant_setslotnocoerce(call_context* context)
+void ABCVm::abc_convert_b_constant_localresult(call_context* context)
 {
-	LOG_CALL("multiply_ccs");
-	asAtom res = asAtomHandler::invalidAtom;
-	asAtomHandler::multiplyreplace(res,context->worker,*context->exec_pos->arg1_constant,*context->exec_pos->arg2_constant,context->exec_pos->local3.flags & ABC_OP_FORCEINT);
-
-	asAtom obj = CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos);
-	uint32_t t = context->exec_pos->local3.flags & ~ABC_OP_BITMASK_USED;
-	asAtomHandler::getObjectNoCheck(obj)->setSlotNoCoerce(t,res);
+	LOG_CALL("convert_b_cl");
+	asAtom res = *context->exec_pos->arg1_constant;
+	if(!asAtomHandler::isBool(res))
+		asAtomHandler::convert_b(res,false);
+	replacelocalresult(context,context->exec_pos->local3.pos,res);
 	++(context->exec_pos);
 }
-void ABCVm::abc_multiply_local_constant_setslotnocoerce(call_context* context)
+void ABCVm::abc_convert_b_local_localresult(call_context* context)
 {
-	LOG_CALL("multiply_lcs");
-	asAtom res = asAtomHandler::invalidAtom;
-	asAtomHandler::multiplyreplace(res,context->worker,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1),*context->exec_pos->arg2_constant,context->exec_pos->local3.flags & ABC_OP_FORCEINT);
-
-	asAtom obj = CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos);
-	uint32_t t = context->exec_pos->local3.flags & ~ABC_OP_BITMASK_USED;
-	asAtomHandler::getObjectNoCheck(obj)->setSlotNoCoerce(t,res);
+	LOG_CALL("convert_b_ll");
+	asAtom res = CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1);
+	if(!asAtomHandler::isBool(res))
+		asAtomHandler::convert_b(res,false);
+	replacelocalresult(context,context->exec_pos->local3.pos,res);
 	++(context->exec_pos);
 }
-void ABCVm::abc_multiply_constant_local_setslotnocoerce(call_context* context)
+void ABCVm::abc_convert_b_constant_setslotnocoerce(call_context* context)
 {
-	LOG_CALL("multiply_cls");
-	asAtom res = asAtomHandler::invalidAtom;
-	asAtomHandler::multiplyreplace(res,context->worker,*context->exec_pos->arg1_constant,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2),context->exec_pos->local3.flags & ABC_OP_FORCEINT);
-
+	LOG_CALL("convert_b_cs");
+	asAtom res = *context->exec_pos->arg1_constant;
+	if(!asAtomHandler::isBool(res))
+		asAtomHandler::convert_b(res,false);
 	asAtom obj = CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos);
 	uint32_t t = context->exec_pos->local3.flags & ~ABC_OP_BITMASK_USED;
 	asAtomHandler::getObjectNoCheck(obj)->setSlotNoCoerce(t,res);
 	++(context->exec_pos);
 }
-void ABCVm::abc_multiply_local_local_setslotnocoerce(call_context* context)
+void ABCVm::abc_convert_b_local_setslotnocoerce(call_context* context)
 {
-	LOG_CALL("multiply_lls");
-	asAtom res = asAtomHandler::invalidAtom;
-	asAtomHandler::multiplyreplace(res,context->worker,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1),CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2),context->exec_pos->local3.flags & ABC_OP_FORCEINT);
-
+	LOG_CALL("convert_b_ls");
+	asAtom res = CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1);
+	if(!asAtomHandler::isBool(res))
+		asAtomHandler::convert_b(res,false);
 	asAtom obj = CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos);
 	uint32_t t = context->exec_pos->local3.flags & ~ABC_OP_BITMASK_USED;
 	asAtomHandler::getObjectNoCheck(obj)->setSlotNoCoerce(t,res);
 	++(context->exec_pos);
 }
 
-void ABCVm::abc_divide_constant_constant(call_context* context)
+void ABCVm::abc_astypelate_constant_constant(call_context* context)
 {
-	LOG_CALL("divide_cc");
-	asAtom res = *context->exec_pos->arg1_constant;
-	asAtomHandler::divide(res,context->worker,*context->exec_pos->arg2_constant,context->exec_pos->local3.flags & ABC_OP_FORCEINT);
-	RUNTIME_STACK_PUSH(context,res);
+	LOG_CALL("astypelate_cc");
+	asAtom ret = asAtomHandler::asTypelate(*context->exec_pos->arg1_constant,*context->exec_pos->arg2_constant,context->worker);
+	ASATOM_INCREF(ret);
+	RUNTIME_STACK_PUSH(context,ret);
 	++(context->exec_pos);
 }
-void ABCVm::abc_divide_local_constant(call_context* context)
+void ABCVm::abc_astypelate_local_constant(call_context* context)
 {
-	LOG_CALL("divide_lc");
-	asAtom res = CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1);
-	asAtomHandler::divide(res,context->worker,*context->exec_pos->arg2_constant,context->exec_pos->local3.flags & ABC_OP_FORCEINT);
-	RUNTIME_STACK_PUSH(context,res);
+	LOG_CALL("astypelate_lc");
+	asAtom ret = asAtomHandler::asTypelate(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1),*context->exec_pos->arg2_constant,context->worker);
+	ASATOM_INCREF(ret);
+	RUNTIME_STACK_PUSH(context,ret);
 	++(context->exec_pos);
 }
-void ABCVm::abc_divide_constant_local(call_context* context)
+void ABCVm::abc_astypelate_constant_local(call_context* context)
 {
-	LOG_CALL("divide_cl");
-	asAtom res = *context->exec_pos->arg1_constant;
-	asAtomHandler::divide(res,context->worker,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2),context->exec_pos->local3.flags & ABC_OP_FORCEINT);
-	RUNTIME_STACK_PUSH(context,res);
+	LOG_CALL("astypelate_cl");
+	asAtom ret = asAtomHandler::asTypelate(*context->exec_pos->arg1_constant,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2),context->worker);
+	ASATOM_INCREF(ret);
+	RUNTIME_STACK_PUSH(context,ret);
 	++(context->exec_pos);
 }
-void ABCVm::abc_divide_local_local(call_context* context)
+void ABCVm::abc_astypelate_local_local(call_context* context)
 {
-	LOG_CALL("divide_ll");
-	asAtom res = CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1);
-	asAtomHandler::divide(res,context->worker,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2),context->exec_pos->local3.flags & ABC_OP_FORCEINT);
-	RUNTIME_STACK_PUSH(context,res);
+	LOG_CALL("astypelate_ll");
+	asAtom ret = asAtomHandler::asTypelate(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1),CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2),context->worker);
+	ASATOM_INCREF(ret);
+	RUNTIME_STACK_PUSH(context,ret);
 	++(context->exec_pos);
 }
-void ABCVm::abc_divide_constant_constant_localresult(call_context* context)
+void ABCVm::abc_astypelate_constant_constant_localresult(call_context* context)
 {
-	LOG_CALL("divide_ccl");
-	asAtomHandler::dividereplace(CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos),context->worker,*context->exec_pos->arg1_constant,*context->exec_pos->arg2_constant,context->exec_pos->local3.flags & ABC_OP_FORCEINT);
+	LOG_CALL("astypelate_ccl");
+	asAtom ret = asAtomHandler::asTypelate(*context->exec_pos->arg1_constant,*context->exec_pos->arg2_constant,context->worker);
+	ASATOM_INCREF(ret);
+	replacelocalresult(context,context->exec_pos->local3.pos,ret);
 	++(context->exec_pos);
 }
-void ABCVm::abc_divide_local_constant_localresult(call_context* context)
+void ABCVm::abc_astypelate_local_constant_localresult(call_context* context)
 {
-	LOG_CALL("divide_lcl");
-	asAtomHandler::dividereplace(CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos),context->worker,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1),*context->exec_pos->arg2_constant,context->exec_pos->local3.flags & ABC_OP_FORCEINT);
+	LOG_CALL("astypelate_lcl");
+	asAtom ret = asAtomHandler::asTypelate(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1),*context->exec_pos->arg2_constant,context->worker);
+	ASATOM_INCREF(ret);
+	replacelocalresult(context,context->exec_pos->local3.pos,ret);
 	++(context->exec_pos);
 }
-void ABCVm::abc_divide_constant_local_localresult(call_context* context)
+void ABCVm::abc_astypelate_constant_local_localresult(call_context* context)
 {
-	LOG_CALL("divide_cll");
-	asAtomHandler::dividereplace(CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos),context->worker,*context->exec_pos->arg1_constant,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2),context->exec_pos->local3.flags & ABC_OP_FORCEINT);
+	LOG_CALL("astypelate_cll");
+	asAtom ret = asAtomHandler::asTypelate(*context->exec_pos->arg1_constant,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2),context->worker);
+	ASATOM_INCREF(ret);
+	replacelocalresult(context,context->exec_pos->local3.pos,ret);
 	++(context->exec_pos);
 }
-void ABCVm::abc_divide_local_local_localresult(call_context* context)
+void ABCVm::abc_astypelate_local_local_localresult(call_context* context)
 {
-	LOG_CALL("divide_lll");
-	asAtomHandler::dividereplace(CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos),context->worker,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1),CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2),context->exec_pos->local3.flags & ABC_OP_FORCEINT);
+	LOG_CALL("astypelate_lll");
+	asAtom ret = asAtomHandler::asTypelate(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1),CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2),context->worker);
+	ASATOM_INCREF(ret);
+	replacelocalresult(context,context->exec_pos->local3.pos,ret);
 	++(context->exec_pos);
 }
-void ABCVm::abc_divide_constant_constant_setslotnocoerce(call_context* context)
+void ABCVm::abc_astypelate_constant_constant_setslotnocoerce(call_context* context)
 {
-	LOG_CALL("divide_ccs");
-	asAtom res = asAtomHandler::invalidAtom;
-	asAtomHandler::dividereplace(res,context->worker,*context->exec_pos->arg1_constant,*context->exec_pos->arg2_constant,context->exec_pos->local3.flags & ABC_OP_FORCEINT);
+	LOG_CALL("astypelate_ccs");
+	asAtom res = asAtomHandler::asTypelate(*context->exec_pos->arg1_constant,*context->exec_pos->arg2_constant,context->worker);
 
 	asAtom obj = CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos);
 	uint32_t t = context->exec_pos->local3.flags & ~ABC_OP_BITMASK_USED;
 	asAtomHandler::getObjectNoCheck(obj)->setSlotNoCoerce(t,res);
 	++(context->exec_pos);
 }
-void ABCVm::abc_divide_local_constant_setslotnocoerce(call_context* context)
+void ABCVm::abc_astypelate_local_constant_setslotnocoerce(call_context* context)
 {
-	LOG_CALL("divide_lcs");
-	asAtom res = asAtomHandler::invalidAtom;
-	asAtomHandler::dividereplace(res,context->worker,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1),*context->exec_pos->arg2_constant,context->exec_pos->local3.flags & ABC_OP_FORCEINT);
+	LOG_CALL("astypelate_lcs");
+	asAtom res = asAtomHandler::asTypelate(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1),*context->exec_pos->arg2_constant,context->worker);
 
 	asAtom obj = CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos);
 	uint32_t t = context->exec_pos->local3.flags & ~ABC_OP_BITMASK_USED;
 	asAtomHandler::getObjectNoCheck(obj)->setSlotNoCoerce(t,res);
 	++(context->exec_pos);
 }
-void ABCVm::abc_divide_constant_local_setslotnocoerce(call_context* context)
+void ABCVm::abc_astypelate_constant_local_setslotnocoerce(call_context* context)
 {
-	LOG_CALL("divide_cls");
-	asAtom res = asAtomHandler::invalidAtom;
-	asAtomHandler::dividereplace(res,context->worker,*context->exec_pos->arg1_constant,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2),context->exec_pos->local3.flags & ABC_OP_FORCEINT);
+	LOG_CALL("astypelate_cls");
+	asAtom res = asAtomHandler::asTypelate(*context->exec_pos->arg1_constant,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2),context->worker);
 
 	asAtom obj = CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos);
 	uint32_t t = context->exec_pos->local3.flags & ~ABC_OP_BITMASK_USED;
 	asAtomHandler::getObjectNoCheck(obj)->setSlotNoCoerce(t,res);
 	++(context->exec_pos);
 }
-void ABCVm::abc_divide_local_local_setslotnocoerce(call_context* context)
+void ABCVm::abc_astypelate_local_local_setslotnocoerce(call_context* context)
 {
-	LOG_CALL("divide_lls");
-	asAtom res = asAtomHandler::invalidAtom;
-	asAtomHandler::dividereplace(res,context->worker,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1),CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2),context->exec_pos->local3.flags & ABC_OP_FORCEINT);
+	LOG_CALL("astypelate_lls");
+	asAtom res = asAtomHandler::asTypelate(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1),CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2),context->worker);
 
 	asAtom obj = CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos);
 	uint32_t t = context->exec_pos->local3.flags & ~ABC_OP_BITMASK_USED;
 	asAtomHandler::getObjectNoCheck(obj)->setSlotNoCoerce(t,res);
 	++(context->exec_pos);
 }
-void ABCVm::abc_modulo_constant_constant(call_context* context)
+
+void ABCVm::abc_increment_local(call_context* context)
 {
-	asAtom res = *context->exec_pos->arg1_constant;
-	asAtomHandler::modulo(res,context->worker,*context->exec_pos->arg2_constant,context->exec_pos->local3.flags & ABC_OP_FORCEINT);
+	asAtom res = CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1);
+	LOG_CALL("increment_l "<<context->exec_pos->local_pos1<<" "<<asAtomHandler::toDebugString(res));
+	if (!asAtomHandler::increment(res,context->worker,false))
+		ASATOM_INCREF(res);
 	RUNTIME_STACK_PUSH(context,res);
 	++(context->exec_pos);
 }
-void ABCVm::abc_modulo_local_constant(call_context* context)
+void ABCVm::abc_increment_local_localresult(call_context* context)
 {
+	LOG_CALL("increment_ll "<<context->exec_pos->local_pos1<<" "<<context->exec_pos->local3.pos<<" "<<asAtomHandler::toDebugString(CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos))<<" "<<asAtomHandler::toDebugString(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1)));
 	asAtom res = CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1);
-	asAtomHandler::modulo(res,context->worker,*context->exec_pos->arg2_constant,context->exec_pos->local3.flags & ABC_OP_FORCEINT);
-	RUNTIME_STACK_PUSH(context,res);
+	if (context->exec_pos->local_pos1 != context->exec_pos->local3.pos)
+	{
+		ASATOM_DECREF(CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos));
+		if (asAtomHandler::isNumber(res))
+			asAtomHandler::setNumber(CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos),context->worker,asAtomHandler::getNumber(res));
+		else
+			asAtomHandler::set(CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos),res);
+	}
+	else
+		asAtomHandler::set(CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos),res);
+	asAtomHandler::increment(CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos),context->worker,context->exec_pos->local3.pos == context->exec_pos->local_pos1);
 	++(context->exec_pos);
 }
-void ABCVm::abc_modulo_constant_local(call_context* context)
+void ABCVm::abc_decrement_local(call_context* context)
 {
-	asAtom res = *context->exec_pos->arg1_constant;
-	asAtomHandler::modulo(res,context->worker,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2),context->exec_pos->local3.flags & ABC_OP_FORCEINT);
+	asAtom res = CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1);
+	LOG_CALL("decrement_l "<<context->exec_pos->local_pos1<<" "<<asAtomHandler::toDebugString(res));
+	if (!asAtomHandler::decrement(res,context->worker,false))
+		ASATOM_INCREF(res);
 	RUNTIME_STACK_PUSH(context,res);
 	++(context->exec_pos);
 }
-void ABCVm::abc_modulo_local_local(call_context* context)
+void ABCVm::abc_decrement_local_localresult(call_context* context)
 {
+	LOG_CALL("decrement_ll "<<context->exec_pos->local_pos1<<" "<<context->exec_pos->local3.pos<<" "<<asAtomHandler::toDebugString(CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos)));
 	asAtom res = CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1);
-	asAtomHandler::modulo(res,context->worker,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2),context->exec_pos->local3.flags & ABC_OP_FORCEINT);
-	RUNTIME_STACK_PUSH(context,res);
+	if (context->exec_pos->local_pos1 != context->exec_pos->local3.pos)
+	{
+		ASATOM_DECREF(CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos));
+		if (asAtomHandler::isNumber(res))
+			asAtomHandler::setNumber(CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos),context->worker,asAtomHandler::getNumber(res));
+		else
+			asAtomHandler::set(CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos),res);
+	}
+	else
+		asAtomHandler::set(CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos),res);
+	asAtomHandler::decrement(CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos),context->worker,context->exec_pos->local3.pos == context->exec_pos->local_pos1);
 	++(context->exec_pos);
 }
-void ABCVm::abc_modulo_constant_constant_localresult(call_context* context)
+void ABCVm::abc_typeof_constant(call_context* context)
 {
-	LOG_CALL("modulo_ccl");
-	asAtomHandler::moduloreplace(CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos),context->worker,*context->exec_pos->arg1_constant,*context->exec_pos->arg2_constant,context->exec_pos->local3.flags & ABC_OP_FORCEINT);
+	LOG_CALL("typeof_c");
+	asAtom res = asAtomHandler::typeOf(*context->exec_pos->arg1_constant);
+	RUNTIME_STACK_PUSH(context,res);
 	++(context->exec_pos);
 }
-void ABCVm::abc_modulo_local_constant_localresult(call_context* context)
+void ABCVm::abc_typeof_local(call_context* context)
 {
-	LOG_CALL("modulo_lcl");
-	asAtomHandler::moduloreplace(CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos),context->worker,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1),*context->exec_pos->arg2_constant,context->exec_pos->local3.flags & ABC_OP_FORCEINT);
+	LOG_CALL("typeof_l "<<asAtomHandler::toDebugString(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1)));
+	asAtom res = asAtomHandler::typeOf(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1));
+	RUNTIME_STACK_PUSH(context,res);
 	++(context->exec_pos);
 }
-void ABCVm::abc_modulo_constant_local_localresult(call_context* context)
+void ABCVm::abc_typeof_constant_localresult(call_context* context)
 {
-	LOG_CALL("modulo_cll");
-	asAtomHandler::moduloreplace(CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos),context->worker,*context->exec_pos->arg1_constant,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2),context->exec_pos->local3.flags & ABC_OP_FORCEINT);
+	LOG_CALL("typeof_cl");
+	asAtom res = asAtomHandler::typeOf(*context->exec_pos->arg1_constant);
+	replacelocalresult(context,context->exec_pos->local3.pos,res);
 	++(context->exec_pos);
 }
-void ABCVm::abc_modulo_local_local_localresult(call_context* context)
+void ABCVm::abc_typeof_local_localresult(call_context* context)
 {
-	LOG_CALL("modulo_lll");
-	asAtomHandler::moduloreplace(CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos),context->worker,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1),CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2),context->exec_pos->local3.flags & ABC_OP_FORCEINT);
+	LOG_CALL("typeof_ll");
+	asAtom res = asAtomHandler::typeOf(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1));
+	replacelocalresult(context,context->exec_pos->local3.pos,res);
 	++(context->exec_pos);
-}
-void ABCVm::abc_modulo_constant_constant_setslotnocoerce(call_context* context)
+}void ABCVm::abc_not_constant(call_context* context)
 {
-	LOG_CALL("modulo_ccs");
-	asAtom res = asAtomHandler::invalidAtom;
-	asAtomHandler::moduloreplace(res,context->worker,*context->exec_pos->arg1_constant,*context->exec_pos->arg2_constant,context->exec_pos->local3.flags & ABC_OP_FORCEINT);
-
-	asAtom obj = CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos);
-	uint32_t t = context->exec_pos->local3.flags & ~ABC_OP_BITMASK_USED;
-	asAtomHandler::getObjectNoCheck(obj)->setSlotNoCoerce(t,res);
+	LOG_CALL("not_c");
+	asAtom res = asAtomHandler::fromBool(!asAtomHandler::Boolean_concrete(*context->exec_pos->arg1_constant));
+	RUNTIME_STACK_PUSH(context,res);
 	++(context->exec_pos);
 }
-void ABCVm::abc_modulo_local_constant_setslotnocoerce(call_context* context)
+void ABCVm::abc_not_local(call_context* context)
 {
-	LOG_CALL("modulo_lcs");
-	asAtom res = asAtomHandler::invalidAtom;
-	asAtomHandler::moduloreplace(res,context->worker,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1),*context->exec_pos->arg2_constant,context->exec_pos->local3.flags & ABC_OP_FORCEINT);
-
-	asAtom obj = CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos);
-	uint32_t t = context->exec_pos->local3.flags & ~ABC_OP_BITMASK_USED;
-	asAtomHandler::getObjectNoCheck(obj)->setSlotNoCoerce(t,res);
+	LOG_CALL("not_l "<<asAtomHandler::toDebugString(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1)));
+	asAtom res = asAtomHandler::fromBool(!asAtomHandler::Boolean_concrete(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1)));
+	RUNTIME_STACK_PUSH(context,res);
 	++(context->exec_pos);
 }
-void ABCVm::abc_modulo_constant_local_setslotnocoerce(call_context* context)
+void ABCVm::abc_not_constant_localresult(call_context* context)
 {
-	LOG_CALL("modulo_cls");
-	asAtom res = asAtomHandler::invalidAtom;
-	asAtomHandler::moduloreplace(res,context->worker,*context->exec_pos->arg1_constant,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2),context->exec_pos->local3.flags & ABC_OP_FORCEINT);
-
-	asAtom obj = CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos);
-	uint32_t t = context->exec_pos->local3.flags & ~ABC_OP_BITMASK_USED;
-	asAtomHandler::getObjectNoCheck(obj)->setSlotNoCoerce(t,res);
+	LOG_CALL("not_cl");
+	bool res = !asAtomHandler::Boolean_concrete(*context->exec_pos->arg1_constant);
+	ASATOM_DECREF(CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos));
+	asAtomHandler::setBool(CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos),res);
 	++(context->exec_pos);
 }
-void ABCVm::abc_modulo_local_local_setslotnocoerce(call_context* context)
+void ABCVm::abc_not_local_localresult(call_context* context)
 {
-	LOG_CALL("modulo_lls");
-	asAtom res = asAtomHandler::invalidAtom;
-	asAtomHandler::moduloreplace(res,context->worker,CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1),CONTEXT_GETLOCAL(context,context->exec_pos->local_pos2),context->exec_pos->local3.flags & ABC_OP_FORCEINT);
-
-	asAtom obj = CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos);
-	uint32_t t = context->exec_pos->local3.flags & ~ABC_OP_BITMASK_USED;
-	asAtomHandler::getObjectNoCheck(obj)->setSlotNoCoerce(t,res);
+	LOG_CALL("not_ll");
+	bool res = !asAtomHandler::Boolean_concrete(CONTEXT_GETLOCAL(context,context->exec_pos->local_pos1));
+	ASATOM_DECREF(CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos));
+	asAtomHandler::setBool(CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos),res);
 	++(context->exec_pos);
 }
+
 void ABCVm::abc_lshift_constant_constant(call_context* context)
 {
 	int32_t i2=context->exec_pos->arg1_int;
@@ -6952,7 +6075,7 @@ void ABCVm::abc_add_i_local_constant_localresult(call_context* context)
 	asAtom oldres = CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos);
 	if (USUALLY_TRUE(
 #ifdef LIGHTSPARK_64
-			((arg1.uintval & 0xc000000000000007) ==ATOM_INTEGER)
+			((arg1.uintval & 0xffff000000000007) ==ATOM_INTEGER)
 #else
 			((context->exec_pos->arg2_int & 0xc0000007) ==ATOM_INTEGER ) && ((arg1.uintval & 0xc0000007) ==ATOM_INTEGER )
 #endif
@@ -6985,7 +6108,7 @@ void ABCVm::abc_add_i_constant_local_localresult(call_context* context)
 	asAtom oldres = CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos);
 	if (USUALLY_TRUE(
 #ifdef LIGHTSPARK_64
-			((arg2.uintval & 0xc000000000000007) ==ATOM_INTEGER)
+			((arg2.uintval & 0xffff000000000007) ==ATOM_INTEGER)
 #else
 			((context->exec_pos->arg1_int & 0xc0000007) ==ATOM_INTEGER ) && ((arg2.uintval & 0xc0000007) ==ATOM_INTEGER )
 #endif
@@ -7019,7 +6142,7 @@ void ABCVm::abc_add_i_local_local_localresult(call_context* context)
 	asAtom oldres = CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos);
 	if (USUALLY_TRUE(
 #ifdef LIGHTSPARK_64
-			(((res.uintval | arg2.uintval) & 0xc000000000000007) ==ATOM_INTEGER)
+			(((res.uintval | arg2.uintval) & 0xffff000000000007) ==ATOM_INTEGER)
 #else
 			(((res.uintval | arg2.uintval) & 0xc0000007) ==ATOM_INTEGER)
 #endif
@@ -7405,7 +6528,7 @@ void ABCVm::abc_inclocal_i_postfix(call_context* context)
 	asAtom oldres = CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos);
 	if (USUALLY_TRUE(
 #ifdef LIGHTSPARK_64
-			((res.uintval & 0xc000000000000007) ==ATOM_INTEGER)
+			((res.uintval & 0xffff000000000007) ==ATOM_INTEGER)
 #else
 			((res.uintval & 0xc0000007) ==ATOM_INTEGER )
 #endif
@@ -7431,7 +6554,7 @@ void ABCVm::abc_declocal_i_postfix(call_context* context)
 	asAtom oldres = CONTEXT_GETLOCAL(context,context->exec_pos->local3.pos);
 	if (USUALLY_TRUE(
 #ifdef LIGHTSPARK_64
-			((res.uintval & 0xc000000000000007) ==ATOM_INTEGER)
+			((res.uintval & 0xffff000000000007) ==ATOM_INTEGER)
 #else
 			((res.uintval & 0xc0000007) ==ATOM_INTEGER )
 #endif
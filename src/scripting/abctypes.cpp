@@ -18,6 +18,7 @@
 **************************************************************************/
 
 #include "scripting/abctypes.h"
+#include "scripting/abc.h"
 #include "swf.h"
 
 using namespace std;
@@ -409,4 +410,31 @@ method_body_info::~method_body_info()
 {
 	if (localsinitialvalues)
 		delete[] localsinitialvalues;
+#ifdef JIT_ENABLED
+	if (jitcode)
+		ABCVm::releaseJitCode(this);
+#endif
+	if (speculativemethod)
+	{
+		delete speculativemethod->body;
+		delete speculativemethod;
+	}
+}
+
+method_body_info* method_body_info::cloneForSpeculation() const
+{
+	method_body_info* res = new method_body_info();
+	res->method = method;
+	res->max_stack = max_stack;
+	res->local_count = local_count;
+	res->init_scope_depth = init_scope_depth;
+	res->max_scope_depth = max_scope_depth;
+	res->code = code;
+	res->exceptions = exceptions;
+	res->trait_count = trait_count;
+	res->traits = traits;
+	res->returnvaluepos = returnvaluepos;
+	res->speculationStatus = SPECULATION_DISABLED;
+	res->isspeculative = true;
+	return res;
 }
@@ -23,6 +23,7 @@
 #include "swftypes.h"
 #include "memory_support.h"
 #include <unordered_set>
+#include <set>
 
 class memorystream;
 
@@ -264,6 +265,8 @@ struct method_info_simple
 	std::vector<u30> param_names;
 };
 typedef void (*abc_function)(struct call_context*);
+// native code generated by the baseline jit from the preloaded code, returns when the function returned or threw an exception
+typedef void (*jit_function)(struct call_context*, asAtom* ret);
 
 struct preloadedcodedata
 {
@@ -305,7 +308,32 @@ struct preloadedcodedata
 		int32_t arg3_int;
 		uint32_t arg3_uint;
 	};
-	preloadedcodedata():func(nullptr),cacheobj1(nullptr),cacheobj2(nullptr),cacheobj3(nullptr) {}
+	// index+1 of the propertycache of this instruction in method_body_info::propertycaches, 0 if not set
+	// kept outside of the argument slots, as the cached opcodes store pointers in all three of them
+	uint32_t cacheindex;
+	preloadedcodedata():func(nullptr),cacheobj1(nullptr),cacheobj2(nullptr),cacheobj3(nullptr),cacheindex(0) {}
+};
+
+#define PROPERTYCACHE_SIZE 4
+struct variable;
+// one entry of a propertycache
+struct propertycacheentry
+{
+	Class_base* cls; // class of the receiver object
+	variable* var; // variable from the borrowed traits of cls (getter, setter or method), nullptr if the property is stored in an instance slot
+	uint32_t slotid;
+	uint32_t revision; // traitsRevision of cls when this entry was added
+	// id of the class shape and position of the slot variable in its flat layout, shapeid is 0 if the receiver was not created from a shape
+	uint32_t shapeid;
+	uint32_t flatindex;
+};
+// inline cache for getproperty/setproperty with static names, used by the preloaded code
+struct propertycache
+{
+	propertycacheentry entries[PROPERTYCACHE_SIZE];
+	uint32_t count;
+	bool megamorphic; // more than PROPERTYCACHE_SIZE classes were encountered, the cache is no longer used
+	propertycache():count(0),megamorphic(false) {}
 };
 struct localconstantslot
 {
@@ -313,9 +341,21 @@ struct localconstantslot
 	uint32_t slot_number;
 };
 
+// result of the first pass of ABCVm::preloadFunction, only depends on the bytecode of the method body
+struct preloadjumpinfo
+{
+	std::map<int32_t,int32_t> jumptargets;
+	std::multimap<int32_t,int32_t> jumppoints;
+	std::set<uint32_t> skippablekills;
+	bool simplegetter;
+	bool simplesetter;
+	preloadjumpinfo():simplegetter(false),simplesetter(false) {}
+};
+
 struct method_body_info
 {
-	method_body_info():localresultcount(0),hit_count(0),codeStatus(ORIGINAL),localsinitialvalues(nullptr){}
+	method_body_info():localresultcount(0),hit_count(0),codeStatus(ORIGINAL),localsinitialvalues(nullptr),jitcode(nullptr),jitcodesize(0),jitcodestart(nullptr),jitfailed(false),
+		speculationStatus(SPECULATION_PROFILING),speculationhits(0),speculationfailures(0),speculativemethod(nullptr),isspeculative(false){}
 	~method_body_info();
 	u30 method;
 	u30 max_stack;
@@ -336,7 +376,33 @@ struct method_body_info
 	// list of local/slot pairs that were optimized away
 	std::vector<localconstantslot> localconstantslots;
 	std::vector<preloadedcodedata> preloadedcode;
+	std::vector<propertycache> propertycaches;
 	asAtom* localsinitialvalues;
+	// native code of the baseline jit, nullptr if the function was not jitted
+	jit_function jitcode;
+	size_t jitcodesize;
+	// preloaded code the native code was generated from
+	const preloadedcodedata* jitcodestart;
+	// the jit was not able to translate this body, it is not tried again
+	bool jitfailed;
+	// native addresses of the preloaded instructions, indexed by their byte offset in the preloaded code
+	std::vector<const void*> jitdispatch;
+	// type feedback for the untyped arguments, used to preload a version of hot methods specialized for the observed argument classes
+	enum SPECULATION_STATUS { SPECULATION_PROFILING = 0, SPECULATION_ACTIVE, SPECULATION_DISABLED };
+	SPECULATION_STATUS speculationStatus;
+	uint16_t speculationhits;
+	uint16_t speculationfailures;
+	// class of every untyped argument in all profiled calls, nullptr if the argument is typed or its class changed
+	std::vector<Class_base*> observedargumenttypes;
+	// Class_base::uniqueID of the observed classes, 0 if no class is observed for the argument
+	// the guard compares these, as the address of a destroyed class may be reused for a different class
+	std::vector<uint32_t> observedargumentclassids;
+	// the specialized version of the method, nullptr if not yet preloaded
+	method_info* speculativemethod;
+	// this is the body of a specialized version of a method
+	bool isspeculative;
+	// copies the data parsed from the swf, used to create the body of the specialized version
+	method_body_info* cloneForSpeculation() const;
 	inline uint16_t getReturnValuePos() const { return returnvaluepos; }
 };
 
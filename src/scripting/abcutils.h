@@ -23,6 +23,7 @@
 #include "asobject.h"
 #include "smartrefs.h"
 #include "errorconstants.h"
+#include <vector>
 
 namespace lightspark
 {
@@ -93,6 +94,98 @@ struct call_context
 		}
 	}
 };
+
+/*
+ * Stack of call frames of a worker.
+ * The call_context, locals, operand stack and scope stack of a call are taken from it with a single pointer bump
+ * and released in reverse order when the call returns.
+ * Memory is allocated in chunks that are never moved, so pointers into a frame stay valid during the call
+ */
+class callstackarena
+{
+private:
+	struct chunk
+	{
+		char* start;
+		char* end;
+	};
+	std::vector<chunk> chunks;
+	uint32_t currentchunk;
+	char* top;
+	char* end;
+	void addChunk(size_t size)
+	{
+		chunk c;
+		c.start = new char[size];
+		c.end = c.start+size;
+		chunks.push_back(c);
+	}
+	void* allocateSlow(size_t size)
+	{
+		// continue in the next chunk, chunks after the current one are unused and can be replaced if they are too small
+		uint32_t next = currentchunk+1;
+		if (next < chunks.size() && size_t(chunks[next].end-chunks[next].start) < size)
+		{
+			for (uint32_t i = next; i < chunks.size(); i++)
+				delete[] chunks[i].start;
+			chunks.resize(next);
+		}
+		if (next == chunks.size())
+			addChunk(size > CHUNKSIZE ? size : CHUNKSIZE);
+		currentchunk = next;
+		top = chunks[next].start+size;
+		end = chunks[next].end;
+		return chunks[next].start;
+	}
+public:
+	static const size_t CHUNKSIZE = 256*1024;
+	struct position
+	{
+		uint32_t chunk;
+		char* top;
+	};
+	callstackarena():currentchunk(0)
+	{
+		addChunk(CHUNKSIZE);
+		top = chunks[0].start;
+		end = chunks[0].end;
+	}
+	~callstackarena()
+	{
+		for (auto it = chunks.begin(); it != chunks.end(); it++)
+			delete[] it->start;
+	}
+	callstackarena(const callstackarena&) = delete;
+	callstackarena& operator=(const callstackarena&) = delete;
+	FORCE_INLINE position getPosition() const
+	{
+		position p;
+		p.chunk = currentchunk;
+		p.top = top;
+		return p;
+	}
+	// returns 16 byte aligned memory
+	FORCE_INLINE void* allocate(size_t size)
+	{
+		size = (size+15)&~size_t(15);
+		if (USUALLY_FALSE(size_t(end-top) < size))
+			return allocateSlow(size);
+		void* ret = top;
+		top += size;
+		return ret;
+	}
+	// frees everything allocated after position p
+	FORCE_INLINE void release(const position& p)
+	{
+		if (USUALLY_FALSE(p.chunk != currentchunk))
+		{
+			currentchunk = p.chunk;
+			end = chunks[currentchunk].end;
+		}
+		top = p.top;
+	}
+};
+
 typedef ASObject* (*synt_function)(call_context* cc);
 typedef void (*as_atom_function)(asAtom&, ASWorker*, asAtom&, asAtom*, const unsigned int);
 
@@ -0,0 +1,71 @@
+/**************************************************************************
+    Lightspark, a free flash player implementation
+
+    Copyright (C) 2009-2013  Alessandro Pignotti (a.pignotti@sssup.it)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+
+#include "scripting/eventqueue.h"
+#include "logger.h"
+
+using namespace std;
+using namespace lightspark;
+
+DEFINE_AND_INITIALIZE_TLS(event_source);
+
+void lightspark::setEventSource(EVENT_SOURCE source)
+{
+	tls_set(event_source, GINT_TO_POINTER(source));
+}
+
+EVENT_SOURCE lightspark::getEventSource()
+{
+	return EVENT_SOURCE(GPOINTER_TO_INT(tls_get(event_source)));
+}
+
+void EventQueueStats::enqueued(EVENT_SOURCE source)
+{
+	eventsourcestats& s = sources[source];
+	uint32_t depth = s.depth.fetch_add(1,memory_order_relaxed)+1;
+	uint32_t maxdepth = s.maxdepth.load(memory_order_relaxed);
+	while (depth > maxdepth && !s.maxdepth.compare_exchange_weak(maxdepth,depth,memory_order_relaxed))
+		;
+}
+
+void EventQueueStats::dequeued(EVENT_SOURCE source, uint64_t wait)
+{
+	eventsourcestats& s = sources[source];
+	s.depth.fetch_sub(1,memory_order_relaxed);
+	s.count.fetch_add(1,memory_order_relaxed);
+	s.totalwait.fetch_add(wait,memory_order_relaxed);
+	uint64_t maxwait = s.maxwait.load(memory_order_relaxed);
+	while (wait > maxwait && !s.maxwait.compare_exchange_weak(maxwait,wait,memory_order_relaxed))
+		;
+}
+
+void EventQueueStats::log(const char* queuename) const
+{
+	static const char* sourcenames[EVENTSOURCE_COUNT] = { "other", "vm", "render", "input", "timer", "threadpool" };
+	for (uint32_t i = 0; i < EVENTSOURCE_COUNT; i++)
+	{
+		const eventsourcestats& s = sources[i];
+		uint64_t count = s.count.load(memory_order_relaxed);
+		if (count == 0)
+			continue;
+		LOG(LOG_INFO,queuename<<" events from "<<sourcenames[i]<<": "<<count<<" events, max depth "<<s.maxdepth.load(memory_order_relaxed)
+			<<", wait avg "<<s.totalwait.load(memory_order_relaxed)/count<<"us max "<<s.maxwait.load(memory_order_relaxed)<<"us");
+	}
+}
@@ -0,0 +1,211 @@
+/**************************************************************************
+    Lightspark, a free flash player implementation
+
+    Copyright (C) 2009-2013  Alessandro Pignotti (a.pignotti@sssup.it)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+#ifndef SCRIPTING_EVENTQUEUE_H
+#define SCRIPTING_EVENTQUEUE_H 1
+
+#include <atomic>
+#include <deque>
+#include <new>
+#include <glib.h>
+#include "compat.h"
+#include "threading.h"
+
+namespace lightspark
+{
+
+enum EVENT_SOURCE { EVENTSOURCE_OTHER=0, EVENTSOURCE_VM, EVENTSOURCE_RENDER, EVENTSOURCE_INPUT, EVENTSOURCE_TIMER, EVENTSOURCE_THREADPOOL, EVENTSOURCE_COUNT };
+
+// marks the calling thread as producer of events of the given source, used for the event queue statistics
+void setEventSource(EVENT_SOURCE source);
+EVENT_SOURCE getEventSource();
+
+struct eventsourcestats
+{
+	// number of events currently in the queue
+	std::atomic<uint32_t> depth;
+	std::atomic<uint32_t> maxdepth;
+	std::atomic<uint64_t> count;
+	// time in microseconds the events waited until the consumer took them from the queue
+	std::atomic<uint64_t> totalwait;
+	std::atomic<uint64_t> maxwait;
+	eventsourcestats():depth(0),maxdepth(0),count(0),totalwait(0),maxwait(0) {}
+};
+
+class EventQueueStats
+{
+private:
+	eventsourcestats sources[EVENTSOURCE_COUNT];
+public:
+	void enqueued(EVENT_SOURCE source);
+	void dequeued(EVENT_SOURCE source, uint64_t wait);
+	const eventsourcestats& get(EVENT_SOURCE source) const { return sources[source]; }
+	void log(const char* queuename) const;
+};
+
+/*
+ * Bounded lock-free multi producer queue for events (a ring of sequence numbered cells).
+ * Producers never block: if the ring is full the entry is appended to an overflow list under a mutex,
+ * and all producers use the overflow list until the consumer emptied it, so the order of the entries of a producer is kept.
+ * Only one consumer may call drainTo() at a time, the owner of the queue ensures that by holding its own mutex.
+ * The consumer announces that it is going to sleep with setConsumerWaiting(), push() returns true
+ * if the consumer has to be woken up, so producers only touch the condition variable if somebody is waiting on it.
+ */
+template<class T>
+class EventQueue
+{
+private:
+	struct cell
+	{
+		std::atomic<uint32_t> sequence;
+		uint32_t source;
+		gint64 time;
+		alignas(T) unsigned char data[sizeof(T)];
+	};
+	struct overflowentry
+	{
+		T data;
+		uint32_t source;
+		gint64 time;
+	};
+	cell* cells;
+	uint32_t mask;
+	std::atomic<uint32_t> enqueuepos;
+	uint32_t dequeuepos;
+	Mutex overflowmutex;
+	std::deque<overflowentry> overflow;
+	std::atomic<bool> overflowing;
+	std::atomic<bool> consumerwaiting;
+	bool pushRing(const T& v, uint32_t source, gint64 time)
+	{
+		uint32_t pos = enqueuepos.load(std::memory_order_relaxed);
+		while (true)
+		{
+			cell* c = &cells[pos&mask];
+			int32_t diff = int32_t(c->sequence.load(std::memory_order_acquire)-pos);
+			if (diff == 0)
+			{
+				if (enqueuepos.compare_exchange_weak(pos,pos+1,std::memory_order_relaxed))
+				{
+					new (c->data) T(v);
+					c->source = source;
+					c->time = time;
+					c->sequence.store(pos+1,std::memory_order_release);
+					return true;
+				}
+			}
+			else if (diff < 0)
+				return false; // full
+			else
+				pos = enqueuepos.load(std::memory_order_relaxed);
+		}
+	}
+	template<class C>
+	uint32_t drainRing(C& out, gint64 now)
+	{
+		uint32_t n = 0;
+		while (true)
+		{
+			cell* c = &cells[dequeuepos&mask];
+			if (int32_t(c->sequence.load(std::memory_order_acquire)-(dequeuepos+1)) < 0)
+				break;
+			T* v = reinterpret_cast<T*>(c->data);
+			out.push_back(*v);
+			v->~T();
+			stats.dequeued(EVENT_SOURCE(c->source),now-c->time);
+			c->sequence.store(dequeuepos+mask+1,std::memory_order_release);
+			dequeuepos++;
+			n++;
+		}
+		return n;
+	}
+public:
+	EventQueueStats stats;
+	// capacity has to be a power of two
+	EventQueue(uint32_t capacity=256):cells(new cell[capacity]),mask(capacity-1),enqueuepos(0),dequeuepos(0),overflowing(false),consumerwaiting(false)
+	{
+		for (uint32_t i = 0; i < capacity; i++)
+			cells[i].sequence.store(i,std::memory_order_relaxed);
+	}
+	~EventQueue()
+	{
+		std::deque<T> tmp;
+		drainTo(tmp);
+		delete[] cells;
+	}
+	// adds an entry, returns true if the consumer is waiting and has to be signalled
+	bool push(const T& v)
+	{
+		uint32_t source = getEventSource();
+		gint64 time = g_get_monotonic_time();
+		stats.enqueued(EVENT_SOURCE(source));
+		if (overflowing.load(std::memory_order_acquire) || !pushRing(v,source,time))
+		{
+			Locker l(overflowmutex);
+			// the overflow may have been emptied in the meantime
+			if (overflowing.load(std::memory_order_relaxed) || !pushRing(v,source,time))
+			{
+				overflow.push_back(overflowentry{v,source,time});
+				overflowing.store(true,std::memory_order_release);
+			}
+		}
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		return consumerwaiting.load(std::memory_order_relaxed);
+	}
+	// moves all available entries to the back of out, returns the number of moved entries
+	template<class C>
+	uint32_t drainTo(C& out)
+	{
+		gint64 now = g_get_monotonic_time();
+		uint32_t n = drainRing(out,now);
+		if (overflowing.load(std::memory_order_acquire))
+		{
+			Locker l(overflowmutex);
+			// entries that were added to the ring before the overflow started
+			n += drainRing(out,now);
+			for (auto it = overflow.begin(); it != overflow.end(); it++)
+			{
+				out.push_back(it->data);
+				stats.dequeued(EVENT_SOURCE(it->source),now-it->time);
+				n++;
+			}
+			overflow.clear();
+			overflowing.store(false,std::memory_order_release);
+		}
+		return n;
+	}
+	// has to be called by the consumer with the mutex held that is used for waiting
+	void setConsumerWaiting(bool waiting)
+	{
+		consumerwaiting.store(waiting,std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+	}
+	bool empty() const
+	{
+		return int32_t(cells[dequeuepos&mask].sequence.load(std::memory_order_acquire)-(dequeuepos+1)) < 0 && !overflowing.load(std::memory_order_acquire);
+	}
+	// approximate number of entries in the queue
+	uint32_t size() const
+	{
+		return enqueuepos.load(std::memory_order_relaxed)-dequeuepos;
+	}
+};
+
+}
+#endif /* SCRIPTING_EVENTQUEUE_H */
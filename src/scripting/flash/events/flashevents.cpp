@@ -643,7 +643,7 @@ void IOErrorEvent::sinit(Class_base* c)
 	c->setVariableAtomByQName("STANDARD_OUTPUT_IO_ERROR",nsNameAndKind(),asAtomHandler::fromString(c->getSystemState(),"standardOutputIoError"),CONSTANT_TRAIT);
 }
 
-EventDispatcher::EventDispatcher(ASWorker* wrk, Class_base* c):ASObject(wrk,c),forcedTarget(asAtomHandler::invalidAtom)
+EventDispatcher::EventDispatcher(ASWorker* wrk, Class_base* c):ASObject(wrk,c),listenedEventsMask(0),forcedTarget(asAtomHandler::invalidAtom)
 {
 }
 
@@ -666,7 +666,7 @@ bool EventDispatcher::countCylicMemberReferences(garbagecollectorstate& gcstate)
 	bool ret = ASObject::countCylicMemberReferences(gcstate);
 	for (auto it = handlers.begin(); it != handlers.end(); it++)
 	{
-		for (auto it2 = it->second.begin(); it2 != it->second.end(); it2++)
+		for (auto it2 = it->listeners.begin(); it2 != it->listeners.end(); it2++)
 			ret = asAtomHandler::getObjectNoCheck((*it2).f)->countAllCylicMemberReferences(gcstate) || ret;
 	}
 	return ret;
@@ -683,8 +683,7 @@ void EventDispatcher::prepareShutdown()
 	auto it=handlers.begin();
 	while(it!=handlers.end())
 	{
-		auto it2 = it->second.begin();
-		while (it2 != it->second.end())
+		for (auto it2 = it->listeners.begin(); it2 != it->listeners.end(); it2++)
 		{
 			ASObject* f = asAtomHandler::getObject((*it2).f);
 			if (f)
@@ -692,25 +691,40 @@ void EventDispatcher::prepareShutdown()
 				f->prepareShutdown();
 				f->removeStoredMember();
 			}
-			it2 = it->second.erase(it2);
 		}
+		it->listeners.clear();
 		it++;
 	}
 }
 void EventDispatcher::clearEventListeners()
+{
+	std::vector<eventhandlers> tmphandlers;
+	tmphandlers.swap(handlers);
+	RELEASE_WRITE(listenedEventsMask,0);
+	for (auto it = tmphandlers.begin(); it != tmphandlers.end(); it++)
+	{
+		for (auto it2 = it->listeners.begin(); it2 != it->listeners.end(); it2++)
+			asAtomHandler::as<IFunction>((*it2).f)->removeStoredMember();
+	}
+}
+
+std::vector<eventhandlers>::iterator EventDispatcher::findHandlers(uint32_t nameId)
 {
 	auto it=handlers.begin();
-	while(it!=handlers.end())
+	for(;it!=handlers.end();++it)
 	{
-		auto it2 = it->second.begin();
-		while (it2 != it->second.end())
-		{
-			IFunction* f = asAtomHandler::as<IFunction>((*it2).f);
-			it2 = it->second.erase(it2);
-			f->removeStoredMember();
-		}
-		it = handlers.erase(it);
+		if (it->nameId == nameId)
+			break;
 	}
+	return it;
+}
+
+void EventDispatcher::updateListenedEventsMask()
+{
+	uint32_t mask = 0;
+	for (auto it = handlers.begin(); it != handlers.end(); it++)
+		mask |= eventMaskBit(it->nameId);
+	RELEASE_WRITE(listenedEventsMask,mask);
 }
 
 
@@ -729,11 +743,11 @@ void EventDispatcher::sinit(Class_base* c)
 
 void EventDispatcher::dumpHandlers()
 {
-	std::map<tiny_string,list<listener> >::iterator it=handlers.begin();
+	auto it=handlers.begin();
 	for(;it!=handlers.end();++it)
 	{
-		for (auto it2 = it->second.begin();it2 != it->second.end(); it2++)
-			LOG(LOG_INFO, it->first<<":"<<asAtomHandler::toDebugString(it2->f));
+		for (auto it2 = it->listeners.begin();it2 != it->listeners.end(); it2++)
+			LOG(LOG_INFO, getSystemState()->getStringFromUniqueId(it->nameId)<<":"<<asAtomHandler::toDebugString(it2->f));
 	}
 }
 
@@ -755,11 +769,12 @@ ASFUNCTIONBODY_ATOM(EventDispatcher,addEventListener)
 		useWeakReference = asAtomHandler::Boolean_concrete(args[4]);
 
 	const tiny_string& eventName=asAtomHandler::toString(args[0],wrk);
+	uint32_t nameId=asAtomHandler::toStringId(args[0],wrk);
 	if(wrk->isPrimordial // don't register frame listeners for background workers
-			&& th->is<DisplayObject>() && (eventName=="enterFrame"
-				|| eventName=="exitFrame"
-				|| eventName=="frameConstructed"
-				|| eventName=="render") )
+			&& th->is<DisplayObject>() && (nameId==BUILTIN_STRINGS::STRING_ENTERFRAME
+				|| nameId==BUILTIN_STRINGS::STRING_EXITFRAME
+				|| nameId==BUILTIN_STRINGS::STRING_FRAMECONSTRUCTED
+				|| nameId==BUILTIN_STRINGS::STRING_RENDER) )
 	{
 		th->getSystemState()->registerFrameListener(th->as<DisplayObject>());
 	}
@@ -767,10 +782,13 @@ ASFUNCTIONBODY_ATOM(EventDispatcher,addEventListener)
 	{
 		Locker l(th->handlersMutex);
 		//Search if any listener is already registered for the event
-		list<listener>& listeners=th->handlers[eventName];
+		auto h=th->findHandlers(nameId);
+		if (h==th->handlers.end())
+			h=th->handlers.insert(h,eventhandlers(nameId));
+		std::vector<listener>& listeners=h->listeners;
 		const listener newListener(args[1], priority, useCapture, wrk);
 		//Ordered insertion
-		list<listener>::iterator insertionPoint=lower_bound(listeners.begin(),listeners.end(),newListener);
+		auto insertionPoint=lower_bound(listeners.begin(),listeners.end(),newListener);
 		IFunction* newfunc = asAtomHandler::as<IFunction>(args[1]);
 		if (useWeakReference && !newfunc->inClass)
 			LOG(LOG_NOT_IMPLEMENTED,"EventDispatcher::addEventListener parameter useWeakReference is ignored");
@@ -784,6 +802,7 @@ ASFUNCTIONBODY_ATOM(EventDispatcher,addEventListener)
 		newfunc->incRef();
 		newfunc->addStoredMember();
 		listeners.insert(insertionPoint,newListener);
+		th->listenedEventsMask.fetch_or(eventMaskBit(nameId));
 	}
 	th->eventListenerAdded(eventName);
 }
@@ -791,8 +810,7 @@ ASFUNCTIONBODY_ATOM(EventDispatcher,addEventListener)
 ASFUNCTIONBODY_ATOM(EventDispatcher,_hasEventListener)
 {
 	EventDispatcher* th=asAtomHandler::as<EventDispatcher>(obj);
-	const tiny_string& eventName=asAtomHandler::toString(args[0],wrk);
-	asAtomHandler::setBool(ret,th->hasEventListener(eventName));
+	asAtomHandler::setBool(ret,th->hasEventListener(asAtomHandler::toStringId(args[0],wrk)));
 }
 
 ASFUNCTIONBODY_ATOM(EventDispatcher,removeEventListener)
@@ -804,7 +822,7 @@ ASFUNCTIONBODY_ATOM(EventDispatcher,removeEventListener)
 	if(!asAtomHandler::isString(args[0]) || !asAtomHandler::isFunction(args[1]))
 		throw RunTimeException("Type mismatch in EventDispatcher::removeEventListener");
 
-	const tiny_string& eventName=asAtomHandler::toString(args[0],wrk);
+	uint32_t nameId=asAtomHandler::toStringId(args[0],wrk);
 
 	bool useCapture=false;
 	if(argslen>=3)
@@ -812,7 +830,7 @@ ASFUNCTIONBODY_ATOM(EventDispatcher,removeEventListener)
 
 	{
 		Locker l(th->handlersMutex);
-		map<tiny_string, list<listener> >::iterator h=th->handlers.find(eventName);
+		auto h=th->findHandlers(nameId);
 		if(h==th->handlers.end())
 		{
 			LOG(LOG_CALLS,"Event not found");
@@ -820,25 +838,30 @@ ASFUNCTIONBODY_ATOM(EventDispatcher,removeEventListener)
 		}
 
 		const listener ls(args[1],0,useCapture,wrk);
-		std::list<listener>::iterator it=find(h->second.begin(),h->second.end(),ls);
-		if(it!=h->second.end())
+		auto it=find(h->listeners.begin(),h->listeners.end(),ls);
+		ASObject* listenerfunc = nullptr;
+		if(it!=h->listeners.end())
 		{
-			ASObject* listenerfunc = asAtomHandler::getObject(it->f);
+			listenerfunc = asAtomHandler::getObject(it->f);
 			assert(listenerfunc);
-			h->second.erase(it);
-			listenerfunc->removeStoredMember();
+			h->listeners.erase(it);
 		}
-		if(h->second.empty()) //Remove the entry from the map
+		if(h->listeners.empty()) //Remove the entry from the map
+		{
 			th->handlers.erase(h);
+			th->updateListenedEventsMask();
+		}
+		if (listenerfunc)
+			listenerfunc->removeStoredMember();
 	}
 
 	// Only unregister the enterFrame listener _after_ the handlers have been erased.
-	if(th->is<DisplayObject>() && (eventName=="enterFrame"
-					|| eventName=="exitFrame"
-					|| eventName=="frameConstructed")
-				&& (!th->hasEventListener("enterFrame")
-					&& !th->hasEventListener("exitFrame")
-					&& !th->hasEventListener("frameConstructed")) )
+	if(th->is<DisplayObject>() && (nameId==BUILTIN_STRINGS::STRING_ENTERFRAME
+					|| nameId==BUILTIN_STRINGS::STRING_EXITFRAME
+					|| nameId==BUILTIN_STRINGS::STRING_FRAMECONSTRUCTED)
+				&& (!th->hasEventListener(BUILTIN_STRINGS::STRING_ENTERFRAME)
+					&& !th->hasEventListener(BUILTIN_STRINGS::STRING_EXITFRAME)
+					&& !th->hasEventListener(BUILTIN_STRINGS::STRING_FRAMECONSTRUCTED)) )
 	{
 		th->getSystemState()->unregisterFrameListener(th->as<DisplayObject>());
 	}
@@ -912,15 +935,21 @@ void EventDispatcher::handleEvent(_R<Event> e)
 {
 	check();
 	e->check();
+	// most objects don't have any listeners, so we don't have to look up the id of the event type
+	if (ACQUIRE_READ(listenedEventsMask)==0)
+		return;
+	uint32_t nameId = getSystemState()->getUniqueStringId(e->type);
+	if (!mayHaveEventListener(nameId))
+		return;
 	Locker l(handlersMutex);
-	map<tiny_string, list<listener> >::iterator h=handlers.find(e->type);
+	auto h=findHandlers(nameId);
 	if(h==handlers.end())
 		return;
 
-	LOG(LOG_CALLS,"Handling event " << h->first<<" "<<e->getInstanceWorker());
+	LOG(LOG_CALLS,"Handling event " << e->type<<" "<<e->getInstanceWorker());
 
 	//Create a temporary copy of the listeners, as the list can be modified during the calls
-	vector<listener> tmpListener(h->second.begin(),h->second.end());
+	vector<listener> tmpListener(h->listeners);
 	l.release();
 	// listeners may be removed during the call to a listener, so we have to incref them before the call
 	// TODO how to handle listeners that are removed during the call to a listener, should they really be executed anyway?
@@ -959,11 +988,15 @@ void EventDispatcher::handleEvent(_R<Event> e)
 
 bool EventDispatcher::hasEventListener(const tiny_string& eventName)
 {
-	Locker l(handlersMutex);
-	if(handlers.find(eventName)==handlers.end())
+	return hasEventListener(getSystemState()->getUniqueStringId(eventName));
+}
+
+bool EventDispatcher::hasEventListener(uint32_t nameId)
+{
+	if (!mayHaveEventListener(nameId))
 		return false;
-	else
-		return true;
+	Locker l(handlersMutex);
+	return findHandlers(nameId)!=handlers.end();
 }
 
 NetStatusEvent::NetStatusEvent(ASWorker* wrk, Class_base* c, const tiny_string& level, const tiny_string& code):Event(wrk,c, "netStatus"),statuscode(code)
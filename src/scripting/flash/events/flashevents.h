@@ -330,6 +330,13 @@ public:
 	void resetClosure();
 };
 
+struct eventhandlers
+{
+	uint32_t nameId;
+	std::vector<listener> listeners;
+	eventhandlers(uint32_t _nameId):nameId(_nameId){}
+};
+
 class IEventDispatcher
 {
 public:
@@ -340,7 +347,12 @@ class EventDispatcher: public ASObject, public IEventDispatcher
 {
 private:
 	Mutex handlersMutex;
-	std::map<tiny_string,std::list<listener> > handlers;
+	// listeners by id of the event type, objects only listen to a few event types, so a flat vector is searched
+	std::vector<eventhandlers> handlers;
+	// bit (nameId&31) is set if there may be listeners for the event type with id nameId
+	ACQUIRE_RELEASE_VARIABLE(uint32_t,listenedEventsMask);
+	std::vector<eventhandlers>::iterator findHandlers(uint32_t nameId);
+	void updateListenedEventsMask();
 	/*
 	 * This will be used when a target is passed to EventDispatcher constructor
 	 */
@@ -362,6 +374,10 @@ public:
 	void handleEvent(_R<Event> e);
 	void dumpHandlers();
 	bool hasEventListener(const tiny_string& eventName);
+	bool hasEventListener(uint32_t nameId);
+	static uint32_t eventMaskBit(uint32_t nameId) { return 1U<<(nameId&31); }
+	// check without locking that may return true even if there is no listener, used to skip the dispatch of unlistened events
+	bool mayHaveEventListener(uint32_t nameId) const { return ACQUIRE_READ(listenedEventsMask) & eventMaskBit(nameId); }
 	virtual void defaultEventBehavior(_R<Event> e) {}
 	virtual void afterExecution(_R<Event> e) {}
 	ASFUNCTION_ATOM(_constructor);
@@ -570,6 +586,14 @@ public:
 	EVENT_TYPE getEventType() const override { return IDLE_EVENT; }
 };
 
+//Event added after a batch of events, it is signalled when the vm has handled all events of the batch
+class SyncEvent: public WaitableEvent
+{
+public:
+	SyncEvent(): WaitableEvent("SyncEvent") {}
+	EVENT_TYPE getEventType() const override { return SYNC; }
+};
+
 class FlushEventBufferEvent: public Event
 {
 friend class ABCVm;
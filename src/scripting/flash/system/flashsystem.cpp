@@ -20,6 +20,7 @@
 #include "version.h"
 #include "scripting/flash/system/flashsystem.h"
 #include "scripting/flash/utils/ByteArray.h"
+#include "scripting/flash/utils/Dictionary.h"
 #include "scripting/flash/system/messagechannel.h"
 #include "scripting/flash/errors/flasherrors.h"
 #include "scripting/flash/display/Loader.h"
@@ -27,6 +28,7 @@
 #include "scripting/argconv.h"
 #include "compat.h"
 #include "backends/security.h"
+#include "backends/config.h"
 #include "scripting/toplevel/Global.h"
 #include "scripting/toplevel/Number.h"
 #include "scripting/toplevel/UInteger.h"
@@ -1032,7 +1034,8 @@ extern uint32_t asClassCount;
 
 ASWorker::ASWorker(SystemState* s):
 	EventDispatcher(this,nullptr),parser(nullptr),
-	giveAppPrivileges(false),started(false),inGarbageCollection(false),inShutdown(false),inFinalize(false),
+	giveAppPrivileges(false),started(false),inGarbageCollection(false),inShutdown(false),inFinalize(false),eventsclosed(false),
+	gcstate(nullptr),gcstateinuse(false),gcallocationcount(0),
 	freelist(new asfreelist[asClassCount]),currentCallContext(nullptr),cur_recursion(0),isPrimordial(true),state("running"),
 	nativeExtensionCallCount(0)
 {
@@ -1044,12 +1047,12 @@ ASWorker::ASWorker(SystemState* s):
 	limits.max_recursion = 256;
 	limits.script_timeout = 20;
 	stacktrace = new stacktrace_entry[limits.max_recursion];
-	gettimeofday(&last_garbagecollection, nullptr);
 }
 
 ASWorker::ASWorker(Class_base* c):
 	EventDispatcher(c->getSystemState()->worker,c),parser(nullptr),
-	giveAppPrivileges(false),started(false),inGarbageCollection(false),inShutdown(false),inFinalize(false),
+	giveAppPrivileges(false),started(false),inGarbageCollection(false),inShutdown(false),inFinalize(false),eventsclosed(false),
+	gcstate(nullptr),gcstateinuse(false),gcallocationcount(0),
 	freelist(new asfreelist[asClassCount]),currentCallContext(nullptr),cur_recursion(0),isPrimordial(false),state("new"),
 	nativeExtensionCallCount(0)
 {
@@ -1060,11 +1063,11 @@ ASWorker::ASWorker(Class_base* c):
 	limits.script_timeout = 20;
 	stacktrace = new stacktrace_entry[limits.max_recursion];
 	loader = _MR(Class<Loader>::getInstanceS(this));
-	gettimeofday(&last_garbagecollection, nullptr);
 }
 ASWorker::ASWorker(ASWorker* wrk, Class_base* c):
 	EventDispatcher(wrk,c),parser(nullptr),
-	giveAppPrivileges(false),started(false),inGarbageCollection(false),inShutdown(false),inFinalize(false),
+	giveAppPrivileges(false),started(false),inGarbageCollection(false),inShutdown(false),inFinalize(false),eventsclosed(false),
+	gcstate(nullptr),gcstateinuse(false),gcallocationcount(0),
 	freelist(new asfreelist[asClassCount]),currentCallContext(nullptr),cur_recursion(0),isPrimordial(false),state("new"),
 	nativeExtensionCallCount(0)
 {
@@ -1075,7 +1078,6 @@ ASWorker::ASWorker(ASWorker* wrk, Class_base* c):
 	limits.script_timeout = 20;
 	stacktrace = new stacktrace_entry[limits.max_recursion];
 	loader = _MR(Class<Loader>::getInstanceS(this));
-	gettimeofday(&last_garbagecollection, nullptr);
 }
 
 void ASWorker::finalize()
@@ -1138,6 +1140,14 @@ void ASWorker::finalize()
 		(*it)->prepareShutdown();
 	}
 	processGarbageCollection(true);
+	if (gcstatistics.slices)
+		LOG(LOG_INFO,"garbage collection: "<<gcstatistics.slices<<" slices, "<<gcstatistics.candidates<<" candidates, total pause "<<gcstatistics.totalpause<<"us, max pause "<<gcstatistics.maxpause<<"us");
+	for (uint32_t i = 0; i < asClassCount; i++)
+	{
+		Class_base* c = getSystemState()->builtinClasses[i];
+		if (c && freelist[i].overflows)
+			LOG(LOG_INFO,"freelist "<<c->class_name<<": "<<freelist[i].allocations<<" allocations, "<<freelist[i].reused<<" reused, "<<freelist[i].overflows<<" overflows, depth "<<freelist[i].freelistcapacity);
+	}
 	inShutdown=true;
 	if (getWorker()==this)
 		setTLSWorker(nullptr);
@@ -1252,13 +1262,22 @@ void ASWorker::execute()
 	while (true)
 	{
 		event_queue_mutex.lock();
+		events_intake.drainTo(events_queue);
 		while(events_queue.empty() && !this->threadAborting)
-			sem_event_cond.wait(event_queue_mutex);
+		{
+			events_intake.setConsumerWaiting(true);
+			// events added before the flag was set don't signal the condition
+			if (events_intake.drainTo(events_queue) == 0)
+				sem_event_cond.wait(event_queue_mutex);
+			events_intake.setConsumerWaiting(false);
+			events_intake.drainTo(events_queue);
+		}
 		processGarbageCollection(false);
 		if (this->threadAborting)
 		{
 			if(events_queue.empty())
 			{
+				eventsclosed=true;
 				event_queue_mutex.unlock();
 				break;
 			}
@@ -1302,11 +1321,10 @@ void ASWorker::execute()
 		}
 		if (threadAborting)
 		{
-			while(!events_queue.empty())
-			{
-				_R<Event> e=events_queue.front().second;
-				events_queue.pop_front();
-			}
+			event_queue_mutex.lock();
+			eventsclosed=true;
+			signalQueuedEvents();
+			event_queue_mutex.unlock();
 			threadAbort();
 			started = false;
 		}
@@ -1346,13 +1364,39 @@ bool ASWorker::addEvent(_NR<EventDispatcher> obj, _R<Event> ev)
 			obj->afterHandleEvent(ev.getPtr());
 		return false;
 	}
-	Locker l(event_queue_mutex);
-	events_queue.push_back(pair<_NR<EventDispatcher>,_R<Event>>(obj, ev));
 	RELEASE_WRITE(ev->queued,true);
-	sem_event_cond.signal();
+	if (events_intake.push(pair<_NR<EventDispatcher>,_R<Event>>(obj, ev)))
+	{
+		Locker l(event_queue_mutex);
+		sem_event_cond.signal();
+	}
+	// the worker may have started aborting after the check above
+	if (this->threadAborting && rejectLateEvents())
+		return false;
 	return true;
 }
 
+void ASWorker::signalQueuedEvents()
+{
+	events_intake.drainTo(events_queue);
+	while(!events_queue.empty())
+	{
+		_R<Event> e=events_queue.front().second;
+		events_queue.pop_front();
+		if(e->is<WaitableEvent>())
+			e->as<WaitableEvent>()->signal();
+	}
+}
+
+bool ASWorker::rejectLateEvents()
+{
+	Locker l(event_queue_mutex);
+	// until the worker thread stopped handling events it also handles the late ones
+	if (eventsclosed)
+		signalQueuedEvents();
+	return eventsclosed;
+}
+
 tiny_string ASWorker::getDefaultXMLNamespace() const
 {
 	return getSystemState()->getStringFromUniqueId(currentCallContext ? currentCallContext->defaultNamespaceUri : (uint32_t)BUILTIN_STRINGS::EMPTY);
@@ -1376,21 +1420,21 @@ void ASWorker::dumpStacktrace()
 	}
 	LOG(LOG_INFO,"current stacktrace:\n" << strace);
 }
-void ASWorker::processGarbageCollection(bool force)
-{
-	struct timeval currtime;
-	gettimeofday(&currtime, nullptr);
-	int diff =  last_garbagecollection.tv_sec-currtime.tv_sec;
-	if (!force && diff < 10) // ony execute garbagecollection every 10 seconds
-		return;
-	last_garbagecollection = currtime;
-	inGarbageCollection=true;
-	while (!garbagecollection.empty())
+// number of candidates processed between two checks of the time budget of a slice
+#define GC_BATCH_SIZE 64
+uint32_t ASWorker::collectGarbageBatch()
+{
+	// the candidates stay in the set until they are handled, as handling a candidate may destroy other candidates
+	std::vector<ASObject*> batch;
+	for (auto it = garbagecollection.begin(); it != garbagecollection.end() && batch.size() < GC_BATCH_SIZE; it++)
+		batch.push_back(*it);
+	// first check the whole batch with one traversal, the candidates it can't decide are checked one by one
+	ASObject::handleGarbageCollectionBatch(this,batch);
+	for (auto it = batch.begin(); it != batch.end(); it++)
 	{
-		auto it = garbagecollection.begin();
 		ASObject* o = *it;
-		garbagecollection.erase(it);
-		o->handleGarbageCollection();
+		if (o && garbagecollection.erase(o))
+			o->handleGarbageCollection();
 		while (!garbagecollectiondeleted.empty())
 		{
 			auto it = garbagecollectiondeleted.begin();
@@ -1400,7 +1444,68 @@ void ASWorker::processGarbageCollection(bool force)
 			o->decRef();
 		}
 	}
+	return batch.size();
+}
+void ASWorker::trimFreeLists()
+{
+	for (uint32_t i = 0; i < asClassCount; i++)
+		freelist[i].trim();
+	freelist_syntheticfunction.trim();
+}
+void ASWorker::processGarbageCollection(bool force)
+{
+	if (inGarbageCollection)
+		return;
+	// the collector is paced by the number of allocated objects, a slice is only run if enough objects were allocated since the last one.
+	// if the previous slice ran out of time, the remaining candidates are processed in the next slice
+	const Config* config = Config::getConfig();
+	if (!force && gcallocationcount.load(std::memory_order_relaxed) < config->getGCAllocationThreshold())
+		return;
+	uint64_t starttime = g_get_monotonic_time();
+	// the freelists are trimmed at the same pace, also if there are no candidates to collect
+	if (!force)
+		trimFreeLists();
+	// the dead keys of weak dictionaries are removed at the same pace
+	collectWeakKeys();
+	if (garbagecollection.empty())
+	{
+		gcallocationcount.store(0,std::memory_order_relaxed);
+		return;
+	}
+	uint64_t deadline = starttime+config->getGCSliceTime()*1000;
+	uint64_t now = starttime;
+	inGarbageCollection=true;
+	do
+	{
+		gcstatistics.candidates += collectGarbageBatch();
+		now = g_get_monotonic_time();
+	}
+	while (!garbagecollection.empty() && (force || now < deadline));
 	inGarbageCollection=false;
+	if (garbagecollection.empty())
+		gcallocationcount.store(0,std::memory_order_relaxed);
+	uint64_t pause = now-starttime;
+	gcstatistics.slices++;
+	gcstatistics.totalpause += pause;
+	if (pause > gcstatistics.maxpause)
+		gcstatistics.maxpause = pause;
+	LOG(LOG_CALLS,"garbage collection slice took "<<pause<<"us, "<<garbagecollection.size()<<" candidates left");
+}
+
+void ASWorker::collectWeakKeys()
+{
+	if (weakdictionaries.empty())
+		return;
+	// removing a key may destroy other dictionaries, so the set is copied and every dictionary is checked before it is swept
+	std::vector<Dictionary*> dictionaries(weakdictionaries.begin(),weakdictionaries.end());
+	for (auto it = dictionaries.begin(); it != dictionaries.end(); it++)
+	{
+		if (weakdictionaries.find(*it) == weakdictionaries.end())
+			continue;
+		(*it)->incRef();
+		(*it)->collectWeakKeys();
+		(*it)->decRef();
+	}
 }
 
 void ASWorker::registerConstantRef(ASObject* obj)
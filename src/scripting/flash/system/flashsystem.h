@@ -25,6 +25,7 @@
 #include "asobject.h"
 #include "threading.h"
 #include "scripting/abcutils.h"
+#include "scripting/eventqueue.h"
 #include "scripting/flash/utils/ByteArray.h"
 #include "scripting/toplevel/Error.h"
 #include "scripting/flash/events/flashevents.h"
@@ -322,6 +323,15 @@ public:
 class WorkerDomain;
 class ParseThread;
 class Prototype;
+// pause times of the cycle collector of a worker
+struct garbagecollectionstatistics
+{
+	uint64_t slices; // number of collector runs
+	uint64_t candidates; // number of candidate objects checked
+	uint64_t totalpause; // time spent in the collector in microseconds
+	uint64_t maxpause; // longest single run in microseconds
+	garbagecollectionstatistics():slices(0),candidates(0),totalpause(0),maxpause(0) {}
+};
 class ASWorker: public EventDispatcher, public IThreadJob
 {
 friend class WorkerDomain;
@@ -341,11 +351,30 @@ private:
 	Cond sem_event_cond;
 	typedef std::pair<_NR<EventDispatcher>,_R<Event>> eventType;
 	std::deque<eventType> events_queue;
+	// events added by addEvent(), moved to events_queue by the worker thread
+	EventQueue<eventType> events_intake;
+	// set with event_queue_mutex held once the worker thread stopped handling events
+	bool eventsclosed;
+	// removes the queued events and signals the waitable ones, event_queue_mutex has to be locked
+	void signalQueuedEvents();
+	// called by producers that found the worker aborting after they added an event, returns true if the event won't be handled
+	bool rejectLateEvents();
 	map<const Class_base*,_R<Prototype>> protoypeMap;
 	std::unordered_set<ASObject*> garbagecollection;
 	std::unordered_set<ASObject*> garbagecollectiondeleted;
 	std::unordered_set<ASObject*> constantrefs;
-	struct timeval last_garbagecollection;
+	// dictionaries with weak keys, their dead keys are removed by the collector
+	std::unordered_set<Dictionary*> weakdictionaries;
+	void collectWeakKeys();
+	// traversal state shared by all candidates of a batch
+	garbagecollectorstate gcstate;
+	bool gcstateinuse;
+	// objects allocated since the last collector slice, used to pace the collector
+	// objects may be created on any thread, so it is only updated and read with relaxed ordering
+	std::atomic<uint32_t> gcallocationcount;
+	garbagecollectionstatistics gcstatistics;
+	uint32_t collectGarbageBatch();
+	void trimFreeLists();
 	std::vector<ABCContext*> contexts;
 public:
 	asfreelist* freelist;
@@ -364,6 +393,8 @@ public:
 	abc_limits limits;
 	std::vector<call_context*> callStack;
 	call_context* currentCallContext;
+	// memory for the call frames of SyntheticFunction::call
+	callstackarena callstack;
 	/* The current recursion level. Each call increases this by one,
 	 * each return from a call decreases this. */
 	uint32_t cur_recursion;
@@ -415,7 +446,33 @@ public:
 		garbagecollection.erase(o);
 		garbagecollectiondeleted.erase(o);
 	}
+	void addWeakDictionary(Dictionary* d)
+	{
+		weakdictionaries.insert(d);
+	}
+	void removeWeakDictionary(Dictionary* d)
+	{
+		weakdictionaries.erase(d);
+	}
+	/* runs a slice of the incremental cycle collector if enough objects were allocated since the last slice.
+	 * If force is true, all pending candidates are processed */
 	void processGarbageCollection(bool force);
+	FORCE_INLINE void countAllocation() { gcallocationcount.fetch_add(1,std::memory_order_relaxed); }
+	/* returns the shared traversal state, or nullptr if it is already in use */
+	garbagecollectorstate* acquireGarbageCollectorState(ASObject* startobj)
+	{
+		if (gcstateinuse)
+			return nullptr;
+		gcstateinuse=true;
+		gcstate.reset(startobj);
+		return &gcstate;
+	}
+	void releaseGarbageCollectorState(garbagecollectorstate* state)
+	{
+		if (state == &gcstate)
+			gcstateinuse=false;
+	}
+	const garbagecollectionstatistics& getGarbageCollectionStatistics() const { return gcstatistics; }
 	FORCE_INLINE bool isInGarbageCollection() const { return inGarbageCollection; }
 	FORCE_INLINE bool isDeletedInGarbageCollection(ASObject* o) const
 	{
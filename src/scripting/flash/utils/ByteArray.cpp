@@ -183,8 +183,11 @@ uint8_t* ByteArray::getBufferIntern(unsigned int size, bool enableResize)
 #ifdef MEMORY_USAGE_PROFILING
 		uint32_t prev_real_len = real_len;
 #endif
-		while(real_len < size)
-			real_len += BA_CHUNK_SIZE;
+		// grow by at least half of the current size, so that appending many small values
+		// (like the serializer does) doesn't copy the buffer over and over again
+		uint64_t newlen = max(uint64_t(size),uint64_t(real_len)+real_len/2);
+		newlen = min(uint64_t(BA_MAX_SIZE),(newlen+BA_CHUNK_SIZE-1)/BA_CHUNK_SIZE*BA_CHUNK_SIZE);
+		real_len = max(uint32_t(newlen),size);
 		// Reallocate the buffer, in chunks of BA_CHUNK_SIZE bytes
 		uint8_t* bytes2 = new uint8_t[real_len];
 		assert_and_throw(bytes2);
@@ -564,9 +567,9 @@ uint32_t ByteArray::writeObject(ASObject* obj, ASWorker* wrk)
 	//Return the length of the serialized object
 
 	//TODO: support custom serialization
-	map<tiny_string, uint32_t> stringMap;
-	map<const ASObject*, uint32_t> objMap;
-	map<const Class_base*, uint32_t> traitsMap;
+	amf3stringtable stringMap;
+	amf3objecttable objMap;
+	amf3traitstable traitsMap;
 	uint32_t oldPosition=position;
 	obj->serialize(this, stringMap, objMap,traitsMap,wrk);
 	return position-oldPosition;
@@ -576,9 +579,9 @@ uint32_t ByteArray::writeAtomObject(asAtom obj, ASWorker* wrk)
 	//Return the length of the serialized object
 
 	//TODO: support custom serialization
-	map<tiny_string, uint32_t> stringMap;
-	map<const ASObject*, uint32_t> objMap;
-	map<const Class_base*, uint32_t> traitsMap;
+	amf3stringtable stringMap;
+	amf3objecttable objMap;
+	amf3traitstable traitsMap;
 	uint32_t oldPosition=position;
 	asAtomHandler::serialize(this,stringMap,objMap,traitsMap,wrk,obj);
 	return position-oldPosition;
@@ -606,9 +609,9 @@ void ByteArray::writeSharedObject(ASObject* obj, const tiny_string& name, ASWork
 	writeByte(0x00);
 	writeByte(0x03);// always store as AMF3
 
-	map<tiny_string, uint32_t> stringMap;
-	map<const ASObject*, uint32_t> objMap;
-	map<const Class_base*, uint32_t> traitsMap;
+	amf3stringtable stringMap;
+	amf3objecttable objMap;
+	amf3traitstable traitsMap;
 	obj->serializeDynamicProperties(this, stringMap, objMap,traitsMap,wrk,true,true);
 	setPosition(sizepos);
 	writeUnsignedInt(GUINT32_TO_BE(getLength()-6));
@@ -1314,36 +1317,72 @@ void ByteArray::acquireBuffer(uint8_t* buf, int bufLen)
 
 void ByteArray::writeU29(uint32_t val)
 {
-	for(uint32_t i=0;i<4;i++)
+	//The most significant bits are written first, the last byte of the 4 byte form contains 8 bits
+	val &= 0x1fffffff;
+	uint8_t b[4];
+	uint32_t count;
+	if(val < 0x80)
 	{
-		uint8_t b;
-		if(i<3)
-		{
-			uint32_t tmp=(val >> ((3-i)*7));
-			if(tmp==0)
-				continue;
-
-			b=(tmp&0x7f)|0x80;
-		}
-		else
-			b=val&0x7f;
-		writeByte(b);
+		b[0]=val;
+		count=1;
+	}
+	else if(val < 0x4000)
+	{
+		b[0]=(val >> 7)|0x80;
+		b[1]=val&0x7f;
+		count=2;
 	}
+	else if(val < 0x200000)
+	{
+		b[0]=(val >> 14)|0x80;
+		b[1]=((val >> 7)&0x7f)|0x80;
+		b[2]=val&0x7f;
+		count=3;
+	}
+	else
+	{
+		b[0]=(val >> 22)|0x80;
+		b[1]=((val >> 15)&0x7f)|0x80;
+		b[2]=((val >> 8)&0x7f)|0x80;
+		b[3]=val&0xff;
+		count=4;
+	}
+	writeBytes(b,count);
 }
 
 void ByteArray::serializeDouble(number_t val)
 {
 	//We have to write the double in network byte order (big endian)
-	const uint64_t* tmpPtr=reinterpret_cast<const uint64_t*>(&val);
-	uint64_t bigEndianVal=GINT64_FROM_BE(*tmpPtr);
-	uint8_t* bigEndianPtr=reinterpret_cast<uint8_t*>(&bigEndianVal);
-		
-	for(uint32_t i=0;i<8;i++)
-		writeByte(bigEndianPtr[i]);
-	
+	uint64_t bigEndianVal;
+	memcpy(&bigEndianVal,&val,8);
+	bigEndianVal=GINT64_TO_BE(bigEndianVal);
+	writeBytes(reinterpret_cast<uint8_t*>(&bigEndianVal),8);
 }
 
-void ByteArray::writeStringVR(map<tiny_string, uint32_t>& stringMap, const tiny_string& s)
+void ByteArray::reserve(uint32_t size)
+{
+	if(size <= real_len)
+		return;
+	uint32_t prevLen=len;
+	if(getBufferIntern(size,true))
+		len=prevLen;
+}
+
+uint8_t* ByteArray::reserveWrite(uint64_t size)
+{
+	if(position+size > BA_MAX_SIZE)
+	{
+		createError<ASError>(getInstanceWorker(), kOutOfMemoryError);
+		return nullptr;
+	}
+	if(!getBuffer(position+size,true))
+		return nullptr;
+	uint8_t* ret=bytes+position;
+	position+=size;
+	return ret;
+}
+
+void ByteArray::writeStringVR(amf3stringtable& stringMap, const tiny_string& s)
 {
 	const uint32_t len=s.numBytes();
 	if(len >= 1<<28)
@@ -1353,19 +1392,19 @@ void ByteArray::writeStringVR(map<tiny_string, uint32_t>& stringMap, const tiny_
 	}
 
 	//Check if the string is already in the map
-	auto it=stringMap.find(s);
-	if(it!=stringMap.end())
+	uint32_t ref=len ? stringMap.find(s) : amf3stringtable::npos;
+	if(ref!=amf3stringtable::npos)
 	{
 		//The first bit must be 0, the next 29 bits
 		//store the index of the string in the map
-		writeU29(it->second << 1);
+		writeU29(ref << 1);
 	}
 	else
 	{
 		//The AMF3 spec says that the empty string is never sent by reference
 		//So add the string to the map only if it's not the empty string
 		if(len)
-			stringMap.insert(make_pair(s, stringMap.size()));
+			stringMap.add(s);
 
 		//The first bit must be 1, the next 29 bits
 		//store the number of bytes of the string
@@ -1394,7 +1433,7 @@ void ByteArray::writeStringAMF0(const tiny_string& s)
 	}
 }
 
-void ByteArray::writeXMLString(std::map<const ASObject*, uint32_t>& objMap,
+void ByteArray::writeXMLString(amf3objecttable& objMap,
 			       ASObject *xml,
 			       const tiny_string& xmlstr)
 {
@@ -1405,16 +1444,16 @@ void ByteArray::writeXMLString(std::map<const ASObject*, uint32_t>& objMap,
 	}
 
 	//Check if the XML object has been already serialized
-	auto it=objMap.find(xml);
-	if(it!=objMap.end())
+	uint32_t ref=objMap.find(xml);
+	if(ref!=amf3objecttable::npos)
 	{
 		//The least significant bit is 0 to signal a reference
-		writeU29(it->second << 1);
+		writeU29(ref << 1);
 	}
 	else
 	{
 		//Add the XML object to the map
-		objMap.insert(make_pair(xml, objMap.size()));
+		objMap.add(xml);
 
 		//The first bit must be 1, the next 29 bits
 		//store the number of bytes of the string
@@ -1721,34 +1760,39 @@ ASFUNCTIONBODY_ATOM(ByteArray,_toJSON)
 	ret = asAtomHandler::fromString(wrk->getSystemState(),"ByteArray");
 }
 
-void ByteArray::serialize(ByteArray* out, std::map<tiny_string, uint32_t>& stringMap,
-				std::map<const ASObject*, uint32_t>& objMap,
-				std::map<const Class_base*, uint32_t>& traitsMap,ASWorker* wrk)
+void ByteArray::serialize(ByteArray* out, amf3stringtable& stringMap,
+				amf3objecttable& objMap,
+				amf3traitstable& traitsMap,ASWorker* wrk)
 {
 	if (out->getObjectEncoding() == OBJECT_ENCODING::AMF0)
 	{
 		LOG(LOG_NOT_IMPLEMENTED,"serializing ByteArray in AMF0 not implemented");
 		return;
 	}
-	assert_and_throw(objMap.find(this)==objMap.end());
+	assert_and_throw(objMap.find(this)==amf3objecttable::npos);
 	out->writeByte(byte_array_marker);
 	//Check if the bytearray has been already serialized
-	auto it=objMap.find(this);
-	if(it!=objMap.end())
+	uint32_t ref=objMap.find(this);
+	if(ref!=amf3objecttable::npos)
 	{
 		//The least significant bit is 0 to signal a reference
-		out->writeU29(it->second << 1);
+		out->writeU29(ref << 1);
 	}
 	else
 	{
 		//Add the dictionary to the map
-		objMap.insert(make_pair(this, objMap.size()));
+		objMap.add(this);
 
 		assert_and_throw(len<0x20000000);
 		uint32_t value = (len << 1) | 1;
 		out->writeU29(value);
-		// TODO faster implementation
-		for (unsigned int i = 0; i < len; i++)
-			out->writeByte(this->bytes[i]);
+		if (out == this)
+		{
+			// the buffer may be reallocated while writing
+			std::vector<uint8_t> tmp(bytes,bytes+len);
+			out->writeBytes(tmp.data(),tmp.size());
+		}
+		else if (len)
+			out->writeBytes(bytes,len);
 	}
 }
@@ -128,11 +128,15 @@ public:
 	uint32_t writeObject(ASObject* obj,ASWorker* wrk);
 	uint32_t writeAtomObject(asAtom obj,ASWorker* wrk);
 	void writeSharedObject(ASObject* obj, const tiny_string& name, ASWorker* wrk);
-	void writeStringVR(std::map<tiny_string, uint32_t>& stringMap, const tiny_string& s);
+	void writeStringVR(amf3stringtable& stringMap, const tiny_string& s);
 	void writeStringAMF0(const tiny_string& s);
-	void writeXMLString(std::map<const ASObject*, uint32_t>& objMap, ASObject *xml, const tiny_string& s);
+	void writeXMLString(amf3objecttable& objMap, ASObject *xml, const tiny_string& s);
 	void writeU29(uint32_t val);
 	void serializeDouble(number_t val);
+	// makes sure the buffer can hold size bytes without changing the length
+	void reserve(uint32_t size);
+	// returns a pointer to size bytes at the current position and moves the position behind them, nullptr on error
+	uint8_t* reserveWrite(uint64_t size);
 
 	void setLength(uint32_t newLen);
 	FORCE_INLINE uint32_t getPosition() const
@@ -290,9 +294,9 @@ public:
 	void setVariableByMultiname_i(multiname& name, int32_t value,ASWorker* wrk) override;
 	bool hasPropertyByMultiname(const multiname& name, bool considerDynamic, bool considerPrototype, ASWorker* wrk) override;
 
-	void serialize(ByteArray* out, std::map<tiny_string, uint32_t>& stringMap,
-				std::map<const ASObject*, uint32_t>& objMap,
-				std::map<const Class_base*, uint32_t>& traitsMap, ASWorker* wrk) override;
+	void serialize(ByteArray* out, amf3stringtable& stringMap,
+				amf3objecttable& objMap,
+				amf3traitstable& traitsMap, ASWorker* wrk) override;
 };
 
 }
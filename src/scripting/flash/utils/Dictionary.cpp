@@ -26,53 +26,89 @@
 #include "scripting/flash/errors/flasherrors.h"
 #include "scripting/flash/utils/Dictionary.h"
 #include "scripting/flash/utils/ByteArray.h"
+#include <algorithm>
 
 using namespace std;
 using namespace lightspark;
 
+// minimum size of the hash table
+#define DICTIONARY_MIN_SLOTS 16
+// number of slots migrated to the new hash table on every modification while the table is growing
+#define DICTIONARY_REHASH_STEP 32
+// number of entries checked for dead weak keys in every collector slice
+#define DICTIONARY_SWEEP_STEP 64
+// entries are renumbered when the ids reach this value, so the indices of the dynamic properties in for-in loops don't overflow
+#define DICTIONARY_MAX_ID 0x40000000
+
 Dictionary::Dictionary(ASWorker* wrk,Class_base* c):ASObject(wrk,c,T_OBJECT,SUBTYPE_DICTIONARY),
-	data(std::less<dictType::key_type>(), reporter_allocator<dictType::value_type>(c->memoryAccount)),weakkeys(false)
+	entries(reporter_allocator<dictionaryentry>(c->memoryAccount)),
+	slots(reporter_allocator<uint32_t>(c->memoryAccount)),
+	oldslots(reporter_allocator<uint32_t>(c->memoryAccount)),
+	rehashpos(0),usedslots(0),livecount(0),sweeppos(0),nextid(0),weakkeys(false)
 {
 }
 
-void Dictionary::finalize()
+void Dictionary::clearEntries()
 {
-	auto it=data.begin();
-	while (it != data.end())
+	entryType tmp(entries.get_allocator());
+	tmp.swap(entries);
+	slots.clear();
+	oldslots.clear();
+	rehashpos=0;
+	usedslots=0;
+	livecount=0;
+	sweeppos=0;
+	nextid=0;
+	for (auto it=tmp.begin(); it != tmp.end(); ++it)
 	{
-		ASObject* key = it->first;
-		ASObject* obj = asAtomHandler::getObject(it->second);
-		it = data.erase(it);
-		key->removeStoredMember();
+		if (!it->key)
+			continue;
+		ASObject* obj = asAtomHandler::getObject(it->value);
+		it->key->removeStoredMember();
 		if (obj)
 			obj->removeStoredMember();
 	}
 }
 
+void Dictionary::finalize()
+{
+	clearEntries();
+	setWeakKeys(false);
+}
+
 bool Dictionary::destruct()
 {
-	auto it=data.begin();
-	while (it != data.end())
-	{
-		ASObject* key = it->first;
-		ASObject* obj = asAtomHandler::getObject(it->second);
-		it = data.erase(it);
-		key->removeStoredMember();
-		if (obj)
-			obj->removeStoredMember();
-	}
-	weakkeys=false;
+	clearEntries();
+	setWeakKeys(false);
 	return destructIntern();
 }
+
+void Dictionary::setWeakKeys(bool weak)
+{
+	if (weak == weakkeys)
+		return;
+	weakkeys=weak;
+	if (weak)
+		getInstanceWorker()->addWeakDictionary(this);
+	else
+		getInstanceWorker()->removeWeakDictionary(this);
+}
+
+void Dictionary::collectWeakKeys()
+{
+	sweepWeakKeys(DICTIONARY_SWEEP_STEP);
+}
 void Dictionary::prepareShutdown()
 {
 	if (preparedforshutdown)
 		return;
 	ASObject::prepareShutdown();
-	for (auto it=data.begin() ; it != data.end(); ++it)
+	for (auto it=entries.begin() ; it != entries.end(); ++it)
 	{
-		it->first->prepareShutdown();
-		ASObject* o = asAtomHandler::getObject(it->second);
+		if (!it->key)
+			continue;
+		it->key->prepareShutdown();
+		ASObject* o = asAtomHandler::getObject(it->value);
 		if (o)
 			o->prepareShutdown();
 	}
@@ -88,7 +124,9 @@ void Dictionary::sinit(Class_base* c)
 ASFUNCTIONBODY_ATOM(Dictionary,_constructor)
 {
 	Dictionary* th=asAtomHandler::as<Dictionary>(obj);
-	ARG_CHECK(ARG_UNPACK(th->weakkeys, false));
+	bool weak;
+	ARG_CHECK(ARG_UNPACK(weak, false));
+	th->setWeakKeys(weak);
 }
 
 ASFUNCTIONBODY_ATOM(Dictionary,_toJSON)
@@ -96,16 +134,249 @@ ASFUNCTIONBODY_ATOM(Dictionary,_toJSON)
 	ret = asAtomHandler::fromString(wrk->getSystemState(),"Dictionary");
 }
 
-Dictionary::dictType::iterator Dictionary::findKey(ASObject *o)
+/*
+ * Keys are compared with strict equality.
+ * For most objects this is identity, objects that are compared by value get a hash that is
+ * consistent with their isEqual implementation and byvalue is set
+ */
+uint32_t Dictionary::hashKey(ASObject* key, bool& byvalue)
+{
+	uintptr_t h = (uintptr_t)key;
+	byvalue = false;
+	switch (key->getObjectType())
+	{
+		case T_FUNCTION:
+			if (key->is<SyntheticFunction>())
+			{
+				if (key->as<SyntheticFunction>()->inClass)
+				{
+					h = (uintptr_t)key->as<SyntheticFunction>()->getMethodInfo();
+					byvalue = true;
+				}
+			}
+			else if (key->is<Function>())
+			{
+				h = (uintptr_t)key->as<Function>()->getImplementation();
+				byvalue = true;
+			}
+			break;
+		case T_QNAME:
+		case T_NAMESPACE:
+		case T_NULL:
+		case T_UNDEFINED:
+			h = key->getObjectType();
+			byvalue = true;
+			break;
+		default:
+			break;
+	}
+	// fibonacci hashing, so that aligned pointers are spread over the table
+	return uint32_t((uint64_t(h)*0x9e3779b97f4a7c15ULL)>>32);
+}
+
+uint32_t Dictionary::findSlotEntry(const slotType& table, ASObject* key, uint32_t hash, bool byvalue) const
+{
+	if (table.empty())
+		return UINT32_MAX;
+	uint32_t mask = table.size()-1;
+	uint32_t s = hash&mask;
+	while (table[s])
+	{
+		const dictionaryentry& e = entries[table[s]-1];
+		if (e.key && e.hash == hash && (e.key == key || (byvalue && e.key->isEqualStrict(key))))
+			return table[s]-1;
+		s = (s+1)&mask;
+	}
+	return UINT32_MAX;
+}
+
+// returns the position of the entry for key in entries, UINT32_MAX if the key is not found
+uint32_t Dictionary::findKey(ASObject* key)
+{
+	bool byvalue;
+	uint32_t hash = hashKey(key,byvalue);
+	uint32_t res = findSlotEntry(slots,key,hash,byvalue);
+	if (res == UINT32_MAX)
+		res = findSlotEntry(oldslots,key,hash,byvalue);
+	return res;
+}
+
+void Dictionary::insertSlot(slotType& table, uint32_t hash, uint32_t index)
+{
+	uint32_t mask = table.size()-1;
+	uint32_t s = hash&mask;
+	while (table[s])
+		s = (s+1)&mask;
+	table[s] = index+1;
+}
+
+/*
+ * Moves count slots of the previous hash table into the current one.
+ * Growing the table is spread over the following modifications this way,
+ * so adding an entry to a large dictionary never has to rehash all entries at once
+ */
+void Dictionary::rehashStep(uint32_t count)
+{
+	while (count && rehashpos < oldslots.size())
+	{
+		uint32_t index = oldslots[rehashpos++];
+		count--;
+		if (index && entries[index-1].key)
+		{
+			insertSlot(slots,entries[index-1].hash,index-1);
+			usedslots++;
+		}
+	}
+	if (rehashpos == oldslots.size() && !oldslots.empty())
+	{
+		slotType tmp(oldslots.get_allocator());
+		tmp.swap(oldslots);
+		rehashpos=0;
+	}
+}
+
+// removes all deleted entries and rebuilds the hash table with the given size
+// the ids of the entries are kept, so running for-in loops continue with the next entry they have not visited
+void Dictionary::rebuild(uint32_t newsize)
+{
+	uint32_t pos = 0;
+	uint32_t newsweeppos = 0;
+	for (uint32_t i = 0; i < entries.size(); i++)
+	{
+		if (!entries[i].key)
+			continue;
+		if (i < sweeppos)
+			newsweeppos++;
+		entries[pos++] = entries[i];
+	}
+	entries.erase(entries.begin()+pos,entries.end());
+	sweeppos=newsweeppos;
+	if (nextid >= DICTIONARY_MAX_ID)
+	{
+		// only happens after a huge number of insertions, running for-in loops may visit entries twice
+		for (uint32_t i = 0; i < entries.size(); i++)
+			entries[i].id = i;
+		nextid = entries.size();
+	}
+	slotType tmp(oldslots.get_allocator());
+	tmp.swap(oldslots);
+	rehashpos=0;
+	slots.assign(newsize,0);
+	usedslots=0;
+	for (uint32_t i = 0; i < entries.size(); i++)
+	{
+		if (!entries[i].key)
+			continue;
+		insertSlot(slots,entries[i].hash,i);
+		usedslots++;
+	}
+}
+
+// adds a new entry for key, which must not be in the dictionary
+void Dictionary::addEntry(ASObject* key, asAtom& value)
 {
-	Dictionary::dictType::iterator it = data.begin();
-	for(; it!=data.end(); ++it)
+	rehashStep(DICTIONARY_REHASH_STEP);
+	// keep the load factor below 1/2
+	if ((usedslots+1)*2 > slots.size() || nextid >= DICTIONARY_MAX_ID)
 	{
-		if (it->first->isEqualStrict(o))
-			return it;
+		uint32_t newsize = DICTIONARY_MIN_SLOTS;
+		while (newsize < (livecount+1)*4)
+			newsize*=2;
+		if (!oldslots.empty() || entries.size() >= livecount*2 || newsize <= slots.size() || nextid >= DICTIONARY_MAX_ID)
+		{
+			// many deleted entries, compact the entries instead of growing incrementally
+			rebuild(newsize);
+		}
+		else
+		{
+			oldslots.swap(slots);
+			slots.assign(newsize,0);
+			usedslots=0;
+			rehashpos=0;
+			rehashStep(DICTIONARY_REHASH_STEP);
+		}
 	}
+	bool byvalue;
+	dictionaryentry e;
+	e.key = key;
+	e.value = value;
+	e.hash = hashKey(key,byvalue);
+	e.id = nextid++;
+	entries.push_back(e);
+	insertSlot(slots,e.hash,entries.size()-1);
+	usedslots++;
+	livecount++;
+}
 
-	return data.end();
+void Dictionary::removeEntry(uint32_t index)
+{
+	ASObject* key = entries[index].key;
+	ASObject* obj = asAtomHandler::getObject(entries[index].value);
+	// the slot stays occupied until the table is rebuilt, so the entry is only marked as deleted
+	entries[index].key = nullptr;
+	entries[index].value = asAtomHandler::invalidAtom;
+	livecount--;
+	rehashStep(DICTIONARY_REHASH_STEP);
+	key->removeStoredMember();
+	if (obj)
+		obj->removeStoredMember();
+}
+
+/*
+ * A weak key is dead if all its references come from this dictionary,
+ * either directly or through the value stored for it (e.g. a value that has the key as a member).
+ * The references through the value are counted like the cycle collector does, with the entry as the only outside reference
+ */
+bool Dictionary::isDeadWeakKey(const dictionaryentry& e)
+{
+	ASObject* key = e.key;
+	if (key->isLastRef())
+		return true;
+	ASObject* value = asAtomHandler::getObject(e.value);
+	if (!value || key->getConstant() || key->getCached() || (uint32_t)key->getRefCount() != key->storedmembercount)
+		return false;
+	ASWorker* wrk = getInstanceWorker();
+	garbagecollectorstate localgcstate(key);
+	garbagecollectorstate* pgcstate = wrk->acquireGarbageCollectorState(key);
+	garbagecollectorstate& gcstate = pgcstate ? *pgcstate : localgcstate;
+	// count the references of the entry to the key and to the value
+	key->countAllCylicMemberReferences(gcstate);
+	if (value->countAllCylicMemberReferences(gcstate))
+	{
+		auto itc = gcstate.checkedobjects.find(value);
+		if (itc != gcstate.checkedobjects.end())
+			(*itc).second.hasmember=true;
+	}
+	bool dead = true;
+	for (auto it = gcstate.checkedobjects.begin(); it != gcstate.checkedobjects.end() && dead; it++)
+	{
+		if ((*it).first == key)
+			dead = (*it).second.count == (uint32_t)key->getRefCount();
+		else if ((*it).second.hasmember && (*it).second.count != (uint32_t)(*it).first->getRefCount())
+			dead = false;
+	}
+	wrk->releaseGarbageCollectorState(pgcstate);
+	return dead;
+}
+
+/*
+ * Removes entries whose weak key is only referenced by this dictionary, see isDeadWeakKey.
+ * This is done incrementally in every slice of the collector, see ASWorker::processGarbageCollection.
+ * Keys are still reference counted, so the cycle collector handles cycles through keys and values of other objects as usual
+ */
+void Dictionary::sweepWeakKeys(uint32_t count)
+{
+	if (entries.empty())
+		return;
+	count = min(count,(uint32_t)entries.size());
+	while (count--)
+	{
+		if (sweeppos >= entries.size())
+			sweeppos=0;
+		uint32_t index = sweeppos++;
+		if (entries[index].key && isDeadWeakKey(entries[index]))
+			removeEntry(index);
+	}
 }
 
 void Dictionary::setVariableByMultiname_i(multiname& name, int32_t value,ASWorker* wrk)
@@ -145,21 +416,21 @@ multiname *Dictionary::setVariableByMultiname(multiname& name, asAtom& o, CONST_
 				break;
 		}
 
-		Dictionary::dictType::iterator it=findKey(name.name_o);
-		if(it!=data.end())
+		uint32_t index=findKey(name.name_o);
+		if(index!=UINT32_MAX)
 		{
-			if (alreadyset && it->second.uintval == o.uintval)
+			if (alreadyset && entries[index].value.uintval == o.uintval)
 				*alreadyset=true;
 			else
 			{
-				asAtom oldvar = it->second;
-				ASObject* obj = asAtomHandler::getObject(oldvar);
-				if (obj)
-					obj->removeStoredMember();
-				it->second=o;
-				obj = asAtomHandler::getObject(o);
+				asAtom oldvar = entries[index].value;
+				entries[index].value=o;
+				ASObject* obj = asAtomHandler::getObject(o);
 				if (obj)
 					obj->addStoredMember();
+				obj = asAtomHandler::getObject(oldvar);
+				if (obj)
+					obj->removeStoredMember();
 			}
 		}
 		else
@@ -169,7 +440,7 @@ multiname *Dictionary::setVariableByMultiname(multiname& name, asAtom& o, CONST_
 			ASObject* obj = asAtomHandler::getObject(o);
 			if (obj)
 				obj->addStoredMember();
-			data.insert(make_pair(name.name_o,o));
+			addEntry(name.name_o,o);
 		}
 	}
 	else
@@ -216,14 +487,10 @@ bool Dictionary::deleteVariableByMultiname(const multiname& name, ASWorker* wrk)
 				break;
 		}
 
-		Dictionary::dictType::iterator it=findKey(name.name_o);
-		if(it != data.end())
+		uint32_t index=findKey(name.name_o);
+		if(index != UINT32_MAX)
 		{
-			ASObject* obj = asAtomHandler::getObject(it->second);
-			if (obj)
-				obj->removeStoredMember();
-			data.erase(it);
-			name.name_o->removeStoredMember();
+			removeEntry(index);
 			return true;
 		}
 		return false;
@@ -269,23 +536,13 @@ GET_VARIABLE_RESULT Dictionary::getVariableByMultiname(asAtom& ret, const multin
 				default:
 					break;
 			}
-			bool islastref = name.name_o->isLastRef();
-
-			Dictionary::dictType::iterator it=findKey(name.name_o);
-			if(it != data.end())
+			uint32_t index=findKey(name.name_o);
+			if(index != UINT32_MAX)
 			{
-				ret = it->second;
-				if (islastref && weakkeys)
-				{
-					name.name_o->removeStoredMember();
-					data.erase(it);
-				}
-				else
-					ASATOM_INCREF(ret);
-				return GET_VARIABLE_RESULT::GETVAR_NORMAL;
+				ret = entries[index].value;
+				ASATOM_INCREF(ret);
 			}
-			else
-				return GET_VARIABLE_RESULT::GETVAR_NORMAL;
+			return GET_VARIABLE_RESULT::GETVAR_NORMAL;
 		}
 		else
 		{
@@ -339,8 +596,7 @@ bool Dictionary::hasPropertyByMultiname(const multiname& name, bool considerDyna
 			default:
 				break;
 		}
-		Dictionary::dictType::iterator it=findKey(name.name_o);
-		return it != data.end();
+		return findKey(name.name_o) != UINT32_MAX;
 	}
 	else
 	{
@@ -354,57 +610,79 @@ bool Dictionary::hasPropertyByMultiname(const multiname& name, bool considerDyna
 	}
 }
 
+// returns the position of the entry with the given id, or of the next entry if it was removed
+uint32_t Dictionary::findEntryPosition(uint32_t id) const
+{
+	// removing deleted entries only moves entries to lower positions
+	if (id < entries.size() && entries[id].id == id)
+		return id;
+	auto end = entries.begin()+min(id+1,(uint32_t)entries.size());
+	auto it = std::lower_bound(entries.begin(),end,id,
+		[](const dictionaryentry& e, uint32_t i) { return e.id < i; });
+	return it-entries.begin();
+}
+
 uint32_t Dictionary::nextNameIndex(uint32_t cur_index)
 {
 	assert_and_throw(implEnable);
-	if(cur_index<data.size())
-		return cur_index+1;
-	else
+	if(cur_index<nextid)
 	{
-		//Fall back on object properties
-		uint32_t ret=ASObject::nextNameIndex(cur_index-data.size());
-		if(ret==0)
-			return 0;
-		else
-			return ret+data.size();
-
+		for (uint32_t pos = findEntryPosition(cur_index); pos < entries.size(); pos++)
+		{
+			if (entries[pos].key)
+				return entries[pos].id+1;
+		}
+		cur_index=nextid;
 	}
+	//Fall back on object properties
+	uint32_t ret=ASObject::nextNameIndex(cur_index-nextid);
+	if(ret==0)
+		return 0;
+	else
+		return ret+nextid;
 }
 
 void Dictionary::nextName(asAtom& ret,uint32_t index)
 {
 	assert_and_throw(implEnable);
-	if(index<=data.size())
+	if(index<=nextid)
 	{
-		auto it=data.begin();
-		for(unsigned int i=1;i<index;i++)
-			++it;
-		it->first->incRef();
-		ret = asAtomHandler::fromObject(it->first);
+		// the entry may have been deleted since nextNameIndex was called
+		uint32_t pos = findEntryPosition(index-1);
+		ASObject* key = pos < entries.size() && entries[pos].id == index-1 ? entries[pos].key : nullptr;
+		if (key)
+		{
+			key->incRef();
+			ret = asAtomHandler::fromObject(key);
+		}
+		else
+			asAtomHandler::setUndefined(ret);
 	}
 	else
 	{
 		//Fall back on object properties
-		ASObject::nextName(ret,index-data.size());
+		ASObject::nextName(ret,index-nextid);
 	}
 }
 
 void Dictionary::nextValue(asAtom& ret,uint32_t index)
 {
 	assert_and_throw(implEnable);
-	if(index<=data.size())
+	if(index<=nextid)
 	{
-		auto it=data.begin();
-		for(unsigned int i=1;i<index;i++)
-			++it;
-
-		ASATOM_INCREF(it->second);
-		ret = it->second;
+		uint32_t pos = findEntryPosition(index-1);
+		if (pos < entries.size() && entries[pos].id == index-1 && entries[pos].key)
+		{
+			ret = entries[pos].value;
+			ASATOM_INCREF(ret);
+		}
+		else
+			asAtomHandler::setUndefined(ret);
 	}
 	else
 	{
 		//Fall back on object properties
-		ASObject::nextValue(ret,index-data.size());
+		ASObject::nextValue(ret,index-nextid);
 	}
 }
 
@@ -413,11 +691,13 @@ bool Dictionary::countCylicMemberReferences(garbagecollectorstate& gcstate)
 	if (gcstate.checkAncestors(this))
 		return false;
 	bool ret = ASObject::countCylicMemberReferences(gcstate);
-	for (auto it = data.begin(); it != data.end(); it++)
+	for (auto it = entries.begin(); it != entries.end(); it++)
 	{
-		ret = it->first->countAllCylicMemberReferences(gcstate) || ret;
-		if (asAtomHandler::isObject(it->second))
-			ret = asAtomHandler::getObjectNoCheck(it->second)->countAllCylicMemberReferences(gcstate) || ret;
+		if (!it->key)
+			continue;
+		ret = it->key->countAllCylicMemberReferences(gcstate) || ret;
+		if (asAtomHandler::isObject(it->value))
+			ret = asAtomHandler::getObjectNoCheck(it->value)->countAllCylicMemberReferences(gcstate) || ret;
 	}
 	return ret;
 }
@@ -426,13 +706,15 @@ tiny_string Dictionary::toString()
 {
 	std::stringstream retstr;
 	retstr << "{";
-	auto it=data.begin();
-	while(it != data.end())
+	bool first=true;
+	for (auto it=entries.begin(); it != entries.end(); ++it)
 	{
-		if(it != data.begin())
+		if (!it->key)
+			continue;
+		if(!first)
 			retstr << ", ";
-		retstr << "{" << it->first->toString() << ", " << asAtomHandler::toString(it->second,getInstanceWorker()) << "}";
-		++it;
+		first=false;
+		retstr << "{" << it->key->toString() << ", " << asAtomHandler::toString(it->value,getInstanceWorker()) << "}";
 	}
 	retstr << "}";
 
@@ -440,39 +722,37 @@ tiny_string Dictionary::toString()
 }
 
 
-void Dictionary::serialize(ByteArray* out, std::map<tiny_string, uint32_t>& stringMap,
-				std::map<const ASObject*, uint32_t>& objMap,
-				std::map<const Class_base*, uint32_t>& traitsMap,ASWorker* wrk)
+void Dictionary::serialize(ByteArray* out, amf3stringtable& stringMap,
+				amf3objecttable& objMap,
+				amf3traitstable& traitsMap,ASWorker* wrk)
 {
 	if (out->getObjectEncoding() == OBJECT_ENCODING::AMF0)
 	{
 		LOG(LOG_NOT_IMPLEMENTED,"serializing Dictionary in AMF0 not implemented");
 		return;
 	}
-	assert_and_throw(objMap.find(this)==objMap.end());
+	assert_and_throw(objMap.find(this)==amf3objecttable::npos);
 	out->writeByte(dictionary_marker);
 	//Check if the dictionary has been already serialized
-	auto it=objMap.find(this);
-	if(it!=objMap.end())
+	uint32_t ref=objMap.find(this);
+	if(ref!=amf3objecttable::npos)
 	{
 		//The least significant bit is 0 to signal a reference
-		out->writeU29(it->second << 1);
+		out->writeU29(ref << 1);
 	}
 	else
 	{
 		//Add the dictionary to the map
-		objMap.insert(make_pair(this, objMap.size()));
+		objMap.add(this);
 
 		uint32_t count = 0;
-		uint32_t tmp;
-		while ((tmp = nextNameIndex(count)) != 0)
-		{
-			count = tmp;
-		}
+		uint32_t tmp = 0;
+		while ((tmp = nextNameIndex(tmp)) != 0)
+			count++;
 		assert_and_throw(count<0x20000000);
 		uint32_t value = (count << 1) | 1;
 		out->writeU29(value);
-		out->writeByte(0x00); // TODO handle weak keys
+		out->writeByte(weakkeys ? 0x01 : 0x00);
 		
 		tmp = 0;
 		while ((tmp = nextNameIndex(tmp)) != 0)
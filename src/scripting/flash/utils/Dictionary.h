@@ -30,11 +30,51 @@ namespace lightspark
 class Dictionary: public ASObject
 {
 friend class ABCVm;
+friend class Amf3Deserializer;
 private:
-	typedef std::map<ASObject*, asAtom> dictType;
-	dictType data;
-	dictType::iterator findKey(ASObject *);
+	/*
+	 * Object keys are stored in insertion order in entries, the hash table (slots) only contains positions in entries.
+	 * Deleted entries are only marked (key is set to nullptr) and removed when the table has to grow.
+	 * for-in loops use the id of an entry as index, so they are not disturbed when deleted entries are removed.
+	 * Primitive keys are stored as normal dynamic properties.
+	 */
+	struct dictionaryentry
+	{
+		ASObject* key;
+		asAtom value;
+		uint32_t hash;
+		// insertion counter of the dictionary when the entry was added, ids grow with the position in entries
+		uint32_t id;
+	};
+	typedef std::vector<dictionaryentry, reporter_allocator<dictionaryentry>> entryType;
+	typedef std::vector<uint32_t, reporter_allocator<uint32_t>> slotType;
+	entryType entries;
+	// index+1 of the entry in entries, 0 for empty slots
+	slotType slots;
+	// table that is currently migrated into slots, see rehashStep
+	slotType oldslots;
+	uint32_t rehashpos;
+	// number of non-empty slots in slots
+	uint32_t usedslots;
+	// number of entries with a key
+	uint32_t livecount;
+	// position in entries where the next incremental sweep of dead weak keys starts
+	uint32_t sweeppos;
+	// id of the next added entry, the indices of the dynamic properties in for-in loops start after it
+	uint32_t nextid;
 	bool weakkeys;
+	static uint32_t hashKey(ASObject* key, bool& byvalue);
+	uint32_t findSlotEntry(const slotType& table, ASObject* key, uint32_t hash, bool byvalue) const;
+	uint32_t findKey(ASObject* key);
+	uint32_t findEntryPosition(uint32_t id) const;
+	void insertSlot(slotType& table, uint32_t hash, uint32_t index);
+	void addEntry(ASObject* key, asAtom& value);
+	void removeEntry(uint32_t index);
+	void rehashStep(uint32_t count);
+	void rebuild(uint32_t newsize);
+	void clearEntries();
+	void sweepWeakKeys(uint32_t count);
+	bool isDeadWeakKey(const dictionaryentry& e);
 public:
 	Dictionary(ASWorker* wrk,Class_base* c);
 	void finalize() override;
@@ -42,6 +82,9 @@ public:
 	void prepareShutdown() override;
 
 	static void sinit(Class_base*);
+	void setWeakKeys(bool weak);
+	// called by the collector of the worker for dictionaries with weak keys
+	void collectWeakKeys();
 	ASFUNCTION_ATOM(_constructor);
 	ASFUNCTION_ATOM(_toJSON);
 
@@ -61,9 +104,9 @@ public:
 	void nextValue(asAtom &ret, uint32_t index) override;
 	bool countCylicMemberReferences(lightspark::garbagecollectorstate& gcstate) override;
 
-	void serialize(ByteArray* out, std::map<tiny_string, uint32_t>& stringMap,
-				std::map<const ASObject*, uint32_t>& objMap,
-				std::map<const Class_base*, uint32_t>& traitsMap, ASWorker* wrk) override;
+	void serialize(ByteArray* out, amf3stringtable& stringMap,
+				amf3objecttable& objMap,
+				amf3traitstable& traitsMap, ASWorker* wrk) override;
 };
 
 }
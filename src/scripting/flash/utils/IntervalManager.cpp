@@ -37,7 +37,7 @@ IntervalManager::IntervalManager() : currentID(1)
 IntervalManager::~IntervalManager()
 {
 	//Run through all running intervals and remove their tickjob, delete their intervalRunner and erase their entry
-	std::map<uint32_t,IntervalRunner*>::iterator it = runners.begin();
+	auto it = runners.begin();
 	while(it != runners.end())
 	{
 		getSys()->removeJob((*it).second);
@@ -99,7 +99,7 @@ void IntervalManager::clearInterval(uint32_t id, IntervalRunner::INTERVALTYPE ty
 {
 	Locker l(mutex);
 
-	std::map<uint32_t,IntervalRunner*>::iterator it = runners.find(id);
+	auto it = runners.find(id);
 	//If the entry exists and the types match, remove its tickjob, delete its intervalRunner and erase their entry
 	if(it != runners.end() && (*it).second->getType() == type)
 	{
@@ -21,6 +21,7 @@
 #define SCRIPTING_FLASH_UTILS_INTERVALMANAGER_H 1
 
 #include "compat.h"
+#include <unordered_map>
 #include "swftypes.h"
 #include "scripting/flash/utils/IntervalRunner.h"
 
@@ -32,7 +33,7 @@ class IntervalManager
 {
 private:
 	Mutex mutex;
-	std::map<uint32_t,IntervalRunner*> runners;
+	std::unordered_map<uint32_t,IntervalRunner*> runners;
 	uint32_t currentID;
 public:
 	IntervalManager();
@@ -27,6 +27,7 @@
 #include "scripting/flash/errors/flasherrors.h"
 #include "scripting/flash/utils/IntervalRunner.h"
 #include "scripting/flash/utils/IntervalManager.h"
+#include "timer.h"
 
 using namespace std;
 using namespace lightspark;
@@ -49,9 +50,17 @@ IntervalRunner::~IntervalRunner()
 }
 
 void IntervalRunner::tick()
+{
+	TickBatch batch;
+	tickBatched(batch);
+	if (!batch.events.empty())
+		getVm(getSys())->addEventBatch(batch.events,batch.sync);
+}
+
+bool IntervalRunner::tickBatched(TickBatch& batch)
 {
 	if (getSys()->isShuttingDown())
-		return;
+		return true;
 	//incRef all arguments
 	uint32_t i;
 	for(i=0; i < argslen; i++)
@@ -60,15 +69,15 @@ void IntervalRunner::tick()
 	}
 	ASATOM_INCREF(obj);
 	_R<FunctionEvent> event(new (getSys()->unaccountedMemory) FunctionEvent(callback, obj, args, argslen));
-	getVm(getSys())->addEvent(NullRef,event);
-	event->wait();
+	batch.addEvent(NullRef,event);
+	//The next tick happens after the callback has been executed
+	batch.sync=true;
 	if(type == TIMEOUT)
 	{
-		//TODO: IntervalRunner deletes itself. Is this allowed?
-		//Delete ourselves from the active intervals list
+		//Delete ourselves from the active intervals list, the TimerThread calls tickFence after the batch was handled
 		getSys()->intervalManager->clearInterval(id, TIMEOUT, false);
-		//No actions may be performed after this point
 	}
+	return true;
 }
 
 void IntervalRunner::tickFence()
@@ -47,6 +47,7 @@ public:
 	IntervalRunner(INTERVALTYPE _type, uint32_t _id, asAtom _callback, asAtom* _args,
 			const unsigned int _argslen, asAtom _obj);
 	void tick();
+	bool tickBatched(TickBatch& batch) override;
 	void tickFence();
 	INTERVALTYPE getType() { return type; }
 };
@@ -33,11 +33,18 @@ using namespace std;
 using namespace lightspark;
 
 void Timer::tick()
+{
+	TickBatch batch;
+	tickBatched(batch);
+	getVm(getSystemState())->addEventBatch(batch.events,false);
+}
+
+bool Timer::tickBatched(TickBatch& batch)
 {
 	//This will be executed once if repeatCount was originally 1
 	//Otherwise it's executed until stopMe is set to true
 	this->incRef();
-	getVm(getSystemState())->addEvent(_MR(this),_MR(Class<TimerEvent>::getInstanceS(getInstanceWorker(),"timer")));
+	batch.addEvent(_MR(this),_MR(Class<TimerEvent>::getInstanceS(getInstanceWorker(),"timer")));
 
 	currentCount++;
 	if(repeatCount!=0)
@@ -45,11 +52,12 @@ void Timer::tick()
 		if(currentCount>=repeatCount)
 		{
 			this->incRef();
-			getVm(getSystemState())->addEvent(_MR(this),_MR(Class<TimerEvent>::getInstanceS(getInstanceWorker(),"timerComplete")));
+			batch.addEvent(_MR(this),_MR(Class<TimerEvent>::getInstanceS(getInstanceWorker(),"timerComplete")));
 			stopMe=true;
 			running=false;
 		}
 	}
+	return true;
 }
 
 void Timer::tickFence()
@@ -35,6 +35,7 @@ class Timer: public EventDispatcher, public ITickJob
 {
 private:
 	void tick();
+	bool tickBatched(TickBatch& batch) override;
 	void tickFence();
 	//tickJobInstance keeps a reference to self while this
 	//instance is being used by the timer thread.
@@ -335,9 +335,9 @@ ASFUNCTIONBODY_ATOM(XMLDocument,_constructor)
 		th->parseXMLImpl(source);
 }
 
-void XMLDocument::serialize(ByteArray* out, std::map<tiny_string, uint32_t>& stringMap,
-				std::map<const ASObject*, uint32_t>& objMap,
-				std::map<const Class_base*, uint32_t>& traitsMap,ASWorker* wrk)
+void XMLDocument::serialize(ByteArray* out, amf3stringtable& stringMap,
+				amf3objecttable& objMap,
+				amf3traitstable& traitsMap,ASWorker* wrk)
 {
 	if (out->getObjectEncoding() == OBJECT_ENCODING::AMF0)
 	{
@@ -85,9 +85,9 @@ public:
 	ASFUNCTION_ATOM(_toString);
 	ASFUNCTION_ATOM(createElement);
 	//Serialization interface
-	void serialize(ByteArray* out, std::map<tiny_string, uint32_t>& stringMap,
-				std::map<const ASObject*, uint32_t>& objMap,
-				std::map<const Class_base*, uint32_t>& traitsMap, ASWorker* wrk);
+	void serialize(ByteArray* out, amf3stringtable& stringMap,
+				amf3objecttable& objMap,
+				amf3traitstable& traitsMap, ASWorker* wrk);
 };
 
 }
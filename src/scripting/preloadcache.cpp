@@ -0,0 +1,256 @@
+/**************************************************************************
+    Lightspark, a free flash player implementation
+
+    Copyright (C) 2009-2013  Alessandro Pignotti (a.pignotti@sssup.it)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+#include <fstream>
+#include <cstdio>
+#include <cstring>
+#include <glib.h>
+#include <glib/gstdio.h>
+#include "scripting/preloadcache.h"
+#include "backends/config.h"
+#include "swftypes.h"
+#include "logger.h"
+#include "version.h"
+
+using namespace std;
+using namespace lightspark;
+
+// increase this if the layout of the cache file or of the preloaded code changes
+#define PRELOADCACHE_FORMAT 3
+static const char preloadcachemagic[4] = {'L','S','P','C'};
+
+namespace
+{
+class cachewriter
+{
+	ofstream& f;
+public:
+	cachewriter(ofstream& _f):f(_f) {}
+	template<class T> void write(const T& v) { f.write((const char*)&v,sizeof(T)); }
+	void write(const string& s)
+	{
+		write(uint32_t(s.size()));
+		f.write(s.data(),s.size());
+	}
+	template<class T> void writevector(const vector<T>& v)
+	{
+		write(uint32_t(v.size()));
+		for (auto it = v.begin(); it != v.end(); it++)
+			write(*it);
+	}
+};
+class cachereader
+{
+	ifstream& f;
+public:
+	cachereader(ifstream& _f):f(_f) {}
+	bool good() const { return f.good(); }
+	template<class T> void read(T& v) { f.read((char*)&v,sizeof(T)); }
+	void read(string& s)
+	{
+		uint32_t len=0;
+		read(len);
+		if (!f.good() || len > 0x10000)
+		{
+			f.setstate(ios_base::failbit);
+			return;
+		}
+		s.resize(len);
+		f.read(&s[0],len);
+	}
+	template<class T> void readvector(vector<T>& v)
+	{
+		uint32_t len=0;
+		read(len);
+		if (!f.good() || len > 0x1000000)
+		{
+			f.setstate(ios_base::failbit);
+			return;
+		}
+		v.resize(len);
+		for (uint32_t i = 0; i < len && f.good(); i++)
+			read(v[i]);
+	}
+};
+}
+
+PreloadCache::PreloadCache(const string& _filename):filename(_filename),modified(false)
+{
+	load();
+}
+
+PreloadCache::~PreloadCache()
+{
+	if (modified)
+		save();
+}
+
+PreloadCache* PreloadCache::create(const char* data, size_t len)
+{
+	if (!Config::getConfig()->isPreloadCacheEnabled())
+		return nullptr;
+	// the argument slots are stored as 64 bit values, so unmarked pointers can only be told apart from the 32 bit arguments on 64 bit platforms
+	if (sizeof(void*) != sizeof(uint64_t))
+		return nullptr;
+	// FNV-1a hash over the player version and the abc data
+	uint64_t hash = 0xcbf29ce484222325ULL;
+	const char* version = VERSION;
+	for (const char* c = version; *c; c++)
+		hash = (hash ^ uint8_t(*c)) * 0x100000001b3ULL;
+	for (size_t i = 0; i < len; i++)
+		hash = (hash ^ uint8_t(data[i])) * 0x100000001b3ULL;
+	char name[64];
+	snprintf(name,64,"preload-%016llx.cache",(unsigned long long)hash);
+	return new PreloadCache(Config::getConfig()->getCacheDirectory() + G_DIR_SEPARATOR_S + name);
+}
+
+void PreloadCache::load()
+{
+	ifstream f(filename,ios_base::in|ios_base::binary);
+	if (!f.is_open())
+		return;
+	cachereader r(f);
+	char magic[4];
+	uint32_t format=0;
+	string version;
+	f.read(magic,4);
+	r.read(format);
+	r.read(version);
+	if (!r.good() || memcmp(magic,preloadcachemagic,4) || format != PRELOADCACHE_FORMAT || version != VERSION)
+	{
+		LOG(LOG_INFO,"ignoring outdated preload cache "<<filename);
+		return;
+	}
+	uint32_t count=0;
+	r.read(count);
+	for (uint32_t i = 0; i < count && r.good(); i++)
+	{
+		uint32_t methodindex;
+		preloadcacheentry e;
+		r.read(methodindex);
+		r.readvector(e.types);
+		r.readvector(e.resolvedclasses);
+		r.readvector(e.code);
+		r.readvector(e.localconstantslots);
+		r.readvector(e.exceptions);
+		r.readvector(e.localsinitialvalues);
+		r.read(e.propertycachecount);
+		r.read(e.simplegetterorsettername);
+		r.read(e.localresultcount);
+		r.read(e.needscoerceresult);
+		r.read(e.needsscope);
+		if (r.good())
+			entries[methodindex]=e;
+	}
+	if (!r.good())
+	{
+		LOG(LOG_ERROR,"preload cache "<<filename<<" is corrupted");
+		entries.clear();
+		return;
+	}
+	LOG(LOG_INFO,"loaded "<<entries.size()<<" methods from preload cache "<<filename);
+}
+
+void PreloadCache::save()
+{
+	Locker l(mutex);
+	// write to a temporary file first, so a concurrently running player never reads a partial file
+	string tmpname = filename+".tmp";
+	{
+		ofstream f(tmpname,ios_base::out|ios_base::binary|ios_base::trunc);
+		if (!f.is_open())
+		{
+			LOG(LOG_ERROR,"unable to write preload cache "<<filename);
+			return;
+		}
+		cachewriter w(f);
+		f.write(preloadcachemagic,4);
+		w.write(uint32_t(PRELOADCACHE_FORMAT));
+		w.write(string(VERSION));
+		w.write(uint32_t(entries.size()));
+		for (auto it = entries.begin(); it != entries.end(); it++)
+		{
+			const preloadcacheentry& e = it->second;
+			w.write(it->first);
+			w.writevector(e.types);
+			w.writevector(e.resolvedclasses);
+			w.writevector(e.code);
+			w.writevector(e.localconstantslots);
+			w.writevector(e.exceptions);
+			w.writevector(e.localsinitialvalues);
+			w.write(e.propertycachecount);
+			w.write(e.simplegetterorsettername);
+			w.write(e.localresultcount);
+			w.write(e.needscoerceresult);
+			w.write(e.needsscope);
+		}
+		if (!f.good())
+		{
+			LOG(LOG_ERROR,"unable to write preload cache "<<filename);
+			return;
+		}
+	}
+	if (g_rename(tmpname.c_str(),filename.c_str()) != 0)
+		LOG(LOG_ERROR,"unable to write preload cache "<<filename);
+	modified = false;
+}
+
+bool PreloadCache::get(uint32_t methodindex, preloadcacheentry& entry)
+{
+	Locker l(mutex);
+	auto it = entries.find(methodindex);
+	if (it == entries.end())
+		return false;
+	entry = it->second;
+	return true;
+}
+
+void PreloadCache::add(uint32_t methodindex, const preloadcacheentry& entry)
+{
+	Locker l(mutex);
+	entries[methodindex]=entry;
+	modified = true;
+}
+
+void PreloadCache::remove(uint32_t methodindex)
+{
+	Locker l(mutex);
+	if (entries.erase(methodindex))
+		modified = true;
+}
+
+uint32_t PreloadCache::getMultinameIndex(const cpool_info& pool, const multiname* m)
+{
+	Locker l(mutex);
+	auto it = multinameindices.find(m);
+	if (it != multinameindices.end())
+		return it->second;
+	if (!m->isStatic)
+		return UINT32_MAX;
+	// multinames are cached on first use, so the index is built lazily
+	for (uint32_t i = 1; i < pool.multinames.size(); i++)
+	{
+		if (pool.multinames[i].cached == m)
+		{
+			multinameindices[m]=i;
+			return i;
+		}
+	}
+	return UINT32_MAX;
+}
@@ -0,0 +1,99 @@
+/**************************************************************************
+    Lightspark, a free flash player implementation
+
+    Copyright (C) 2009-2013  Alessandro Pignotti (a.pignotti@sssup.it)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+#ifndef SCRIPTING_PRELOADCACHE_H
+#define SCRIPTING_PRELOADCACHE_H 1
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include "threading.h"
+#include "scripting/abctypes.h"
+
+namespace lightspark
+{
+
+enum PRELOADCACHE_RELOCATION { PRELOADCACHE_RAW=0, PRELOADCACHE_CONSTANT, PRELOADCACHE_MULTINAME };
+
+// one entry of the preloaded code in a relocatable form
+struct preloadcacheinstruction
+{
+	// index of the handler in ABCVm::abcfunctions
+	uint32_t func;
+	// PRELOADCACHE_RELOCATION of the three argument slots
+	uint8_t relocation[3];
+	// raw value, constant (kind<<32|index) or multiname index, depending on relocation
+	uint64_t slots[3];
+	// preloadedcodedata::cacheindex
+	uint32_t cacheindex;
+};
+
+// everything preloadFunction computes for a method, without pointers to runtime objects
+struct preloadcacheentry
+{
+	// names of the types the code was generated for (class of the method, return type, parameter types)
+	std::vector<std::string> types;
+	// indices of the classes of this context the code depends on, they have to be defined when the code is reused
+	std::vector<uint32_t> resolvedclasses;
+	std::vector<preloadcacheinstruction> code;
+	std::vector<localconstantslot> localconstantslots;
+	// from/to/target of the exception handlers, mapped to positions in the preloaded code
+	std::vector<uint32_t> exceptions;
+	// constants (kind<<32|index) the locals are initialized to, empty if the locals are not initialized
+	std::vector<uint64_t> localsinitialvalues;
+	uint32_t propertycachecount;
+	// multiname index of SyntheticFunction::simpleGetterOrSetterName, UINT32_MAX if not set
+	uint32_t simplegetterorsettername;
+	uint16_t localresultcount;
+	bool needscoerceresult;
+	bool needsscope;
+	preloadcacheentry():propertycachecount(0),simplegetterorsettername(UINT32_MAX),localresultcount(0),needscoerceresult(false),needsscope(false) {}
+};
+
+/*
+ * On-disk cache of preloaded method code of one DoABC tag.
+ * The file is keyed by a hash of the tag data and the player version,
+ * entries are indexed by the method index in the ABCContext
+ */
+class PreloadCache
+{
+private:
+	Mutex mutex;
+	std::string filename;
+	std::unordered_map<uint32_t,preloadcacheentry> entries;
+	// static multinames of the context and their index in the constant pool, used to relocate the preloaded code
+	std::unordered_map<const multiname*,uint32_t> multinameindices;
+	bool modified;
+	void load();
+	void save();
+	PreloadCache(const std::string& _filename);
+public:
+	~PreloadCache();
+	/* returns the cache for the given abc data, or nullptr if the preload cache is disabled in the configuration */
+	static PreloadCache* create(const char* data, size_t len);
+	bool get(uint32_t methodindex, preloadcacheentry& entry);
+	void add(uint32_t methodindex, const preloadcacheentry& entry);
+	void remove(uint32_t methodindex);
+	/* returns the index of a static multiname in the constant pool, UINT32_MAX if it is not found */
+	uint32_t getMultinameIndex(const cpool_info& pool, const multiname* m);
+};
+
+}
+#endif /* SCRIPTING_PRELOADCACHE_H */
@@ -0,0 +1,229 @@
+/**************************************************************************
+    Lightspark, a free flash player implementation
+
+    Copyright (C) 2009-2013  Alessandro Pignotti (a.pignotti@sssup.it)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+#include <algorithm>
+#include <numeric>
+#include <limits>
+#include <cmath>
+#include <cstring>
+#include <SDL2/SDL_cpuinfo.h>
+#include "scripting/sortkeys.h"
+#include "interfaces/threading.h"
+#include "threading.h"
+#include "swf.h"
+
+using namespace std;
+using namespace lightspark;
+
+// comparison sorts of at least this many elements are split over the thread pool
+#define SORTKEYS_PARALLEL_THRESHOLD 65536
+#define SORTKEYS_MAX_CHUNKS 8
+
+namespace lightspark
+{
+class SortKeysJob : public IThreadJob
+{
+private:
+	SortKeys* keys;
+public:
+	uint32_t from;
+	uint32_t to;
+	bool executed;
+	Semaphore finished;
+	SortKeysJob(SortKeys* _keys, uint32_t _from, uint32_t _to):keys(_keys),from(_from),to(_to),executed(false),finished(0) {}
+	void execute() override
+	{
+		keys->sortRange(from,to);
+		executed=true;
+	}
+	void jobFence() override
+	{
+		finished.signal();
+	}
+	// the vm thread waits for the result
+	THREADJOB_PRIORITY getPriority() const override { return THREADJOB_PRIORITY_HIGH; }
+	bool isShortRunning() const override { return true; }
+};
+}
+
+SortKeys::SortKeys(uint32_t _count, const vector<sortkeyfield>& _fields):fields(_fields),count(_count)
+{
+	bool hasnumeric=false;
+	bool hasstring=false;
+	for (auto it = fields.begin(); it != fields.end(); it++)
+	{
+		if (it->isNumeric)
+			hasnumeric=true;
+		else
+			hasstring=true;
+	}
+	if (hasnumeric)
+		numkeys.resize(size_t(count)*fields.size());
+	if (hasstring)
+		strkeys.resize(size_t(count)*fields.size());
+}
+
+void SortKeys::setNumber(uint32_t index, uint32_t field, number_t n)
+{
+	// -0 is equal to 0 and all NaNs are sorted after Infinity
+	if (n == 0)
+		n = 0;
+	else if (std::isnan(n))
+		n = numeric_limits<double>::quiet_NaN();
+	uint64_t bits;
+	memcpy(&bits,&n,sizeof(bits));
+	// map the double to an unsigned integer with the same order
+	if (bits>>63)
+		bits = ~bits;
+	else
+		bits |= 1ULL<<63;
+	if (fields[field].isDescending)
+		bits = ~bits;
+	numkeys[size_t(index)*fields.size()+field]=bits;
+}
+
+void SortKeys::setString(uint32_t index, uint32_t field, const tiny_string& s)
+{
+	tiny_string& key = strkeys[size_t(index)*fields.size()+field];
+	if (fields[field].isCaseInsensitive)
+	{
+		// the casefolded string is compared bytewise, which is the order of the code points
+		// and doesn't depend on the locale
+		char* folded = g_utf8_casefold(s.raw_buf(),s.numBytes());
+		key = tiny_string(folded,true);
+		g_free(folded);
+	}
+	else
+		key = s;
+}
+
+bool SortKeys::lessThan(uint32_t a, uint32_t b) const
+{
+	size_t fieldcount = fields.size();
+	for (size_t f = 0; f < fieldcount; f++)
+	{
+		size_t ka = size_t(a)*fieldcount+f;
+		size_t kb = size_t(b)*fieldcount+f;
+		if (fields[f].isNumeric)
+		{
+			// descending order is already part of the key
+			if (numkeys[ka] != numkeys[kb])
+				return numkeys[ka] < numkeys[kb];
+		}
+		else
+		{
+			const tiny_string& sa = strkeys[ka];
+			const tiny_string& sb = strkeys[kb];
+			if (sa == sb)
+				continue;
+			return fields[f].isDescending ? sb < sa : sa < sb;
+		}
+	}
+	return false;
+}
+
+void SortKeys::radixSort()
+{
+	// LSD radix sort over the 8 bytes of the key, passes where all keys have the same byte are skipped
+	vector<uint64_t> keys(numkeys);
+	vector<uint64_t> tmpkeys(count);
+	vector<uint32_t> tmporder(count);
+	vector<uint32_t> histogram(8*256,0);
+	for (uint32_t i = 0; i < count; i++)
+	{
+		for (uint32_t b = 0; b < 8; b++)
+			histogram[b*256+((keys[i]>>(b*8))&0xff)]++;
+	}
+	for (uint32_t b = 0; b < 8; b++)
+	{
+		uint32_t* h = &histogram[b*256];
+		uint32_t shift = b*8;
+		if (h[(keys[0]>>shift)&0xff] == count)
+			continue;
+		uint32_t pos = 0;
+		for (uint32_t i = 0; i < 256; i++)
+		{
+			uint32_t c = h[i];
+			h[i] = pos;
+			pos += c;
+		}
+		for (uint32_t i = 0; i < count; i++)
+		{
+			uint32_t p = h[(keys[i]>>shift)&0xff]++;
+			tmpkeys[p] = keys[i];
+			tmporder[p] = order[i];
+		}
+		keys.swap(tmpkeys);
+		order.swap(tmporder);
+	}
+}
+
+void SortKeys::sortRange(uint32_t from, uint32_t to)
+{
+	stable_sort(order.begin()+from,order.begin()+to,[this](uint32_t a, uint32_t b) { return lessThan(a,b); });
+}
+
+void SortKeys::sort(SystemState* sys)
+{
+	order.resize(count);
+	iota(order.begin(),order.end(),0);
+	if (count < 2)
+		return;
+	if (fields.size() == 1 && fields[0].isNumeric)
+	{
+		radixSort();
+		return;
+	}
+	uint32_t chunks = 1;
+	if (sys && count >= SORTKEYS_PARALLEL_THRESHOLD)
+		chunks = min(uint32_t(max(SDL_GetCPUCount(),1)),uint32_t(SORTKEYS_MAX_CHUNKS));
+	if (chunks < 2)
+	{
+		sortRange(0,count);
+		return;
+	}
+	vector<uint32_t> bounds(chunks+1);
+	for (uint32_t i = 0; i <= chunks; i++)
+		bounds[i] = uint64_t(count)*i/chunks;
+	// the first chunk is sorted on this thread
+	vector<SortKeysJob*> jobs;
+	for (uint32_t i = 1; i < chunks; i++)
+	{
+		SortKeysJob* job = new SortKeysJob(this,bounds[i],bounds[i+1]);
+		// queue the chunks on different threads
+		job->setAffinity(i);
+		jobs.push_back(job);
+		sys->addJob(job);
+	}
+	sortRange(bounds[0],bounds[1]);
+	for (auto it = jobs.begin(); it != jobs.end(); it++)
+	{
+		(*it)->finished.wait();
+		// the job is fenced without being executed if the thread pool is stopped
+		if (!(*it)->executed)
+			sortRange((*it)->from,(*it)->to);
+		delete *it;
+	}
+	auto cmp = [this](uint32_t a, uint32_t b) { return lessThan(a,b); };
+	for (uint32_t width = 1; width < chunks; width *= 2)
+	{
+		for (uint32_t i = 0; i+width < chunks; i += 2*width)
+			inplace_merge(order.begin()+bounds[i],order.begin()+bounds[i+width],order.begin()+bounds[min(i+2*width,chunks)],cmp);
+	}
+}
@@ -0,0 +1,73 @@
+/**************************************************************************
+    Lightspark, a free flash player implementation
+
+    Copyright (C) 2009-2013  Alessandro Pignotti (a.pignotti@sssup.it)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+#ifndef SCRIPTING_SORTKEYS_H
+#define SCRIPTING_SORTKEYS_H 1
+
+#include <vector>
+#include <cstdint>
+#include "swftypes.h"
+
+namespace lightspark
+{
+
+class SystemState;
+
+struct sortkeyfield
+{
+	bool isNumeric;
+	bool isCaseInsensitive;
+	bool isDescending;
+	sortkeyfield(bool n, bool ci, bool d):isNumeric(n),isCaseInsensitive(ci),isDescending(d) {}
+};
+
+/*
+ * Stable sort of elements by keys that are extracted once per element,
+ * so the elements don't have to be converted to strings or numbers on every comparison.
+ * Numeric keys are stored as order preserving integers, a single numeric key is sorted by radix sort.
+ * String keys are compared bytewise, case insensitive keys are stored as the casefolded string.
+ * Very large comparison sorts are split over the thread pool and merged afterwards.
+ * The keys have to be set on the calling thread, as extracting them may run AS3 code.
+ */
+class SortKeys
+{
+friend class SortKeysJob;
+private:
+	std::vector<sortkeyfield> fields;
+	uint32_t count;
+	// the keys of element i are at i*fields.size()
+	std::vector<uint64_t> numkeys;
+	std::vector<tiny_string> strkeys;
+	std::vector<uint32_t> order;
+	bool lessThan(uint32_t a, uint32_t b) const;
+	void radixSort();
+	void sortRange(uint32_t from, uint32_t to);
+public:
+	SortKeys(uint32_t _count, const std::vector<sortkeyfield>& _fields);
+	void setNumber(uint32_t index, uint32_t field, number_t n);
+	void setString(uint32_t index, uint32_t field, const tiny_string& s);
+	// sorts the elements, sys may be null if the sort should not use the thread pool
+	void sort(SystemState* sys);
+	uint32_t size() const { return count; }
+	// returns the original index of the element at position i of the sorted elements
+	uint32_t operator[](uint32_t i) const { return order[i]; }
+};
+
+}
+#endif /* SCRIPTING_SORTKEYS_H */
@@ -33,30 +33,97 @@
 using namespace std;
 using namespace lightspark;
 
-ASString::ASString(ASWorker* wrk,Class_base* c):ASObject(wrk,c,T_STRING),hasId(true),datafilled(true)
+ASString::ASString(ASWorker* wrk,Class_base* c):ASObject(wrk,c,T_STRING),builder(nullptr),hasId(true),datafilled(true)
 {
 	stringId = BUILTIN_STRINGS::EMPTY;
 }
 
-ASString::ASString(ASWorker* wrk,Class_base* c,const string& s) : ASObject(wrk,c,T_STRING),data(s),hasId(false),datafilled(true)
+ASString::ASString(ASWorker* wrk,Class_base* c,const string& s) : ASObject(wrk,c,T_STRING),data(s),builder(nullptr),hasId(false),datafilled(true)
 {
 }
 
-ASString::ASString(ASWorker* wrk,Class_base* c,const tiny_string& s) : ASObject(wrk,c,T_STRING),data(s),hasId(false),datafilled(true)
+ASString::ASString(ASWorker* wrk,Class_base* c,const tiny_string& s) : ASObject(wrk,c,T_STRING),data(s),builder(nullptr),hasId(false),datafilled(true)
 {
 }
 
-ASString::ASString(ASWorker* wrk,Class_base* c,const char* s) : ASObject(wrk,c,T_STRING),data(s, /*copy:*/true),hasId(false),datafilled(true)
+ASString::ASString(ASWorker* wrk,Class_base* c,const char* s) : ASObject(wrk,c,T_STRING),data(s, /*copy:*/true),builder(nullptr),hasId(false),datafilled(true)
 {
 }
 
-ASString::ASString(ASWorker* wrk,Class_base* c,const char* s, uint32_t len) : ASObject(wrk,c,T_STRING)
+ASString::ASString(ASWorker* wrk,Class_base* c,const char* s, uint32_t len) : ASObject(wrk,c,T_STRING),builder(nullptr)
 {
 	data = std::string(s,len);
 	hasId = false;
 	datafilled=true;
 }
 
+// minimum length in bytes of a concatenation that is stored in a builder
+#define STRINGBUILDER_MIN_SIZE 256
+ASString* ASString::concatenate(ASWorker* wrk, const tiny_string& r)
+{
+	uint32_t len = builder ? builderlength : getData().numBytes();
+	if (len+r.numBytes() < STRINGBUILDER_MIN_SIZE)
+		return nullptr;
+	ASString* ret = Class<ASString>::getInstanceSNoArgs(wrk);
+	if (builder && builderlength == builder->buffer.size())
+	{
+		// this string is the end of the builder, so the result can share it
+		builder->refcount++;
+		ret->builder = builder;
+		ret->buildernumchars = buildernumchars;
+		ret->builderisascii = builderisascii;
+		ret->builderhasnull = builderhasnull;
+	}
+	else
+	{
+		ret->builder = new asstringbuilder();
+		if (builder)
+		{
+			ret->builder->buffer.assign(builder->buffer,0,builderlength);
+			ret->buildernumchars = buildernumchars;
+			ret->builderisascii = builderisascii;
+			ret->builderhasnull = builderhasnull;
+		}
+		else
+		{
+			ret->builder->buffer.assign(data.raw_buf(),data.numBytes());
+			ret->buildernumchars = data.numChars();
+			ret->builderisascii = data.isSinglebyte();
+			ret->builderhasnull = data.hasNullEntries();
+		}
+	}
+	ret->builder->buffer.append(r.raw_buf(),r.numBytes());
+	ret->builderlength = ret->builder->buffer.size();
+	ret->buildernumchars += r.numChars();
+	ret->builderisascii = ret->builderisascii && r.isSinglebyte();
+	ret->builderhasnull = ret->builderhasnull || r.hasNullEntries();
+	ret->data.clear();
+	ret->stringId = UINT32_MAX;
+	ret->hasId = false;
+	ret->datafilled = false;
+	return ret;
+}
+
+void ASString::fillData()
+{
+	if (builder)
+	{
+		// the flat copy is used from now on, so the buffer is not kept alive for this string
+		data.setValue(builder->buffer.data(),builderlength,buildernumchars,builderisascii,builderhasnull,true);
+		releaseBuilder();
+	}
+	else
+		data = getSystemState()->getStringFromUniqueId(stringId);
+	datafilled = true;
+}
+
+void ASString::releaseBuilder()
+{
+	if (builder && --builder->refcount == 0)
+		delete builder;
+	builder = nullptr;
+}
+
 ASFUNCTIONBODY_ATOM(ASString,_constructor)
 {
 	ASString* th=asAtomHandler::as<ASString>(obj);
@@ -79,7 +146,7 @@ ASFUNCTIONBODY_ATOM(ASString,_getLength)
 	else if (asAtomHandler::isString(obj))
 	{
 		ASString* th = asAtomHandler::getObjectNoCheck(obj)->as<ASString>();
-		asAtomHandler::setInt(ret,wrk,int32_t(th->getData().numChars()));
+		asAtomHandler::setInt(ret,wrk,int32_t(th->getNumChars()));
 	}
 	else
 	{
@@ -148,62 +215,29 @@ ASFUNCTIONBODY_ATOM(ASString,search)
 		return;
 	}
 
-	int options=PCRE_UTF8|PCRE_NEWLINE_ANY|PCRE_NO_UTF8_CHECK;//|PCRE_JAVASCRIPT_COMPAT;
-	tiny_string restr;
+	std::shared_ptr<regexpcompiled> pcreRE;
 	if(asAtomHandler::is<RegExp>(args[0]))
-	{
-		RegExp* re=asAtomHandler::as<RegExp>(args[0]);
-		restr = re->source;
-		if(re->ignoreCase)
-			options|=PCRE_CASELESS;
-		if(re->extended)
-			options|=PCRE_EXTENDED;
-		if(re->multiline)
-			options|=PCRE_MULTILINE;
-		if(re->dotall)
-			options|=PCRE_DOTALL;
-	}
+		pcreRE = asAtomHandler::as<RegExp>(args[0])->compile(true);
 	else
+		pcreRE = RegExp::getCompiledPattern(asAtomHandler::toString(args[0],wrk),PCRE_UTF8|PCRE_NEWLINE_ANY|PCRE_NO_UTF8_CHECK);//|PCRE_JAVASCRIPT_COMPAT;
+	if(!pcreRE)
 	{
-		restr = asAtomHandler::toString(args[0],wrk);
-	}
-
-	const char* error;
-	int errorOffset;
-	pcre* pcreRE=pcre_compile(restr.raw_buf(), options, &error, &errorOffset,nullptr);
-	if(error)
-	{
-		pcre_free(pcreRE);
-		asAtomHandler::setInt(ret,wrk,res);
-		return;
-	}
-	int capturingGroups;
-	int infoOk=pcre_fullinfo(pcreRE, nullptr, PCRE_INFO_CAPTURECOUNT, &capturingGroups);
-	if(infoOk!=0)
-	{
-		pcre_free(pcreRE);
 		asAtomHandler::setInt(ret,wrk,res);
 		return;
 	}
-	pcre_extra extra;
-	extra.match_limit_recursion=500;
-	extra.flags = PCRE_EXTRA_MATCH_LIMIT_RECURSION;
+	int capturingGroups=pcreRE->capturingGroups;
 	int ovector[(capturingGroups+1)*3];
 	int offset=0;
 	//Global is not used in search
-	int rc=pcre_exec(pcreRE, &extra, data.raw_buf(), data.numBytes(), offset, PCRE_NO_UTF8_CHECK, ovector, (capturingGroups+1)*3);
+	int rc=pcreRE->exec(data, offset, ovector, (capturingGroups+1)*3, 500);
 	if(rc<0)
 	{
 		//No matches or error
-		pcre_free(pcreRE);
 		asAtomHandler::setInt(ret,wrk,res);
 		return;
 	}
-	pcre_free(pcreRE);
-	res=ovector[0];
 	// pcre_exec returns byte position, so we have to convert it to character position 
-	tiny_string tmp = data.substr_bytes(0, res);
-	res = tmp.numChars();
+	res = data.bytePosToIndex(ovector[0]);
 	asAtomHandler::setInt(ret,wrk,res);
 }
 
@@ -329,23 +363,13 @@ ASFUNCTIONBODY_ATOM(ASString,split)
 			return;
 		}
 
-		pcre* pcreRE = re->compile(!data.isSinglebyte());
+		std::shared_ptr<regexpcompiled> pcreRE = re->compile(!data.isSinglebyte());
 		if (!pcreRE)
 		{
 			ret = asAtomHandler::fromObject(res);
 			return;
 		}
-		int capturingGroups;
-		int infoOk=pcre_fullinfo(pcreRE, nullptr, PCRE_INFO_CAPTURECOUNT, &capturingGroups);
-		if(infoOk!=0)
-		{
-			pcre_free(pcreRE);
-			ret = asAtomHandler::fromObject(res);
-			return;
-		}
-		pcre_extra extra;
-		extra.match_limit_recursion=200;
-		extra.flags = PCRE_EXTRA_MATCH_LIMIT_RECURSION;
+		int capturingGroups=pcreRE->capturingGroups;
 		int ovector[(capturingGroups+1)*3];
 		int offset=0;
 		unsigned int end;
@@ -353,7 +377,7 @@ ASFUNCTIONBODY_ATOM(ASString,split)
 		do
 		{
 			//offset is a byte offset that must point to the beginning of an utf8 character
-			int rc=pcre_exec(pcreRE, &extra, data.raw_buf(), data.numBytes(), offset, PCRE_NO_UTF8_CHECK, ovector, (capturingGroups+1)*3);
+			int rc=pcreRE->exec(data, offset, ovector, (capturingGroups+1)*3, 200);
 			end=ovector[0];
 			if(rc<0)
 				break;
@@ -385,7 +409,6 @@ ASFUNCTIONBODY_ATOM(ASString,split)
 			ASObject* s=abstract_s(wrk,data.substr_bytes(lastMatch,data.numBytes()-lastMatch));
 			res->push(asAtomHandler::fromObject(s));
 		}
-		pcre_free(pcreRE);
 	}
 	else
 	{
@@ -692,9 +715,9 @@ TRISTATE ASString::isLessAtom(asAtom& r)
 	return (a<b)?TTRUE:TFALSE;
 }
 
-void ASString::serialize(ByteArray* out, std::map<tiny_string, uint32_t>& stringMap,
-				std::map<const ASObject*, uint32_t>& objMap,
-				std::map<const Class_base*, uint32_t>& traitsMap,ASWorker* wrk)
+void ASString::serialize(ByteArray* out, amf3stringtable& stringMap,
+				amf3objecttable& objMap,
+				amf3traitstable& traitsMap,ASWorker* wrk)
 {
 	if (out->getObjectEncoding() == OBJECT_ENCODING::AMF0)
 	{
@@ -713,6 +736,8 @@ string ASString::toDebugString() const
 	tiny_string ret;
 	if (!datafilled && hasId)
 		ret = std::string("\"") + std::string(getSystemState()->getStringFromUniqueId(stringId)) + "\"_id";
+	else if (!datafilled && builder)
+		ret = std::string("\"") + builder->buffer.substr(0,builderlength) + "\"_concatenated";
 	else
 		ret = std::string("\"") + std::string(data) + "\"";
 #ifndef _NDEBUG
@@ -991,24 +1016,14 @@ ASFUNCTIONBODY_ATOM(ASString,replace)
 	{
 		RegExp* re=asAtomHandler::as<RegExp>(args[0]);
 
-		pcre* pcreRE = re->compile(!data.isSinglebyte());
+		std::shared_ptr<regexpcompiled> pcreRE = re->compile(!data.isSinglebyte());
 		if (!pcreRE)
 		{
 			ret = asAtomHandler::fromObject(res);
 			return;
 		}
 
-		int capturingGroups;
-		int infoOk=pcre_fullinfo(pcreRE, nullptr, PCRE_INFO_CAPTURECOUNT, &capturingGroups);
-		if(infoOk!=0)
-		{
-			pcre_free(pcreRE);
-			ret = asAtomHandler::fromObject(res);
-			return;
-		}
-		pcre_extra extra;
-		extra.match_limit_recursion=200;
-		extra.flags = PCRE_EXTRA_MATCH_LIMIT_RECURSION;
+		int capturingGroups=pcreRE->capturingGroups;
 		int ovector[(capturingGroups+1)*3];
 		int offset=0;
 		int retDiff=0;
@@ -1016,11 +1031,10 @@ ASFUNCTIONBODY_ATOM(ASString,replace)
 		do
 		{
 			tiny_string replaceWithTmp = replaceWith;
-			int rc=pcre_exec(pcreRE, &extra, res->getData().raw_buf(), res->getData().numBytes(), offset, PCRE_NO_UTF8_CHECK, ovector, (capturingGroups+1)*3);
+			int rc=pcreRE->exec(res->getData(), offset, ovector, (capturingGroups+1)*3, 200);
 			if(rc<0)
 			{
 				//No matches or error
-				pcre_free(pcreRE);
 				ret = asAtomHandler::fromObject(res);
 				return;
 			}
@@ -1101,7 +1115,6 @@ ASFUNCTIONBODY_ATOM(ASString,replace)
 			retDiff+=replaceWithTmp.numBytes()-(ovector[1]-ovector[0]);
 		}
 		while(re->global);
-		pcre_free(pcreRE);
 	}
 	else
 	{
@@ -27,6 +27,17 @@ namespace Glib { class ustring; }
 
 namespace lightspark
 {
+/*
+ * shared buffer of strings created by repeated concatenation.
+ * Every string using the builder is a prefix of the buffer,
+ * only a string that uses the whole buffer may append to it
+ */
+struct asstringbuilder
+{
+	std::string buffer;
+	uint32_t refcount;
+	asstringbuilder():refcount(1) {}
+};
 /*
  * The AS String class.
  * The 'data' is immutable -> it cannot be changed after creation of the object
@@ -42,10 +53,16 @@ class ASString: public ASObject
 private:
 	number_t parseStringInfinite(const char *s, char **end) const;
 	tiny_string data;
-	
-	// stores the position of utf8-characters in the string
-	// speeds up direct access to characters by position
-	std::vector<uint32_t> charpositions;
+
+	// concatenated strings are kept in a builder and only copied to 'data' when the data is accessed,
+	// the builder is released once the data is copied
+	asstringbuilder* builder;
+	uint32_t builderlength;
+	uint32_t buildernumchars;
+	bool builderisascii:1;
+	bool builderhasnull:1;
+	void fillData();
+	void releaseBuilder();
 public:
 	ASString(ASWorker* wrk,Class_base* c);
 	ASString(ASWorker* wrk,Class_base* c, const std::string& s);
@@ -53,23 +70,32 @@ public:
 	ASString(ASWorker* wrk,Class_base* c, const Glib::ustring& s);
 	ASString(ASWorker* wrk,Class_base* c, const char* s);
 	ASString(ASWorker* wrk,Class_base* c, const char* s, uint32_t len);
+	~ASString() { releaseBuilder(); }
 	bool hasId:1;
 	bool datafilled:1;
 	FORCE_INLINE tiny_string& getData()
 	{
 		if (!datafilled)
-		{
-			data = getSystemState()->getStringFromUniqueId(stringId);
-			datafilled = true;
-		}
+			fillData();
 		return data;
 	}
 	FORCE_INLINE bool isEmpty() const
 	{
 		if (hasId)
 			return stringId == BUILTIN_STRINGS::EMPTY || stringId == UINT32_MAX;
+		if (builder)
+			return builderlength == 0;
 		return data.empty();
 	}
+	FORCE_INLINE uint32_t getNumChars()
+	{
+		if (!datafilled && builder)
+			return buildernumchars;
+		return getData().numChars();
+	}
+	/* returns the concatenation of this string and r in amortized constant time,
+	 * or nullptr if the result is too short to be worth using a builder */
+	ASString* concatenate(ASWorker* wrk, const tiny_string& r);
 
 	static void sinit(Class_base* c);
 	ASFUNCTION_ATOM(_constructor);
@@ -103,18 +129,18 @@ public:
 
 	ASFUNCTION_ATOM(generator);
 	//Serialization interface
-	void serialize(ByteArray* out, std::map<tiny_string, uint32_t>& stringMap,
-				std::map<const ASObject*, uint32_t>& objMap,
-				std::map<const Class_base*, uint32_t>& traitsMap, ASWorker* wrk) override;
+	void serialize(ByteArray* out, amf3stringtable& stringMap,
+				amf3objecttable& objMap,
+				amf3traitstable& traitsMap, ASWorker* wrk) override;
 	std::string toDebugString() const override;
 	static bool isEcmaSpace(uint32_t c);
 	static bool isEcmaLineTerminator(uint32_t c);
 	inline bool destruct() override
 	{
 		data.clear(); 
+		releaseBuilder();
 		hasId = false;
 		datafilled=false; 
-		charpositions.clear();
 		if (!destructIntern())
 		{
 			stringId = BUILTIN_STRINGS::EMPTY;
@@ -126,20 +152,10 @@ public:
 	}
 	inline uint32_t getBytePosition(uint32_t charpos)
 	{
+		getData();
 		if (charpos > data.numChars())
 			return UINT32_MAX;
-		if (data.isSinglebyte())
-			return charpos;
-		if (charpositions.empty())
-		{
-			charpositions.reserve(this->data.numChars());
-			for (auto it = data.begin(); it != data.end(); it++)
-			{
-				charpositions.push_back(it.ptr()-data.raw_buf());
-			}
-		}
-		return charpositions[charpos];
-		
+		return data.charPointer(charpos)-data.raw_buf();
 	}
 };
 
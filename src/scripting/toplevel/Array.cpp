@@ -20,6 +20,7 @@
 #include "scripting/toplevel/Array.h"
 #include "scripting/abc.h"
 #include "scripting/argconv.h"
+#include "scripting/sortkeys.h"
 #include "parsing/amf3_generator.h"
 #include "scripting/toplevel/toplevel.h"
 #include "scripting/toplevel/AVM1Function.h"
@@ -1003,57 +1004,6 @@ ASFUNCTIONBODY_ATOM(Array,_pop)
 }
 
 
-bool Array::sortComparatorDefault::operator()(const asAtom& d1, const asAtom& d2)
-{
-	asAtom o1 = d1;
-	asAtom o2 = d2;
-	if(isNumeric)
-	{
-		number_t a=numeric_limits<double>::quiet_NaN();
-		number_t b=numeric_limits<double>::quiet_NaN();
-		if (useoldversion)
-		{
-			a=asAtomHandler::toInt(o1) & 0x1fffffff;
-			b=asAtomHandler::toInt(o2) & 0x1fffffff;
-		}
-		else
-		{
-			a=asAtomHandler::toNumber(o1);
-			b=asAtomHandler::toNumber(o2);
-		}
-		if((!asAtomHandler::isNumeric(o1) && std::isnan(a)) || (!asAtomHandler::isNumeric(o2) && std::isnan(b)))
-			throw RunTimeException("Cannot sort non number with Array.NUMERIC option");
-		if(isDescending)
-			return a>b;
-		else
-			return a<b;
-	}
-	else
-	{
-		//Comparison is always in lexicographic order
-		tiny_string s1;
-		tiny_string s2;
-		s1=asAtomHandler::toString(o1,getWorker());
-		s2=asAtomHandler::toString(o2,getWorker());
-
-		if(isDescending)
-		{
-			//TODO: unicode support
-			if(isCaseInsensitive)
-				return s1.strcasecmp(s2)>0;
-			else
-				return s1>s2;
-		}
-		else
-		{
-			//TODO: unicode support
-			if(isCaseInsensitive)
-				return s1.strcasecmp(s2)<0;
-			else
-				return s1<s2;
-		}
-	}
-}
 // std::sort expects strict weak ordering for the comparison function
 // this is not guarranteed by user defined comparison functions, so we need our own sorting method.
 
@@ -1287,7 +1237,33 @@ ASFUNCTIONBODY_ATOM(Array,_sort)
 		qsort(tmp,c,0,tmp.size()-1);
 	}
 	else
-		sort(tmp.begin(),tmp.end(),sortComparatorDefault(wrk->getSystemState()->getSwfVersion() < 11, isNumeric,isCaseInsensitive,isDescending));
+	{
+		// the elements are converted only once, the sort itself doesn't call into AS3 code
+		bool useoldversion = wrk->getSystemState()->getSwfVersion() < 11;
+		SortKeys keys(tmp.size(),std::vector<sortkeyfield>(1,sortkeyfield(isNumeric,isCaseInsensitive,isDescending)));
+		for (uint32_t i = 0; i < tmp.size(); i++)
+		{
+			asAtom o = tmp[i];
+			if (isNumeric)
+			{
+				number_t n;
+				if (useoldversion)
+					n=asAtomHandler::toInt(o) & 0x1fffffff;
+				else
+					n=asAtomHandler::toNumber(o);
+				if (!asAtomHandler::isNumeric(o) && std::isnan(n))
+					throw RunTimeException("Cannot sort non number with Array.NUMERIC option");
+				keys.setNumber(i,0,n);
+			}
+			else
+				keys.setString(i,0,asAtomHandler::toString(o,wrk));
+		}
+		keys.sort(wrk->getSystemState());
+		std::vector<asAtom> sorted(tmp.size());
+		for (uint32_t i = 0; i < tmp.size(); i++)
+			sorted[i]=tmp[keys[i]];
+		tmp.swap(sorted);
+	}
 
 	th->data_first.clear();
 	th->data_second.clear();
@@ -1305,59 +1281,6 @@ ASFUNCTIONBODY_ATOM(Array,_sort)
 	ret = obj;
 }
 
-bool Array::sortOnComparator::operator()(const sorton_value& d1, const sorton_value& d2)
-{
-	std::vector<sorton_field>::iterator it=fields.begin();
-	uint32_t i = 0;
-	for(;it != fields.end();++it)
-	{
-		asAtom obj1 = d1.sortvalues.at(i);
-		asAtom obj2 = d2.sortvalues.at(i);
-		i++;
-		if(it->isNumeric)
-		{
-			number_t a=numeric_limits<double>::quiet_NaN();
-			number_t b=numeric_limits<double>::quiet_NaN();
-			a=asAtomHandler::toNumber(obj1);
-			
-			b=asAtomHandler::toNumber(obj2);
-			
-			if((!asAtomHandler::isNumeric(obj1) && std::isnan(a)) || (!asAtomHandler::isNumeric(obj2) && std::isnan(b)))
-				throw RunTimeException("Cannot sort non number with Array.NUMERIC option");
-			if(it->isDescending)
-				return a>b;
-			else
-				return a<b;
-		}
-		else
-		{
-			//Comparison is always in lexicographic order
-			tiny_string s1;
-			tiny_string s2;
-			s1=asAtomHandler::toString(obj1,getWorker());
-			s2=asAtomHandler::toString(obj2,getWorker());
-			if (s1 != s2)
-			{
-				if(it->isDescending)
-				{
-					if(it->isCaseInsensitive)
-						return s1.strcasecmp(s2)>0;
-					else
-						return s1>s2;
-				}
-				else
-				{
-					if(it->isCaseInsensitive)
-						return s1.strcasecmp(s2)<0;
-					else
-						return s1<s2;
-				}
-			}
-		}
-	}
-	return false;
-}
-
 ASFUNCTIONBODY_ATOM(Array,sortOn)
 {
 	if (argslen != 1 && argslen != 2)
@@ -1371,7 +1294,6 @@ ASFUNCTIONBODY_ATOM(Array,sortOn)
 	if(asAtomHandler::is<Array>(args[0]))
 	{
 		Array* obj=asAtomHandler::as<Array>(args[0]);
-		int n = 0;
 		for(uint32_t i = 0;i<obj->size();i++)
 		{
 			multiname sortfieldname(nullptr);
@@ -1385,8 +1307,8 @@ ASFUNCTIONBODY_ATOM(Array,sortOn)
 		{
 			Array* opts=asAtomHandler::as<Array>(args[1]);
 			auto itopt=opts->data_first.begin();
-			int nopt = 0;
-			for(;itopt != opts->data_first.end() && nopt < n;++itopt)
+			uint32_t nopt = 0;
+			for(;itopt != opts->data_first.end() && nopt < sortfields.size();++itopt)
 			{
 				uint32_t options=0;
 				options = asAtomHandler::toInt(*itopt);
@@ -1424,7 +1346,7 @@ ASFUNCTIONBODY_ATOM(Array,sortOn)
 		sortfields.push_back(sf);
 	}
 	
-	std::vector<sorton_value> tmp;
+	std::vector<asAtom> tmp;
 	auto it1=th->data_first.begin();
 	for(;it1 != th->data_first.end();++it1)
 	{
@@ -1432,15 +1354,7 @@ ASFUNCTIONBODY_ATOM(Array,sortOn)
 			continue;
 		// ensure ASObjects are created
 		asAtomHandler::toObject(*it1,wrk);
-		
-		sorton_value v(*it1);
-		for (auto itsf=sortfields.begin();itsf != sortfields.end(); itsf++)
-		{
-			asAtom tmpval=asAtomHandler::invalidAtom;
-			asAtomHandler::getObject(*it1)->getVariableByMultiname(tmpval,itsf->fieldname,GET_VARIABLE_OPTION::NONE,wrk);
-			v.sortvalues.push_back(tmpval);
-		}
-		tmp.push_back(v);
+		tmp.push_back(*it1);
 	}
 	auto it2=th->data_second.begin();
 	for(;it2 != th->data_second.end();++it2)
@@ -1449,30 +1363,45 @@ ASFUNCTIONBODY_ATOM(Array,sortOn)
 			continue;
 		// ensure ASObjects are created
 		asAtomHandler::toObject(it2->second,wrk);
-		
-		sorton_value v(it2->second);
-		for (auto itsf=sortfields.begin();itsf != sortfields.end(); itsf++)
+		tmp.push_back(it2->second);
+	}
+
+	// the fields are looked up and converted once per element, not on every comparison
+	std::vector<sortkeyfield> keyfields;
+	for (auto itsf=sortfields.begin();itsf != sortfields.end(); itsf++)
+		keyfields.push_back(sortkeyfield(itsf->isNumeric,itsf->isCaseInsensitive,itsf->isDescending));
+	SortKeys keys(tmp.size(),keyfields);
+	for (uint32_t i = 0; i < tmp.size(); i++)
+	{
+		for (uint32_t f = 0; f < sortfields.size(); f++)
 		{
 			asAtom tmpval=asAtomHandler::invalidAtom;
-			asAtomHandler::getObject(it2->second)->getVariableByMultiname(tmpval,itsf->fieldname,GET_VARIABLE_OPTION::NONE,wrk);
-			v.sortvalues.push_back(tmpval);
+			asAtomHandler::getObject(tmp[i])->getVariableByMultiname(tmpval,sortfields[f].fieldname,GET_VARIABLE_OPTION::NONE,wrk);
+			if (sortfields[f].isNumeric)
+			{
+				number_t n=asAtomHandler::toNumber(tmpval);
+				if (!asAtomHandler::isNumeric(tmpval) && std::isnan(n))
+				{
+					ASATOM_DECREF(tmpval);
+					throw RunTimeException("Cannot sort non number with Array.NUMERIC option");
+				}
+				keys.setNumber(i,f,n);
+			}
+			else
+				keys.setString(i,f,asAtomHandler::toString(tmpval,wrk));
+			ASATOM_DECREF(tmpval);
 		}
-		tmp.push_back(v);
 	}
-	
-	sort(tmp.begin(),tmp.end(),sortOnComparator(sortfields));
+	keys.sort(wrk->getSystemState());
 
 	th->data_first.clear();
 	th->data_second.clear();
-	std::vector<sorton_value>::iterator ittmp=tmp.begin();
-	uint32_t i = 0;
-	for(;ittmp != tmp.end();++ittmp)
+	for(uint32_t i = 0; i < tmp.size(); i++)
 	{
 		if (i < ARRAY_SIZE_THRESHOLD)
-			th->data_first.push_back(ittmp->dataAtom);
+			th->data_first.push_back(tmp[keys[i]]);
 		else
-			th->data_second[i] = ittmp->dataAtom;
-		i++;
+			th->data_second[i] = tmp[keys[i]];
 	}
 	// according to spec sortOn should return "nothing"(?), but it seems that the array is returned
 	ASATOM_INCREF(obj);
@@ -2350,9 +2279,9 @@ void Array::resize(uint64_t n,bool removemember)
 	currentsize = n;
 }
 
-void Array::serialize(ByteArray* out, std::map<tiny_string, uint32_t>& stringMap,
-				std::map<const ASObject*, uint32_t>& objMap,
-				std::map<const Class_base*, uint32_t>& traitsMap,ASWorker* wrk)
+void Array::serialize(ByteArray* out, amf3stringtable& stringMap,
+				amf3objecttable& objMap,
+				amf3traitstable& traitsMap,ASWorker* wrk)
 {
 	if (out->getObjectEncoding() == OBJECT_ENCODING::AMF0)
 	{
@@ -2361,22 +2290,24 @@ void Array::serialize(ByteArray* out, std::map<tiny_string, uint32_t>& stringMap
 	}
 	out->writeByte(array_marker);
 	//Check if the array has been already serialized
-	auto it=objMap.find(this);
-	if(it!=objMap.end())
+	uint32_t ref=objMap.find(this);
+	if(ref!=amf3objecttable::npos)
 	{
 		//The least significant bit is 0 to signal a reference
-		out->writeU29(it->second << 1);
+		out->writeU29(ref << 1);
 	}
 	else
 	{
 		//Add the array to the map
-		objMap.insert(make_pair(this, objMap.size()));
+		objMap.add(this);
 
 		uint32_t denseCount = currentsize;
 		assert_and_throw(denseCount<0x20000000);
 		uint32_t value = (denseCount << 1) | 1;
 		out->writeU29(value);
 		serializeDynamicProperties(out, stringMap, objMap, traitsMap,wrk);
+		// every member needs at least one byte
+		out->reserve(out->getPosition()+denseCount);
 		for(uint32_t i=0;i<denseCount;i++)
 		{
 			if (i < ARRAY_SIZE_THRESHOLD)
@@ -2397,23 +2328,21 @@ void Array::serialize(ByteArray* out, std::map<tiny_string, uint32_t>& stringMap
 	}
 }
 
-tiny_string Array::toJSON(std::vector<ASObject *> &path, asAtom replacer, const tiny_string& spaces,const tiny_string& filter)
+void Array::toJSON(std::string& res, std::vector<ASObject *> &path, asAtom replacer, const tiny_string& spaces,const tiny_string& filter)
 {
-	bool ok;
-	tiny_string res = call_toJSON(ok,path,replacer,spaces,filter);
-	if (ok)
-		return res;
+	if (call_toJSON(res,path,replacer,spaces,filter))
+		return;
 	// check for cylic reference
 	if (std::find(path.begin(),path.end(), this) != path.end())
 	{
 		createError<TypeError>(getInstanceWorker(),kJSONCyclicStructure);
-		return res;
+		return;
 	}
 	
 	path.push_back(this);
 	res += "[";
 	bool bfirst = true;
-	tiny_string newline = (spaces.empty() ? "" : "\n");
+	const char* newline = (spaces.empty() ? "" : "\n");
 	uint32_t denseCount = currentsize;
 	asAtom closure = asAtomHandler::isValid(replacer) && asAtomHandler::getClosure(replacer) ? asAtomHandler::fromObject(asAtomHandler::getClosure(replacer)) : asAtomHandler::nullAtom;
 	
@@ -2428,7 +2357,13 @@ tiny_string Array::toJSON(std::vector<ASObject *> &path, asAtom replacer, const
 			if (it != data_second.end())
 				a = it->second;
 		}
-		tiny_string subres;
+		// the separator is written in advance and removed again if the member produces no output
+		size_t separatorpos = res.size();
+		if (!bfirst)
+			res += ",";
+		res += newline;
+		res.append(spaces.raw_buf(),spaces.numBytes());
+		size_t valuepos = res.size();
 		if (asAtomHandler::isValid(replacer) && asAtomHandler::isValid(a))
 		{
 			asAtom params[2];
@@ -2439,7 +2374,7 @@ tiny_string Array::toJSON(std::vector<ASObject *> &path, asAtom replacer, const
 			asAtomHandler::callFunction(replacer,getInstanceWorker(),funcret,closure, params, 2,false);
 			if (asAtomHandler::isValid(funcret))
 			{
-				subres = asAtomHandler::toObject(funcret,getInstanceWorker())->toJSON(path,asAtomHandler::invalidAtom,spaces,filter);
+				asAtomHandler::toObject(funcret,getInstanceWorker())->toJSON(res,path,asAtomHandler::invalidAtom,spaces,filter);
 				ASATOM_DECREF(funcret);
 			}
 		}
@@ -2450,29 +2385,23 @@ tiny_string Array::toJSON(std::vector<ASObject *> &path, asAtom replacer, const
 			ASObject* o = asAtomHandler::isInvalid(a) ? getSystemState()->getNullRef() : asAtomHandler::toObject(tmp,getInstanceWorker());
 			if (o)
 			{
-				subres = o->toJSON(path,replacer,spaces,filter);
+				o->toJSON(res,path,replacer,spaces,filter);
 				if (newobj)
 					o->decRef();
 			}
-			else
-				continue;
 		}
-		if (!subres.empty())
-		{
-			if (!bfirst)
-				res += ",";
-			res += newline+spaces;
-			
+		if (res.size() == valuepos)
+			res.resize(separatorpos);
+		else
 			bfirst = false;
-			res += subres;
-		}
 	}
 	if (!bfirst)
-		res += newline+spaces.substr_bytes(0,spaces.numBytes()/2);
+	{
+		res += newline;
+		res.append(spaces.raw_buf(),spaces.numBytes()/2);
+	}
 	res += "]";
 	path.pop_back();
-	return res;
-	
 }
 
 Array::~Array()
@@ -37,12 +37,6 @@ struct sorton_field
 	multiname fieldname;
 	sorton_field(const multiname& sortfieldname):isNumeric(false),isCaseInsensitive(false),isDescending(false),fieldname(sortfieldname){}
 };
-struct sorton_value
-{
-	std::vector<asAtom> sortvalues;
-	asAtom dataAtom;
-	sorton_value(asAtom _dataAtom):dataAtom(_dataAtom) {}
-};
 
 class Array: public ASObject
 {
@@ -56,25 +50,6 @@ protected:
 	void outofbounds(unsigned int index) const;
 	~Array();
 private:
-	class sortComparatorDefault
-	{
-	private:
-		bool isNumeric;
-		bool isCaseInsensitive;
-		bool isDescending;
-		bool useoldversion;
-	public:
-		sortComparatorDefault(bool oldversion, bool n, bool ci, bool d):isNumeric(n),isCaseInsensitive(ci),isDescending(d),useoldversion(oldversion){}
-		bool operator()(const asAtom& d1, const asAtom& d2);
-	};
-	class sortOnComparator
-	{
-	private:
-		std::vector<sorton_field> fields;
-	public:
-		sortOnComparator(const std::vector<sorton_field>& sf):fields(sf){}
-		bool operator()(const sorton_value& d1, const sorton_value& d2);
-	};
 	void constructorImpl(asAtom *args, const unsigned int argslen);
 	tiny_string toString_priv(bool localized=false);
 	int capIndex(int i);
@@ -165,10 +140,10 @@ public:
 	void nextName(asAtom &ret, uint32_t index) override;
 	void nextValue(asAtom &ret, uint32_t index) override;
 	//Serialization interface
-	void serialize(ByteArray* out, std::map<tiny_string, uint32_t>& stringMap,
-				std::map<const ASObject*, uint32_t>& objMap,
-				std::map<const Class_base*, uint32_t>& traitsMap, ASWorker* wrk) override;
-	virtual tiny_string toJSON(std::vector<ASObject *> &path,asAtom replacer, const tiny_string &spaces,const tiny_string& filter) override;
+	void serialize(ByteArray* out, amf3stringtable& stringMap,
+				amf3objecttable& objMap,
+				amf3traitstable& traitsMap, ASWorker* wrk) override;
+	void toJSON(std::string& res, std::vector<ASObject *> &path, asAtom replacer, const tiny_string &spaces,const tiny_string& filter) override;
 };
 
 
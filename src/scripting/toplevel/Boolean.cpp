@@ -131,9 +131,9 @@ ASFUNCTIONBODY_ATOM(Boolean,_valueOf)
 	asAtomHandler::setBool(ret,asAtomHandler::Boolean_concrete(obj));
 }
 
-void Boolean::serialize(ByteArray* out, std::map<tiny_string, uint32_t>& stringMap,
-				std::map<const ASObject*, uint32_t>& objMap,
-				std::map<const Class_base*, uint32_t>& traitsMap,ASWorker* wrk)
+void Boolean::serialize(ByteArray* out, amf3stringtable& stringMap,
+				amf3objecttable& objMap,
+				amf3traitstable& traitsMap,ASWorker* wrk)
 {
 	if (out->getObjectEncoding() == OBJECT_ENCODING::AMF0)
 	{
@@ -152,9 +152,11 @@ Type* Type::getTypeFromMultiname(multiname* mn, ABCContext* context, bool opport
 	return typeObject ? typeObject->as<Type>() : nullptr;
 }
 
+std::atomic<uint32_t> Class_base::nextUniqueID(0);
+
 Class_base::Class_base(const QName& name, uint32_t _classID, MemoryAccount* m):ASObject(getSys()->worker,Class_object::getClass(getSys()),T_CLASS),protected_ns(getSys(),"",NAMESPACE),constructor(nullptr),
 	qualifiedClassnameID(UINT32_MAX),global(nullptr),
-	context(nullptr),class_name(name),memoryAccount(m),length(1),class_index(-1),isFinal(false),isSealed(false),isInterface(false),isReusable(false),use_protected(false),classID(_classID)
+	context(nullptr),class_name(name),memoryAccount(m),length(1),class_index(-1),isFinal(false),isSealed(false),isInterface(false),isReusable(false),use_protected(false),classID(_classID),uniqueID(++nextUniqueID),traitsRevision(0)
 {
 	setSystemState(getSys());
 	setRefConstant();
@@ -162,7 +164,7 @@ Class_base::Class_base(const QName& name, uint32_t _classID, MemoryAccount* m):A
 
 Class_base::Class_base(const Class_object* c):ASObject((MemoryAccount*)nullptr),protected_ns(getSys(),BUILTIN_STRINGS::EMPTY,NAMESPACE),constructor(nullptr),
 	qualifiedClassnameID(UINT32_MAX),global(nullptr),
-	context(nullptr),class_name(BUILTIN_STRINGS::STRING_CLASS,BUILTIN_STRINGS::EMPTY),memoryAccount(nullptr),length(1),class_index(-1),isFinal(false),isSealed(false),isInterface(false),isReusable(false),use_protected(false),classID(UINT32_MAX)
+	context(nullptr),class_name(BUILTIN_STRINGS::STRING_CLASS,BUILTIN_STRINGS::EMPTY),memoryAccount(nullptr),length(1),class_index(-1),isFinal(false),isSealed(false),isInterface(false),isReusable(false),use_protected(false),classID(UINT32_MAX),uniqueID(++nextUniqueID),traitsRevision(0)
 {
 	type=T_CLASS;
 	//We have tested that (Class is Class == true) so the classdef is 'this'
@@ -185,6 +187,7 @@ Class_base::Class_base(const Class_object* c):ASObject((MemoryAccount*)nullptr),
  */
 void Class_base::copyBorrowedTraits(Class_base* src)
 {
+	traitsRevision++;
 	//assert(borrowedVariables.Variables.empty());
 	variables_map::var_iterator i = src->borrowedVariables.Variables.begin();
 	for(;i != src->borrowedVariables.Variables.end(); ++i)
@@ -1201,6 +1204,7 @@ void Class_base::removeAllDeclaredProperties()
 {
 	Variables.removeAllDeclaredProperties();
 	borrowedVariables.removeAllDeclaredProperties();
+	traitsRevision++;
 }
 
 multiname* Class_base::setVariableByMultiname(multiname& name, asAtom& o, CONST_ALLOWED_FLAG allowConst, bool* alreadyset, ASWorker* wrk)
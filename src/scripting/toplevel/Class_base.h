@@ -191,6 +191,11 @@ private:
 	bool use_protected:1;
 public:
 	uint32_t classID;
+	// unique for every class ever created, unlike the address it is never reused for a different class
+	const uint32_t uniqueID;
+	static std::atomic<uint32_t> nextUniqueID;
+	// incremented every time the borrowed traits are changed, used to invalidate the property caches of the preloaded code
+	uint32_t traitsRevision;
 	void addConstructorGetter();
 	void addPrototypeGetter();
 	void addLengthGetter();
@@ -128,9 +128,9 @@ public:
 	tiny_string format(const char* fmt, bool utc);
 	tiny_string toString();
 	//Serialization interface
-	void serialize(ByteArray* out, std::map<tiny_string, uint32_t>& stringMap,
-				std::map<const ASObject*, uint32_t>& objMap,
-				std::map<const Class_base*, uint32_t>& traitsMap, ASWorker* wrk);
+	void serialize(ByteArray* out, amf3stringtable& stringMap,
+				amf3objecttable& objMap,
+				amf3traitstable& traitsMap, ASWorker* wrk);
 };
 }
 #endif /* SCRIPTING_TOPLEVEL_DATE_H */
@@ -236,9 +236,9 @@ std::string IFunction::toDebugString() const
 #endif
 	return ret;
 }
-void IFunction::serialize(ByteArray* out, std::map<tiny_string, uint32_t>& stringMap,
-				std::map<const ASObject*, uint32_t>& objMap,
-				std::map<const Class_base*, uint32_t>& traitsMap,ASWorker* wrk)
+void IFunction::serialize(ByteArray* out, amf3stringtable& stringMap,
+				amf3objecttable& objMap,
+				amf3traitstable& traitsMap,ASWorker* wrk)
 {
 	// according to avmplus functions are "serialized" as undefined
 	if (out->getObjectEncoding() == OBJECT_ENCODING::AMF0)
@@ -112,9 +112,9 @@ public:
 	virtual multiname* callGetter(asAtom& ret, ASObject* target,ASWorker* wrk) =0;
 	virtual Class_base* getReturnType(bool opportunistic=false) =0;
 	std::string toDebugString() const override;
-	void serialize(ByteArray* out, std::map<tiny_string, uint32_t>& stringMap,
-				std::map<const ASObject*, uint32_t>& objMap,
-				std::map<const Class_base*, uint32_t>& traitsMap, ASWorker* wrk) override;
+	void serialize(ByteArray* out, amf3stringtable& stringMap,
+				amf3objecttable& objMap,
+				amf3traitstable& traitsMap, ASWorker* wrk) override;
 };
 }
 
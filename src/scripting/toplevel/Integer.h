@@ -60,9 +60,9 @@ public:
 	ASFUNCTION_ATOM(_toPrecision);
 	std::string toDebugString() const override { return toString()+"i"; }
 	//Serialization interface
-	void serialize(ByteArray* out, std::map<tiny_string, uint32_t>& stringMap,
-				std::map<const ASObject*, uint32_t>& objMap,
-				std::map<const Class_base*, uint32_t>& traitsMap, ASWorker* wrk) override;
+	void serialize(ByteArray* out, amf3stringtable& stringMap,
+				amf3objecttable& objMap,
+				amf3traitstable& traitsMap, ASWorker* wrk) override;
 	static void serializeValue(ByteArray* out,int32_t val);
 	/*
 	 * This method skips trailing spaces and zeroes
@@ -21,6 +21,10 @@
 #include "scripting/toplevel/JSON.h"
 #include "scripting/toplevel/Array.h"
 #include "scripting/toplevel/Integer.h"
+#include <cstring>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 using namespace std;
 using namespace lightspark;
@@ -147,61 +151,109 @@ ASFUNCTIONBODY_ATOM(JSON,_stringify)
 				spaces = spaces.substr_bytes(0,10);
 		}
 	}
-	tiny_string res;
+	// all members are written to one buffer, the string is only created once at the end
+	std::string res;
 	if (asAtomHandler::isObject(value))
-		res = asAtomHandler::getObjectNoCheck(value)->toJSON(path,replacer,spaces,filter);
+		asAtomHandler::getObjectNoCheck(value)->toJSON(res,path,replacer,spaces,filter);
 	else if (asAtomHandler::isUndefined(value))
 		res ="null";
 	else if(asAtomHandler::isString(value))
-		res = asAtomHandler::toString(value,wrk).toQuotedString();
+		asAtomHandler::toString(value,wrk).toQuotedString(res);
 	else
 		res = asAtomHandler::toString(value,wrk);
-	ret = asAtomHandler::fromObject(abstract_s(wrk,res));
+	ret = asAtomHandler::fromObject(abstract_s(wrk,tiny_string(res)));
+}
+
+/*
+ * The parser works directly on the utf-8 bytes of the input.
+ * All structural characters of JSON are ASCII and never part of a multibyte sequence,
+ * so the bytes of strings can be copied without decoding them.
+ */
+namespace
+{
+inline bool isJSONWhitespace(char c)
+{
+	return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+inline const char* skipWhitespace(const char* it, const char* end)
+{
+	while (it < end && isJSONWhitespace(*it))
+		it++;
+	return it;
+}
+// returns the position of the first '"', '\\' or control character starting at it
+inline const char* scanStringRun(const char* it, const char* end)
+{
+#ifdef __SSE2__
+	const __m128i quote = _mm_set1_epi8('"');
+	const __m128i backslash = _mm_set1_epi8('\\');
+	const __m128i control = _mm_set1_epi8(0x1f);
+	while (end-it >= 16)
+	{
+		__m128i v = _mm_loadu_si128((const __m128i*)it);
+		__m128i m = _mm_or_si128(_mm_cmpeq_epi8(v,quote),_mm_cmpeq_epi8(v,backslash));
+		// unsigned v <= 0x1f
+		m = _mm_or_si128(m,_mm_cmpeq_epi8(_mm_min_epu8(v,control),v));
+		int mask = _mm_movemask_epi8(m);
+		if (mask)
+			return it+__builtin_ctz(mask);
+		it += 16;
+	}
+#endif
+	while (it < end && *it != '"' && *it != '\\' && uint8_t(*it) >= 0x20)
+		it++;
+	return it;
+}
+inline int hexValue(char c)
+{
+	if (c >= '0' && c <= '9')
+		return c-'0';
+	if (c >= 'a' && c <= 'f')
+		return c-'a'+10;
+	if (c >= 'A' && c <= 'F')
+		return c-'A'+10;
+	return -1;
+}
 }
 
 bool JSON::parseAll(const tiny_string &jsonstring, asAtom& parent , multiname& key, asAtom reviver, ASWorker* wrk)
 {
-	CharIterator it = jsonstring.begin();
-	while (it != jsonstring.end())
+	const char* it = jsonstring.raw_buf();
+	const char* end = it+jsonstring.numBytes();
+	while (it < end)
 	{
 		if (asAtomHandler::isPrimitive(parent))
 			return false;
-		if (!parse(jsonstring, it, parent , key, reviver,wrk))
+		if (!parse(it, end, parent , key, reviver,wrk))
 			return false;
-		while (*it == ' ' ||
-			   *it == '\t' ||
-			   *it == '\n' ||
-			   *it == '\r'
-			   )
-			it++;
+		it = skipWhitespace(it,end);
 	}
 	return true;
 }
-bool JSON::parse(const tiny_string &jsonstring, CharIterator& it, asAtom& parent , multiname& key, asAtom reviver, ASWorker* wrk)
+bool JSON::parse(const char*& it, const char* end, asAtom& parent , multiname& key, asAtom reviver, ASWorker* wrk)
 {
-	while (*it == ' ' ||
-		   *it == '\t' ||
-		   *it == '\n' ||
-		   *it == '\r'
-		   )
-		   it++;
-	if (it != jsonstring.end())
+	it = skipWhitespace(it,end);
+	if (it < end)
 	{
-		char c = *it;
-		switch(c)
+		switch(*it)
 		{
 			case '{':
-				if (!parseObject(jsonstring,it,parent,key, reviver,wrk))
+				if (!parseObject(it,end,parent,key, reviver,wrk))
 					return false;
 				break;
 			case '[': 
-				if (!parseArray(jsonstring,it,parent,key, reviver,wrk))
+				if (!parseArray(it,end,parent,key, reviver,wrk))
 					return false;
 				break;
 			case '"':
-				if (!parseString(jsonstring,it,parent,key,wrk))
+			{
+				tiny_string res;
+				if (!parseString(it,end,res))
+					return false;
+				if (!storeValue(parent,key,asAtomHandler::fromObject(abstract_s(wrk,res)),wrk))
 					return false;
 				break;
+			}
 			case '0':
 			case '1':
 			case '2':
@@ -213,19 +265,19 @@ bool JSON::parse(const tiny_string &jsonstring, CharIterator& it, asAtom& parent
 			case '8':
 			case '9':
 			case '-':
-				if (!parseNumber(jsonstring,it,parent,key,wrk))
+				if (!parseNumber(it,end,parent,key,wrk))
 					return false;
 				break;
 			case 't':
-				if (!parseTrue(it,parent,key,wrk))
+				if (!parseLiteral(it,end,"true",asAtomHandler::trueAtom,parent,key,wrk))
 					return false;
 				break;
 			case 'f':
-				if (!parseFalse(it,parent,key,wrk))
+				if (!parseLiteral(it,end,"false",asAtomHandler::falseAtom,parent,key,wrk))
 					return false;
 				break;
 			case 'n':
-				if (!parseNull(it,parent,key,wrk))
+				if (!parseLiteral(it,end,"null",asAtomHandler::nullAtom,parent,key,wrk))
 					return false;
 				break;
 			default:
@@ -298,288 +350,227 @@ bool JSON::parse(const tiny_string &jsonstring, CharIterator& it, asAtom& parent
 	}
 	return true;
 }
-bool JSON::parseTrue(CharIterator& it, asAtom& parent, multiname &key, ASWorker* wrk)
+bool JSON::storeValue(asAtom& parent, multiname &key, asAtom v, ASWorker* wrk)
 {
-	if (*it++ != 't')
-		return false;
-	if (*it++ != 'r')
-		return false;
-	if (*it++ != 'u')
-		return false;
-	if (*it++ != 'e')
-		return false;
 	if (asAtomHandler::isInvalid(parent))
-		parent = asAtomHandler::trueAtom;
-	else if (asAtomHandler::isObject(parent))
 	{
-		asAtom v = asAtomHandler::trueAtom;
-		asAtomHandler::getObjectNoCheck(parent)->setVariableByMultiname(key,v,ASObject::CONST_NOT_ALLOWED,nullptr,wrk);
+		parent = v;
+		return true;
 	}
-	else
-		return false;
-	return true;
-}
-bool JSON::parseFalse(CharIterator& it, asAtom& parent, multiname &key, ASWorker* wrk)
-{
-	if (*it++ != 'f')
-		return false;
-	if (*it++ != 'a')
-		return false;
-	if (*it++ != 'l')
-		return false;
-	if (*it++ != 's')
-		return false;
-	if (*it++ != 'e')
+	if (!asAtomHandler::isObject(parent))
+	{
+		ASATOM_DECREF(v);
 		return false;
-	if (asAtomHandler::isInvalid(parent))
-		parent = asAtomHandler::falseAtom;
-	else if (asAtomHandler::isObject(parent))
+	}
+	ASObject* o = asAtomHandler::getObjectNoCheck(parent);
+	if (key.name_type == multiname::NAME_STRING)
 	{
-		asAtom v = asAtomHandler::falseAtom;
-		asAtomHandler::getObjectNoCheck(parent)->setVariableByMultiname(key,v,ASObject::CONST_NOT_ALLOWED,nullptr,wrk);
+		// members of objects created by parseObject are always dynamic, so they can be set directly by the interned key
+		o->setVariableAtomByQName(key.name_s_id,nsNameAndKind(BUILTIN_NAMESPACES::EMPTY_NS),v,DYNAMIC_TRAIT);
+	}
+	else if (key.name_type == multiname::NAME_UINT && o->is<Array>() && key.name_ui == o->as<Array>()->size())
+	{
+		// dense arrays are appended to without going through the multiname lookup
+		o->as<Array>()->push(v);
 	}
 	else
-		return false;
+		o->setVariableByMultiname(key,v,ASObject::CONST_NOT_ALLOWED,nullptr,wrk);
 	return true;
 }
-bool JSON::parseNull(CharIterator& it, asAtom& parent, multiname &key, ASWorker* wrk)
+bool JSON::parseLiteral(const char*& it, const char* end, const char* literal, asAtom value, asAtom& parent, multiname &key, ASWorker* wrk)
 {
-	if (*it++ != 'n')
-		return false;
-	if (*it++ != 'u')
-		return false;
-	if (*it++ != 'l')
-		return false;
-	if (*it++ != 'l')
-		return false;
-	if (asAtomHandler::isInvalid(parent))
-		parent = asAtomHandler::nullAtom;
-	else if (asAtomHandler::isObject(parent))
-	{
-		asAtom v = asAtomHandler::nullAtom;
-		asAtomHandler::getObjectNoCheck(parent)->setVariableByMultiname(key,v,ASObject::CONST_NOT_ALLOWED,nullptr,wrk);
-	}
-	else
+	size_t len = strlen(literal);
+	if (size_t(end-it) < len || memcmp(it,literal,len) != 0)
 		return false;
-	return true;
+	it += len;
+	return storeValue(parent,key,value,wrk);
 }
-bool JSON::parseString(const tiny_string& jsonstring, CharIterator& it, asAtom& parent, multiname &key, ASWorker* wrk, tiny_string* result)
+bool JSON::parseString(const char*& it, const char* end, tiny_string& result)
 {
 	it++; // ignore starting quotes
-	if (it == jsonstring.end())
-		return false;
-
-	tiny_string res;
-	bool done = false;
-	while (it!=jsonstring.end())
+	const char* start = it;
+	it = scanStringRun(it,end);
+	if (it < end && *it == '\"')
+	{
+		// no escape sequences, the bytes can be used as they are
+		uint32_t numchars = 0;
+		bool isascii = true;
+		for (const char* c = start; c < it; c++)
+		{
+			if ((*c & 0xc0) != 0x80)
+				numchars++;
+			if (*c & 0x80)
+				isascii = false;
+		}
+		result.setValue(start,it-start,numchars,isascii,false,true);
+		it++;
+		return true;
+	}
+	std::string res(start,it-start);
+	while (it < end)
 	{
-		if (*it == '\"')
+		char c = *it;
+		if (c == '\"')
 		{
 			it++;
-			done = true;
-			break;
+			result = res;
+			return true;
 		}
-		else if(*it == '\\')
+		else if (c == '\\')
 		{
 			it++;
-			if (it == jsonstring.end())
-				break;
-			if(*it == '\"')
-				res += '\"';
-			else if(*it == '\\')
-				res += '\\';
-			else if(*it == '/')
-				res += '/';
-			else if(*it == 'b')
-				res += '\b';
-			else if(*it == 'f')
-				res += '\f';
-			else if(*it == 'n')
-				res += '\n';
-			else if(*it == 'r')
-				res += '\r';
-			else if(*it == 't')
-				res += '\t';
-			else if(*it == 'u')
+			if (it == end)
+				return false;
+			switch (*it)
 			{
-				tiny_string strhex;
-				for (int i = 0; i < 4; i++)
+				case '\"':
+					res += '\"';
+					break;
+				case '\\':
+					res += '\\';
+					break;
+				case '/':
+					res += '/';
+					break;
+				case 'b':
+					res += '\b';
+					break;
+				case 'f':
+					res += '\f';
+					break;
+				case 'n':
+					res += '\n';
+					break;
+				case 'r':
+					res += '\r';
+					break;
+				case 't':
+					res += '\t';
+					break;
+				case 'u':
 				{
-					it++;
-					if (it == jsonstring.end())
+					if (end-it < 5)
 						return false;
-					switch(*it)
+					uint32_t hexnum = 0;
+					for (int i = 0; i < 4; i++)
 					{
-						case '0':
-						case '1':
-						case '2':
-						case '3':
-						case '4':
-						case '5':
-						case '6':
-						case '7':
-						case '8':
-						case '9':
-						case 'a':
-						case 'b':
-						case 'c':
-						case 'd':
-						case 'e':
-						case 'f':
-						case 'A':
-						case 'B':
-						case 'C':
-						case 'D':
-						case 'E':
-						case 'F':
-							strhex += *it;
-							break;
-						default:
+						int v = hexValue(*++it);
+						if (v < 0)
 							return false;
+						hexnum = (hexnum<<4)|v;
 					}
-					if (it == jsonstring.end())
-						return false;
-				}
-				number_t hexnum;
-				if (Integer::fromStringFlashCompatible(strhex.raw_buf(),hexnum,16))
-				{
 					if (hexnum < 0x20 && hexnum != 0xf)
 						return false;
-					res += tiny_string::fromChar(hexnum);
-				}
-				else
+					char utf8[6];
+					res.append(utf8,g_unichar_to_utf8(hexnum,utf8));
 					break;
+				}
+				default:
+					return false;
 			}
-			else
-				return false;
+			it++;
 		}
-		else if (*it < 0x20)
+		else if (uint8_t(c) < 0x20)
 			return false;
 		else
 		{
-			res += *it;
-		}
-		it++;
-	}
-	if (!done)
-		return false;
-	
-	if (result)
-		*result =res;
-	else
-	{
-		if (asAtomHandler::isInvalid(parent))
-			parent = asAtomHandler::fromObject(abstract_s(wrk,res));
-		else if (asAtomHandler::isObject(parent))
-		{
-			asAtom v = asAtomHandler::fromObject(abstract_s(wrk,res));
-			asAtomHandler::getObjectNoCheck(parent)->setVariableByMultiname(key,v,ASObject::CONST_NOT_ALLOWED,nullptr,wrk);
+			const char* run = scanStringRun(it,end);
+			res.append(it,run-it);
+			it = run;
 		}
-		else
-			return false;
 	}
-	return true;
+	return false;
 }
-bool JSON::parseNumber(const tiny_string &jsonstring, CharIterator& it, asAtom& parent, multiname &key, ASWorker* wrk)
+bool JSON::parseNumber(const char*& it, const char* end, asAtom& parent, multiname &key, ASWorker* wrk)
 {
-	tiny_string res;
-	bool done = false;
-	while (!done && it != jsonstring.end())
+	const char* start = it;
+	bool isinteger = true;
+	while (it < end)
 	{
 		char c = *it;
-		switch(c)
+		if (c >= '0' && c <= '9')
+			it++;
+		else if (c == '-' || c == '+' || c == '.' || c == 'E' || c == 'e')
 		{
-			case '0':
-			case '1':
-			case '2':
-			case '3':
-			case '4':
-			case '5':
-			case '6':
-			case '7':
-			case '8':
-			case '9':
-			case '-':
-			case '+':
-			case '.':
-			case 'E':
-			case 'e':
-				res += c;
-				it++;
-				break;
-			default:
-				done = true;
-				break;
+			if (c != '-' || it != start)
+				isinteger = false;
+			it++;
 		}
+		else
+			break;
 	}
-	ASObject* numstr = abstract_s(wrk,res);
-	number_t num = numstr->toNumber();
-	numstr->decRef();
-
-	if (std::isnan(num))
-		return false;
-
-	if (asAtomHandler::isInvalid(parent))
-		parent = asAtomHandler::fromNumber(wrk,num,false);
-	else if (asAtomHandler::isObject(parent))
+	size_t len = it-start;
+	number_t num;
+	bool negative = *start == '-';
+	if (isinteger && len > (negative ? 1U : 0U) && len < 16)
 	{
-		asAtom v = asAtomHandler::fromNumber(wrk,num,false);
-		asAtomHandler::getObjectNoCheck(parent)->setVariableByMultiname(key,v,ASObject::CONST_NOT_ALLOWED,nullptr,wrk);
+		// short integers can't lose precision, so they are converted directly
+		int64_t v = 0;
+		for (const char* c = start + (negative ? 1 : 0); c < it; c++)
+			v = v*10 + (*c-'0');
+		num = negative ? -number_t(v) : number_t(v);
 	}
 	else
+	{
+		// same conversion as ASString::toNumber, the token can't contain anything but digits, signs, dots and exponents
+		char buf[64];
+		std::string longbuf;
+		char* s = buf;
+		if (len < sizeof(buf))
+		{
+			memcpy(buf,start,len);
+			buf[len] = 0;
+		}
+		else
+		{
+			longbuf.assign(start,len);
+			s = &longbuf[0];
+		}
+		char* numend = nullptr;
+		num = g_ascii_strtod(s,&numend);
+		if (numend != s+len)
+			return false;
+	}
+	if (std::isnan(num))
 		return false;
-	return true;
+	return storeValue(parent,key,asAtomHandler::fromNumber(wrk,num,false),wrk);
 }
-bool JSON::parseObject(const tiny_string &jsonstring, CharIterator& it, asAtom& parent, multiname &key, asAtom reviver, ASWorker* wrk)
+bool JSON::parseObject(const char*& it, const char* end, asAtom& parent, multiname &key, asAtom reviver, ASWorker* wrk)
 {
-	it++; // ignore '{' or ','
+	it++; // ignore '{'
 	ASObject* subobj = Class<ASObject>::getInstanceS(wrk);
-	if (asAtomHandler::isInvalid(parent))
-		parent = asAtomHandler::fromObject(subobj);
-	else if (asAtomHandler::isObject(parent))
-	{
-		asAtom v = asAtomHandler::fromObject(subobj);
-		asAtomHandler::getObjectNoCheck(parent)->setVariableByMultiname(key,v,ASObject::CONST_NOT_ALLOWED,nullptr,wrk);
-	}
-	else
+	if (!storeValue(parent,key,asAtomHandler::fromObject(subobj),wrk))
 		return false;
 	multiname name(nullptr);
 	name.name_type=multiname::NAME_STRING;
 	name.ns.push_back(nsNameAndKind(wrk->getSystemState(),"",NAMESPACE));
 	name.isAttribute = false;
-	bool done = false;
 	bool bfirst = true;
 	bool needkey = true;
 	bool needvalue = false;
 
-	while (!done && it != jsonstring.end())
+	while (true)
 	{
-		while (*it == ' ' ||
-			   *it == '\t' ||
-			   *it == '\n' ||
-			   *it == '\r'
-			   )
-			it++;
-		char c = *it;
-		switch(c)
+		it = skipWhitespace(it,end);
+		if (it == end)
+			return false;
+		switch(*it)
 		{
 			case '}':
 				if (!bfirst && (needkey || needvalue))
 					return false;
-				done = true;
 				it++;
-				break;
+				return true;
 			case '\"':
-				{
-					tiny_string keyname;
-					asAtom p = asAtomHandler::invalidAtom;
-					if (!parseString(jsonstring,it,p,name,wrk,&keyname))
-						return false;
-					name.name_s_id=wrk->getSystemState()->getUniqueStringId(keyname);
-					needkey = false;
-					needvalue = true;
-				}
+			{
+				tiny_string keyname;
+				if (!parseString(it,end,keyname))
+					return false;
+				name.name_s_id=wrk->getSystemState()->getUniqueStringId(keyname);
+				needkey = false;
+				needvalue = true;
 				break;
+			}
 			case ',':
 				if (needkey || needvalue)
 					return false;
@@ -591,7 +582,7 @@ bool JSON::parseObject(const tiny_string &jsonstring, CharIterator& it, asAtom&
 			{
 				it++;
 				asAtom p = asAtomHandler::fromObjectNoPrimitive(subobj);
-				if (!parse(jsonstring,it,p,name,reviver,wrk))
+				if (!parse(it,end,p,name,reviver,wrk))
 					return false;
 				needvalue = false;
 				break;
@@ -601,44 +592,30 @@ bool JSON::parseObject(const tiny_string &jsonstring, CharIterator& it, asAtom&
 		}
 		bfirst=false;
 	}
-	return done;
 }
 
-bool JSON::parseArray(const tiny_string &jsonstring, CharIterator& it, asAtom& parent, multiname &key, asAtom reviver, ASWorker* wrk)
+bool JSON::parseArray(const char*& it, const char* end, asAtom& parent, multiname &key, asAtom reviver, ASWorker* wrk)
 {
 	it++; // ignore '['
 	ASObject* subobj = Class<Array>::getInstanceSNoArgs(wrk);
-	if (asAtomHandler::isInvalid(parent))
-		parent = asAtomHandler::fromObject(subobj);
-	else if (asAtomHandler::isObject(parent))
-	{
-		asAtom v = asAtomHandler::fromObject(subobj);
-		asAtomHandler::getObjectNoCheck(parent)->setVariableByMultiname(key,v,ASObject::CONST_NOT_ALLOWED,nullptr,wrk);
-	}
-	else
+	if (!storeValue(parent,key,asAtomHandler::fromObject(subobj),wrk))
 		return false;
 	multiname name(nullptr);
 	name.name_type=multiname::NAME_UINT;
 	name.name_ui = 0;
 	name.ns.push_back(nsNameAndKind(wrk->getSystemState(),"",NAMESPACE));
 	name.isAttribute = false;
-	bool done = false;
 	bool needdata = false;
-	while (!done && it != jsonstring.end())
+	while (true)
 	{
-		while (*it == ' ' ||
-			   *it == '\t' ||
-			   *it == '\n' ||
-			   *it == '\r'
-			   )
-			it++;
-		char c = *it;
-		switch(c)
+		it = skipWhitespace(it,end);
+		if (it == end)
+			return false;
+		switch(*it)
 		{
 			case ']':
-				done = true;
 				it++;
-				break;
+				return !needdata;
 			case ',':
 				name.name_ui++;
 				needdata = true;
@@ -647,16 +624,13 @@ bool JSON::parseArray(const tiny_string &jsonstring, CharIterator& it, asAtom& p
 			default:
 			{
 				asAtom p = asAtomHandler::fromObjectNoPrimitive(subobj);
-				if (!parse(jsonstring,it,p,name, reviver,wrk))
+				if (!parse(it,end,p,name, reviver,wrk))
 					return false;
 				needdata = false;
 				break;
 			}
 		}
 	}
-	if (!done || needdata)
-		return false;
-	return true;
 }
 
 
@@ -38,14 +38,14 @@ public:
 	static bool doParse(asAtom& res,const tiny_string &jsonstring, asAtom reviver, ASWorker* wrk);
 private:
 	static bool parseAll(const tiny_string &jsonstring, asAtom& parent , multiname &key, asAtom reviver, ASWorker* wrk);
-	static bool parse(const tiny_string &jsonstring, CharIterator& it, asAtom& parent, multiname &key, asAtom reviver, ASWorker* wrk);
-	static bool parseTrue(CharIterator& it, asAtom& parent, multiname &key, ASWorker* wrk);
-	static bool parseFalse(CharIterator& it, asAtom& parent, multiname &key, ASWorker* wrk);
-	static bool parseNull(CharIterator& it, asAtom& parent, multiname &key, ASWorker* wrk);
-	static bool parseString(const tiny_string &jsonstring, CharIterator& it, asAtom& parent, multiname &key, ASWorker* wrk, tiny_string *result = nullptr);
-	static bool parseNumber(const tiny_string &jsonstring, CharIterator& it, asAtom& parent, multiname &key, ASWorker* wrk);
-	static bool parseObject(const tiny_string &jsonstring, CharIterator& it, asAtom& parent, multiname &key, asAtom reviver, ASWorker* wrk);
-	static bool parseArray(const tiny_string &jsonstring, CharIterator& it, asAtom& parent, multiname &key, asAtom reviver, ASWorker* wrk);
+	static bool parse(const char*& it, const char* end, asAtom& parent, multiname &key, asAtom reviver, ASWorker* wrk);
+	static bool parseLiteral(const char*& it, const char* end, const char* literal, asAtom value, asAtom& parent, multiname &key, ASWorker* wrk);
+	static bool parseString(const char*& it, const char* end, tiny_string& result);
+	static bool parseNumber(const char*& it, const char* end, asAtom& parent, multiname &key, ASWorker* wrk);
+	static bool parseObject(const char*& it, const char* end, asAtom& parent, multiname &key, asAtom reviver, ASWorker* wrk);
+	static bool parseArray(const char*& it, const char* end, asAtom& parent, multiname &key, asAtom reviver, ASWorker* wrk);
+	// stores a parsed value as the result or as member key of parent, takes ownership of v
+	static bool storeValue(asAtom& parent, multiname &key, asAtom v, ASWorker* wrk);
 };
 
 }
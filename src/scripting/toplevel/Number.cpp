@@ -796,16 +796,20 @@ ASFUNCTIONBODY_ATOM(Number,_valueOf)
 	ret = obj;
 }
 
-void Number::serialize(ByteArray* out, std::map<tiny_string, uint32_t>& stringMap,
-				std::map<const ASObject*, uint32_t>& objMap,
-				std::map<const Class_base*, uint32_t>& traitsMap,ASWorker* wrk)
+void Number::serialize(ByteArray* out, amf3stringtable& stringMap,
+				amf3objecttable& objMap,
+				amf3traitstable& traitsMap,ASWorker* wrk)
+{
+	serializeValue(out,toNumber());
+}
+void Number::serializeValue(ByteArray* out, number_t val)
 {
 	if (out->getObjectEncoding() == OBJECT_ENCODING::AMF0)
 	{
 		out->writeByte(amf0_number_marker);
-		out->serializeDouble(toNumber());
+		out->serializeDouble(val);
 		return;
 	}
 	out->writeByte(double_marker);
-	out->serializeDouble(toNumber());
+	out->serializeDouble(val);
 }
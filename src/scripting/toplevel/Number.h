@@ -117,9 +117,10 @@ public:
 	ASFUNCTION_ATOM(generator);
 	std::string toDebugString() const override;
 	//Serialization interface
-	void serialize(ByteArray* out, std::map<tiny_string, uint32_t>& stringMap,
-				std::map<const ASObject*, uint32_t>& objMap,
-				std::map<const Class_base*, uint32_t>& traitsMap, ASWorker* wrk) override;
+	void serialize(ByteArray* out, amf3stringtable& stringMap,
+				amf3objecttable& objMap,
+				amf3traitstable& traitsMap, ASWorker* wrk) override;
+	static void serializeValue(ByteArray* out,number_t val);
 };
 
 
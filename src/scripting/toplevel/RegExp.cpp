@@ -17,6 +17,9 @@
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
 **************************************************************************/
 
+#include <list>
+#include <unordered_map>
+#include "threading.h"
 #include "scripting/argconv.h"
 #include "scripting/toplevel/RegExp.h"
 #include "scripting/toplevel/Array.h"
@@ -26,6 +29,97 @@
 using namespace std;
 using namespace lightspark;
 
+regexpcompiled::regexpcompiled(pcre* _re):re(_re),study(nullptr),capturingGroups(0),namedGroups(0),namedSize(0),nametable(nullptr)
+{
+	const char* error=nullptr;
+	study = pcre_study(re,0,&error);
+	if (pcre_fullinfo(re, nullptr, PCRE_INFO_CAPTURECOUNT, &capturingGroups) != 0
+		|| pcre_fullinfo(re, nullptr, PCRE_INFO_NAMECOUNT, &namedGroups) != 0
+		|| pcre_fullinfo(re, nullptr, PCRE_INFO_NAMEENTRYSIZE, &namedSize) != 0
+		|| pcre_fullinfo(re, nullptr, PCRE_INFO_NAMETABLE, &nametable) != 0)
+	{
+		capturingGroups = namedGroups = namedSize = 0;
+		nametable = nullptr;
+	}
+}
+
+regexpcompiled::~regexpcompiled()
+{
+	if (study)
+		pcre_free(study);
+	pcre_free(re);
+}
+
+int regexpcompiled::exec(const tiny_string& subject, int offset, int* ovector, int ovecsize, unsigned long recursionlimit) const
+{
+	pcre_extra extra;
+	if (study)
+		extra = *study;
+	else
+		extra.flags = 0;
+	if (recursionlimit)
+	{
+		extra.match_limit_recursion=recursionlimit;
+		extra.flags |= PCRE_EXTRA_MATCH_LIMIT_RECURSION;
+	}
+	return pcre_exec(re, extra.flags ? &extra : nullptr, subject.raw_buf(), subject.numBytes(), offset, PCRE_NO_UTF8_CHECK, ovector, ovecsize);
+}
+
+namespace
+{
+/*
+ * process wide cache of compiled patterns, keyed on the pcre options and the source.
+ * The least recently used pattern is removed if the cache is full
+ */
+#define REGEXP_CACHE_SIZE 256
+class regexpcache
+{
+private:
+	typedef std::pair<std::string,std::shared_ptr<regexpcompiled>> entry;
+	Mutex mutex;
+	std::list<entry> lru;
+	std::unordered_map<std::string,std::list<entry>::iterator> entries;
+public:
+	std::shared_ptr<regexpcompiled> get(const tiny_string& source, int options)
+	{
+		std::string key((const char*)&options,sizeof(options));
+		key.append(source.raw_buf(),source.numBytes());
+		Locker l(mutex);
+		auto it = entries.find(key);
+		if (it != entries.end())
+		{
+			lru.splice(lru.begin(),lru,it->second);
+			return it->second->second;
+		}
+		const char * error;
+		int errorOffset;
+		int errorcode;
+		pcre* pcreRE=pcre_compile2(source.raw_buf(), options,&errorcode,  &error, &errorOffset,nullptr);
+		if(error)
+		{
+			//		if (errorcode == 64) // invalid pattern in javascript compatibility mode (we try again in normal mode to match flash behaviour)
+			//		{
+			//			options &= ~PCRE_JAVASCRIPT_COMPAT;
+			//			pcreRE=pcre_compile2(source.raw_buf(), options,&errorcode,  &error, &errorOffset,NULL);
+			//		}
+			if (pcreRE)
+				pcre_free(pcreRE);
+			return nullptr;
+		}
+		std::shared_ptr<regexpcompiled> res = std::make_shared<regexpcompiled>(pcreRE);
+		lru.push_front(make_pair(key,res));
+		entries[key]=lru.begin();
+		if (lru.size() > REGEXP_CACHE_SIZE)
+		{
+			entries.erase(lru.back().first);
+			lru.pop_back();
+		}
+		return res;
+	}
+};
+regexpcache patterncache;
+}
+
 RegExp::RegExp(ASWorker* wrk, Class_base* c):ASObject(wrk,c,T_OBJECT,SUBTYPE_REGEXP),dotall(false),global(false),ignoreCase(false),
 	extended(false),multiline(false),lastIndex(0)
 {
@@ -36,6 +130,13 @@ RegExp::RegExp(ASWorker* wrk,Class_base* c, const tiny_string& _re):ASObject(wrk
 {
 }
 
+bool RegExp::destruct()
+{
+	compiled[0].reset();
+	compiled[1].reset();
+	return destructIntern();
+}
+
 void RegExp::sinit(Class_base* c)
 {
 	CLASS_SETUP(c, ASObject, _constructor, CLASS_DYNAMIC_NOT_FINAL);
@@ -65,6 +166,8 @@ void RegExp::buildTraits(ASObject* o)
 ASFUNCTIONBODY_ATOM(RegExp,_constructor)
 {
 	RegExp* th=asAtomHandler::as<RegExp>(obj);
+	th->compiled[0].reset();
+	th->compiled[1].reset();
 	if(argslen > 0 && asAtomHandler::is<RegExp>(args[0]))
 	{
 		if(argslen > 1 && !asAtomHandler::is<Undefined>(args[1]))
@@ -152,62 +255,30 @@ ASFUNCTIONBODY_ATOM(RegExp,exec)
 
 ASObject *RegExp::match(const tiny_string& str)
 {
-	pcre* pcreRE = compile(!str.isSinglebyte());
+	std::shared_ptr<regexpcompiled> pcreRE = compile(!str.isSinglebyte());
 	if (!pcreRE)
 		return getSystemState()->getNullRef();
-	int capturingGroups;
-	int infoOk=pcre_fullinfo(pcreRE, nullptr, PCRE_INFO_CAPTURECOUNT, &capturingGroups);
-	if(infoOk!=0)
-	{
-		pcre_free(pcreRE);
-		return getSystemState()->getNullRef();
-	}
-	//Get information about named capturing groups
-	int namedGroups;
-	infoOk=pcre_fullinfo(pcreRE, nullptr, PCRE_INFO_NAMECOUNT, &namedGroups);
-	if(infoOk!=0)
-	{
-		pcre_free(pcreRE);
-		return getSystemState()->getNullRef();
-	}
-	//Get information about the size of named entries
-	int namedSize;
-	infoOk=pcre_fullinfo(pcreRE, nullptr, PCRE_INFO_NAMEENTRYSIZE, &namedSize);
-	if(infoOk!=0)
-	{
-		pcre_free(pcreRE);
-		return getSystemState()->getNullRef();
-	}
+	int capturingGroups=pcreRE->capturingGroups;
+	int namedGroups=pcreRE->namedGroups;
+	int namedSize=pcreRE->namedSize;
 	struct nameEntry
 	{
 		uint16_t number;
 		char name[0];
 	};
-	char* entries;
-	infoOk=pcre_fullinfo(pcreRE, nullptr, PCRE_INFO_NAMETABLE, &entries);
-	if(infoOk!=0)
-	{
-		pcre_free(pcreRE);
-		lastIndex=0;
-		return getSystemState()->getNullRef();
-	}
-	pcre_extra extra;
-	extra.match_limit_recursion=500;
-	extra.flags = PCRE_EXTRA_MATCH_LIMIT_RECURSION;
+	char* entries=pcreRE->nametable;
 	int ovector[(capturingGroups+1)*3];
 	int offset=global?lastIndex:0;
 	if(offset<0)
 	{
 		//beyond last match
-		pcre_free(pcreRE);
 		lastIndex=0;
 		return getSystemState()->getNullRef();
 	}
-	int rc=pcre_exec(pcreRE,capturingGroups > 500 ? &extra : nullptr, str.raw_buf(), str.numBytes(), offset, PCRE_NO_UTF8_CHECK, ovector, (capturingGroups+1)*3);
+	int rc=pcreRE->exec(str, offset, ovector, (capturingGroups+1)*3, capturingGroups > 500 ? 500 : 0);
 	if(rc<0)
 	{
 		//No matches or error
-		pcre_free(pcreRE);
 		lastIndex=0;
 		return getSystemState()->getNullRef();
 	}
@@ -223,8 +294,7 @@ ASObject *RegExp::match(const tiny_string& str)
 	a->setVariableByQName("input","",abstract_s(getInstanceWorker(),str),DYNAMIC_TRAIT);
 
 	// pcre_exec returns byte position, so we have to convert it to character position 
-	tiny_string tmp = str.substr_bytes(0, ovector[0]);
-	int index = tmp.numChars();
+	int index = str.bytePosToIndex(ovector[0]);
 
 	a->setVariableAtomByQName("index",nsNameAndKind(),asAtomHandler::fromInt(index),DYNAMIC_TRAIT);
 	for(int i=0;i<namedGroups;i++)
@@ -237,7 +307,6 @@ ASObject *RegExp::match(const tiny_string& str)
 		entries+=namedSize;
 	}
 	lastIndex=ovector[1];
-	pcre_free(pcreRE);
 	return a;
 }
 
@@ -253,29 +322,18 @@ ASFUNCTIONBODY_ATOM(RegExp,test)
 	const tiny_string& arg0 = asAtomHandler::toString(args[0],wrk);
 	if (wrk->currentCallContext->exceptionthrown)
 		return;
-	pcre* pcreRE = th->compile(!arg0.isSinglebyte());
+	std::shared_ptr<regexpcompiled> pcreRE = th->compile(!arg0.isSinglebyte());
 	if (!pcreRE)
 	{
 		asAtomHandler::setNull(ret);
 		return;
 	}
-	int capturingGroups;
-	int infoOk=pcre_fullinfo(pcreRE, NULL, PCRE_INFO_CAPTURECOUNT, &capturingGroups);
-	if(infoOk!=0)
-	{
-		pcre_free(pcreRE);
-		asAtomHandler::setNull(ret);
-		return;
-	}
+	int capturingGroups=pcreRE->capturingGroups;
 	int ovector[(capturingGroups+1)*3];
 	
 	int offset=(th->global)?th->lastIndex:0;
-	pcre_extra extra;
-	extra.match_limit_recursion=200;
-	extra.flags = PCRE_EXTRA_MATCH_LIMIT_RECURSION;
-	int rc = pcre_exec(pcreRE, &extra, arg0.raw_buf(), arg0.numBytes(), offset, PCRE_NO_UTF8_CHECK, ovector, (capturingGroups+1)*3);
+	int rc = pcreRE->exec(arg0, offset, ovector, (capturingGroups+1)*3, 200);
 	bool res = (rc >= 0);
-	pcre_free(pcreRE);
 	asAtomHandler::setBool(ret,res);
 }
 
@@ -308,8 +366,10 @@ ASFUNCTIONBODY_ATOM(RegExp,_toString)
 	ret = asAtomHandler::fromObject(abstract_s(wrk,res));
 }
 
-pcre* RegExp::compile(bool isutf8)
+std::shared_ptr<regexpcompiled> RegExp::compile(bool isutf8)
 {
+	if (compiled[isutf8])
+		return compiled[isutf8];
 	int options = PCRE_NEWLINE_ANY | PCRE_NO_UTF8_CHECK;
 	if(isutf8)
 		options |= PCRE_UTF8;
@@ -321,20 +381,11 @@ pcre* RegExp::compile(bool isutf8)
 		options |= PCRE_MULTILINE;
 	if(dotall)
 		options|=PCRE_DOTALL;
+	compiled[isutf8] = getCompiledPattern(source,options);
+	return compiled[isutf8];
+}
 
-	const char * error;
-	int errorOffset;
-	int errorcode;
-	pcre* pcreRE=pcre_compile2(source.raw_buf(), options,&errorcode,  &error, &errorOffset,nullptr);
-	if(error)
-	{
-//		if (errorcode == 64) // invalid pattern in javascript compatibility mode (we try again in normal mode to match flash behaviour)
-//		{
-//			options &= ~PCRE_JAVASCRIPT_COMPAT;
-//			pcreRE=pcre_compile2(source.raw_buf(), options,&errorcode,  &error, &errorOffset,NULL);
-//		}
-		if (error)
-			return nullptr;
-	}
-	return pcreRE;
+std::shared_ptr<regexpcompiled> RegExp::getCompiledPattern(const tiny_string& source, int options)
+{
+	return patterncache.get(source,options);
 }
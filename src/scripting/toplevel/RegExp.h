@@ -19,6 +19,7 @@
 
 #ifndef SCRIPTING_TOPLEVEL_REGEXP_H
 #define SCRIPTING_TOPLEVEL_REGEXP_H 1
+#include <memory>
 #include "compat.h"
 #include "asobject.h"
 #include "3rdparty/avmplus/pcre/pcre.h"
@@ -26,12 +27,38 @@
 namespace lightspark
 {
 
+/*
+ * a compiled and studied pcre pattern.
+ * It is shared by all RegExp objects with the same source and flags through the pattern cache,
+ * so it must not be modified after creation
+ */
+struct regexpcompiled
+{
+	pcre* re;
+	pcre_extra* study;
+	int capturingGroups;
+	int namedGroups;
+	int namedSize;
+	char* nametable;
+	regexpcompiled(pcre* _re);
+	~regexpcompiled();
+	/* runs pcre_exec with the study data of the pattern, recursionlimit==0 means no limit */
+	int exec(const tiny_string& subject, int offset, int* ovector, int ovecsize, unsigned long recursionlimit) const;
+};
+
 class RegExp: public ASObject
 {
+private:
+	// compiled patterns for single byte and utf8 subjects
+	std::shared_ptr<regexpcompiled> compiled[2];
 public:
 	RegExp(ASWorker* wrk,Class_base* c);
 	RegExp(ASWorker* wrk, Class_base* c, const tiny_string& _re);
-	pcre* compile(bool isutf8);
+	bool destruct() override;
+	/* returns the compiled pattern, or nullptr if the source is invalid */
+	std::shared_ptr<regexpcompiled> compile(bool isutf8);
+	/* returns the compiled pattern from the process wide pattern cache, or nullptr if the source is invalid */
+	static std::shared_ptr<regexpcompiled> getCompiledPattern(const tiny_string& source, int options);
 	static void sinit(Class_base* c);
 	static void buildTraits(ASObject* o);
 	ASObject *match(const tiny_string& str);
@@ -87,9 +87,9 @@ ASObject *Undefined::describeType(ASWorker* wrk) const
 	return ASObject::describeType(wrk);
 }
 
-void Undefined::serialize(ByteArray* out, std::map<tiny_string, uint32_t>& stringMap,
-				std::map<const ASObject*, uint32_t>& objMap,
-				std::map<const Class_base*, uint32_t>& traitsMap,ASWorker* wrk)
+void Undefined::serialize(ByteArray* out, amf3stringtable& stringMap,
+				amf3objecttable& objMap,
+				amf3traitstable& traitsMap,ASWorker* wrk)
 {
 	if (out->getObjectEncoding() == OBJECT_ENCODING::AMF0)
 		out->writeByte(amf0_undefined_marker);
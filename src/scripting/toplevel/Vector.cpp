@@ -22,6 +22,7 @@
 #include "scripting/class.h"
 #include "parsing/amf3_generator.h"
 #include "scripting/argconv.h"
+#include "scripting/sortkeys.h"
 #include "scripting/toplevel/Array.h"
 #include "scripting/toplevel/Number.h"
 #include "scripting/toplevel/Integer.h"
@@ -104,8 +105,11 @@ void Vector::sinit(Class_base* c)
 	c->prototype->setVariableByQName("unshift",nsNameAndKind(c->getSystemState(),BUILTIN_STRINGS::STRING_AS3NS,NAMESPACE),c->getSystemState()->getBuiltinFunction(unshift),CONSTANT_TRAIT);
 }
 
-Vector::Vector(ASWorker* wrk, Class_base* c, Type *vtype):ASObject(wrk,c,T_OBJECT,SUBTYPE_VECTOR),vec_type(vtype),fixed(false),vec(reporter_allocator<asAtom>(c->memoryAccount))
+Vector::Vector(ASWorker* wrk, Class_base* c, Type *vtype):ASObject(wrk,c,T_OBJECT,SUBTYPE_VECTOR),vec_type(vtype),fixed(false),
+	storage(VECTOR_STORAGE_ATOM),elementshift(0),vec(reporter_allocator<asAtom>(c->memoryAccount)),packed(reporter_allocator<uint8_t>(c->memoryAccount))
 {
+	if (vec_type)
+		setStorage();
 }
 
 Vector::~Vector()
@@ -114,7 +118,8 @@ Vector::~Vector()
 
 bool Vector::destruct()
 {
-	for(unsigned int i=0;i<size();i++)
+	// packed vectors have no elements in vec
+	for(unsigned int i=0;i<vec.size();i++)
 	{
 		ASObject* obj = asAtomHandler::getObject(vec[i]);
 		vec[i]=asAtomHandler::invalidAtom;
@@ -122,13 +127,16 @@ bool Vector::destruct()
 			obj->removeStoredMember();
 	}
 	vec.clear();
+	packed.clear();
 	vec_type=nullptr;
+	storage=VECTOR_STORAGE_ATOM;
 	return destructIntern();
 }
 
 void Vector::finalize()
 {
-	for(unsigned int i=0;i<size();i++)
+	// packed vectors have no elements in vec
+	for(unsigned int i=0;i<vec.size();i++)
 	{
 		ASObject* obj = asAtomHandler::getObject(vec[i]);
 		vec[i]=asAtomHandler::invalidAtom;
@@ -136,7 +144,9 @@ void Vector::finalize()
 			obj->removeStoredMember();
 	}
 	vec.clear();
+	packed.clear();
 	vec_type=nullptr;
+	storage=VECTOR_STORAGE_ATOM;
 }
 
 void Vector::prepareShutdown()
@@ -173,6 +183,98 @@ void Vector::setTypes(const std::vector<Type *> &types)
 	assert(vec_type == nullptr);
 	if(types.size() == 1)
 		vec_type = types[0];
+	setStorage();
+}
+
+void Vector::setStorage()
+{
+	assert(vec.empty() && packed.empty());
+	storage = VECTOR_STORAGE_ATOM;
+	elementshift = 0;
+#ifdef LIGHTSPARK_ATOM_NANBOXING
+	if (vec_type == Class<Integer>::getClass(getSystemState()))
+	{
+		storage = VECTOR_STORAGE_INT;
+		elementshift = 2;
+	}
+	else if (vec_type == Class<UInteger>::getClass(getSystemState()))
+	{
+		storage = VECTOR_STORAGE_UINT;
+		elementshift = 2;
+	}
+	else if (vec_type == Class<Number>::getClass(getSystemState()))
+	{
+		storage = VECTOR_STORAGE_NUMBER;
+		elementshift = 3;
+	}
+	else if (vec_type == Class<Boolean>::getClass(getSystemState()))
+		storage = VECTOR_STORAGE_BOOL;
+#endif
+}
+
+int32_t Vector::indexOfPacked(asAtom& o, uint32_t from, bool backwards)
+{
+	// strict equality is only true for values of the same primitive type
+	uint32_t count = size();
+	if (from >= count)
+		return -1;
+	if (storage == VECTOR_STORAGE_BOOL)
+	{
+		if (!asAtomHandler::isBool(o))
+			return -1;
+		uint8_t v = asAtomHandler::Boolean_concrete(o);
+		const uint8_t* data = packedData<uint8_t>();
+		for (int64_t i = from; i >= 0 && i < count; i += (backwards ? -1 : 1))
+		{
+			if (data[i] == v)
+				return i;
+		}
+		return -1;
+	}
+	switch (asAtomHandler::getObjectType(o))
+	{
+		case T_NUMBER:
+		case T_INTEGER:
+		case T_UINTEGER:
+			break;
+		default:
+			return -1;
+	}
+	number_t v = asAtomHandler::toNumber(o);
+	switch (storage)
+	{
+		case VECTOR_STORAGE_INT:
+		{
+			const int32_t* data = packedData<int32_t>();
+			for (int64_t i = from; i >= 0 && i < count; i += (backwards ? -1 : 1))
+			{
+				if (data[i] == v)
+					return i;
+			}
+			break;
+		}
+		case VECTOR_STORAGE_UINT:
+		{
+			const uint32_t* data = packedData<uint32_t>();
+			for (int64_t i = from; i >= 0 && i < count; i += (backwards ? -1 : 1))
+			{
+				if (data[i] == v)
+					return i;
+			}
+			break;
+		}
+		default:
+		{
+			const number_t* data = packedData<number_t>();
+			for (int64_t i = from; i >= 0 && i < count; i += (backwards ? -1 : 1))
+			{
+				if (data[i] == v)
+					return i;
+			}
+			break;
+		}
+	}
+	return -1;
 }
 bool Vector::sameType(const Class_base *cls) const
 {
@@ -201,6 +303,11 @@ void Vector::generator(asAtom& ret, ASWorker* wrk, asAtom &o_class, asAtom* args
 		for(unsigned int i=0;i<a->size();++i)
 		{
 			asAtom o = a->at(i);
+			if (res->isPacked())
+			{
+				res->pushPacked(o);
+				continue;
+			}
 			//Convert the elements of the array to the type of this vector
 			if (!type->coerce(wrk,o))
 				ASATOM_INCREF(o);
@@ -228,9 +335,14 @@ void Vector::generator(asAtom& ret, ASWorker* wrk, asAtom &o_class, asAtom* args
 			//create object without calling _constructor
 			asAtomHandler::as<TemplatedClass<Vector>>(o_class)->getInstance(wrk,ret,false,nullptr,0);
 			res = asAtomHandler::as<Vector>(ret);
-			for(auto i = arg->vec.begin(); i != arg->vec.end(); ++i)
+			for(uint32_t i = 0; i < arg->size(); ++i)
 			{
-				asAtom o = *i;
+				asAtom o = arg->getElement(i);
+				if (res->isPacked())
+				{
+					res->pushPacked(o);
+					continue;
+				}
 				if (!type->coerce(wrk,o))
 					ASATOM_INCREF(o);
 				ASObject* obj = asAtomHandler::getObject(o);
@@ -256,7 +368,10 @@ ASFUNCTIONBODY_ATOM(Vector,_constructor)
 	Vector* th=asAtomHandler::as<Vector>(obj);
 	assert(th->vec_type);
 	th->fixed = fixed;
-	th->vec.resize(len, th->getDefaultValue());
+	if (th->isPacked())
+		th->packed.resize(size_t(len)<<th->elementshift);
+	else
+		th->vec.resize(len, th->getDefaultValue());
 }
 
 ASFUNCTIONBODY_ATOM(Vector,_concat)
@@ -264,6 +379,36 @@ ASFUNCTIONBODY_ATOM(Vector,_concat)
 	Vector* th=asAtomHandler::as<Vector>(obj);
 	th->getClass()->getInstance(wrk,ret,true,nullptr,0);
 	Vector* res = asAtomHandler::as<Vector>(ret);
+	if (res->isPacked())
+	{
+		// copy the native arrays, only elements of other types have to be converted
+		res->packed = th->packed;
+		int pos = wrk->getSystemState()->getSwfVersion() < 11 ? argslen-1 : 0;
+		for(unsigned int i=0;i<argslen;i++)
+		{
+			if (asAtomHandler::is<Vector>(args[pos]))
+			{
+				Vector* arg=asAtomHandler::as<Vector>(args[pos]);
+				if (arg->storage == res->storage)
+					res->packed.insert(res->packed.end(),arg->packed.begin(),arg->packed.end());
+				else
+				{
+					for (uint32_t j = 0; j < arg->size(); j++)
+					{
+						asAtom v = arg->getElement(j);
+						if (asAtomHandler::isValid(v))
+							res->pushPacked(v);
+						else
+							res->packed.resize(res->packed.size()+(1<<res->elementshift));
+					}
+				}
+			}
+			else
+				res->pushPacked(args[pos]);
+			pos += (wrk->getSystemState()->getSwfVersion() < 11 ?-1 : 1);
+		}
+		return;
+	}
 	// copy values into new Vector
 	res->vec.resize(th->size(), th->getDefaultValue());
 	auto it=th->vec.begin();
@@ -287,14 +432,14 @@ ASFUNCTIONBODY_ATOM(Vector,_concat)
 		{
 			Vector* arg=asAtomHandler::as<Vector>(args[pos]);
 			res->vec.resize(index+arg->size(), th->getDefaultValue());
-			auto it=arg->vec.begin();
-			for(;it != arg->vec.end();++it)
+			for(uint32_t j = 0; j < arg->size(); j++)
 			{
-				if (asAtomHandler::isValid(*it))
+				asAtom v = arg->getElement(j);
+				if (asAtomHandler::isValid(v))
 				{
-					res->vec[index]= *it;
+					res->vec[index]= v;
 					th->vec_type->coerceForTemplate(th->getInstanceWorker(),res->vec[index]);
-					ASObject* obj = asAtomHandler::getObject(*it);
+					ASObject* obj = asAtomHandler::getObject(v);
 					if (obj)
 					{
 						obj->incRef();
@@ -342,7 +487,7 @@ ASFUNCTIONBODY_ATOM(Vector,filter)
 
 	for(unsigned int i=0;i<th->size();i++)
 	{
-		params[0] = th->vec[i];
+		params[0] = th->getElement(i);
 		params[1] = asAtomHandler::fromUInt(i);
 		params[2] = asAtomHandler::fromObject(th);
 
@@ -356,7 +501,16 @@ ASFUNCTIONBODY_ATOM(Vector,filter)
 		}
 		if(asAtomHandler::isValid(funcRet))
 		{
-			if(asAtomHandler::Boolean_concrete(funcRet))
+			if(asAtomHandler::Boolean_concrete(funcRet) && th->isPacked())
+			{
+				// the callback may have changed the vector
+				if (i < th->size())
+				{
+					asAtom v = th->getPacked(i);
+					res->pushPacked(v);
+				}
+			}
+			else if(asAtomHandler::Boolean_concrete(funcRet))
 			{
 				ASObject* obj = asAtomHandler::getObject(th->vec[i]);
 				if (obj)
@@ -390,7 +544,7 @@ ASFUNCTIONBODY_ATOM(Vector, some)
 
 	for(unsigned int i=0; i < th->size(); i++)
 	{
-		params[0] = th->vec[i];
+		params[0] = th->getElement(i);
 		params[1] = asAtomHandler::fromUInt(i);
 		params[2] = asAtomHandler::fromObject(th);
 
@@ -433,9 +587,8 @@ ASFUNCTIONBODY_ATOM(Vector, every)
 
 	for(unsigned int i=0; i < th->size(); i++)
 	{
-		if (asAtomHandler::isValid(th->vec[i]))
-			params[0] = th->vec[i];
-		else
+		params[0] = th->getElement(i);
+		if (asAtomHandler::isInvalid(params[0]))
 			params[0] = asAtomHandler::nullAtom;
 		params[1] = asAtomHandler::fromUInt(i);
 		params[2] = asAtomHandler::fromObject(th);
@@ -473,6 +626,12 @@ void Vector::append(asAtom &o)
 		createError<RangeError>(getInstanceWorker(),kVectorFixedError);
 		return;
 	}
+	if (isPacked())
+	{
+		pushPacked(o);
+		ASATOM_DECREF(o);
+		return;
+	}
 	asAtom v = o;
 	if (vec_type->coerce(getInstanceWorker(),v))
 		ASATOM_DECREF(v);
@@ -484,6 +643,8 @@ void Vector::append(asAtom &o)
 
 void Vector::remove(ASObject *o)
 {
+	if (isPacked())
+		return;
 	for (auto it = vec.begin(); it != vec.end(); it++)
 	{
 		if (asAtomHandler::getObject(*it) == o)
@@ -531,6 +692,15 @@ ASFUNCTIONBODY_ATOM(Vector,push)
 		createError<RangeError>(wrk,kVectorFixedError);
 		return;
 	}
+	if (th->isPacked())
+	{
+		uint32_t pos = th->size();
+		th->packed.resize(size_t(pos+argslen)<<th->elementshift);
+		for(size_t i = 0; i < argslen; ++i)
+			th->setPacked(pos+i,args[i]);
+		asAtomHandler::setUInt(ret,wrk,th->size());
+		return;
+	}
 	for(size_t i = 0; i < argslen; ++i)
 	{
 		//The proprietary player violates the specification and allows elements of any type to be pushed;
@@ -543,7 +713,7 @@ ASFUNCTIONBODY_ATOM(Vector,push)
 			obj->addStoredMember();
 		th->vec.push_back(v);
 	}
-	asAtomHandler::setUInt(ret,wrk,(uint32_t)th->vec.size());
+	asAtomHandler::setUInt(ret,wrk,(uint32_t)th->size());
 }
 
 ASFUNCTIONBODY_ATOM(Vector,_pop)
@@ -561,6 +731,12 @@ ASFUNCTIONBODY_ATOM(Vector,_pop)
 		th->vec_type->coerce(th->getInstanceWorker(),ret);
 		return;
 	}
+	if (th->isPacked())
+	{
+		ret = th->getPacked(size-1);
+		th->packed.resize(size_t(size-1)<<th->elementshift);
+		return;
+	}
 	ret = th->vec[size-1];
 	ASObject* ob = asAtomHandler::getObject(ret);
 	if (ob)
@@ -573,7 +749,7 @@ ASFUNCTIONBODY_ATOM(Vector,_pop)
 
 ASFUNCTIONBODY_ATOM(Vector,getLength)
 {
-	asAtomHandler::setUInt(ret,wrk,(uint32_t)asAtomHandler::as<Vector>(obj)->vec.size());
+	asAtomHandler::setUInt(ret,wrk,asAtomHandler::as<Vector>(obj)->size());
 }
 
 ASFUNCTIONBODY_ATOM(Vector,setLength)
@@ -586,9 +762,14 @@ ASFUNCTIONBODY_ATOM(Vector,setLength)
 	}
 	uint32_t len;
 	ARG_CHECK(ARG_UNPACK (len));
-	if(len < th->vec.size())
+	if (th->isPacked())
+	{
+		th->packed.resize(size_t(len)<<th->elementshift);
+		return;
+	}
+	if(len < th->size())
 	{
-		for(size_t i=len; i< th->vec.size(); ++i)
+		for(size_t i=len; i< th->size(); ++i)
 		{
 			ASObject* ob = asAtomHandler::getObject(th->vec[i]);
 			if (ob)
@@ -630,7 +811,7 @@ ASFUNCTIONBODY_ATOM(Vector,forEach)
 
 	for(unsigned int i=0; i < th->size(); i++)
 	{
-		params[0] = th->vec[i];
+		params[0] = th->getElement(i);
 		params[1] = asAtomHandler::fromUInt(i);
 		params[2] = asAtomHandler::fromObject(th);
 
@@ -650,6 +831,25 @@ ASFUNCTIONBODY_ATOM(Vector,forEach)
 ASFUNCTIONBODY_ATOM(Vector, _reverse)
 {
 	Vector* th = asAtomHandler::as<Vector>(obj);
+	if (th->isPacked())
+	{
+		switch (th->storage)
+		{
+			case VECTOR_STORAGE_INT:
+			case VECTOR_STORAGE_UINT:
+				std::reverse(th->packedData<uint32_t>(),th->packedData<uint32_t>()+th->size());
+				break;
+			case VECTOR_STORAGE_NUMBER:
+				std::reverse(th->packedData<number_t>(),th->packedData<number_t>()+th->size());
+				break;
+			default:
+				std::reverse(th->packed.begin(),th->packed.end());
+				break;
+		}
+		th->incRef();
+		ret = asAtomHandler::fromObject(th);
+		return;
+	}
 
 	std::vector<asAtom> tmp = std::vector<asAtom>(th->vec.begin(),th->vec.end());
 	uint32_t size = th->size();
@@ -673,7 +873,7 @@ ASFUNCTIONBODY_ATOM(Vector,lastIndexOf)
 	int32_t res=-1;
 	asAtom arg0=args[0];
 
-	if(th->vec.size() == 0)
+	if(th->size() == 0)
 	{
 		asAtomHandler::setInt(ret,wrk,(int32_t)-1);
 		return;
@@ -705,6 +905,11 @@ ASFUNCTIONBODY_ATOM(Vector,lastIndexOf)
 				i = j;
 		}
 	}
+	if (th->isPacked())
+	{
+		asAtomHandler::setInt(ret,wrk,th->indexOfPacked(arg0,i,true));
+		return;
+	}
 	do
 	{
 		if (asAtomHandler::isEqualStrict(th->vec[i],wrk,arg0))
@@ -732,6 +937,12 @@ ASFUNCTIONBODY_ATOM(Vector,shift)
 		th->vec_type->coerce(th->getInstanceWorker(),ret);
 		return;
 	}
+	if (th->isPacked())
+	{
+		ret = th->getPacked(0);
+		th->packed.erase(th->packed.begin(),th->packed.begin()+(1<<th->elementshift));
+		return;
+	}
 	if(asAtomHandler::isValid(th->vec[0]))
 		ret=th->vec[0];
 	else
@@ -798,6 +1009,12 @@ ASFUNCTIONBODY_ATOM(Vector,slice)
 	endIndex=th->capIndex(endIndex);
 	th->getClass()->getInstance(wrk,ret,true,nullptr,0);
 	Vector* res= asAtomHandler::as<Vector>(ret);
+	if (th->isPacked())
+	{
+		if (endIndex > startIndex)
+			res->packed.assign(th->packed.begin()+(size_t(startIndex)<<th->elementshift),th->packed.begin()+(size_t(endIndex)<<th->elementshift));
+		return;
+	}
 	res->vec.resize(endIndex-startIndex, th->getDefaultValue());
 	int j = 0;
 	for(int i=startIndex; i<endIndex; i++) 
@@ -838,6 +1055,22 @@ ASFUNCTIONBODY_ATOM(Vector,splice)
 	if((startIndex+deleteCount)>totalSize)
 		deleteCount=totalSize-startIndex;
 
+	if (th->isPacked())
+	{
+		if (deleteCount < 0)
+			deleteCount = 0;
+		auto start = th->packed.begin()+(size_t(startIndex)<<th->elementshift);
+		auto end = start+(size_t(deleteCount)<<th->elementshift);
+		res->packed.assign(start,end);
+		th->packed.erase(start,end);
+		if (argslen > 2)
+		{
+			th->packed.insert(th->packed.begin()+(size_t(startIndex)<<th->elementshift),size_t(argslen-2)<<th->elementshift,0);
+			for(unsigned int i=2;i<argslen;i++)
+				th->setPacked(startIndex+i-2,args[i]);
+		}
+		return;
+	}
 	res->vec.resize(deleteCount, th->getDefaultValue());
 	if(deleteCount)
 	{
@@ -895,8 +1128,9 @@ ASFUNCTIONBODY_ATOM(Vector,join)
 	string res;
 	for(uint32_t i=0;i<th->size();i++)
 	{
-		if (asAtomHandler::isValid(th->vec[i]))
-			res+=asAtomHandler::toString(th->vec[i],wrk).raw_buf();
+		asAtom v = th->getElement(i);
+		if (asAtomHandler::isValid(v))
+			res+=asAtomHandler::toString(v,wrk).raw_buf();
 		if(i!=th->size()-1)
 			res+=del.raw_buf();
 	}
@@ -915,6 +1149,11 @@ ASFUNCTIONBODY_ATOM(Vector,indexOf)
 	{
 		i = asAtomHandler::toInt(args[1]);
 	}
+	if (th->isPacked())
+	{
+		asAtomHandler::setInt(ret,wrk,th->indexOfPacked(arg0,i,false));
+		return;
+	}
 
 	for(;i<th->size();i++)
 	{
@@ -926,47 +1165,6 @@ ASFUNCTIONBODY_ATOM(Vector,indexOf)
 	}
 	asAtomHandler::setInt(ret,wrk,res);
 }
-bool Vector::sortComparatorDefault::operator()(const asAtom& d1, const asAtom& d2)
-{
-	asAtom o1 = d1;
-	asAtom o2 = d2;
-	if(isNumeric)
-	{
-		number_t a=asAtomHandler::toNumber(o1);
-
-		number_t b=asAtomHandler::toNumber(o2);
-
-		if(std::isnan(a) || std::isnan(b))
-			throw RunTimeException("Cannot sort non number with Array.NUMERIC option");
-		if(isDescending)
-			return a>b;
-		else
-			return a<b;
-	}
-	else
-	{
-		//Comparison is always in lexicographic order
-		tiny_string s1 = asAtomHandler::toString(o1,getWorker());
-		tiny_string s2 = asAtomHandler::toString(o2,getWorker());
-
-		if(isDescending)
-		{
-			//TODO: unicode support
-			if(isCaseInsensitive)
-				return s1.strcasecmp(s2)>0;
-			else
-				return s1>s2;
-		}
-		else
-		{
-			//TODO: unicode support
-			if(isCaseInsensitive)
-				return s1.strcasecmp(s2)<0;
-			else
-				return s1<s2;
-		}
-	}
-}
 number_t Vector::sortComparatorWrapper::compare(const asAtom& d1, const asAtom& d2)
 {
 	asAtom objs[2];
@@ -1145,6 +1343,15 @@ recurse:
 	return;
 }
 
+template<class T>
+void sortPacked(T* data, uint32_t count, bool descending)
+{
+	if (descending)
+		std::sort(data,data+count,std::greater<T>());
+	else
+		std::sort(data,data+count);
+}
+
 ASFUNCTIONBODY_ATOM(Vector,_sort)
 {
 	if (argslen != 1)
@@ -1175,25 +1382,84 @@ ASFUNCTIONBODY_ATOM(Vector,_sort)
 		if(options&(~(Array::NUMERIC|Array::CASEINSENSITIVE|Array::DESCENDING)))
 			throw UnsupportedException("Vector::sort not completely implemented");
 	}
-	std::vector<asAtom> tmp = vector<asAtom>(th->vec.size());
-	int i = 0;
-	for(auto it=th->vec.begin();it != th->vec.end();++it)
+	if (th->isPacked() && asAtomHandler::isInvalid(comp) && isNumeric && th->storage != VECTOR_STORAGE_BOOL)
 	{
-		tmp[i++]= *it;
+		// numeric sort of numeric vectors can be done on the native array
+		switch (th->storage)
+		{
+			case VECTOR_STORAGE_INT:
+				sortPacked(th->packedData<int32_t>(),th->size(),isDescending);
+				break;
+			case VECTOR_STORAGE_UINT:
+				sortPacked(th->packedData<uint32_t>(),th->size(),isDescending);
+				break;
+			default:
+			{
+				number_t* data = th->packedData<number_t>();
+				for (uint32_t i = 0; i < th->size(); i++)
+				{
+					if (std::isnan(data[i]))
+						throw RunTimeException("Cannot sort non number with Array.NUMERIC option");
+				}
+				sortPacked(data,th->size(),isDescending);
+				break;
+			}
+		}
+		ASATOM_INCREF(obj);
+		ret = obj;
+		return;
 	}
-	
 	if(asAtomHandler::isValid(comp))
 	{
+		std::vector<asAtom> tmp = vector<asAtom>(th->size());
+		for(uint32_t i=0;i < th->size();++i)
+			tmp[i]= th->getElement(i);
 		sortComparatorWrapper c(comp);
 		qsortVector(tmp,c,0,tmp.size()-1);
+		if (th->isPacked())
+		{
+			// the comparator may have changed the size of the vector
+			th->packed.resize(tmp.size()<<th->elementshift);
+			for(uint32_t i=0;i < tmp.size();++i)
+				th->setPacked(i,tmp[i]);
+		}
+		else
+			th->vec.assign(tmp.begin(),tmp.end());
+		ASATOM_INCREF(obj);
+		ret = obj;
+		return;
+	}
+	// the elements are converted only once, the sort itself doesn't call into AS3 code
+	uint32_t count = th->size();
+	SortKeys keys(count,std::vector<sortkeyfield>(1,sortkeyfield(isNumeric,isCaseInsensitive,isDescending)));
+	for(uint32_t i=0;i < count;++i)
+	{
+		asAtom o = th->getElement(i);
+		if (isNumeric)
+		{
+			number_t n = asAtomHandler::toNumber(o);
+			if(std::isnan(n))
+				throw RunTimeException("Cannot sort non number with Array.NUMERIC option");
+			keys.setNumber(i,0,n);
+		}
+		else
+			keys.setString(i,0,asAtomHandler::toString(o,wrk));
+	}
+	keys.sort(wrk->getSystemState());
+	if (th->isPacked())
+	{
+		uint32_t elementsize = 1<<th->elementshift;
+		std::vector<uint8_t, reporter_allocator<uint8_t>> sorted(th->packed.size(),0,th->packed.get_allocator());
+		for(uint32_t i=0;i < count;++i)
+			memcpy(sorted.data()+i*elementsize,th->packed.data()+keys[i]*elementsize,elementsize);
+		th->packed.swap(sorted);
 	}
 	else
-		sort(tmp.begin(),tmp.end(),sortComparatorDefault(isNumeric,isCaseInsensitive,isDescending));
-
-	th->vec.clear();
-	for(auto ittmp=tmp.begin();ittmp != tmp.end();++ittmp)
 	{
-		th->vec.push_back(*ittmp);
+		std::vector<asAtom, reporter_allocator<asAtom>> sorted(count,asAtomHandler::invalidAtom,th->vec.get_allocator());
+		for(uint32_t i=0;i < count;++i)
+			sorted[i] = th->vec[keys[i]];
+		th->vec.swap(sorted);
 	}
 	ASATOM_INCREF(obj);
 	ret = obj;
@@ -1207,7 +1473,13 @@ ASFUNCTIONBODY_ATOM(Vector,unshift)
 		createError<RangeError>(wrk,kVectorFixedError);
 		return;
 	}
-	if (argslen > 0)
+	if (argslen > 0 && th->isPacked())
+	{
+		th->packed.insert(th->packed.begin(),size_t(argslen)<<th->elementshift,0);
+		for(uint32_t i=0;i<argslen;i++)
+			th->setPacked(i,args[i]);
+	}
+	else if (argslen > 0)
 	{
 		uint32_t s = th->size();
 		th->vec.resize(th->size()+argslen, th->getDefaultValue());
@@ -1252,12 +1524,18 @@ ASFUNCTIONBODY_ATOM(Vector,_map)
 	for(uint32_t i=0;i<th->size();i++)
 	{
 		asAtom funcArgs[3];
-		funcArgs[0]=th->vec[i];
+		funcArgs[0]=th->getElement(i);
 		funcArgs[1]=asAtomHandler::fromUInt(i);
 		funcArgs[2]=asAtomHandler::fromObject(th);
 		asAtom funcRet=asAtomHandler::invalidAtom;
 		asAtomHandler::callFunction(func,wrk,funcRet,thisObject, funcArgs, 3,false);
 		assert_and_throw(asAtomHandler::isValid(funcRet));
+		if (res->isPacked())
+		{
+			res->pushPacked(funcRet);
+			ASATOM_DECREF(funcRet);
+			continue;
+		}
 		ASObject* obj = asAtomHandler::getObject(funcRet);
 		if (obj)
 			obj->addStoredMember();
@@ -1271,10 +1549,11 @@ ASFUNCTIONBODY_ATOM(Vector,_toString)
 {
 	tiny_string res;
 	Vector* th = asAtomHandler::as<Vector>(obj);
-	for(size_t i=0; i < th->vec.size(); ++i)
+	for(size_t i=0; i < th->size(); ++i)
 	{
-		if (asAtomHandler::isValid(th->vec[i]))
-			res += asAtomHandler::toString(th->vec[i],wrk);
+		asAtom v = th->getElement(i);
+		if (asAtomHandler::isValid(v))
+			res += asAtomHandler::toString(v,wrk);
 		else
 		{
 			// use the type's default value
@@ -1283,7 +1562,7 @@ ASFUNCTIONBODY_ATOM(Vector,_toString)
 			res += asAtomHandler::toString(natom,wrk);
 		}
 
-		if(i!=th->vec.size()-1)
+		if(i!=th->size()-1)
 			res += ',';
 	}
 	ret = asAtomHandler::fromObject(abstract_s(wrk,res));
@@ -1301,17 +1580,25 @@ ASFUNCTIONBODY_ATOM(Vector,insertAt)
 	asAtom o=asAtomHandler::invalidAtom;
 	ARG_CHECK(ARG_UNPACK(index)(o));
 
-	if (index < 0 && th->vec.size() >= (uint32_t)(-index))
-		index = th->vec.size()+(index);
+	if (index < 0 && th->size() >= (uint32_t)(-index))
+		index = th->size()+(index);
 	if (index < 0)
 		index = 0;
+	if (th->isPacked())
+	{
+		if ((uint32_t)index > th->size())
+			index = th->size();
+		th->packed.insert(th->packed.begin()+(size_t(index)<<th->elementshift),size_t(1)<<th->elementshift,0);
+		th->setPacked(index,o);
+		return;
+	}
 	ASObject* ob = asAtomHandler::getObject(o);
 	if (ob)
 	{
 		ob->incRef();
 		ob->addStoredMember();
 	}
-	if ((uint32_t)index >= th->vec.size())
+	if ((uint32_t)index >= th->size())
 		th->vec.push_back(o);
 	else
 		th->vec.insert(th->vec.begin()+index,o);
@@ -1328,10 +1615,16 @@ ASFUNCTIONBODY_ATOM(Vector,removeAt)
 	int32_t index;
 	ARG_CHECK(ARG_UNPACK(index));
 	if (index < 0)
-		index = th->vec.size()+index;
+		index = th->size()+index;
 	if (index < 0)
 		index = 0;
-	if ((uint32_t)index < th->vec.size())
+	if (th->isPacked() && (uint32_t)index < th->size())
+	{
+		ret = th->getPacked(index);
+		auto start = th->packed.begin()+(size_t(index)<<th->elementshift);
+		th->packed.erase(start,start+(1<<th->elementshift));
+	}
+	else if ((uint32_t)index < th->size())
 	{
 		ret = th->vec[index];
 		ASObject* ob = asAtomHandler::getObject(ret);
@@ -1358,7 +1651,7 @@ bool Vector::hasPropertyByMultiname(const multiname& name, bool considerDynamic,
 	if(!Vector::isValidMultiname(getSystemState(),name,index))
 		return ASObject::hasPropertyByMultiname(name, considerDynamic, considerPrototype,wrk);
 
-	if(index < vec.size())
+	if(index < size())
 		return true;
 	else
 		return false;
@@ -1379,32 +1672,32 @@ GET_VARIABLE_RESULT Vector::getVariableByMultiname(asAtom& ret, const multiname&
 
 	unsigned int index=0;
 	bool isNumber =false;
-	if(!Vector::isValidMultiname(getSystemState(),name,index,&isNumber) || index > vec.size())
+	if(!Vector::isValidMultiname(getSystemState(),name,index,&isNumber) || index > size())
 	{
 		switch(name.name_type) 
 		{
 			case multiname::NAME_NUMBER:
 				if (getSystemState()->getSwfVersion() >= 11 
 						|| (uint32_t(name.name_d) == name.name_d && name.name_d < UINT32_MAX))
-					createError<RangeError>(getInstanceWorker(),kOutOfRangeError,name.normalizedName(getSystemState()),Integer::toString(vec.size()));
+					createError<RangeError>(getInstanceWorker(),kOutOfRangeError,name.normalizedName(getSystemState()),Integer::toString(size()));
 				else
 					createError<ReferenceError>(getInstanceWorker(),kReadSealedError, name.normalizedName(getSystemState()), this->getClass()->getQualifiedClassName());
 				return GET_VARIABLE_RESULT::GETVAR_NORMAL;
 			case multiname::NAME_INT:
 				if (getSystemState()->getSwfVersion() >= 11
-						|| name.name_i >= (int32_t)vec.size())
-					createError<RangeError>(getInstanceWorker(),kOutOfRangeError,name.normalizedName(getSystemState()),Integer::toString(vec.size()));
+						|| name.name_i >= (int32_t)size())
+					createError<RangeError>(getInstanceWorker(),kOutOfRangeError,name.normalizedName(getSystemState()),Integer::toString(size()));
 				else
 					createError<ReferenceError>(getInstanceWorker(),kReadSealedError, name.normalizedName(getSystemState()), this->getClass()->getQualifiedClassName());
 				return GET_VARIABLE_RESULT::GETVAR_NORMAL;
 			case multiname::NAME_UINT:
-				createError<RangeError>(getInstanceWorker(),kOutOfRangeError,name.normalizedName(getSystemState()),Integer::toString(vec.size()));
+				createError<RangeError>(getInstanceWorker(),kOutOfRangeError,name.normalizedName(getSystemState()),Integer::toString(size()));
 				return GET_VARIABLE_RESULT::GETVAR_NORMAL;
 			case multiname::NAME_STRING:
 				if (isNumber)
 				{
 					if (getSystemState()->getSwfVersion() >= 11 )
-						createError<RangeError>(getInstanceWorker(),kOutOfRangeError,name.normalizedName(getSystemState()),Integer::toString(vec.size()));
+						createError<RangeError>(getInstanceWorker(),kOutOfRangeError,name.normalizedName(getSystemState()),Integer::toString(size()));
 					else
 						createError<ReferenceError>(getInstanceWorker(),kReadSealedError, name.normalizedName(getSystemState()), this->getClass()->getQualifiedClassName());
 					return GET_VARIABLE_RESULT::GETVAR_NORMAL;
@@ -1419,9 +1712,9 @@ GET_VARIABLE_RESULT Vector::getVariableByMultiname(asAtom& ret, const multiname&
 			createError<ReferenceError>(getInstanceWorker(),kReadSealedError, name.normalizedName(getSystemState()), this->getClass()->getQualifiedClassName());
 		return res;
 	}
-	if(index < vec.size())
+	if(index < size())
 	{
-		ret = vec[index];
+		ret = getElement(index);
 		if (!(opt & NO_INCREF))
 			ASATOM_INCREF(ret);
 	}
@@ -1429,7 +1722,7 @@ GET_VARIABLE_RESULT Vector::getVariableByMultiname(asAtom& ret, const multiname&
 	{
 		createError<RangeError>(getInstanceWorker(),kOutOfRangeError,
 				       Integer::toString(index),
-				       Integer::toString(vec.size()));
+				       Integer::toString(size()));
 	}
 	return GET_VARIABLE_RESULT::GETVAR_NORMAL;
 }
@@ -1437,7 +1730,7 @@ GET_VARIABLE_RESULT Vector::getVariableByInteger(asAtom &ret, int index, GET_VAR
 {
 	if (index >=0 && uint32_t(index) < size())
 	{
-		ret = vec[index];
+		ret = getElement(index);
 		if (!(opt & NO_INCREF))
 			ASATOM_INCREF(ret);
 		return GET_VARIABLE_RESULT::GETVAR_NORMAL;
@@ -1458,20 +1751,20 @@ multiname *Vector::setVariableByMultiname(multiname& name, asAtom& o, CONST_ALLO
 		{
 			case multiname::NAME_NUMBER:
 				if (getSystemState()->getSwfVersion() >= 11 
-						|| (this->fixed && ((int32_t(name.name_d) != name.name_d) || name.name_d >= (int32_t)vec.size() || name.name_d < 0)))
-					createError<RangeError>(getInstanceWorker(),kOutOfRangeError,name.normalizedName(getSystemState()),Integer::toString(vec.size()));
+						|| (this->fixed && ((int32_t(name.name_d) != name.name_d) || name.name_d >= (int32_t)size() || name.name_d < 0)))
+					createError<RangeError>(getInstanceWorker(),kOutOfRangeError,name.normalizedName(getSystemState()),Integer::toString(size()));
 				else
 					createError<ReferenceError>(getInstanceWorker(),kWriteSealedError, name.normalizedName(getSystemState()), this->getClass()->getQualifiedClassName());
 				return nullptr;
 			case multiname::NAME_INT:
 				if (getSystemState()->getSwfVersion() >= 11
-						|| (this->fixed && (name.name_i >= (int32_t)vec.size() || name.name_i < 0)))
-					createError<RangeError>(getInstanceWorker(),kOutOfRangeError,name.normalizedName(getSystemState()),Integer::toString(vec.size()));
+						|| (this->fixed && (name.name_i >= (int32_t)size() || name.name_i < 0)))
+					createError<RangeError>(getInstanceWorker(),kOutOfRangeError,name.normalizedName(getSystemState()),Integer::toString(size()));
 				else
 					createError<ReferenceError>(getInstanceWorker(),kWriteSealedError, name.normalizedName(getSystemState()), this->getClass()->getQualifiedClassName());
 				return nullptr;
 			case multiname::NAME_UINT:
-				createError<RangeError>(getInstanceWorker(),kOutOfRangeError,name.normalizedName(getSystemState()),Integer::toString(vec.size()));
+				createError<RangeError>(getInstanceWorker(),kOutOfRangeError,name.normalizedName(getSystemState()),Integer::toString(size()));
 				return nullptr;
 			default:
 				break;
@@ -1484,10 +1777,21 @@ multiname *Vector::setVariableByMultiname(multiname& name, asAtom& o, CONST_ALLO
 		}
 		return ASObject::setVariableByMultiname(name, o, allowConst,alreadyset,wrk);
 	}
+	if (isPacked())
+	{
+		if(index < size())
+			setPacked(index,o);
+		else if(!fixed && index == size())
+			pushPacked(o);
+		else
+			throwRangeError(index);
+		ASATOM_DECREF(o);
+		return nullptr;
+	}
 	asAtom v = o;
 	if (this->vec_type->coerce(getInstanceWorker(), o))
 		ASATOM_DECREF(v);
-	if(index < vec.size())
+	if(index < size())
 	{
 		if (vec[index].uintval == o.uintval)
 		{
@@ -1505,7 +1809,7 @@ multiname *Vector::setVariableByMultiname(multiname& name, asAtom& o, CONST_ALLO
 			vec[index] = o;
 		}
 	}
-	else if(!fixed && index == vec.size())
+	else if(!fixed && index == size())
 	{
 		ASObject* obj = asAtomHandler::getObject(o);
 		if (obj)
@@ -1518,7 +1822,7 @@ multiname *Vector::setVariableByMultiname(multiname& name, asAtom& o, CONST_ALLO
 		 * one beyond the current final index. */
 		createError<RangeError>(getInstanceWorker(),kOutOfRangeError,
 				       Integer::toString(index),
-				       Integer::toString(vec.size()));
+				       Integer::toString(size()));
 	}
 	return nullptr;
 }
@@ -1531,10 +1835,21 @@ void Vector::setVariableByInteger(int index, asAtom &o, ASObject::CONST_ALLOWED_
 		return;
 	}
 	*alreadyset = false;
+	if (isPacked())
+	{
+		if(uint32_t(index) < size())
+			setPacked(index,o);
+		else if(!fixed && uint32_t(index) == size())
+			pushPacked(o);
+		else
+			throwRangeError(index);
+		ASATOM_DECREF(o);
+		return;
+	}
 	asAtom v = o;
 	if (this->vec_type->coerce(getInstanceWorker(), o))
 		ASATOM_DECREF(v);
-	if(size_t(index) < vec.size())
+	if(size_t(index) < size())
 	{
 		if (vec[index].uintval != o.uintval)
 		{
@@ -1549,7 +1864,7 @@ void Vector::setVariableByInteger(int index, asAtom &o, ASObject::CONST_ALLOWED_
 		else
 			*alreadyset=true;
 	}
-	else if(!fixed && size_t(index) == vec.size())
+	else if(!fixed && size_t(index) == size())
 	{
 		ASObject* obj = asAtomHandler::getObject(o);
 		if (obj)
@@ -1562,7 +1877,7 @@ void Vector::setVariableByInteger(int index, asAtom &o, ASObject::CONST_ALLOWED_
 		 * one beyond the current final index. */
 		createError<RangeError>(getInstanceWorker(),kOutOfRangeError,
 				       Integer::toString(index),
-				       Integer::toString(vec.size()));
+				       Integer::toString(size()));
 	}
 }
 
@@ -1572,25 +1887,25 @@ void Vector::throwRangeError(int index)
 	 * one beyond the current final index. */
 	createError<RangeError>(getInstanceWorker(),kOutOfRangeError,
 				   Integer::toString(index),
-				   Integer::toString(vec.size()));
+				   Integer::toString(size()));
 }
 
 tiny_string Vector::toString()
 {
 	//TODO: test
 	tiny_string t;
-	for(size_t i = 0; i < vec.size(); ++i)
+	for(size_t i = 0; i < size(); ++i)
 	{
 		if( i )
 			t += ",";
-		t += asAtomHandler::toString(vec[i],getInstanceWorker());
+		t += asAtomHandler::toString(getElement(i),getInstanceWorker());
 	}
 	return t;
 }
 
 uint32_t Vector::nextNameIndex(uint32_t cur_index)
 {
-	if(cur_index < vec.size())
+	if(cur_index < size())
 		return cur_index+1;
 	else
 		return 0;
@@ -1598,7 +1913,7 @@ uint32_t Vector::nextNameIndex(uint32_t cur_index)
 
 void Vector::nextName(asAtom& ret,uint32_t index)
 {
-	if(index<=vec.size())
+	if(index<=size())
 		asAtomHandler::setUInt(ret,this->getInstanceWorker(),index-1);
 	else
 		throw RunTimeException("Vector::nextName out of bounds");
@@ -1606,10 +1921,10 @@ void Vector::nextName(asAtom& ret,uint32_t index)
 
 void Vector::nextValue(asAtom& ret,uint32_t index)
 {
-	if(index<=vec.size())
+	if(index<=size())
 	{
-		ASATOM_INCREF(vec[index-1]);
-		ret = vec[index-1];
+		ret = getElement(index-1);
+		ASATOM_INCREF(ret);
 	}
 	else
 		throw RunTimeException("Vector::nextValue out of bounds");
@@ -1624,7 +1939,10 @@ bool Vector::ensureLength(uint32_t len)
 			createError<RangeError>(getInstanceWorker(),kVectorFixedError);
 			return false;
 		}
-		vec.resize(len, getDefaultValue());
+		if (isPacked())
+			packed.resize(size_t(len)<<elementshift);
+		else
+			vec.resize(len, getDefaultValue());
 	}
 	return true;
 }
@@ -1641,28 +1959,32 @@ bool Vector::isValidMultiname(SystemState* sys,const multiname& name, uint32_t&
 	return validIndex;
 }
 
-tiny_string Vector::toJSON(std::vector<ASObject *> &path, asAtom replacer, const tiny_string &spaces, const tiny_string &filter)
+void Vector::toJSON(std::string& res, std::vector<ASObject *> &path, asAtom replacer, const tiny_string &spaces, const tiny_string &filter)
 {
-	bool ok;
-	tiny_string res = call_toJSON(ok,path,replacer,spaces,filter);
-	if (ok)
-		return res;
+	if (call_toJSON(res,path,replacer,spaces,filter))
+		return;
 	// check for cylic reference
 	if (std::find(path.begin(),path.end(), this) != path.end())
 	{
 		createError<TypeError>(getInstanceWorker(),kJSONCyclicStructure);
-		return res;
+		return;
 	}
 
 	path.push_back(this);
 	res += "[";
 	bool bfirst = true;
-	tiny_string newline = (spaces.empty() ? "" : "\n");
+	const char* newline = (spaces.empty() ? "" : "\n");
 	asAtom closure = asAtomHandler::isValid(replacer) && asAtomHandler::getClosure(replacer) ? asAtomHandler::fromObject(asAtomHandler::getClosure(replacer)) : asAtomHandler::nullAtom;
-	for (unsigned int i =0;  i < vec.size(); i++)
-	{
-		tiny_string subres;
-		asAtom o = vec[i];
+	for (unsigned int i =0;  i < size(); i++)
+	{
+		asAtom o = getElement(i);
+		// the separator is written in advance and removed again if the member produces no output
+		size_t separatorpos = res.size();
+		if (!bfirst)
+			res += ",";
+		res += newline;
+		res.append(spaces.raw_buf(),spaces.numBytes());
+		size_t valuepos = res.size();
 		if (asAtomHandler::isValid(replacer))
 		{
 			asAtom params[2];
@@ -1673,45 +1995,42 @@ tiny_string Vector::toJSON(std::vector<ASObject *> &path, asAtom replacer, const
 			asAtomHandler::callFunction(replacer,getInstanceWorker(),funcret,closure, params, 2,false);
 			if (asAtomHandler::isValid(funcret))
 			{
-				subres = asAtomHandler::toObject(funcret,getInstanceWorker())->toJSON(path,asAtomHandler::invalidAtom,spaces,filter);
+				asAtomHandler::toObject(funcret,getInstanceWorker())->toJSON(res,path,asAtomHandler::invalidAtom,spaces,filter);
 				ASATOM_DECREF(funcret);
 			}
 		}
 		else
 		{
 			bool newobj = !asAtomHandler::isObject(o); // member is not a pointer to an ASObject, so toObject() will create a temporary ASObject that has to be decreffed after usage
-			subres = asAtomHandler::toObject(o,getInstanceWorker())->toJSON(path,replacer,spaces,filter);
+			asAtomHandler::toObject(o,getInstanceWorker())->toJSON(res,path,replacer,spaces,filter);
 			if (newobj)
 				ASATOM_DECREF(o);
 		}
-		if (!subres.empty())
-		{
-			if (!bfirst)
-				res += ",";
-			res += newline+spaces;
-			
+		if (res.size() == valuepos)
+			res.resize(separatorpos);
+		else
 			bfirst = false;
-			res += subres;
-		}
 	}
 	if (!bfirst)
-		res += newline+spaces.substr_bytes(0,spaces.numBytes()/2);
+	{
+		res += newline;
+		res.append(spaces.raw_buf(),spaces.numBytes()/2);
+	}
 	res += "]";
 	path.pop_back();
-	return res;
 }
 
 asAtom Vector::at(unsigned int index, asAtom defaultValue) const
 {
-	if (index < vec.size())
-		return vec.at(index);
+	if (index < size())
+		return getElement(index);
 	else
 		return defaultValue;
 }
 
-void Vector::serialize(ByteArray* out, std::map<tiny_string, uint32_t>& stringMap,
-				std::map<const ASObject*, uint32_t>& objMap,
-				std::map<const Class_base*, uint32_t>& traitsMap,ASWorker* wrk)
+void Vector::serialize(ByteArray* out, amf3stringtable& stringMap,
+				amf3objecttable& objMap,
+				amf3traitstable& traitsMap,ASWorker* wrk)
 {
 	if (out->getObjectEncoding() == OBJECT_ENCODING::AMF0)
 	{
@@ -1729,16 +2048,16 @@ void Vector::serialize(ByteArray* out, std::map<tiny_string, uint32_t>& stringMa
 		marker = vector_object_marker;
 	out->writeByte(marker);
 	//Check if the vector has been already serialized
-	auto it=objMap.find(this);
-	if(it!=objMap.end())
+	uint32_t ref=objMap.find(this);
+	if(ref!=amf3objecttable::npos)
 	{
 		//The least significant bit is 0 to signal a reference
-		out->writeU29(it->second << 1);
+		out->writeU29(ref << 1);
 	}
 	else
 	{
 		//Add the Vector to the map
-		objMap.insert(make_pair(this, objMap.size()));
+		objMap.add(this);
 
 		uint32_t count = size();
 		assert_and_throw(count<0x20000000);
@@ -1749,8 +2068,66 @@ void Vector::serialize(ByteArray* out, std::map<tiny_string, uint32_t>& stringMa
 		{
 			out->writeStringVR(stringMap,vec_type->getName());
 		}
+		else
+		{
+			// numeric contents have a fixed size, so they are written into the buffer in one block
+			uint32_t elementsize = marker == vector_double_marker ? 8 : 4;
+			uint8_t* buf = out->reserveWrite(uint64_t(count)*elementsize);
+			if (!buf)
+				return;
+			if (storage == VECTOR_STORAGE_NUMBER)
+			{
+				const number_t* data = packedData<number_t>();
+				for(uint32_t i=0;i<count;i++)
+				{
+					uint64_t v;
+					memcpy(&v,&data[i],8);
+					v = GINT64_TO_BE(v);
+					memcpy(buf+i*8,&v,8);
+				}
+				return;
+			}
+			if (storage == VECTOR_STORAGE_INT || storage == VECTOR_STORAGE_UINT)
+			{
+				const uint32_t* data = packedData<uint32_t>();
+				for(uint32_t i=0;i<count;i++)
+				{
+					uint32_t v = out->endianIn(data[i]);
+					memcpy(buf+i*4,&v,4);
+				}
+				return;
+			}
+			for(uint32_t i=0;i<count;i++)
+			{
+				if (marker == vector_double_marker)
+				{
+					number_t d = asAtomHandler::isValid(vec[i]) ? asAtomHandler::toNumber(vec[i]) : 0;
+					uint64_t v;
+					memcpy(&v,&d,8);
+					v = GINT64_TO_BE(v);
+					memcpy(buf,&v,8);
+				}
+				else
+				{
+					uint32_t v = 0;
+					if (asAtomHandler::isValid(vec[i]))
+						v = marker == vector_int_marker ? (uint32_t)asAtomHandler::toInt(vec[i]) : asAtomHandler::toUInt(vec[i]);
+					v = out->endianIn(v);
+					memcpy(buf,&v,4);
+				}
+				buf += elementsize;
+			}
+			return;
+		}
 		for(uint32_t i=0;i<count;i++)
 		{
+			if (isPacked())
+			{
+				// Vector.<Boolean> is written as object vector
+				asAtom v = getPacked(i);
+				asAtomHandler::serialize(out, stringMap, objMap, traitsMap,wrk,v);
+				continue;
+			}
 			if (asAtomHandler::isInvalid(vec[i]))
 			{
 				//TODO should we write a null_marker here?
@@ -234,22 +234,78 @@ public:
 };
 
 
+/*
+ * Vectors of int, uint, Number and Boolean store their elements as a native array in packed
+ * instead of atoms in vec. Packed storage is only used if those values are stored inline in an atom,
+ * so reading an element never creates an object and the atoms returned need no reference counting
+ */
+enum VECTOR_STORAGE { VECTOR_STORAGE_ATOM=0, VECTOR_STORAGE_INT, VECTOR_STORAGE_UINT, VECTOR_STORAGE_NUMBER, VECTOR_STORAGE_BOOL };
+
 class Vector: public ASObject
 {
 	Type* vec_type;
 	bool fixed;
+	VECTOR_STORAGE storage;
+	// log2 of the size of one element in packed
+	uint8_t elementshift;
 	std::vector<asAtom, reporter_allocator<asAtom>> vec;
+	std::vector<uint8_t, reporter_allocator<uint8_t>> packed;
 	int capIndex(int i) const;
-	class sortComparatorDefault
+	void setStorage();
+	template<class T> T* packedData() { return reinterpret_cast<T*>(packed.data()); }
+	template<class T> const T* packedData() const { return reinterpret_cast<const T*>(packed.data()); }
+	FORCE_INLINE asAtom getPacked(uint32_t index) const
 	{
-	private:
-		bool isNumeric;
-		bool isCaseInsensitive;
-		bool isDescending;
-	public:
-		sortComparatorDefault(bool n, bool ci, bool d):isNumeric(n),isCaseInsensitive(ci),isDescending(d){}
-		bool operator()(const asAtom& d1, const asAtom& d2);
-	};
+		switch (storage)
+		{
+			case VECTOR_STORAGE_INT:
+				return asAtomHandler::fromInt(packedData<int32_t>()[index]);
+			case VECTOR_STORAGE_UINT:
+				return asAtomHandler::fromUInt(packedData<uint32_t>()[index]);
+			case VECTOR_STORAGE_NUMBER:
+			{
+				asAtom ret=asAtomHandler::invalidAtom;
+				asAtomHandler::setInlineNumber(ret,packedData<number_t>()[index]);
+				return ret;
+			}
+			default:
+			{
+				asAtom ret=asAtomHandler::invalidAtom;
+				asAtomHandler::setBool(ret,packedData<uint8_t>()[index]);
+				return ret;
+			}
+		}
+	}
+	// converts o to the element type and stores it at index, o is not released
+	FORCE_INLINE void setPacked(uint32_t index, asAtom& o)
+	{
+		switch (storage)
+		{
+			case VECTOR_STORAGE_INT:
+				packedData<int32_t>()[index] = asAtomHandler::toInt(o);
+				break;
+			case VECTOR_STORAGE_UINT:
+				packedData<uint32_t>()[index] = asAtomHandler::toUInt(o);
+				break;
+			case VECTOR_STORAGE_NUMBER:
+				packedData<number_t>()[index] = asAtomHandler::toNumber(o);
+				break;
+			default:
+				packedData<uint8_t>()[index] = asAtomHandler::Boolean_concrete(o);
+				break;
+		}
+	}
+	void pushPacked(asAtom& o)
+	{
+		packed.resize(packed.size()+(1<<elementshift));
+		setPacked(size()-1,o);
+	}
+	int32_t indexOfPacked(asAtom& o, uint32_t from, bool backwards);
+	// returns a borrowed reference to the element at index
+	FORCE_INLINE asAtom getElement(uint32_t index) const
+	{
+		return isPacked() ? getPacked(index) : vec[index];
+	}
 	asAtom getDefaultValue();
 public:
 	class sortComparatorWrapper
@@ -286,6 +342,17 @@ public:
 			return;
 		}
 		*alreadyset=false;
+		if (isPacked())
+		{
+			if(uint32_t(index) < size())
+				setPacked(index,o);
+			else if(!fixed && uint32_t(index) == size())
+				pushPacked(o);
+			else
+				throwRangeError(index);
+			ASATOM_DECREF(o);
+			return;
+		}
 		if(size_t(index) < vec.size())
 		{
 			if (vec[index].uintval != o.uintval)
@@ -321,30 +388,43 @@ public:
 	FORCE_INLINE void getVariableByIntegerDirect(asAtom& ret, int index, ASWorker* wrk)
 	{
 		if (index >=0 && uint32_t(index) < size())
-			ret = vec[index];
+			ret = isPacked() ? getPacked(index) : vec[index];
 		else
 			getVariableByIntegerIntern(ret,index,GET_VARIABLE_OPTION::NONE,wrk);
 	}
 	static bool isValidMultiname(SystemState* sys, const multiname& name, uint32_t& index, bool *isNumber = nullptr);
 
-	tiny_string toJSON(std::vector<ASObject *> &path, asAtom replacer, const tiny_string &spaces,const tiny_string& filter) override;
+	void toJSON(std::string& res, std::vector<ASObject *> &path, asAtom replacer, const tiny_string &spaces,const tiny_string& filter) override;
 
 	uint32_t nextNameIndex(uint32_t cur_index) override;
 	void nextName(asAtom &ret, uint32_t index) override;
 	void nextValue(asAtom &ret, uint32_t index) override;
 
+	bool isPacked() const { return storage != VECTOR_STORAGE_ATOM; }
 	uint32_t size() const
 	{
-		return vec.size();
+		return isPacked() ? packed.size()>>elementshift : vec.size();
 	}
 	asAtom at(unsigned int index) const
 	{
+		if (isPacked())
+		{
+			if (index >= size())
+				throw std::out_of_range("Vector::at");
+			return getPacked(index);
+		}
 		return vec.at(index);
 	}
 	bool ensureLength(uint32_t len);
 	void set(uint32_t index, asAtom v)
 	{
-		if (index < size())
+		if (isPacked())
+		{
+			if (index < size())
+				setPacked(index,v);
+			ASATOM_DECREF(v);
+		}
+		else if (index < size())
 		{
 			ASObject* obj = asAtomHandler::getObject(vec[index]);
 			if (obj)
@@ -398,9 +478,9 @@ public:
 
 	ASObject* describeType(ASWorker* wrk) const override;
 	//Serialization interface
-	void serialize(ByteArray* out, std::map<tiny_string, uint32_t>& stringMap,
-				std::map<const ASObject*, uint32_t>& objMap,
-				std::map<const Class_base*, uint32_t>& traitsMap, ASWorker* wrk) override;
+	void serialize(ByteArray* out, amf3stringtable& stringMap,
+				amf3objecttable& objMap,
+				amf3traitstable& traitsMap, ASWorker* wrk) override;
 };
 
 }
@@ -2902,9 +2902,9 @@ bool XML::isEqual(ASObject* r)
 	return false;
 }
 
-void XML::serialize(ByteArray* out, std::map<tiny_string, uint32_t>& stringMap,
-		    std::map<const ASObject*, uint32_t>& objMap,
-		    std::map<const Class_base*, uint32_t>& traitsMap,ASWorker* wrk)
+void XML::serialize(ByteArray* out, amf3stringtable& stringMap,
+		    amf3objecttable& objMap,
+		    amf3traitstable& traitsMap,ASWorker* wrk)
 {
 	if (out->getObjectEncoding() == OBJECT_ENCODING::AMF0)
 	{
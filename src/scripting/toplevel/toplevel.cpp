@@ -130,6 +130,167 @@ void dumpFunctionCallCount(bool builtinonly = false,uint32_t mincallcount=0, uin
 	}
 }
 #endif
+/*
+ * Type feedback for methods with untyped arguments:
+ * the classes of the untyped arguments are recorded for every call. If they are stable after a number of calls,
+ * a version of the method is preloaded that treats the arguments as typed with the observed classes,
+ * so the preloader can select the same optimized handlers as for typed code.
+ * Calls whose arguments don't match the observed classes run the generic version
+ */
+method_info* SyntheticFunction::getSpeculativeMethod(ASWorker* wrk, asAtom* args, uint32_t numArgs)
+{
+	const uint32_t speculation_hit_threshold=50;
+	const uint32_t speculation_max_failures=100;
+	method_body_info* body = mi->body;
+	if (body->speculationStatus == method_body_info::SPECULATION_ACTIVE)
+	{
+		if (numArgs == mi->numArgs())
+		{
+			bool match = true;
+			for (uint32_t i = 0; i < numArgs && match; i++)
+			{
+				if (body->observedargumentclassids[i] == 0)
+					continue;
+				Class_base* c = asAtomHandler::getClass(args[i],getSystemState());
+				match = c && c->uniqueID == body->observedargumentclassids[i];
+			}
+			if (match)
+				return body->speculativemethod;
+		}
+		// guard failed, fall back to the generic version
+		if (++body->speculationfailures >= speculation_max_failures)
+			body->speculationStatus = method_body_info::SPECULATION_DISABLED;
+		return mi;
+	}
+	if (numArgs != mi->numArgs())
+		return mi;
+	bool first = body->observedargumenttypes.empty();
+	if (first)
+	{
+		if (!body->exceptions.empty() || numArgs == 0)
+		{
+			body->speculationStatus = method_body_info::SPECULATION_DISABLED;
+			return mi;
+		}
+		body->observedargumenttypes.resize(numArgs,nullptr);
+		body->observedargumentclassids.resize(numArgs,0);
+	}
+	bool speculate = false;
+	for (uint32_t i = 0; i < numArgs; i++)
+	{
+		if (mi->paramTypes[i] != Type::anyType)
+			continue;
+		Class_base* c = asAtomHandler::getClass(args[i],getSystemState());
+		uint32_t classid = c ? c->uniqueID : 0;
+		if (first)
+		{
+			body->observedargumenttypes[i] = c;
+			body->observedargumentclassids[i] = classid;
+		}
+		else if (body->observedargumentclassids[i] != classid)
+		{
+			body->observedargumenttypes[i] = nullptr;
+			body->observedargumentclassids[i] = 0;
+		}
+		speculate |= body->observedargumentclassids[i] != 0;
+	}
+	if (!speculate)
+		body->speculationStatus = method_body_info::SPECULATION_DISABLED;
+	else if (++body->speculationhits >= speculation_hit_threshold && body->codeStatus == method_body_info::PRELOADED)
+		preloadSpeculativeMethod(wrk);
+	return mi;
+}
+
+void SyntheticFunction::preloadSpeculativeMethod(ASWorker* wrk)
+{
+	method_body_info* body = mi->body;
+	method_info* speculative = new method_info(*mi);
+	speculative->body = body->cloneForSpeculation();
+	for (uint32_t i = 0; i < body->observedargumenttypes.size(); i++)
+	{
+		if (body->observedargumenttypes[i])
+			speculative->paramTypes[i] = body->observedargumenttypes[i];
+	}
+	// the generic version is used if preloading throws, speculation is not tried again in that case
+	body->speculationStatus = method_body_info::SPECULATION_DISABLED;
+	{
+		// preloadFunction works on the method of the function, so it is replaced by the specialized version during preloading
+		// the generic method is restored when preloading is left, also by an exception
+		struct restoremethod
+		{
+			method_info*& mi;
+			method_info* genericmi;
+			restoremethod(method_info*& _mi):mi(_mi),genericmi(_mi) {}
+			~restoremethod() { mi = genericmi; }
+		} restore(mi);
+		mi = speculative;
+		speculative->body->codeStatus = method_body_info::PRELOADING;
+		ABCVm::preloadFunction(this,wrk);
+		speculative->body->codeStatus = method_body_info::PRELOADED;
+	}
+	body->speculativemethod = speculative;
+	body->speculationStatus = method_body_info::SPECULATION_ACTIVE;
+}
+
+/**
+ * takes the call_context and the locals, operand stack and scope stack of a call from the call stack of the worker
+ */
+static FORCE_INLINE call_context* allocateCallFrame(ASWorker* wrk, method_info* mi)
+{
+	method_body_info* body = mi->body;
+	const uint32_t localcount = body->getReturnValuePos()+1+body->localresultcount;
+	const uint32_t slotcount = body->localconstantslots.size()+localcount;
+	const size_t atomcount = localcount+body->max_stack+1+body->max_scope_depth;
+	char* frame = (char*)wrk->callstack.allocate(sizeof(call_context)+atomcount*sizeof(asAtom)+slotcount*sizeof(asAtom*)+body->max_scope_depth*sizeof(bool));
+	call_context* cc = new (frame) call_context(mi);
+	cc->locals = (asAtom*)(frame+sizeof(call_context));
+	cc->stack = cc->locals+localcount;
+	cc->scope_stack = cc->stack+body->max_stack+1;
+	cc->localslots = (asAtom**)(cc->scope_stack+body->max_scope_depth);
+	cc->scope_stack_dynamic = (bool*)(cc->localslots+slotcount);
+	cc->max_stackp = cc->stack+body->max_stack;
+	cc->lastlocal = cc->locals+localcount;
+	for (uint32_t i = 0; i < localcount; i++)
+		cc->localslots[i] = &cc->locals[i];
+	return cc;
+}
+
+/**
+ * owns the call frame of a SyntheticFunction::call
+ * the frame is removed from the call stack of the worker and given back to the arena when the call is left,
+ * also when it is left by a C++ exception
+ */
+class callframeguard
+{
+private:
+	ASWorker* wrk;
+	call_context* saved_cc;
+	callstackarena::position framestart;
+	bool onstack;
+public:
+	callframeguard(ASWorker* _wrk, call_context* _saved_cc):wrk(_wrk),saved_cc(_saved_cc),framestart(_wrk->callstack.getPosition()),onstack(false)
+	{
+	}
+	~callframeguard()
+	{
+		leave();
+		wrk->callstack.release(framestart);
+	}
+	FORCE_INLINE void enter(call_context* cc)
+	{
+		wrk->callStack.push_back(cc);
+		onstack=true;
+	}
+	FORCE_INLINE void leave()
+	{
+		if (!onstack)
+			return;
+		onstack=false;
+		wrk->decStack(saved_cc);
+		wrk->callStack.pop_back();
+	}
+};
+
 /**
  * This prepares a new call_context and then executes the ABC bytecode function
  * by ABCVm::executeFunction() or through JIT.
@@ -140,8 +301,7 @@ void SyntheticFunction::call(ASWorker* wrk,asAtom& ret, asAtom& obj, asAtom *arg
 #ifdef PROFILING_SUPPORT
 	uint64_t t1 = compat_get_thread_cputime_us();
 #endif
-	const method_body_info::CODE_STATUS& codeStatus = mi->body->codeStatus;
-	if (codeStatus == method_body_info::PRELOADING)
+	if (mi->body->codeStatus == method_body_info::PRELOADING)
 	{
 		// this is a call to this method during preloading, it can happen when constructing objects for optimization detection
 		return;
@@ -149,26 +309,11 @@ void SyntheticFunction::call(ASWorker* wrk,asAtom& ret, asAtom& obj, asAtom *arg
 	assert(wrk == getWorker());
 	auto prev_cur_recursion = wrk->cur_recursion;
 	call_context* saved_cc = wrk->incStack(obj,this->functionname);
-	if (codeStatus != method_body_info::PRELOADED && codeStatus != method_body_info::USED)
+	if (mi->body->codeStatus != method_body_info::PRELOADED && mi->body->codeStatus != method_body_info::USED)
 	{
 		mi->body->codeStatus = method_body_info::PRELOADING;
-		mi->cc.sys = getSystemState();
-		mi->cc.worker=wrk;
-		mi->cc.exceptionthrown = nullptr;
 		ABCVm::preloadFunction(this,wrk);
 		mi->body->codeStatus = method_body_info::PRELOADED;
-		mi->cc.exec_pos = mi->body->preloadedcode.data();
-		mi->cc.locals = new asAtom[mi->body->getReturnValuePos()+1+mi->body->localresultcount];
-		mi->cc.stack = new asAtom[mi->body->max_stack+1];
-		mi->cc.scope_stack = new asAtom[mi->body->max_scope_depth];
-		mi->cc.scope_stack_dynamic = new bool[mi->body->max_scope_depth];
-		mi->cc.max_stackp=mi->cc.stack+mi->cc.mi->body->max_stack;
-		mi->cc.lastlocal = mi->cc.locals+mi->cc.mi->body->getReturnValuePos()+1+mi->body->localresultcount;
-		mi->cc.localslots = new asAtom*[mi->body->localconstantslots.size()+mi->body->getReturnValuePos()+1+mi->body->localresultcount];
-		for (uint32_t i = 0; i < uint32_t(mi->body->getReturnValuePos()+1+mi->body->localresultcount); i++)
-		{
-			mi->cc.localslots[i] = &mi->cc.locals[i];
-		}
 	}
 	if (saved_cc && saved_cc->exceptionthrown)
 	{
@@ -213,6 +358,12 @@ void SyntheticFunction::call(ASWorker* wrk,asAtom& ret, asAtom& obj, asAtom *arg
 		return;
 	}
 
+	// from here on the version of the method specialized for the classes of the arguments is used, if they match
+	method_info* mi = this->mi;
+	if (mi->body->speculationStatus != method_body_info::SPECULATION_DISABLED)
+		mi = getSpeculativeMethod(wrk,args,numArgs);
+	const method_body_info::CODE_STATUS& codeStatus = mi->body->codeStatus;
+
 #ifdef LLVM_ENABLED
 	//Temporarily disable JITting
 	const uint32_t jit_hit_threshold=20;
@@ -223,6 +374,16 @@ void SyntheticFunction::call(ASWorker* wrk,asAtom& ret, asAtom& obj, asAtom *arg
 		assert(val);
 	}
 	++mi->body->hit_count;
+#elif defined(JIT_ENABLED)
+	const uint32_t jit_hit_threshold=20;
+	if(getSystemState()->useJit && mi->body->jitcode==nullptr && !mi->body->jitfailed && mi->body->exceptions.empty() && codeStatus==method_body_info::PRELOADED
+			&& (mi->body->hit_count>=jit_hit_threshold || getSystemState()->useInterpreter==false))
+	{
+		//We passed the hot function threshold, jit the preloaded code
+		ABCVm::jitFunction(mi->body);
+	}
+	if (mi->body->hit_count < UINT16_MAX)
+		++mi->body->hit_count;
 #endif
 
 	//Prepare arguments
@@ -256,31 +417,10 @@ void SyntheticFunction::call(ASWorker* wrk,asAtom& ret, asAtom& obj, asAtom *arg
 	}
 
 	/* setup call_context */
-	bool recursive_call = codeStatus == method_body_info::USED;
-	call_context* cc = nullptr;
-	if (recursive_call)
-	{
-		cc = new call_context(mi);
-		cc->sys = getSystemState();
-		cc->worker=wrk;
-		cc->exceptionthrown = nullptr;
-		cc->locals= g_newa(asAtom, mi->body->getReturnValuePos()+1+mi->body->localresultcount);
-		cc->stack = g_newa(asAtom, mi->body->max_stack+1);
-		cc->scope_stack=g_newa(asAtom, mi->body->max_scope_depth);
-		cc->scope_stack_dynamic=g_newa(bool, mi->body->max_scope_depth);
-		cc->max_stackp=cc->stackp+cc->mi->body->max_stack;
-		cc->lastlocal = cc->locals+mi->body->getReturnValuePos()+1+mi->body->localresultcount;
-		cc->localslots = g_newa(asAtom*,mi->body->localconstantslots.size()+mi->body->getReturnValuePos()+1+mi->body->localresultcount);
-		for (uint32_t i = 0; i < uint32_t(mi->body->getReturnValuePos()+1+mi->body->localresultcount); i++)
-		{
-			cc->localslots[i] = &cc->locals[i];
-		}
-	}
-	else
-	{
-		cc = &mi->cc;
-		assert(cc->worker==wrk);
-	}
+	callframeguard frameguard(wrk,saved_cc);
+	call_context* cc = allocateCallFrame(wrk,mi);
+	cc->sys = getSystemState();
+	cc->worker=wrk;
 	cc->exec_pos = mi->body->preloadedcode.data();
 	cc->parent_scope_stack=func_scope.getPtr();
 	cc->defaultNamespaceUri = saved_cc ? saved_cc->defaultNamespaceUri : (uint32_t)BUILTIN_STRINGS::EMPTY;
@@ -289,7 +429,7 @@ void SyntheticFunction::call(ASWorker* wrk,asAtom& ret, asAtom& obj, asAtom *arg
 	if (wrk->currentCallContext != nullptr)
 		cc->explicitConstruction = wrk->currentCallContext->explicitConstruction;
 
-	wrk->callStack.push_back(cc);
+	frameguard.enter(cc);
 	/* Set the current global object, each script in each DoABCTag has its own */
 	wrk->currentCallContext = cc;
 
@@ -375,10 +515,16 @@ void SyntheticFunction::call(ASWorker* wrk,asAtom& ret, asAtom& obj, asAtom *arg
 #ifndef NDEBUG
 	if (wrk->isPrimordial)
 		Log::calls_indent++;
+#endif
+	bool runpreloadedcode = getSystemState()->useInterpreter;
+#ifdef JIT_ENABLED
+	//jitted code is executed in place of the interpreter loop
+	//if the method could not be jitted there is no native code, so the interpreter has to be used even if it is disabled
+	runpreloadedcode |= mi->body->jitcode!=nullptr || val==nullptr;
 #endif
 	while (true)
 	{
-		if(!mi->body->exceptions.empty() || (val==nullptr && getSystemState()->useInterpreter))
+		if(!mi->body->exceptions.empty() || (val==nullptr && runpreloadedcode))
 		{
 			if(codeStatus == method_body_info::OPTIMIZED && getSystemState()->useFastInterpreter)
 			{
@@ -419,6 +565,11 @@ void SyntheticFunction::call(ASWorker* wrk,asAtom& ret, asAtom& obj, asAtom *arg
 					cc->scope_stack_dynamic[0] = false;
 					cc->curr_scope_stack++;
 				}
+#ifdef JIT_ENABLED
+				if (mi->body->jitcode)
+					ABCVm::executeFunctionJit(cc);
+				else
+#endif
 				//This is not a hot function, execute it using the interpreter
 				ABCVm::executeFunction(cc);
 				//Restore the previous codeStatus
@@ -484,8 +635,7 @@ void SyntheticFunction::call(ASWorker* wrk,asAtom& ret, asAtom& obj, asAtom *arg
 		}
 		break;
 	}
-	wrk->decStack(saved_cc);
-	wrk->callStack.pop_back();
+	frameguard.leave();
 #ifndef NDEBUG
 	if (wrk->isPrimordial)
 		Log::calls_indent--;
@@ -545,8 +695,6 @@ void SyntheticFunction::call(ASWorker* wrk,asAtom& ret, asAtom& obj, asAtom *arg
 		else
 			this->decRef();
 	}
-	if (recursive_call)
-		delete cc;
 #ifdef PROFILING_SUPPORT
 	uint64_t t2 = compat_get_thread_cputime_us();
 	if (inClass)
@@ -205,6 +205,8 @@ public:
 #endif
 	}
 	bool isEqual(ASObject* r) override;
+	// builtin functions are equal if they have the same implementation
+	as_atom_function getImplementation() const { return val_atom; }
 	FORCE_INLINE multiname* callGetter(asAtom& ret, ASObject* target,ASWorker* wrk) override
 	{
 		asAtom c = asAtomHandler::fromObject(target);
@@ -257,6 +259,9 @@ private:
 	multiname* simpleGetterOrSetterName;
 	bool fromNewFunction;
 	SyntheticFunction(ASWorker* wrk,Class_base* c,method_info* m);
+	// records the classes of the arguments and returns the method version to execute for them
+	method_info* getSpeculativeMethod(ASWorker* wrk, asAtom* args, uint32_t numArgs);
+	void preloadSpeculativeMethod(ASWorker* wrk);
 protected:
 	IFunction* clone(ASWorker* wrk) override;
 public:
@@ -116,32 +116,52 @@ void SystemState::unregisterFrameListener(DisplayObject* obj)
 	frameListeners.erase(obj);
 }
 
+// AVM1 objects are registered as frame listeners for their clip events, so they get all broadcast events
+static bool listensToBroadcastEvent(DisplayObject* obj, uint32_t nameId)
+{
+	return !obj->needsActionScript3() || obj->mayHaveEventListener(nameId);
+}
+
 void SystemState::addBroadcastEvent(const tiny_string& event)
 {
 	Locker l(mutexFrameListeners);
 	if(!frameListeners.empty())
 	{
-		_R<Event> e(Class<Event>::getInstanceS(this->worker,event));
+		uint32_t nameId = getUniqueStringId(event);
+		// the event is only created if there is an object listening to it
+		Event* e = nullptr;
 		auto it=frameListeners.begin();
 		for(;it!=frameListeners.end();it++)
 		{
+			if (!listensToBroadcastEvent(*it,nameId))
+				continue;
+			if (!e)
+				e = Class<Event>::getInstanceS(this->worker,event);
 			(*it)->incRef();
-			getVm(this)->addEvent(_MR(*it),e);
+			e->incRef();
+			getVm(this)->addEvent(_MR(*it),_MR(e));
 		}
+		if (e)
+			e->decRef();
 	}
 }
 
 void SystemState::handleBroadcastEvent(const tiny_string& event)
 {
+	uint32_t nameId = getUniqueStringId(event);
 	std::set<DisplayObject*> tmplisteners; // work on copy of framelistners, as the list may change during event handling
 	{
 		Locker l(mutexFrameListeners);
 		for (auto it : frameListeners)
 		{
+			if (!listensToBroadcastEvent(it,nameId))
+				continue;
 			it->incRef();
 			tmplisteners.insert(it);
 		}
 	}
+	if (tmplisteners.empty())
+		return;
 	_R<Event> e(Class<Event>::getInstanceS(worker, event));
 	for (auto it : tmplisteners)
 		ABCVm::publicHandleEvent(it, e);
@@ -193,7 +213,8 @@ static const char* builtinStrings[] = {"any", "void", "prototype", "Function", "
 									   "__proto__","target","flash.events:IEventDispatcher","addEventListener","removeEventListener","dispatchEvent","hasEventListener",
 									   "onConnect","onData","onClose","onSelect",
 									   "add","alpha","darken","difference","erase","hardlight","invert","layer","lighten","multiply","overlay","screen","subtract",
-									   "text"
+									   "text",
+									   "enterFrame","exitFrame","frameConstructed","render"
 									  };
 
 extern uint32_t asClassCount;
@@ -203,7 +224,7 @@ SystemState::SystemState(uint32_t fileSize, FLASH_MODE mode):
 	renderThread(nullptr),inputThread(nullptr),engineData(nullptr),dumpedSWFPathAvailable(0),
 	vmVersion(VMNONE),childPid(0),
 	parameters(NullRef),
-	invalidateQueueHead(NullRef),invalidateQueueTail(NullRef),lastUsedStringId(0),lastUsedNamespaceId(0x7fffffff),framePhase(FramePhase::IDLE),
+	invalidateQueueHead(NullRef),invalidateQueueTail(NullRef),lastUsedNamespaceId(0x7fffffff),framePhase(FramePhase::IDLE),
 	showProfilingData(false),allowFullscreen(false),flashMode(mode),swffilesize(fileSize),instanceCounter(0),avm1global(nullptr),
 	currentVm(nullptr),builtinClasses(nullptr),useInterpreter(true),useFastInterpreter(false),useJit(false),ignoreUnhandledExceptions(false),exitOnError(ERROR_NONE),
 	systemDomain(nullptr),worker(nullptr),workerDomain(nullptr),singleworker(true),
@@ -211,25 +232,12 @@ SystemState::SystemState(uint32_t fileSize, FLASH_MODE mode):
 	static_SoundMixer_bufferTime(0),static_Multitouch_inputMode("gesture"),isinitialized(false)
 {
 	//Forge the builtin strings
-	uniqueStringIDMap.reserve(LAST_BUILTIN_STRING);
-	tiny_string sempty;
-	uniqueStringMap.emplace(make_pair(sempty,lastUsedStringId));
-	uniqueStringIDMap.push_back(sempty);
-	lastUsedStringId++;
+	uniqueStrings.getId(tiny_string());
 	for(uint32_t i=1;i<BUILTIN_STRINGS_CHAR_MAX;i++)
-	{
-		tiny_string s = tiny_string::fromChar(i);
-		uniqueStringMap.emplace(make_pair(s,lastUsedStringId));
-		uniqueStringIDMap.push_back(s);
-		lastUsedStringId++;
-	}
+		uniqueStrings.getId(tiny_string::fromChar(i));
 	for(uint32_t i=BUILTIN_STRINGS_CHAR_MAX;i<LAST_BUILTIN_STRING;i++)
-	{
-		tiny_string s(builtinStrings[i-BUILTIN_STRINGS_CHAR_MAX]);
-		uniqueStringMap.emplace(make_pair(s,lastUsedStringId));
-		uniqueStringIDMap.push_back(s);
-		lastUsedStringId++;
-	}
+		uniqueStrings.getId(tiny_string(builtinStrings[i-BUILTIN_STRINGS_CHAR_MAX]));
+	assert(uniqueStrings.size()==LAST_BUILTIN_STRING);
 	//Forge the empty namespace and make sure it gets id 0
 	nsNameAndKindImpl emptyNs(BUILTIN_STRINGS::EMPTY, NAMESPACE);
 	uint32_t nsId;
@@ -738,7 +746,6 @@ void SystemState::destroy()
 
 	for(auto it=profilingData.begin();it!=profilingData.end();it++)
 		delete *it;
-	uniqueStringMap.clear();
 }
 
 bool SystemState::isOnError() const
@@ -2217,26 +2224,12 @@ void SystemState::resizeCompleted()
 
 const tiny_string& SystemState::getStringFromUniqueId(uint32_t id) const
 {
-	Locker l(poolMutex);
-	assert(uniqueStringIDMap.size() > id);
-	return uniqueStringIDMap[id];
+	return uniqueStrings.getString(id);
 }
 
 uint32_t SystemState::getUniqueStringId(const tiny_string& s)
 {
-	Locker l(poolMutex);
-	auto it=uniqueStringMap.find(s);
-	if(it==uniqueStringMap.end())
-	{
-		tiny_string s2;
-		s2 += s; // ensure that a deep copy of the string is stored in the map, as s might be type READONLY/DYNAMIC and be deleted later
-		auto ret=uniqueStringMap.insert(make_pair(s2,lastUsedStringId));
-		uniqueStringIDMap.push_back(s2);
-		assert(ret.second);
-		it=ret.first;
-		lastUsedStringId++;
-	}
-	return it->second;
+	return uniqueStrings.getId(s);
 }
 
 const nsNameAndKindImpl& SystemState::getNamespaceFromUniqueId(uint32_t id) const
@@ -36,6 +36,7 @@
 #include <string>
 #include "swftypes.h"
 #include "memory_support.h"
+#include "uniquestringpool.h"
 #include "scripting/abcutils.h"
 
 using namespace std;
@@ -229,10 +230,8 @@ private:
 	/*
 	 * Pooling support
 	 */
+	UniqueStringPool uniqueStrings;
 	mutable Mutex poolMutex;
-	unordered_map<tiny_string, uint32_t> uniqueStringMap;
-	vector<tiny_string> uniqueStringIDMap;
-	uint32_t lastUsedStringId;
 	map<nsNameAndKindImpl, uint32_t> uniqueNamespaceImplMap;
 	unordered_map<uint32_t,nsNameAndKindImpl> uniqueNamespaceIDMap;
 	//This needs to be atomic because it's decremented without the mutex held
@@ -541,6 +540,8 @@ public:
 	RootMovieClip* getRootMovie() const;
 	static FILE_TYPE recognizeFile(uint8_t c1, uint8_t c2, uint8_t c3, uint8_t c4);
 	void execute() override;
+	// parsing runs behind the jobs needed for rendering the current frame
+	THREADJOB_PRIORITY getPriority() const override { return THREADJOB_PRIORITY_LOW; }
 	_NR<ApplicationDomain> applicationDomain;
 	_NR<SecurityDomain> securityDomain;
 	void getSWFByteArray(ByteArray* ba);
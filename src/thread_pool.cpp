@@ -26,67 +26,154 @@
 #include "compat.h"
 #include "logger.h"
 #include "swf.h"
+#include "scripting/eventqueue.h"
 #include "scripting/flash/system/flashsystem.h"
+#include "backends/config.h"
+#ifdef __GNUC__
+#include <cxxabi.h>
+#endif
 
 using namespace lightspark;
 
-ThreadPool::ThreadPool(SystemState* s):num_jobs(0),stopFlag(false),runcount(0)
+DEFINE_AND_INITIALIZE_TLS(threadpool_data);
+
+ThreadPool::ThreadPool(SystemState* s):num_jobs(0),nextthread(0),blockingjobs(0),stopFlag(false)
 {
 	m_sys=s;
-	for(uint32_t i=0;i<NUM_THREADS;i++)
+	numthreads=Config::getConfig()->getThreadPoolSize();
+	if(numthreads==0)
+		numthreads=SDL_GetCPUCount();
+	if(numthreads<THREADPOOL_MIN_THREADS)
+		numthreads=THREADPOOL_MIN_THREADS;
+	data=new ThreadPoolData[numthreads];
+	for(uint32_t i=0;i<numthreads;i++)
 	{
-		curJobs[i]=nullptr;
+		data[i].curJob=nullptr;
 		data[i].index=i;
 		data[i].pool = this;
-		threads[i] = SDL_CreateThread(job_worker,"ThreadPool",&data[i]);
 	}
+	for(uint32_t i=0;i<numthreads;i++)
+		data[i].thread = SDL_CreateThread(job_worker,"ThreadPool",&data[i]);
 }
 
 void ThreadPool::forceStop()
 {
 	if(!stopFlag)
 	{
-		stopFlag=true;
+		{
+			Locker l(mutex);
+			stopFlag=true;
+		}
 		//Signal an event for all the threads
-		for(int i=0;i<NUM_THREADS;i++)
+		for(uint32_t i=0;i<numthreads;i++)
 			num_jobs.signal();
 
+		for(uint32_t i=0;i<numthreads;i++)
 		{
-			Locker l(mutex);
+			Locker l(data[i].mutex);
 			//Now abort any job that is still executing
-			for(int i=0;i<NUM_THREADS;i++)
+			if(data[i].curJob)
 			{
-				if(curJobs[i])
-				{
-					curJobs[i]->threadAborting = true;
-					curJobs[i]->threadAbort();
-				}
+				data[i].curJob->threadAborting = true;
+				data[i].curJob->threadAbort();
 			}
 			//Fence all the non executed jobs
-			std::deque<IThreadJob*>::iterator it=jobs.begin();
-			for(;it!=jobs.end();++it)
-				(*it)->jobFence();
-			jobs.clear();
+			for(uint32_t p=0;p<THREADJOB_PRIORITY_COUNT;p++)
+			{
+				for(auto it=data[i].jobs[p].begin();it!=data[i].jobs[p].end();++it)
+					it->job->jobFence();
+				data[i].jobs[p].clear();
+			}
 		}
 
-		for(int i=0;i<NUM_THREADS;i++)
+		for(uint32_t i=0;i<numthreads;i++)
 		{
-			SDL_WaitThread(threads[i],nullptr);
+			SDL_WaitThread(data[i].thread,nullptr);
 		}
+		logStats();
 	}
 }
 
 ThreadPool::~ThreadPool()
 {
 	forceStop();
+	delete[] data;
+}
+
+bool ThreadPool::takeJob(uint32_t index, queuedjob& j)
+{
+	for(uint32_t p=0;p<THREADJOB_PRIORITY_COUNT;p++)
+	{
+		//Our own queue first, then steal from the other threads
+		for(uint32_t i=0;i<numthreads;i++)
+		{
+			ThreadPoolData& d=data[(index+i)%numthreads];
+			d.mutex.lock();
+			if(d.jobs[p].empty())
+			{
+				d.mutex.unlock();
+				continue;
+			}
+			if(i==0)
+			{
+				j=d.jobs[p].front();
+				d.jobs[p].pop_front();
+			}
+			else
+			{
+				j=d.jobs[p].back();
+				d.jobs[p].pop_back();
+			}
+			d.mutex.unlock();
+			Locker l(data[index].mutex);
+			data[index].curJob=j.job;
+			return true;
+		}
+	}
+	return false;
+}
+
+void ThreadPool::addStats(IThreadJob* j, uint64_t queuedtime, uint64_t starttime)
+{
+	uint64_t now=g_get_monotonic_time();
+	Locker l(statsmutex);
+	jobstats& s=stats[std::type_index(typeid(*j))];
+	s.count++;
+	s.totalwait+=starttime-queuedtime;
+	s.maxwait=std::max(s.maxwait,starttime-queuedtime);
+	s.totalrun+=now-starttime;
+	s.maxrun=std::max(s.maxrun,now-starttime);
+}
+
+void ThreadPool::logStats()
+{
+	Locker l(statsmutex);
+	for(auto it=stats.begin();it!=stats.end();++it)
+	{
+		const char* name=it->first.name();
+#ifdef __GNUC__
+		char* demangled=abi::__cxa_demangle(name,nullptr,nullptr,nullptr);
+		if(demangled)
+			name=demangled;
+#endif
+		const jobstats& s=it->second;
+		LOG(LOG_INFO,"ThreadPool jobs "<<name<<": "<<s.count<<" jobs, wait avg "<<s.totalwait/s.count<<"us max "<<s.maxwait
+			<<"us, run avg "<<s.totalrun/s.count<<"us max "<<s.maxrun<<"us");
+#ifdef __GNUC__
+		free(demangled);
+#endif
+	}
 }
 
 int ThreadPool::job_worker(void *d)
 {
 	ThreadPoolData* data = (ThreadPoolData*)d;
-	setTLSSys(data->pool->m_sys);
+	ThreadPool* pool = data->pool;
+	setTLSSys(pool->m_sys);
+	setEventSource(EVENTSOURCE_THREADPOOL);
+	tls_set(threadpool_data, data);
 
-	ThreadProfile* profile=data->pool->m_sys->allocateProfiler(RGB(200,200,0));
+	ThreadProfile* profile=pool->m_sys->allocateProfiler(RGB(200,200,0));
 	char buf[16];
 	snprintf(buf,16,"Thread %u",data->index);
 	profile->setTag(buf);
@@ -94,24 +181,31 @@ int ThreadPool::job_worker(void *d)
 	Chronometer chronometer;
 	while(1)
 	{
-		data->pool->num_jobs.wait();
-		if(data->pool->stopFlag)
+		pool->num_jobs.wait();
+		if(pool->stopFlag)
 			return 0;
-		Locker l(data->pool->mutex);
-		IThreadJob* myJob=data->pool->jobs.front();
-		data->pool->jobs.pop_front();
-		data->pool->curJobs[data->index]=myJob;
-		data->pool->runcount++;
-		l.release();
+		//The semaphore guarantees that a job is queued, but another thread may have taken the one that signalled it
+		queuedjob j;
+		while(!pool->takeJob(data->index,j))
+		{
+			if(pool->stopFlag)
+				return 0;
+		}
+		IThreadJob* myJob=j.job;
+		// the statistics are added before jobFence(), as the job may be deleted there
+		bool blocking=!myJob->isShortRunning();
+
+		// it's possible that a job was added and will be executed while forcestop() has been called.
+		// the job is already taken from the queue, so forcestop() doesn't fence it and it is fenced below without executing it
+		bool stopped=pool->stopFlag;
 
 		setTLSWorker(myJob->fromWorker);
 		chronometer.checkpoint();
+		uint64_t starttime=g_get_monotonic_time();
 		try
 		{
-			// it's possible that a job was added and will be executed while forcestop() has been called
-			if(data->pool->stopFlag)
-				return 0;
-			myJob->execute();
+			if(!stopped)
+				myJob->execute();
 		}
 		catch(JobTerminationException& ex)
 		{
@@ -120,29 +214,39 @@ int ThreadPool::job_worker(void *d)
 		catch(LightsparkException& e)
 		{
 			LOG(LOG_ERROR,"Exception in ThreadPool " << e.what());
-			data->pool->m_sys->setError(e.cause);
+			pool->m_sys->setError(e.cause);
 		}
 		catch(std::exception& e)
 		{
 			LOG(LOG_ERROR,"std Exception in ThreadPool:"<<myJob<<" "<<e.what());
-			data->pool->m_sys->setError(e.what());
+			pool->m_sys->setError(e.what());
 		}
 		
 		profile->accountTime(chronometer.checkpoint());
+		if(!stopped)
+			pool->addStats(myJob,j.queuedtime,starttime);
 
-		l.acquire();
-		data->pool->curJobs[data->index]=nullptr;
-		data->pool->runcount--;
-		l.release();
+		{
+			Locker l(data->mutex);
+			data->curJob=nullptr;
+		}
+		if(blocking)
+		{
+			Locker l(pool->mutex);
+			pool->blockingjobs--;
+		}
 
 		//jobFencing is allowed to happen outside the mutex
 		myJob->jobFence();
+		if(stopped)
+			return 0;
 	}
 	return 0;
 }
 
 void ThreadPool::addJob(IThreadJob* j)
 {
+	assert(j);
 	Locker l(mutex);
 	j->setWorker(getWorker());
 	if(stopFlag)
@@ -150,30 +254,44 @@ void ThreadPool::addJob(IThreadJob* j)
 		j->jobFence();
 		return;
 	}
-	assert(j);
-	if (runcount == NUM_THREADS)
+	if(!j->isShortRunning())
 	{
-		// no slot available, we create an additional thread
-		runAdditionalThread(j);
+		// jobs that may block have to leave at least one thread for the other jobs
+		if(blockingjobs+1 >= numthreads)
+		{
+			runAdditionalThread(j);
+			return;
+		}
+		blockingjobs++;
 	}
+
+	uint32_t index;
+	ThreadPoolData* current=(ThreadPoolData*)tls_get(threadpool_data);
+	if(j->affinity >= 0)
+		index=j->affinity%numthreads;
+	else if(current && current->pool==this)
+		index=current->index;
 	else
+		index=nextthread.fetch_add(1,std::memory_order_relaxed)%numthreads;
+	//The pool mutex is kept until the job is queued, so forceStop() can't miss it
 	{
-		jobs.push_back(j);
-		num_jobs.signal();
+		Locker l2(data[index].mutex);
+		data[index].jobs[j->getPriority()].push_back(queuedjob{j,uint64_t(g_get_monotonic_time())});
 	}
+	num_jobs.signal();
 }
 void ThreadPool::runAdditionalThread(IThreadJob* j)
 {
 	SDL_Thread* t = SDL_CreateThread(additional_job_worker,"additionalThread",j);
 	SDL_DetachThread(t);
 }
-
 int ThreadPool::additional_job_worker(void* d)
 {
 	IThreadJob* myJob=(IThreadJob*)d;
 
 	setTLSSys(myJob->fromWorker->getSystemState());
 	setTLSWorker(myJob->fromWorker);
+	setEventSource(EVENTSOURCE_THREADPOOL);
 	try
 	{
 		myJob->execute();
@@ -23,33 +23,68 @@
 #include "compat.h"
 #include <deque>
 #include <cstdlib>
+#include <atomic>
+#include <typeindex>
+#include <unordered_map>
 #include "threading.h"
 
 namespace lightspark
 {
 
-#define NUM_THREADS 20
+#define THREADPOOL_MIN_THREADS 4
 
 class SystemState;
 
+/*
+ * Pool of threads sized to the number of cpus.
+ * Every thread has its own queue for each job priority, idle threads steal jobs from the queues of other threads.
+ * Jobs that may block are run on additional threads if they would otherwise occupy all threads of the pool.
+ */
 class ThreadPool
 {
 private:
+	struct queuedjob
+	{
+		IThreadJob* job;
+		uint64_t queuedtime;
+	};
 	struct ThreadPoolData
 	{
 		ThreadPool* pool;
-		int index;
+		uint32_t index;
+		SDL_Thread* thread;
+		// protects jobs and curJob
+		Mutex mutex;
+		// the owner takes jobs from the front, other threads steal from the back
+		std::deque<queuedjob> jobs[THREADJOB_PRIORITY_COUNT];
+		IThreadJob* volatile curJob;
+	};
+	struct jobstats
+	{
+		uint64_t count;
+		// time in microseconds between addJob() and the start of the job
+		uint64_t totalwait;
+		uint64_t maxwait;
+		uint64_t totalrun;
+		uint64_t maxrun;
+		jobstats():count(0),totalwait(0),maxwait(0),totalrun(0),maxrun(0) {}
 	};
 	Mutex mutex;
-	SDL_Thread* threads[NUM_THREADS];
-	ThreadPoolData data[NUM_THREADS];
-	IThreadJob* volatile curJobs[NUM_THREADS];
-	std::deque<IThreadJob*> jobs;
+	uint32_t numthreads;
+	ThreadPoolData* data;
+	// number of queued jobs in all queues
 	Semaphore num_jobs;
+	std::atomic<uint32_t> nextthread;
+	// queued or running jobs that may block, protected by mutex
+	uint32_t blockingjobs;
+	Mutex statsmutex;
+	std::unordered_map<std::type_index,jobstats> stats;
 	static int job_worker(void* d);
 	SystemState* m_sys;
 	volatile bool stopFlag;
-	uint32_t runcount;
+	bool takeJob(uint32_t index, queuedjob& j);
+	void addStats(IThreadJob* j, uint64_t queuedtime, uint64_t starttime);
+	void logStats();
 	void runAdditionalThread(IThreadJob* j);
 	static int additional_job_worker(void* d);
 public:
@@ -57,6 +92,7 @@ public:
 	~ThreadPool();
 	void addJob(IThreadJob* j);
 	void forceStop();
+	uint32_t getThreadCount() const { return numthreads; }
 };
 
 }
@@ -22,14 +22,23 @@
 #include <cassert>
 
 #include "timer.h"
+#include "scripting/abc.h"
 #include "compat.h"
 #include "interfaces/timer.h"
 
 using namespace lightspark;
 using namespace std;
 
-TimerThread::TimerThread(SystemState* s):m_sys(s),stopped(false),joined(false)
+TimerThread::TimerThread(SystemState* s):currentTime(0),sleepUntil(UINT64_MAX),m_sys(s),stopped(false),joined(false)
 {
+	for(uint32_t l=0;l<TIMERWHEEL_LEVELS;l++)
+	{
+		for(uint32_t i=0;i<TIMERWHEEL_SLOTS;i++)
+			wheel[l][i].first=wheel[l][i].last=nullptr;
+		for(uint32_t i=0;i<TIMERWHEEL_SLOTS/64;i++)
+			occupied[l][i]=0;
+	}
+	startTime=g_get_monotonic_time();
 	t = SDL_CreateThread(&TimerThread::worker,"TimerThread",this);
 }
 
@@ -53,37 +62,155 @@ void TimerThread::wait()
 TimerThread::~TimerThread()
 {
 	stop();
-	list<TimingEvent*>::iterator it=pendingEvents.begin();
-	for(;it!=pendingEvents.end();++it)
+	for(auto it=pendingEvents.begin();it!=pendingEvents.end();++it)
 	{
-		if ((*it)->job)
-			(*it)->job->tickFence();
-		delete *it;
+		if (it->second->job)
+			it->second->job->tickFence();
+		delete it->second;
 	}
 }
 
-void TimerThread::insertNewEvent_nolock(TimingEvent* e)
+uint64_t TimerThread::getCurrentMilliseconds() const
 {
-	list<TimingEvent*>::iterator it=pendingEvents.begin();
-	//If there are no events pending, or this is earlier than the first, signal newEvent
-	if(pendingEvents.empty() || (*it)->wakeUpTime > e->wakeUpTime)
-	{
-		pendingEvents.insert(it, e);
-		newEvent.signal();
+	return (g_get_monotonic_time()-startTime)/G_TIME_SPAN_MILLISECOND;
+}
+
+void TimerThread::wheelInsert(TimingEvent* e, bool cascading)
+{
+	//Slots up to currentTime have already been processed, but cascaded events are due at currentTime at the earliest
+	if(e->expires<=currentTime && !cascading)
+		e->expires=currentTime+1;
+	uint64_t delta=e->expires-currentTime;
+	uint32_t level=0;
+	while(level<TIMERWHEEL_LEVELS-1 && delta>=(uint64_t(1)<<(TIMERWHEEL_BITS*(level+1))))
+		level++;
+	uint64_t pos=e->expires;
+	//Events beyond the range of the wheel are put in the last slot and inserted again when it is reached
+	if(delta>=(uint64_t(1)<<(TIMERWHEEL_BITS*TIMERWHEEL_LEVELS)))
+		pos=currentTime+(uint64_t(1)<<(TIMERWHEEL_BITS*TIMERWHEEL_LEVELS))-1;
+	uint32_t index=(pos>>(TIMERWHEEL_BITS*level))&(TIMERWHEEL_SLOTS-1);
+	timerslot* slot=&wheel[level][index];
+	e->slot=slot;
+	e->next=nullptr;
+	e->prev=slot->last;
+	if(slot->last)
+		slot->last->next=e;
+	else
+		slot->first=e;
+	slot->last=e;
+	occupied[level][index/64]|=uint64_t(1)<<(index%64);
+}
+
+void TimerThread::wheelRemove(TimingEvent* e)
+{
+	timerslot* slot=e->slot;
+	if(!slot)
 		return;
+	if(e->prev)
+		e->prev->next=e->next;
+	else
+		slot->first=e->next;
+	if(e->next)
+		e->next->prev=e->prev;
+	else
+		slot->last=e->prev;
+	e->slot=nullptr;
+	e->prev=e->next=nullptr;
+	if(!slot->first)
+	{
+		uint32_t level=(slot-&wheel[0][0])/TIMERWHEEL_SLOTS;
+		uint32_t index=(slot-&wheel[0][0])%TIMERWHEEL_SLOTS;
+		occupied[level][index/64]&=~(uint64_t(1)<<(index%64));
+	}
+}
+
+void TimerThread::cascade(uint32_t level)
+{
+	uint32_t index=(currentTime>>(TIMERWHEEL_BITS*level))&(TIMERWHEEL_SLOTS-1);
+	//The next level has to be cascaded first, its events may belong to the slot of this level
+	if(index==0 && level<TIMERWHEEL_LEVELS-1)
+		cascade(level+1);
+	timerslot* slot=&wheel[level][index];
+	TimingEvent* e=slot->first;
+	slot->first=slot->last=nullptr;
+	occupied[level][index/64]&=~(uint64_t(1)<<(index%64));
+	while(e)
+	{
+		TimingEvent* next=e->next;
+		wheelInsert(e,true);
+		e=next;
 	}
-	++it;
+}
 
-	for(;it!=pendingEvents.end();++it)
+void TimerThread::advance(uint64_t time, vector<TimingEvent*>& due)
+{
+	while(currentTime<time)
+	{
+		bool level0empty=true;
+		for(uint32_t i=0;i<TIMERWHEEL_SLOTS/64;i++)
+			level0empty&=occupied[0][i]==0;
+		//Skip to the end of the current round of level 0 if there is nothing to do
+		if(level0empty && (currentTime&(TIMERWHEEL_SLOTS-1))!=TIMERWHEEL_SLOTS-1)
+		{
+			currentTime=min(time,currentTime|(TIMERWHEEL_SLOTS-1));
+			continue;
+		}
+		currentTime++;
+		uint32_t index=currentTime&(TIMERWHEEL_SLOTS-1);
+		if(index==0)
+			cascade(1);
+		timerslot* slot=&wheel[0][index];
+		for(TimingEvent* e=slot->first;e;e=e->next)
+		{
+			e->slot=nullptr;
+			due.push_back(e);
+		}
+		slot->first=slot->last=nullptr;
+		occupied[0][index/64]&=~(uint64_t(1)<<(index%64));
+	}
+}
+
+uint64_t TimerThread::nextExpiration() const
+{
+	uint64_t ret=UINT64_MAX;
+	//Events on the higher levels are moved to level 0 at the end of the current round
+	for(uint32_t l=1;l<TIMERWHEEL_LEVELS && ret==UINT64_MAX;l++)
+	{
+		for(uint32_t i=0;i<TIMERWHEEL_SLOTS/64;i++)
+		{
+			if(occupied[l][i])
+			{
+				ret=(currentTime|(TIMERWHEEL_SLOTS-1))+1;
+				break;
+			}
+		}
+	}
+	//Find the next non empty slot of level 0, starting after the current time
+	uint32_t start=(currentTime+1)&(TIMERWHEEL_SLOTS-1);
+	for(uint32_t n=0;n<=TIMERWHEEL_SLOTS/64;n++)
 	{
-		if((*it)->wakeUpTime > e->wakeUpTime)
+		uint32_t word=((start/64)+n)%(TIMERWHEEL_SLOTS/64);
+		uint64_t bits=occupied[0][word];
+		if(n==0)
+			bits&=~uint64_t(0)<<(start%64);
+		else if(n==TIMERWHEEL_SLOTS/64)
+			bits&=(uint64_t(1)<<(start%64))-1;
+		if(bits)
 		{
-			pendingEvents.insert(it, e);
-			return;
+			uint32_t index=word*64+__builtin_ctzll(bits);
+			return min(ret,currentTime+1+((index-start)&(TIMERWHEEL_SLOTS-1)));
 		}
 	}
-	//Event has to be inserted after all the others
-	pendingEvents.insert(pendingEvents.end(), e);
+	return ret;
+}
+
+void TimerThread::insertNewEvent_nolock(TimingEvent* e)
+{
+	pendingEvents.insert(make_pair(e->job,e));
+	wheelInsert(e);
+	//Wake up the worker if the event is due before the time it is sleeping until
+	if(e->expires<sleepUntil)
+		newEvent.signal();
 }
 
 void TimerThread::insertNewEvent(TimingEvent* e)
@@ -95,10 +222,8 @@ void TimerThread::insertNewEvent(TimingEvent* e)
 //Unsafe debugging routine
 void TimerThread::dumpJobs()
 {
-	list<TimingEvent*>::iterator it=pendingEvents.begin();
-	//Find if the job is in the list
-	for(;it!=pendingEvents.end();++it)
-		LOG(LOG_INFO, (*it)->job );
+	for(auto it=pendingEvents.begin();it!=pendingEvents.end();++it)
+		LOG(LOG_INFO, it->first );
 }
 
 /*
@@ -106,101 +231,131 @@ void TimerThread::dumpJobs()
  *
  * It holds "mutex" all the time but
  *   1. when waiting for on newEvent or for the correct time to execute a job.
- *   2. while executing e->job->tick() (during this time inExectution == e->job)
- * The pendingEvents queue may be altered by another thread with "mutex"
- * An event may be deleted by another thread with "mutex" only if inExectution != jobToDelete
+ *   2. while executing the tick() of the due jobs
+ * The timing wheel may be altered by another thread with "mutex"
+ * Events of jobs that are ticked repeatedly are inserted again before the jobs are ticked,
+ * single-shot events are only owned by the worker after they were taken from the wheel.
+ * All jobs due at the same time are ticked together, and the events they send to the vm are added as one batch.
  */
 int TimerThread::worker(void *d)
 {
 	TimerThread* th = (TimerThread*)d;
 	setTLSSys(th->m_sys);
+	setEventSource(EVENTSOURCE_TIMER);
 
+	vector<TimingEvent*> due;
+	vector<ITickJob*> jobs;
+	vector<TimingEvent*> finished;
 	Locker l(th->mutex);
 	while(1)
 	{
-		/* Wait until the first event appears */
-		while(th->pendingEvents.empty())
-		{
-			th->newEvent.wait(th->mutex);
-			if(th->stopped)
-				return 0;
-		}
-
-		/* Get expiration of first event */
-		CondTime timing=th->pendingEvents.front()->wakeUpTime;
-		/* Wait for the absolute time or a newEvent signal
-		 * this unlocks the mutex and relocks it before returing
-		 */
-		timing.wait(th->mutex,th->newEvent);
-
 		if(th->stopped)
 			return 0;
-
-		if(th->pendingEvents.empty())
-			continue;
-
-		TimingEvent* e=th->pendingEvents.front();
-
-		/* check if the top event is due now. It could be have been removed/inserted
-		 * while we slept */
-		if(e->wakeUpTime.isInTheFuture())
-			continue;
-
-		th->pendingEvents.pop_front();
-
-		if(e->job->stopMe)
+		uint64_t now=th->getCurrentMilliseconds();
+		uint64_t next=th->nextExpiration();
+		if(next>now)
 		{
-			e->job->tickFence();
-			delete e;
+			th->sleepUntil=next;
+			/* Wait for the next event or a newEvent signal
+			 * this unlocks the mutex and relocks it before returing
+			 */
+			if(next==UINT64_MAX)
+				th->newEvent.wait(th->mutex);
+			else
+				th->newEvent.wait_until(th->mutex,next-now);
+			th->sleepUntil=UINT64_MAX;
 			continue;
 		}
 
-		if(e->isTick)
+		th->advance(now,due);
+		for(auto it=due.begin();it!=due.end();++it)
 		{
-			/* re-enqueue*/
-			e->wakeUpTime.addMilliseconds(e->tickTime);
-			th->insertNewEvent_nolock(e);
+			TimingEvent* e=*it;
+			if(e->job->stopMe || !e->isTick)
+			{
+				auto range=th->pendingEvents.equal_range(e->job);
+				for(auto p=range.first;p!=range.second;++p)
+				{
+					if(p->second==e)
+					{
+						th->pendingEvents.erase(p);
+						break;
+					}
+				}
+			}
+			if(e->job->stopMe)
+			{
+				e->job->tickFence();
+				delete e;
+				continue;
+			}
+			if(e->isTick)
+			{
+				/* re-enqueue, but don't allow that the next time is in the past */
+				e->expires+=e->tickTime;
+				if(e->expires<=now)
+					e->expires=now+e->tickTime;
+				th->wheelInsert(e);
+			}
+			else
+				finished.push_back(e);
+			jobs.push_back(e->job);
 		}
+		due.clear();
+		if(jobs.empty())
+			continue;
 
-		/* If e->isTick == false, e is not in pendingQueue anymore and this function has the only reference to it.
-		 * If e->isTick == true, we just enqueued e another time. If removeJob() is called on e->job from
-		 * job->tick() or another thread, then this will remove e from pendingQueue and delete e after we release the mutex.
-		 * In that case we may not access e after 'l.release()'.
+		/* If removeJob() is called on a repeated job from job->tick() or another thread,
+		 * its event is removed from the wheel and deleted after we release the mutex.
+		 * So only the job pointers may be used after 'l.release()'.
 		 */
-		ITickJob* job = e->job;
-		bool isTick = e->isTick;
 		l.release();
 
-		job->tick();
+		TickBatch batch;
+		for(auto it=jobs.begin();it!=jobs.end();++it)
+		{
+			if(!(*it)->tickBatched(batch))
+				(*it)->tick();
+		}
+		if(!batch.events.empty())
+		{
+			ABCVm* vm=getVm(th->m_sys);
+			if(vm)
+				vm->addEventBatch(batch.events,batch.sync);
+		}
 
 		l.acquire();
+		jobs.clear();
 
 		/* Cleanup */
-		if(!isTick)
+		for(auto it=finished.begin();it!=finished.end();++it)
 		{
-			e->job->tickFence();
-			delete e;
+			(*it)->job->tickFence();
+			delete *it;
 		}
+		finished.clear();
 	}
 	return 0;
 }
 
 void TimerThread::addTick(uint32_t tickTime, ITickJob* job)
 {
-	TimingEvent* e=new TimingEvent(job, true, tickTime, 0);
-	insertNewEvent(e);
+	Locker l(mutex);
+	TimingEvent* e=new TimingEvent(job, true, tickTime, getCurrentMilliseconds()+tickTime);
+	insertNewEvent_nolock(e);
 }
 
 void TimerThread::addWait(uint32_t waitTime, ITickJob* job)
 {
-	TimingEvent* e=new TimingEvent(job, false, 0, waitTime);
-	insertNewEvent(e);
+	Locker l(mutex);
+	TimingEvent* e=new TimingEvent(job, false, 0, getCurrentMilliseconds()+waitTime);
+	insertNewEvent_nolock(e);
 }
 
 /*
  * removeJob()
  *
- * Removes the given job from the pendingEvents queue
+ * Removes the given job from the timing wheel
  */
 void TimerThread::removeJob(ITickJob* job)
 {
@@ -209,28 +364,15 @@ void TimerThread::removeJob(ITickJob* job)
 }
 void TimerThread::removeJob_noLock(ITickJob* job)
 {
-
 	/* See if that job is currently pending */
-	list<TimingEvent*>::iterator it=pendingEvents.begin();
-	bool first=true;
-	//Find if the job is in the list
-	for(;it!=pendingEvents.end();++it)
-	{
-		if((*it)->job==job)
-			break;
-		first=false;
-	}
-
+	auto it=pendingEvents.find(job);
 	if(it==pendingEvents.end())
 		return;
 
-	TimingEvent* e=*it;
+	TimingEvent* e=it->second;
 	pendingEvents.erase(it);
+	wheelRemove(e);
 	delete e;
-
-	/* the worker is waiting on this job, wake him up */
-	if(first)
-		newEvent.signal();
 }
 
 Chronometer::Chronometer()
@@ -22,36 +22,90 @@
 
 #include "forwards/timer.h"
 #include "compat.h"
-#include <list>
+#include <vector>
+#include <unordered_map>
 #include <ctime>
 #include "threading.h"
+#include "smartrefs.h"
 
 namespace lightspark
 {
 
 class SystemState;
+class EventDispatcher;
+class Event;
 
+#define TIMERWHEEL_LEVELS 4
+#define TIMERWHEEL_BITS 8
+#define TIMERWHEEL_SLOTS (1<<TIMERWHEEL_BITS)
+
+/*
+ * Events for the vm collected from the tick jobs that are due in the same millisecond.
+ * They are added to the vm queue together after all jobs were ticked.
+ */
+class TickBatch
+{
+public:
+	std::vector<std::pair<_NR<EventDispatcher>,_R<Event>>> events;
+	// set by jobs that have to wait until the vm has handled their events
+	bool sync;
+	TickBatch():sync(false) {}
+	void addEvent(_NR<EventDispatcher> obj, _R<Event> ev) { events.push_back(std::make_pair(obj,ev)); }
+};
+
+/*
+ * Runs ITickJobs on a hierarchical timing wheel with a resolution of one millisecond.
+ * Level 0 has a slot for each of the next 256 milliseconds, every further level covers 256 times the range of the previous one.
+ * Events of a higher level are moved to the lower levels when the wheel reaches their slot,
+ * so adding and removing a job is O(1) independent of the number of pending jobs.
+ */
 class TimerThread
 {
 private:
+	class TimingEvent;
+	struct timerslot
+	{
+		TimingEvent* first;
+		TimingEvent* last;
+	};
 	class TimingEvent
 	{
 	public:
-		TimingEvent(ITickJob* _job, bool _isTick, uint32_t _tickTime, uint32_t _waitTime) 
-			: job(_job),wakeUpTime(_isTick ? _tickTime : _waitTime),tickTime(_tickTime),isTick(_isTick) {}
+		TimingEvent(ITickJob* _job, bool _isTick, uint32_t _tickTime, uint64_t _expires)
+			: job(_job),expires(_expires),tickTime(_tickTime),isTick(_isTick),slot(nullptr),prev(nullptr),next(nullptr) {}
 		ITickJob* job;
-		CondTime wakeUpTime;
+		// milliseconds since the start of the timer thread
+		uint64_t expires;
 		uint32_t tickTime;
 		bool isTick;
+		// list of the wheel slot the event is in, nullptr if it is not in the wheel
+		timerslot* slot;
+		TimingEvent* prev;
+		TimingEvent* next;
 	};
 	Mutex mutex;
 	Cond newEvent;
 	SDL_Thread* t;
-	std::list<TimingEvent*> pendingEvents;
+	timerslot wheel[TIMERWHEEL_LEVELS][TIMERWHEEL_SLOTS];
+	// bitmap of the non empty slots of each level
+	uint64_t occupied[TIMERWHEEL_LEVELS][TIMERWHEEL_SLOTS/64];
+	// all events expiring up to this time have been taken from the wheel
+	uint64_t currentTime;
+	// time the worker sleeps until, used to wake it up only for earlier events
+	uint64_t sleepUntil;
+	gint64 startTime;
+	std::unordered_multimap<ITickJob*,TimingEvent*> pendingEvents;
 	SystemState* m_sys;
 	volatile bool stopped;
 	bool joined;
 	static int worker(void* d);
+	uint64_t getCurrentMilliseconds() const;
+	void wheelInsert(TimingEvent* e, bool cascading=false);
+	void wheelRemove(TimingEvent* e);
+	void cascade(uint32_t level);
+	// takes all events expiring until time from the wheel
+	void advance(uint64_t time, std::vector<TimingEvent*>& due);
+	uint64_t nextExpiration() const;
 	void insertNewEvent(TimingEvent* e);
 	void insertNewEvent_nolock(TimingEvent* e);
 	void dumpJobs();
@@ -22,7 +22,7 @@
 
 using namespace lightspark;
 
-tiny_string::tiny_string(std::istream& in, int len):buf(_buf_static),stringSize(len+1),type(STATIC)
+tiny_string::tiny_string(std::istream& in, int len):buf(_buf_static),stringSize(len+1),type(STATIC),charindex(nullptr)
 {
 	if(stringSize > STATIC_SIZE)
 		createBuffer(stringSize);
@@ -31,7 +31,7 @@ tiny_string::tiny_string(std::istream& in, int len):buf(_buf_static),stringSize(
 	init();
 }
 
-tiny_string::tiny_string(const char* s,bool copy):_buf_static(),buf(_buf_static),type(READONLY)
+tiny_string::tiny_string(const char* s,bool copy):_buf_static(),buf(_buf_static),type(READONLY),charindex(nullptr)
 {
 	if(copy)
 		makePrivateCopy(s);
@@ -44,7 +44,7 @@ tiny_string::tiny_string(const char* s,bool copy):_buf_static(),buf(_buf_static)
 }
 
 tiny_string::tiny_string(const tiny_string& r):
-	_buf_static(),buf(_buf_static),stringSize(r.stringSize),numchars(r.numchars),type(STATIC),isASCII(r.isASCII),hasNull(r.hasNull)
+	_buf_static(),buf(_buf_static),stringSize(r.stringSize),numchars(r.numchars),type(STATIC),charindex(nullptr),isASCII(r.isASCII),hasNull(r.hasNull)
 {
 	//Fast path for static read-only strings
 	if(r.type==READONLY)
@@ -58,7 +58,7 @@ tiny_string::tiny_string(const tiny_string& r):
 	memcpy(buf,r.buf,stringSize);
 }
 
-tiny_string::tiny_string(const std::string& r):_buf_static(),buf(_buf_static),stringSize(r.size()+1),type(STATIC)
+tiny_string::tiny_string(const std::string& r):_buf_static(),buf(_buf_static),stringSize(r.size()+1),type(STATIC),charindex(nullptr)
 {
 	if(stringSize > STATIC_SIZE)
 		createBuffer(stringSize);
@@ -113,6 +113,7 @@ tiny_string& tiny_string::operator=(const char* s)
 
 tiny_string& tiny_string::operator+=(const char* s)
 {	//deprecated, cannot handle '\0' inside string
+	dropCharIndex();
 	if(type==READONLY)
 	{
 		char* tmp=buf;
@@ -137,6 +138,7 @@ tiny_string& tiny_string::operator+=(const char* s)
 
 tiny_string& tiny_string::operator+=(const tiny_string& r)
 {
+	dropCharIndex();
 	if(type==READONLY)
 	{
 		char* tmp=buf;
@@ -295,12 +297,12 @@ uint32_t tiny_string::find(const tiny_string& needle, uint32_t start) const
 		const char* p = strstr(buf+start,needle.raw_buf());
 		return (p ? p-buf : npos);
 	}
-	gchar* gp = g_utf8_offset_to_pointer(buf,start);
+	gchar* gp = charPointer(start);
 	gchar* found =g_strstr_len(gp,-1,needle.raw_buf());
 	if(found == nullptr)
 		return npos;
 	else
-		return start + g_utf8_pointer_to_offset(gp,found);
+		return bytePosToIndex(found-buf);
 }
 bool tiny_string::getLine(uint32_t& byteindex, tiny_string& line)
 {
@@ -362,6 +364,7 @@ bool tiny_string::getLine(uint32_t& byteindex, tiny_string& line)
 	}
 	//prepare line for new size
 	uint32_t newStringSize=endindex-startindex+1;
+	line.dropCharIndex();
 	if(line.type==READONLY)
 		line.resetToStatic();
 	if(line.type==STATIC && newStringSize > STATIC_SIZE)
@@ -385,13 +388,13 @@ uint32_t tiny_string::rfind(const tiny_string& needle, uint32_t start) const
 	if(start == npos)
 		bytestart = std::string::npos;
 	else
-		bytestart = g_utf8_offset_to_pointer(buf,start) - buf;
+		bytestart = charPointer(start) - buf;
 
 	size_t bytepos = std::string(*this).rfind(needle.raw_buf(),bytestart,needle.numBytes());
 	if(bytepos == std::string::npos)
 		return npos;
 	else
-		return g_utf8_pointer_to_offset(buf,buf+bytepos);
+		return bytePosToIndex(bytepos);
 }
 
 void tiny_string::makePrivateCopy(const char* s)
@@ -423,6 +426,7 @@ void tiny_string::resizeBuffer(uint32_t s)
 
 void tiny_string::resetToStatic()
 {
+	dropCharIndex();
 	if(type==DYNAMIC)
 	{
 		reportMemoryChange(-stringSize);
@@ -436,6 +440,7 @@ void tiny_string::resetToStatic()
 
 void tiny_string::init()
 {
+	dropCharIndex();
 	numchars = 0;
 	isASCII = true;
 	hasNull = false;
@@ -491,8 +496,8 @@ tiny_string& tiny_string::replace(uint32_t pos1, uint32_t n1, const tiny_string&
 		n1 = numChars()-pos1;
 	if (isASCII)
 		return replace_bytes(pos1, n1, o);
-	uint32_t bytestart = g_utf8_offset_to_pointer(buf,pos1)-buf;
-	uint32_t byteend = g_utf8_offset_to_pointer(buf,pos1+n1)-buf;
+	uint32_t bytestart = charPointer(pos1)-buf;
+	uint32_t byteend = charPointer(pos1+n1)-buf;
 	return replace_bytes(bytestart, byteend-bytestart, o);
 }
 
@@ -505,6 +510,7 @@ tiny_string& tiny_string::replace_bytes(uint32_t bytestart, uint32_t bytenum, co
 	memcpy(newbuf+bytestart,o.raw_buf(),o.numBytes());
 	memcpy(newbuf+bytestart+o.numBytes(),this->raw_buf()+bytestart+bytenum,this->stringSize-(bytestart+bytenum));
 	newbuf[newlen-1] = '\0';
+	dropCharIndex();
 	if(type==DYNAMIC)
 	{
 		reportMemoryChange(-stringSize);
@@ -555,8 +561,8 @@ tiny_string tiny_string::substr(uint32_t start, uint32_t len) const
 		len = numChars()-start;
 	if (isASCII)
 		return substr_bytes(start, len);
-	uint32_t bytestart = g_utf8_offset_to_pointer(buf,start) - buf;
-	uint32_t byteend = g_utf8_offset_to_pointer(buf+bytestart,len) - (buf+bytestart);
+	uint32_t bytestart = charPointer(start) - buf;
+	uint32_t byteend = charPointer(start+len) - (buf+bytestart);
 	return substr_bytes(bytestart, byteend,byteend-bytestart == len && !this->hasNull);
 }
 
@@ -565,7 +571,7 @@ tiny_string tiny_string::substr(uint32_t start, const CharIterator& end) const
 	if (isASCII)
 		return substr_bytes(start, (end.buf_ptr - buf)-start);
 	assert_and_throw(start < numChars());
-	uint32_t bytestart = g_utf8_offset_to_pointer(buf,start) - buf;
+	uint32_t bytestart = charPointer(start) - buf;
 	uint32_t byteend = end.buf_ptr - buf;
 	return substr_bytes(bytestart, byteend-bytestart);
 }
@@ -1240,8 +1246,54 @@ uint32_t tiny_string::bytePosToIndex(uint32_t bytepos) const
 		return numChars();
 	if (isASCII)
 		return bytepos;
+	if (numchars < CHARINDEX_MIN_CHARS)
+		return g_utf8_pointer_to_offset(raw_buf(), raw_buf() + bytepos);
+	// find the last indexed character before bytepos
+	indexedCharPointer(0);
+	uint32_t low = 0;
+	uint32_t high = numchars/CHARINDEX_STRIDE;
+	while (low < high)
+	{
+		uint32_t mid = (low+high+1)/2;
+		if (charindex[mid] <= bytepos)
+			low = mid;
+		else
+			high = mid-1;
+	}
+	return low*CHARINDEX_STRIDE + g_utf8_pointer_to_offset(raw_buf()+charindex[low], raw_buf() + bytepos);
+}
+
+char* tiny_string::indexedCharPointer(uint32_t idx) const
+{
+	uint32_t* index = __atomic_load_n(&charindex,__ATOMIC_ACQUIRE);
+	if (!index)
+	{
+		// const strings may be shared between threads, so the index is only published if no other thread created one
+		index = new uint32_t[numchars/CHARINDEX_STRIDE+1];
+		char* p = buf;
+		for (uint32_t i = 0; i <= numchars; i += CHARINDEX_STRIDE)
+		{
+			index[i/CHARINDEX_STRIDE] = p-buf;
+			if (i+CHARINDEX_STRIDE <= numchars)
+				p = g_utf8_offset_to_pointer(p,CHARINDEX_STRIDE);
+		}
+		uint32_t* expected = nullptr;
+		if (!__atomic_compare_exchange_n(&charindex,&expected,index,false,__ATOMIC_ACQ_REL,__ATOMIC_ACQUIRE))
+		{
+			delete[] index;
+			index = expected;
+		}
+	}
+	return g_utf8_offset_to_pointer(buf+index[idx/CHARINDEX_STRIDE],idx%CHARINDEX_STRIDE);
+}
 
-	return g_utf8_pointer_to_offset(raw_buf(), raw_buf() + bytepos);
+void tiny_string::dropCharIndex()
+{
+	if (charindex)
+	{
+		delete[] charindex;
+		charindex = nullptr;
+	}
 }
 
 CharIterator tiny_string::begin()
@@ -1285,10 +1337,34 @@ int tiny_string::compare(const tiny_string& r) const
 
 tiny_string tiny_string::toQuotedString() const
 {
-	tiny_string res("\"");
-	for (CharIterator it=this->begin(); it!=this->end(); it++)
+	std::string res;
+	toQuotedString(res);
+	return tiny_string(res);
+}
+
+void tiny_string::toQuotedString(std::string& res) const
+{
+	res += '\"';
+	const char* it = buf;
+	const char* end = buf+numBytes();
+	while (it < end)
 	{
-		switch (*it)
+		// characters that don't need escaping are copied in runs
+		const char* run = it;
+		while (run < end && uint8_t(*run) >= 0x20 && uint8_t(*run) < 0x80 && *run != '\"' && *run != '\\')
+			run++;
+		res.append(it,run-it);
+		it = run;
+		if (it == end)
+			break;
+		uint32_t c = uint8_t(*it);
+		const char* next = it+1;
+		if (c >= 0x80 && !isASCII)
+		{
+			c = g_utf8_get_char(it);
+			next = g_utf8_next_char(it);
+		}
+		switch (c)
 		{
 			case '\b':
 				res += "\\b";
@@ -1312,19 +1388,19 @@ tiny_string tiny_string::toQuotedString() const
 				res += "\\\\";
 				break;
 			default:
-				if ((*it < 0x20) || (*it > 0xff))
+				if ((c < 0x20) || (c > 0xff))
 				{
-					char hexstr[7];
-					sprintf(hexstr,"\\u%04x",*it);
+					char hexstr[12];
+					sprintf(hexstr,"\\u%04x",c);
 					res += hexstr;
 				}
 				else
-					res += *it;
+					res.append(it,next-it);
 				break;
 		}
+		it = next;
 	}
-	res += "\"";
-	return res;
+	res += '\"';
 }
 
 void tiny_string::getTrimPositions(uint32_t& start, uint32_t& end) const
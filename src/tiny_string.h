@@ -102,6 +102,15 @@ private:
 	uint32_t stringSize;
 	uint32_t numchars;
 	TYPE type;
+	/*
+	   sparse index from character positions to byte positions for long non-ascii strings,
+	   entry n contains the byte position of character n*CHARINDEX_STRIDE.
+	   It is created on the first indexed access and dropped when the string is modified
+	*/
+	static constexpr uint32_t CHARINDEX_STRIDE = 32;
+	// shorter strings are scanned from the start instead of building an index
+	static constexpr uint32_t CHARINDEX_MIN_CHARS = 64;
+	mutable uint32_t* charindex;
 #ifdef MEMORY_USAGE_PROFILING
 	//Implemented in memory_support.cpp
 	DLL_PUBLIC void reportMemoryChange(int32_t change) const;
@@ -116,12 +125,14 @@ private:
 	void resetToStatic();
 	void getTrimPositions(uint32_t& start, uint32_t &end) const;
 	void init();
+	void dropCharIndex();
+	char* indexedCharPointer(uint32_t idx) const;
 	bool isASCII:1;
 	bool hasNull:1;
 public:
 	static const uint32_t npos = (uint32_t)(-1);
 
-	tiny_string():_buf_static(),buf(_buf_static),stringSize(1),numchars(0),type(STATIC),isASCII(true),hasNull(false){buf[0]=0;}
+	tiny_string():_buf_static(),buf(_buf_static),stringSize(1),numchars(0),type(STATIC),charindex(nullptr),isASCII(true),hasNull(false){buf[0]=0;}
 	/* construct from utf character */
 	static tiny_string fromChar(uint32_t c);
 	tiny_string(const char* s,bool copy=false);
@@ -205,6 +216,7 @@ public:
 
 	FORCE_INLINE void setValue(const char* s,int _numbytes, int _numchars, bool _isASCII, bool _hasNull, bool copy)
 	{
+		dropCharIndex();
 		if(copy)
 		{
 			resetToStatic();
@@ -233,6 +245,7 @@ public:
 	{
 		if (type != STATIC)
 			resetToStatic();
+		dropCharIndex();
 		isASCII = c<0x80;
 		if (isASCII)
 		{
@@ -248,12 +261,21 @@ public:
 	
 	bool startsWith(const char* o) const;
 	bool endsWith(const char* o) const;
+	/* returns a pointer to the utf-8 character at character index idx */
+	inline char* charPointer(uint32_t idx) const
+	{
+		if (isASCII)
+			return buf+idx;
+		if (numchars < CHARINDEX_MIN_CHARS)
+			return g_utf8_offset_to_pointer(buf,idx);
+		return indexedCharPointer(idx);
+	}
 	/* idx is an index of utf-8 characters */
 	uint32_t charAt(uint32_t idx) const
 	{
 		if (isASCII)
 			return buf[idx];
-		return g_utf8_get_char(g_utf8_offset_to_pointer(buf,idx));
+		return g_utf8_get_char(charPointer(idx));
 	}
 	/* start is an index of characters.
 	 * returns index of character */
@@ -280,6 +302,8 @@ public:
 	CharIterator end() const;
 	int compare(const tiny_string& r) const;
 	tiny_string toQuotedString() const;
+	// appends the quoted string to res
+	void toQuotedString(std::string& res) const;
 	// returns string that has whitespace characters removed at begin and end 
 	tiny_string removeWhitespace() const;
 	// returns true if the string is empty or only contains whitespace characters
@@ -0,0 +1,137 @@
+/**************************************************************************
+    Lightspark, a free flash player implementation
+
+    Copyright (C) 2009-2013  Alessandro Pignotti (a.pignotti@sssup.it)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+#include "uniquestringpool.h"
+
+using namespace std;
+using namespace lightspark;
+
+UniqueStringPool::indextable::indextable(uint32_t capacity):mask(capacity-1),used(0)
+{
+	slots = new std::atomic<uint64_t>[capacity];
+	for (uint32_t i = 0; i < capacity; i++)
+		slots[i].store(0,memory_order_relaxed);
+}
+
+UniqueStringPool::indextable::~indextable()
+{
+	delete[] slots;
+}
+
+UniqueStringPool::UniqueStringPool():nextId(0)
+{
+	for (uint32_t i = 0; i < UNIQUESTRINGPOOL_SEGMENTS; i++)
+		segments[i].store(nullptr,memory_order_relaxed);
+	for (uint32_t i = 0; i < (1<<UNIQUESTRINGPOOL_SHARD_BITS); i++)
+		shards[i].table.store(new indextable(256),memory_order_relaxed);
+}
+
+UniqueStringPool::~UniqueStringPool()
+{
+	for (uint32_t i = 0; i < (1<<UNIQUESTRINGPOOL_SHARD_BITS); i++)
+	{
+		delete shards[i].table.load(memory_order_relaxed);
+		for (auto it = shards[i].retiredtables.begin(); it != shards[i].retiredtables.end(); it++)
+			delete *it;
+	}
+	for (uint32_t i = 0; i < UNIQUESTRINGPOOL_SEGMENTS; i++)
+		delete[] segments[i].load(memory_order_relaxed);
+}
+
+tiny_string* UniqueStringPool::allocateSegment(uint32_t segment)
+{
+	tiny_string* seg = segments[segment].load(memory_order_acquire);
+	if (seg)
+		return seg;
+	// the segment may be allocated concurrently from another shard, only one allocation is kept
+	tiny_string* newseg = new tiny_string[1U<<(segment+UNIQUESTRINGPOOL_FIRST_SEGMENT_BITS)];
+	if (segments[segment].compare_exchange_strong(seg,newseg,memory_order_acq_rel))
+		return newseg;
+	delete[] newseg;
+	return seg;
+}
+
+uint32_t UniqueStringPool::find(shard& sh, const tiny_string& s, uint32_t hash) const
+{
+	indextable* t = sh.table.load(memory_order_acquire);
+	for (uint32_t i = hash&t->mask; ; i = (i+1)&t->mask)
+	{
+		uint64_t v = t->slots[i].load(memory_order_acquire);
+		if (v == 0)
+			return UINT32_MAX;
+		if (uint32_t(v>>32) != hash)
+			continue;
+		uint32_t id = uint32_t(v)-1;
+		if (getEntry(id) == s)
+			return id;
+	}
+}
+
+uint32_t UniqueStringPool::insert(shard& sh, const tiny_string& s, uint32_t hash)
+{
+	uint32_t id = nextId.fetch_add(1,memory_order_relaxed);
+	uint32_t segment;
+	uint32_t offset;
+	getSegment(id,segment,offset);
+	tiny_string& stored = allocateSegment(segment)[offset];
+	stored += s; // ensure that a deep copy of the string is stored, as s might be type READONLY/DYNAMIC and be deleted later
+
+	indextable* t = sh.table.load(memory_order_relaxed);
+	// keep the load factor below 3/4, so the probe sequences of the readers always end at an empty slot
+	if ((t->used+1)*4 > (t->mask+1)*3)
+	{
+		indextable* newtable = new indextable((t->mask+1)*2);
+		for (uint32_t i = 0; i <= t->mask; i++)
+		{
+			uint64_t v = t->slots[i].load(memory_order_relaxed);
+			if (v == 0)
+				continue;
+			uint32_t j = uint32_t(v>>32)&newtable->mask;
+			while (newtable->slots[j].load(memory_order_relaxed))
+				j = (j+1)&newtable->mask;
+			newtable->slots[j].store(v,memory_order_relaxed);
+			newtable->used++;
+		}
+		sh.table.store(newtable,memory_order_release);
+		sh.retiredtables.push_back(t);
+		t = newtable;
+	}
+	uint32_t i = hash&t->mask;
+	while (t->slots[i].load(memory_order_relaxed))
+		i = (i+1)&t->mask;
+	// the entry is completely written before it can be found by readers
+	t->slots[i].store((uint64_t(hash)<<32)|(id+1),memory_order_release);
+	t->used++;
+	return id;
+}
+
+uint32_t UniqueStringPool::getId(const tiny_string& s)
+{
+	uint32_t hash = uint32_t(std::hash<tiny_string>()(s));
+	shard& sh = shards[(hash*0x9e3779b9U)>>(32-UNIQUESTRINGPOOL_SHARD_BITS)];
+	uint32_t id = find(sh,s,hash);
+	if (id != UINT32_MAX)
+		return id;
+	// the string may have been added since the index was read
+	Locker l(sh.mutex);
+	id = find(sh,s,hash);
+	if (id != UINT32_MAX)
+		return id;
+	return insert(sh,s,hash);
+}
@@ -0,0 +1,100 @@
+/**************************************************************************
+    Lightspark, a free flash player implementation
+
+    Copyright (C) 2009-2013  Alessandro Pignotti (a.pignotti@sssup.it)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+**************************************************************************/
+
+#ifndef UNIQUESTRINGPOOL_H
+#define UNIQUESTRINGPOOL_H 1
+
+#include <atomic>
+#include <vector>
+#include <cassert>
+#include "compat.h"
+#include "threading.h"
+#include "tiny_string.h"
+
+namespace lightspark
+{
+
+// the first segment holds 1<<UNIQUESTRINGPOOL_FIRST_SEGMENT_BITS strings, every following segment twice as many as the previous one
+#define UNIQUESTRINGPOOL_FIRST_SEGMENT_BITS 10
+#define UNIQUESTRINGPOOL_SEGMENTS (32-UNIQUESTRINGPOOL_FIRST_SEGMENT_BITS)
+#define UNIQUESTRINGPOOL_SHARD_BITS 4
+
+/*
+ * Maps strings to unique ids and back.
+ * The strings are stored in segments that are never moved once allocated,
+ * so the id->string direction needs no lock and returned references stay valid.
+ * The string->id direction is split into shards by the hash of the string. Every shard has an open addressing index
+ * that is read without lock, inserts take the mutex of the shard.
+ * Strings are never removed: ids are copied into multinames, variable maps and preloaded code that don't track their lifetime.
+ */
+class UniqueStringPool
+{
+private:
+	// every slot holds the hash of the string in the upper and id+1 in the lower 32 bits, 0 if the slot is empty
+	struct indextable
+	{
+		uint32_t mask;
+		uint32_t used;
+		std::atomic<uint64_t>* slots;
+		indextable(uint32_t capacity);
+		~indextable();
+	};
+	struct shard
+	{
+		Mutex mutex;
+		std::atomic<indextable*> table;
+		// indexes replaced by larger ones, readers may still use them, so they are kept until the pool is destroyed.
+		// As the index doubles on every growth they take at most as much memory as the current index
+		std::vector<indextable*> retiredtables;
+	};
+	shard shards[1<<UNIQUESTRINGPOOL_SHARD_BITS];
+	std::atomic<tiny_string*> segments[UNIQUESTRINGPOOL_SEGMENTS];
+	std::atomic<uint32_t> nextId;
+	static FORCE_INLINE void getSegment(uint32_t id, uint32_t& segment, uint32_t& offset)
+	{
+		uint32_t n = id+(1<<UNIQUESTRINGPOOL_FIRST_SEGMENT_BITS);
+		uint32_t bit = 31-__builtin_clz(n);
+		segment = bit-UNIQUESTRINGPOOL_FIRST_SEGMENT_BITS;
+		offset = n-(1<<bit);
+	}
+	FORCE_INLINE tiny_string& getEntry(uint32_t id) const
+	{
+		uint32_t segment;
+		uint32_t offset;
+		getSegment(id,segment,offset);
+		return segments[segment].load(std::memory_order_acquire)[offset];
+	}
+	tiny_string* allocateSegment(uint32_t segment);
+	uint32_t find(shard& sh, const tiny_string& s, uint32_t hash) const;
+	uint32_t insert(shard& sh, const tiny_string& s, uint32_t hash);
+public:
+	UniqueStringPool();
+	~UniqueStringPool();
+	// returns the id of s, s is added to the pool if it isn't already in it
+	uint32_t getId(const tiny_string& s);
+	FORCE_INLINE const tiny_string& getString(uint32_t id) const
+	{
+		assert(id < nextId.load(std::memory_order_relaxed));
+		return getEntry(id);
+	}
+	uint32_t size() const { return nextId.load(std::memory_order_relaxed); }
+};
+
+}
+#endif /* UNIQUESTRINGPOOL_H */